@@ -0,0 +1,349 @@
+/**
+ * STM32ZERO Active Objects
+ *
+ * Event-driven components with a private mailbox and run-to-completion
+ * dispatch. Instead of one task + queue per component, several active
+ * objects share one ActiveKernel task (a cooperative kernel inside the
+ * preemptive one): the kernel always dispatches the next event of the
+ * highest-priority object with a non-empty mailbox, and each handler runs
+ * to completion before the next event is taken.
+ *
+ *   ActiveObject<Derived, QueueDepth, Events...>
+ *     Derived     CRTP class with on_event(const E&) for every E in Events
+ *     QueueDepth  mailbox depth (events)
+ *     Events      event types (trivially copyable), stored as EventVariant
+ *
+ *   ActiveKernel<MaxObjects, StackWords>
+ *     one StaticTask dispatching up to MaxObjects active objects
+ *
+ * Objects with higher priority numbers are served first. Handlers must not
+ * block: waiting belongs in another event (or a timer posting one).
+ * Each object records dispatch latency (post -> handler start) and handler
+ * run time with ustim.
+ *
+ * Usage:
+ *   struct Press { uint8_t key; };
+ *   struct Tick {};
+ *
+ *   class Keypad : public ActiveObject<Keypad, 8, Press, Tick> {
+ *   public:
+ *       void on_event(const Press& e) { ... }
+ *       void on_event(const Tick&) { ... }
+ *   };
+ *
+ *   STM32ZERO_DTCM static ActiveKernel<4, 512> kernel;
+ *   static Keypad keypad;
+ *   keypad.start(kernel, 2);
+ *   kernel.start("AO", Priority::ABOVE_NORMAL);
+ *   keypad.post(Press{ 3 });             // or post_from_isr()
+ */
+
+#ifndef __STM32ZERO_ACTIVE_HPP__
+#define __STM32ZERO_ACTIVE_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-typedqueue.hpp"
+#include "stm32zero-ustim.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// EventVariant (tagged union of trivially copyable events)
+//=============================================================================
+
+namespace detail {
+
+template<typename... Ts>
+struct all_trivially_copyable : std::true_type {};
+
+template<typename T, typename... Ts>
+struct all_trivially_copyable<T, Ts...>
+	: std::integral_constant<bool, std::is_trivially_copyable<T>::value &&
+				       all_trivially_copyable<Ts...>::value> {};
+
+constexpr size_t max_of(std::initializer_list<size_t> values)
+{
+	size_t m = 1;
+	for (size_t v : values) {
+		m = (v > m) ? v : m;
+	}
+	return m;
+}
+
+template<typename E, typename... Ts>
+constexpr size_t index_of()
+{
+	constexpr bool same[] = { std::is_same<E, Ts>::value... };
+	for (size_t i = 0; i < sizeof...(Ts); i++) {
+		if (same[i]) {
+			return i;
+		}
+	}
+	return sizeof...(Ts);
+}
+
+template<typename E, typename... Ts>
+constexpr size_t count_of()
+{
+	constexpr bool same[] = { std::is_same<E, Ts>::value... };
+	size_t n = 0;
+	for (bool s : same) {
+		n += s ? 1 : 0;
+	}
+	return n;
+}
+
+} // namespace detail
+
+template<typename... Events>
+class EventVariant {
+	static_assert(sizeof...(Events) > 0, "EventVariant: no event types");
+	static_assert(sizeof...(Events) < 0xFF, "EventVariant: too many event types");
+	static_assert(detail::all_trivially_copyable<Events...>::value,
+		      "EventVariant: events must be trivially copyable");
+
+public:
+	static constexpr uint8_t EMPTY = 0xFF;
+
+	EventVariant() = default;
+
+	template<typename E>
+	EventVariant(const E& e)
+	{
+		static_assert(detail::index_of<E, Events...>() < sizeof...(Events),
+			      "EventVariant: not one of the event types");
+		static_assert(detail::count_of<E, Events...>() == 1, "EventVariant: duplicate event type");
+		new (storage_) E(e);
+		index_ = static_cast<uint8_t>(detail::index_of<E, Events...>());
+	}
+
+	uint8_t index() const { return index_; }
+	bool empty() const { return index_ == EMPTY; }
+
+	template<typename E>
+	bool is() const { return index_ == detail::index_of<E, Events...>(); }
+
+	template<typename E>
+	const E& get() const { return *reinterpret_cast<const E*>(storage_); }
+
+	// Call fn(const E&) with the stored event
+	template<typename F>
+	void visit(F&& fn) const
+	{
+		(void)((index_ == detail::index_of<Events, Events...>() ? (fn(get<Events>()), true) : false) || ...);
+	}
+
+private:
+	alignas(detail::max_of({ alignof(Events)... })) uint8_t storage_[detail::max_of({ sizeof(Events)... })];
+	uint8_t index_ = EMPTY;
+};
+
+//=============================================================================
+// ActiveBase (capacity-independent part)
+//=============================================================================
+
+struct ActiveStats {
+	uint32_t dispatched;
+	uint32_t dropped;           // mailbox full
+	uint32_t max_latency_us;    // post -> handler start
+	uint64_t total_latency_us;
+	uint32_t max_run_us;        // handler run time
+
+	uint32_t avg_latency_us() const
+	{
+		return dispatched ? static_cast<uint32_t>(total_latency_us / dispatched) : 0;
+	}
+};
+
+class ActiveKernelBase;
+
+class ActiveBase {
+public:
+	ActiveStats stats() const
+	{
+		CriticalSection cs;
+		return stats_;
+	}
+
+	void reset_stats()
+	{
+		CriticalSection cs;
+		stats_ = {};
+	}
+
+	uint8_t priority() const { return priority_; }
+
+protected:
+	ActiveBase() = default;
+	ActiveBase(const ActiveBase&) = delete;
+	ActiveBase& operator=(const ActiveBase&) = delete;
+
+	// Dispatch one event; false if the mailbox is empty
+	virtual bool dispatch_one_() = 0;
+
+	bool attach_(ActiveKernelBase& kernel, uint8_t priority);
+	void wake_kernel_();
+	void wake_kernel_from_isr_(BaseType_t* woken);
+
+	void record_(uint32_t post_us, uint32_t start_us, uint32_t end_us);
+	void count_dropped_();
+
+private:
+	friend class ActiveKernelBase;
+
+	ActiveKernelBase* kernel_ = nullptr;
+	uint8_t priority_ = 0;
+	ActiveStats stats_ = {};
+};
+
+//=============================================================================
+// ActiveObject
+//=============================================================================
+
+template<typename Derived, size_t QueueDepth, typename... Events>
+class ActiveObject : public ActiveBase {
+	static_assert(QueueDepth > 0, "ActiveObject: QueueDepth must be > 0");
+
+public:
+	using Event = EventVariant<Events...>;
+
+	// Create the mailbox and attach to kernel (higher priority served first)
+	bool start(ActiveKernelBase& kernel, uint8_t priority)
+	{
+		if (!mailbox_.is_created() && mailbox_.create() == nullptr) {
+			return false;
+		}
+		return attach_(kernel, priority);
+	}
+
+	// Returns false if the mailbox is still full after timeout
+	template<typename E>
+	bool post(const E& e, TickType_t timeout = 0)
+	{
+		Envelope env = { Event(e), static_cast<uint32_t>(ustim::get()) };
+		if (!mailbox_.send(env, timeout)) {
+			count_dropped_();
+			return false;
+		}
+		wake_kernel_();
+		return true;
+	}
+
+	template<typename E>
+	bool post_from_isr(const E& e, BaseType_t* woken = nullptr)
+	{
+		Envelope env = { Event(e), static_cast<uint32_t>(ustim::get()) };
+		if (!mailbox_.send_from_isr(env, woken)) {
+			count_dropped_();
+			return false;
+		}
+		wake_kernel_from_isr_(woken);
+		return true;
+	}
+
+	// Events waiting in the mailbox
+	size_t pending() const { return mailbox_.count(); }
+
+	static constexpr size_t depth() { return QueueDepth; }
+
+private:
+	struct Envelope {
+		Event event;
+		uint32_t post_us;
+	};
+
+	bool dispatch_one_() override
+	{
+		Envelope env;
+		if (!mailbox_.receive(env, 0)) {
+			return false;
+		}
+
+		uint32_t start = static_cast<uint32_t>(ustim::get());
+		Derived* self = static_cast<Derived*>(this);
+		env.event.visit([self](const auto& e) { self->on_event(e); });
+		record_(env.post_us, start, static_cast<uint32_t>(ustim::get()));
+		return true;
+	}
+
+	TypedQueue<Envelope, QueueDepth> mailbox_;
+};
+
+//=============================================================================
+// ActiveKernelBase (capacity-independent part)
+//=============================================================================
+
+class ActiveKernelBase {
+public:
+	// Attach before or after start(); objects sorted by priority
+	bool attach(ActiveBase& object, uint8_t priority);
+
+	void wake();
+	void wake_from_isr(BaseType_t* woken = nullptr);
+
+	// Kernel task wake-ups / events dispatched (events per wake-up = batching)
+	uint32_t wakeups() const { return wakeups_; }
+	uint32_t dispatched() const { return dispatched_; }
+
+	size_t attached() const { return count_; }
+	TaskHandle_t task() const { return task_; }
+
+protected:
+	ActiveKernelBase(ActiveBase** objects, size_t capacity) : objects_(objects), capacity_(capacity) {}
+
+	[[noreturn]] void run_();
+
+	TaskHandle_t task_ = nullptr;
+
+private:
+	// Highest-priority object with a pending event runs one handler
+	bool dispatch_next_();
+
+	ActiveBase** objects_;
+	size_t capacity_;
+	size_t count_ = 0;
+	volatile uint32_t wakeups_ = 0;
+	volatile uint32_t dispatched_ = 0;
+};
+
+//=============================================================================
+// ActiveKernel
+//=============================================================================
+
+template<size_t MaxObjects, size_t StackWords>
+class ActiveKernel : public ActiveKernelBase {
+	static_assert(MaxObjects > 0, "ActiveKernel: MaxObjects must be > 0");
+
+public:
+	ActiveKernel() : ActiveKernelBase(objects_, MaxObjects) {}
+
+	bool start(const char* name, Priority priority)
+	{
+		task_ = task_obj_.create(task_func_, name, priority, this);
+		return task_ != nullptr;
+	}
+
+	static constexpr size_t capacity() { return MaxObjects; }
+	static constexpr size_t stack_words() { return StackWords; }
+
+private:
+	static void task_func_(void* param)
+	{
+		static_cast<ActiveKernel*>(param)->run_();
+	}
+
+	StaticTask<StackWords> task_obj_;
+	ActiveBase* objects_[MaxObjects] = {};
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_ACTIVE_HPP__
@@ -0,0 +1,710 @@
+/**
+ * STM32ZERO FDCAN Bus with Hardware Filter Routing
+ *
+ * fdcan::Fdcan accepts a single standard ID (set_filter_id()) and hands
+ * every frame to one queue. CanBus drives an FDCAN handle directly and
+ * programs the acceptance filter RAM instead:
+ *
+ *   - Filters: ID lists (two IDs per element), ID/mask and ranges, for
+ *     standard and extended IDs. Non-matching frames are rejected by the
+ *     controller unless a route is set for them.
+ *   - Routes: each filter points at a named RxRoute, a queue bound to
+ *     RX FIFO0, RX FIFO1 or a dedicated RX buffer (one exact ID). Several
+ *     routes may share a FIFO; the RX interrupt demultiplexes by the
+ *     index of the matching filter element, so a consumer task wakes only
+ *     for frames of its own route.
+ *
+ * Lease routes (RxLeaseRoute) skip the queue copies: the RX interrupt
+ * reads each frame once from message RAM into a slot of the route and
+ * queues only its address; read_lease() hands out the slot and release()
+ * returns it. A lease route owns its RX FIFO. When its slots run out
+ * the interrupt leaves frames in the hardware FIFO (fifo_level()) until
+ * a release() makes room; beyond the FIFO depth the controller drops
+ * them (rx_lost). Backpressure is the FIFO fill level, nothing is
+ * dropped silently in software.
+ *
+ * Hook routes (RxHookRoute) have no queue at all: the RX interrupt hands
+ * each frame to a function, for work that must not wait for a task
+ * (gateways, protocol replies). The hook runs in the FDCAN interrupt and
+ * may send() on any bus.
+ *
+ * Transmit goes through the TX FIFO/queue: send() never blocks, write()
+ * waits for one free element and write_many() queues a batch in order,
+ * filling every free element per pass and sleeping (TX complete
+ * interrupt) until half the FIFO has drained, so the bus stays busy with
+ * one task wakeup per half FIFO instead of one per frame.
+ *
+ * TxOrder::PRIORITY (init()) runs the TX FIFO as the M_CAN TX queue: the
+ * pending element with the lowest ID goes first, as in bus arbitration,
+ * so a control frame no longer waits behind every telemetry frame queued
+ * before it. A full queue still refuses it, though. IDs reserved with
+ * add_tx_buffer() (H7) get a dedicated TX buffer each, outside the
+ * FIFO/queue: their frames enter arbitration at the next bus idle however
+ * much bulk traffic is pending, and write() of such an ID waits for its
+ * own buffer, not behind a bulk writer. tx_delay() keeps the queueing
+ * delay (request to TX complete, ustim) of both paths apart.
+ *
+ * A BusTap (set_tap()) sees every frame read and every transmit request
+ * completed, the protocol error interrupts (PEA / PED, with the last
+ * error code) and the error warning / passive / bus-off changes, all in
+ * the FDCAN interrupt; the bus monitor (stm32zero-canmon.hpp) counts
+ * with it.
+ *
+ * Timestamps are on the ustim timebase. The FDCAN timestamp counter runs
+ * from the external input, TIM3's counter, which is the 1 MHz low stage
+ * of ustim; every received frame carries the 16-bit value latched at its
+ * SOF, extended to 64-bit ustim microseconds in the RX interrupt. A frame
+ * sent with FLAG_EVENT stores an element in the TX Event FIFO when it
+ * leaves the controller; its TxEvent (SOF time, marker) goes to the queue
+ * set with set_tx_events().
+ *
+ * Filter and RX element counts come from the CubeMX configuration
+ * (StdFiltersNbr, ExtFiltersNbr, RxFifo0/1ElmtsNbr, RxBuffersNbr,
+ * TxBuffersNbr).
+ * Requires USE_HAL_FDCAN_REGISTER_CALLBACKS=1. A handle is driven either
+ * by CanBus or by fdcan::Fdcan, not both.
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static CanBus bus1;
+ *   STM32ZERO_DTCM static RxRoute<8> ctrl;
+ *   STM32ZERO_DTCM static RxRoute<16> telemetry;
+ *
+ *   ctrl.create("ctrl", RxTarget::FIFO0);
+ *   telemetry.create("telem", RxTarget::FIFO1);
+ *   bus1.init(&hfdcan1);
+ *   int c = bus1.add_route(ctrl);
+ *   int t = bus1.add_route(telemetry);
+ *   bus1.add_filter(RxFilter::std_ids(0x100, 0x101, c));
+ *   bus1.add_filter(RxFilter::std_range(0x200, 0x27F, t));
+ *   bus1.add_filter(RxFilter::ext_mask(0x18DA00F1, 0x1FFF00FF, t));
+ *   bus1.start();
+ *
+ *   CanFrame f;
+ *   ctrl.receive(f);                     // only 0x100 / 0x101 wake this task
+ *
+ *   STM32ZERO_DTCM static RxLeaseRoute<16> log;
+ *   log.create("log", RxTarget::FIFO1);  // before add_route(); owns FIFO1
+ *   RxLease l = log.read_lease();
+ *   sink(l->data, l->len);               // in the slot the ISR filled
+ *   l.release();                         // or at the end of scope
+ *
+ *   static bool on_sync(void* ctx, const CanFrame& f, BaseType_t* woken);
+ *   STM32ZERO_DTCM static RxHookRoute sync;
+ *   sync.create("sync", RxTarget::FIFO0, on_sync, nullptr);
+ *
+ *   TxResult res[64];
+ *   size_t n = bus1.write_many(block, 64, pdMS_TO_TICKS(100), res);
+ *
+ *   STM32ZERO_DTCM static freertos::TypedQueue<TxEvent, 16> sent;
+ *   bus1.set_tx_events(sent);            // before start()
+ *   f.flags |= CanFrame::FLAG_EVENT;
+ *   f.filter = 7;                        // message marker
+ *   bus1.write(f);
+ *   TxEvent ev;
+ *   sent.receive(ev);                    // ev.timestamp: SOF in ustim us
+ *
+ *   bus1.init(&hfdcan1, FDCAN_MODE_NORMAL, TxOrder::PRIORITY);
+ *   bus1.add_tx_buffer(0x010);           // before start()
+ *   bus1.send(0x010, &cmd, 8);           // passes any telemetry backlog
+ *   bus1.tx_delay(TxPriority::CRITICAL).max();
+ *
+ *   static const BusTap tap = { on_frame, on_error, on_status, &ctx };
+ *   bus1.set_tap(&tap);                  // before start()
+ */
+
+#ifndef __STM32ZERO_CANBUS_HPP__
+#define __STM32ZERO_CANBUS_HPP__
+
+#include "stm32zero.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-typedqueue.hpp"
+#include "stm32zero-histogram.hpp"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include <cstddef>
+#include <cstdint>
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// CanBus instances (one per FDCAN handle)
+#ifndef STM32ZERO_CANBUS_MAX_BUSES
+#define STM32ZERO_CANBUS_MAX_BUSES  2
+#endif
+
+// Routes per bus
+#ifndef STM32ZERO_CANBUS_MAX_ROUTES
+#define STM32ZERO_CANBUS_MAX_ROUTES  8
+#endif
+
+// Filter elements tracked per bus (the hardware count may be lower)
+#ifndef STM32ZERO_CANBUS_MAX_STD_FILTERS
+#define STM32ZERO_CANBUS_MAX_STD_FILTERS  32
+#endif
+
+#ifndef STM32ZERO_CANBUS_MAX_EXT_FILTERS
+#define STM32ZERO_CANBUS_MAX_EXT_FILTERS  16
+#endif
+
+// Dedicated RX buffers tracked per bus
+#ifndef STM32ZERO_CANBUS_MAX_RX_BUFFERS
+#define STM32ZERO_CANBUS_MAX_RX_BUFFERS  8
+#endif
+
+// Dedicated TX buffers reserved per bus (add_tx_buffer())
+#ifndef STM32ZERO_CANBUS_MAX_TX_BUFFERS
+#define STM32ZERO_CANBUS_MAX_TX_BUFFERS  8
+#endif
+
+// Frame timestamps from the FDCAN counter clocked by TIM3 (the ustim low
+// stage). 0 stamps frames with ustim::get() in the RX interrupt instead.
+#ifndef STM32ZERO_CANBUS_TIMESTAMPS
+#define STM32ZERO_CANBUS_TIMESTAMPS  1
+#endif
+
+// Dedicated RX and TX buffers exist on the H7 M_CAN, not on the H5 FDCAN
+#if defined(FDCAN_FILTER_TO_RXBUFFER)
+#define STM32ZERO_CANBUS_RX_BUFFERS  1
+#define STM32ZERO_CANBUS_TX_BUFFERS  1
+#else
+#define STM32ZERO_CANBUS_RX_BUFFERS  0
+#define STM32ZERO_CANBUS_TX_BUFFERS  0
+#endif
+
+namespace stm32zero {
+namespace fdcan {
+
+//=============================================================================
+// CanFrame
+//=============================================================================
+
+struct CanFrame {
+	static constexpr uint8_t FLAG_EXT = 0x01;   // 29-bit identifier
+	static constexpr uint8_t FLAG_FD = 0x02;    // FD format
+	static constexpr uint8_t FLAG_BRS = 0x04;   // bit rate switch
+	static constexpr uint8_t FLAG_ESI = 0x08;   // transmitter error passive
+	static constexpr uint8_t FLAG_EVENT = 0x10; // TX: store a TX event (marker in filter)
+
+	static constexpr uint8_t NO_FILTER = 0xFF;  // accepted as non-matching
+
+	uint32_t id;
+	uint8_t len;                // payload bytes (0..64, FD lengths)
+	uint8_t flags;
+	uint8_t filter;             // matching filter element index / TX event marker
+	uint8_t route;              // route index on the receiving bus
+	uint8_t data[64];
+	uint64_t timestamp;         // RX: SOF time, ustim us
+
+	bool is_ext() const { return (flags & FLAG_EXT) != 0; }
+	bool is_fd() const { return (flags & FLAG_FD) != 0; }
+};
+
+// Transmitted frame as read back from the TX Event FIFO
+struct TxEvent {
+	uint64_t timestamp;         // SOF time, ustim us
+	uint32_t id;
+	uint8_t len;
+	uint8_t flags;              // CanFrame::FLAG_*
+	uint8_t marker;             // CanFrame::filter of the sent frame
+};
+
+// Payload length to DLC code / back (FD lengths round up)
+uint32_t len_to_dlc(uint8_t len);
+uint8_t dlc_to_len(uint32_t dlc);
+
+// 16-bit counter stamp to the 64-bit ustim time at or before now. Valid
+// while now is less than 65.536 ms after the stamp.
+inline uint64_t extend_stamp(uint32_t stamp, uint64_t now)
+{
+	return now - ((now - stamp) & 0xFFFFU);
+}
+
+//=============================================================================
+// RxFilter
+//=============================================================================
+
+enum class RxTarget : uint8_t {
+	FIFO0,
+	FIFO1,
+	BUFFER,                     // dedicated RX buffer, exact ID only
+};
+
+enum class FilterKind : uint8_t {
+	DUAL,                       // id1 or id2
+	MASK,                       // (id & id2) == (id1 & id2)
+	RANGE,                      // id1 <= id <= id2
+};
+
+struct RxFilter {
+	uint32_t id1;
+	uint32_t id2;
+	FilterKind kind;
+	bool ext;
+	uint8_t route;
+
+	static constexpr RxFilter std_id(uint32_t id, int route) { return { id, id, FilterKind::DUAL, false, uint8_t(route) }; }
+	static constexpr RxFilter std_ids(uint32_t a, uint32_t b, int route) { return { a, b, FilterKind::DUAL, false, uint8_t(route) }; }
+	static constexpr RxFilter std_mask(uint32_t id, uint32_t mask, int route) { return { id, mask, FilterKind::MASK, false, uint8_t(route) }; }
+	static constexpr RxFilter std_range(uint32_t lo, uint32_t hi, int route) { return { lo, hi, FilterKind::RANGE, false, uint8_t(route) }; }
+
+	static constexpr RxFilter ext_id(uint32_t id, int route) { return { id, id, FilterKind::DUAL, true, uint8_t(route) }; }
+	static constexpr RxFilter ext_ids(uint32_t a, uint32_t b, int route) { return { a, b, FilterKind::DUAL, true, uint8_t(route) }; }
+	static constexpr RxFilter ext_mask(uint32_t id, uint32_t mask, int route) { return { id, mask, FilterKind::MASK, true, uint8_t(route) }; }
+	static constexpr RxFilter ext_range(uint32_t lo, uint32_t hi, int route) { return { lo, hi, FilterKind::RANGE, true, uint8_t(route) }; }
+};
+
+// Transmission order of the TX FIFO/queue elements (TXBC.TFQM)
+enum class TxOrder : uint8_t {
+	FIFO,                       // request order (CubeMX default)
+	PRIORITY,                   // TX queue: lowest ID first
+};
+
+// Transmit paths with separate queueing delay statistics
+enum class TxPriority : uint8_t {
+	CRITICAL,                   // IDs with a dedicated TX buffer
+	NORMAL,                     // TX FIFO/queue
+};
+
+constexpr size_t TX_PRIORITIES = 2;
+
+// Bus monitor callbacks, run in the FDCAN interrupt (set_tap()). Any of
+// the functions may be nullptr.
+struct BusTap {
+	// Frame read from message RAM (tx false) or transmit request
+	// completed (tx true); flags: CanFrame::FLAG_EXT / FD / BRS
+	void (*frame)(void* context, uint32_t id, uint8_t len, uint8_t flags, bool tx);
+	// Protocol error interrupt: code is the last error code
+	// (FDCAN_PROTOCOL_ERROR_*) of the arbitration or the data phase
+	void (*error)(void* context, uint32_t code, bool data_phase);
+	// Error warning / passive / bus-off change (its: FDCAN_IT_*) and the
+	// state after it
+	void (*status)(void* context, uint32_t its, bool warning, bool passive, bool bus_off);
+	void* context;
+};
+
+enum class TxResult : uint8_t {
+	QUEUED,                     // handed to the TX FIFO/queue
+	INVALID,                    // ID or length out of range, skipped
+	TIMEOUT,                    // no free element before the timeout
+	STOPPED,                    // bus not started
+};
+
+//=============================================================================
+// RxRoute
+//=============================================================================
+
+class CanBus;
+class RxRouteBase;
+
+// Hook route function, called in the RX interrupt for each frame of the
+// route; false counts the frame as dropped. woken as for the FreeRTOS
+// FromISR calls.
+using RxHook = bool (*)(void* context, const CanFrame& frame, BaseType_t* woken);
+
+// Frame on loan from a lease route; the slot returns on release() or
+// destruction. Task context.
+class RxLease {
+public:
+	RxLease() = default;
+	~RxLease() { release(); }
+
+	RxLease(const RxLease&) = delete;
+	RxLease& operator=(const RxLease&) = delete;
+
+	RxLease(RxLease&& other) : frame_(other.frame_), route_(other.route_)
+	{
+		other.frame_ = nullptr;
+		other.route_ = nullptr;
+	}
+
+	RxLease& operator=(RxLease&& other)
+	{
+		if (this != &other) {
+			release();
+			frame_ = other.frame_;
+			route_ = other.route_;
+			other.frame_ = nullptr;
+			other.route_ = nullptr;
+		}
+		return *this;
+	}
+
+	explicit operator bool() const { return frame_ != nullptr; }
+	CanFrame& operator*() const { return *frame_; }
+	CanFrame* operator->() const { return frame_; }
+	CanFrame* get() const { return frame_; }
+
+	void release();
+
+private:
+	friend class RxRouteBase;
+
+	RxLease(CanFrame* frame, RxRouteBase* route) : frame_(frame), route_(route) {}
+
+	CanFrame* frame_ = nullptr;
+	RxRouteBase* route_ = nullptr;
+};
+
+class RxRouteBase {
+public:
+	RxRouteBase(const RxRouteBase&) = delete;
+	RxRouteBase& operator=(const RxRouteBase&) = delete;
+
+	const char* name() const { return name_; }
+	RxTarget target() const { return target_; }
+	bool is_created() const { return queue_ != nullptr || hook_ != nullptr; }
+
+	bool is_lease() const { return slots_ != nullptr; }
+	bool is_hook() const { return hook_ != nullptr; }
+
+	// Next frame of this route, copied out (task context). A lease route
+	// copies from the slot and releases it.
+	bool receive(CanFrame& frame, TickType_t timeout = portMAX_DELAY);
+
+	// Lease routes: next frame in place; empty on timeout (task context)
+	RxLease read_lease(TickType_t timeout = portMAX_DELAY);
+
+	uint32_t waiting() const { return queue_ != nullptr ? uxQueueMessagesWaiting(queue_) : 0; }
+
+	uint32_t frames() const { return frames_; }         // queued by the ISR / hook returned true
+	uint32_t dropped() const { return dropped_; }       // queue full / hook returned false
+
+	// Lease routes: free slots, lowest count seen, and RX interrupts that
+	// found no free slot and left frames in the FIFO
+	uint32_t slots_free() const { return free_count_; }
+	uint32_t slots_min_free() const { return min_free_; }
+	uint32_t held() const { return held_; }
+
+	void reset_stats();
+
+protected:
+	RxRouteBase() = default;
+
+	bool create_(QueueHandle_t queue, const char* name, RxTarget target)
+	{
+		if (queue == nullptr) {
+			return false;
+		}
+		queue_ = queue;
+		name_ = name;
+		target_ = target;
+		return true;
+	}
+
+	// Slot storage and free stack of a lease route (queue of CanFrame*)
+	bool create_lease_(QueueHandle_t queue, CanFrame* slots, CanFrame** free, size_t count,
+			   const char* name, RxTarget target);
+
+	bool create_hook_(RxHook hook, void* context, const char* name, RxTarget target)
+	{
+		if (hook == nullptr) {
+			return false;
+		}
+		hook_ = hook;
+		context_ = context;
+		name_ = name;
+		target_ = target;
+		return true;
+	}
+
+private:
+	friend class CanBus;
+	friend class RxLease;
+
+	CanFrame* take_slot_();             // RX interrupt (FDCAN masked)
+	void give_slot_(CanFrame* frame);   // RX interrupt (FDCAN masked)
+	void release_(CanFrame* frame);
+
+	QueueHandle_t queue_ = nullptr;
+	const char* name_ = "";
+	RxTarget target_ = RxTarget::FIFO0;
+	volatile uint32_t frames_ = 0;
+	volatile uint32_t dropped_ = 0;
+
+	CanBus* bus_ = nullptr;
+	CanFrame** free_ = nullptr;
+	CanFrame* slots_ = nullptr;
+	volatile uint32_t free_count_ = 0;
+	uint32_t min_free_ = 0;
+	volatile uint32_t held_ = 0;
+
+	RxHook hook_ = nullptr;
+	void* context_ = nullptr;
+};
+
+template<size_t N>
+class RxRoute : public RxRouteBase {
+public:
+	RxRoute() = default;
+
+	bool create(const char* name, RxTarget target)
+	{
+		if (is_created()) {
+			return false;
+		}
+		return create_(storage_.create(), name, target);
+	}
+
+private:
+	freertos::TypedQueue<CanFrame, N> storage_;
+};
+
+template<size_t N>
+class RxLeaseRoute : public RxRouteBase {
+	static_assert(N > 0 && N <= 255, "RxLeaseRoute: N must be 1..255");
+
+public:
+	RxLeaseRoute() = default;
+
+	// FIFO targets only
+	bool create(const char* name, RxTarget target)
+	{
+		if (is_created() || target == RxTarget::BUFFER) {
+			return false;
+		}
+		return create_lease_(storage_.create(), slots_, free_, N, name, target);
+	}
+
+private:
+	freertos::TypedQueue<CanFrame*, N> storage_;
+	CanFrame slots_[N];
+	CanFrame* free_[N];
+};
+
+// Frames go to hook(context, frame, woken) in the RX interrupt instead
+// of a queue; receive() and read_lease() return nothing. The hook must
+// not block.
+class RxHookRoute : public RxRouteBase {
+public:
+	RxHookRoute() = default;
+
+	bool create(const char* name, RxTarget target, RxHook hook, void* context)
+	{
+		if (is_created()) {
+			return false;
+		}
+		return create_hook_(hook, context, name, target);
+	}
+};
+
+//=============================================================================
+// CanBus
+//=============================================================================
+
+struct CanBusStats {
+	uint32_t rx_irqs;           // RX FIFO / RX buffer callbacks
+	uint32_t rx_frames;         // frames read from message RAM
+	uint32_t rx_unrouted;       // accepted without a route (discarded)
+	uint32_t rx_lost;           // RX FIFO overflow reported by the controller
+	uint32_t tx_frames;         // frames handed to the TX FIFO/queue
+	uint32_t tx_full;           // send() refused, TX FIFO/queue full
+	uint32_t tx_waits;          // write()/write_many() slept for free elements
+	uint32_t tx_events;         // TX events queued
+	uint32_t tx_events_lost;    // TX Event FIFO overflow or event queue full
+	uint32_t rx_fifo_max[2];    // RX FIFO0/1 high-water mark (fill level at an interrupt)
+};
+
+class CanBus {
+public:
+	static constexpr int REJECT = -1;
+
+	CanBus() = default;
+	CanBus(const CanBus&) = delete;
+	CanBus& operator=(const CanBus&) = delete;
+
+	// Claims the handle and clears routes, filters and TX buffer
+	// reservations. The handle must be initialized and stopped; a
+	// different mode (FDCAN_MODE_*) or TX order re-runs HAL_FDCAN_Init()
+	// with it.
+	bool init(FDCAN_HandleTypeDef* hfdcan, uint32_t mode = FDCAN_MODE_NORMAL,
+		  TxOrder order = TxOrder::FIFO);
+
+	// Stops the bus and gives up the handle (another CanBus may claim it)
+	void deinit();
+
+	// Returns the route index for RxFilter, or -1 (table full, not created,
+	// an RX buffer target without dedicated buffers, or a FIFO owned by a
+	// lease route / a lease route on a FIFO already in use)
+	int add_route(RxRouteBase& route);
+
+	// One filter element; false when the hardware filter list is full.
+	// BUFFER routes take exact IDs only (std_id / ext_id).
+	bool add_filter(const RxFilter& filter);
+
+	// ID list packed two IDs per element
+	bool add_ids(int route, const uint32_t* ids, size_t count, bool ext = false);
+
+	// Destination of frames no filter matches (default REJECT, done by the
+	// controller). Must be a FIFO route.
+	bool set_non_matching(int route);
+
+	// Queue for TX events of FLAG_EVENT frames; before start(). false
+	// without TX Event FIFO elements (TxEventsNbr).
+	template<size_t N>
+	bool set_tx_events(freertos::TypedQueue<TxEvent, N>& queue)
+	{
+		return set_tx_events_(queue.handle());
+	}
+
+	// Reserves the next dedicated TX buffer for one ID; before start().
+	// Returns the buffer index, or -1 (no TX buffer left, ID out of range
+	// or already reserved, or no dedicated TX buffers on this FDCAN).
+	int add_tx_buffer(uint32_t id, bool ext = false);
+
+	// Monitor callbacks (nullptr: none); before start(). The tap must
+	// outlive the bus. Its error and status interrupts are enabled only
+	// with a tap set.
+	bool set_tap(const BusTap* tap);
+
+	// Protocol error interrupts on / off while started (error storms)
+	void set_error_its(bool on);
+
+	// Writes the filter RAM, enables the RX interrupts and starts the bus
+	bool start();
+	void stop();
+
+	bool is_started() const { return started_; }
+
+	// Non-blocking: false if the TX FIFO/queue (or the ID's TX buffer) is
+	// full or the bus is stopped
+	bool send(const CanFrame& frame);
+	bool send(uint32_t id, const void* data, uint8_t len, uint8_t flags = 0);
+
+	// Waits up to timeout for a free TX FIFO/queue element, or for the
+	// ID's TX buffer (task context)
+	bool write(const CanFrame& frame, TickType_t timeout = portMAX_DELAY);
+
+	// Queues frames in order; invalid frames are skipped, frames left at
+	// the timeout are not sent. results[i] (optional) gets the outcome of
+	// frames[i]. Returns the number of frames queued. The timeout covers
+	// the whole call. Task context.
+	size_t write_many(const CanFrame* frames, size_t count, TickType_t timeout = portMAX_DELAY,
+			  TxResult* results = nullptr);
+
+	// Frames in the TX FIFO/queue and reserved TX buffers not yet on the bus
+	uint32_t tx_pending() const;
+
+	// Frames waiting in an RX FIFO (held back for a lease route)
+	uint32_t fifo_level(RxTarget fifo) const;
+
+	uint32_t std_filters_used() const { return std_used_; }
+	uint32_t ext_filters_used() const { return ext_used_; }
+	uint32_t route_count() const { return route_count_; }
+	uint32_t tx_buffers_used() const;
+	RxRouteBase* route(int index) const;
+
+	CanBusStats stats() const;
+	void reset_stats();
+
+	// Queueing delay of the frames sent through one path, from the
+	// request to TX complete (us, includes the frame time). Reset with
+	// reset_stats().
+	Histogram tx_delay(TxPriority prio) const;
+
+	FDCAN_HandleTypeDef* handle() const { return hfdcan_; }
+
+private:
+	friend class RxRouteBase;
+
+	static CanBus* from_(FDCAN_HandleTypeDef* hfdcan);
+	static void rx_fifo0_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its);
+	static void rx_fifo1_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its);
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	static void rx_buffer_cb_(FDCAN_HandleTypeDef* hfdcan);
+#endif
+	static void tx_complete_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t indexes);
+	static void tx_event_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its);
+	static void error_cb_(FDCAN_HandleTypeDef* hfdcan);
+	static void error_status_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its);
+
+	bool set_tx_events_(QueueHandle_t queue);
+
+	void rx_fifo_(uint32_t fifo, uint32_t its);
+	void drain_fifo_(uint32_t fifo, BaseType_t* woken);
+	void resume_(RxTarget fifo);
+	void deliver_(const FDCAN_RxHeaderTypeDef& header, CanFrame& frame, BaseType_t* woken);
+	bool write_filters_();
+	bool put_(const CanFrame& frame);
+	bool wait_space_(size_t wanted, TickType_t start, TickType_t timeout);
+	int tx_buffer_(const CanFrame& frame) const;
+	bool wait_buffer_(int buffer, TickType_t start, TickType_t timeout);
+	void tx_done_(uint32_t indexes, BaseType_t* woken);
+	void tap_rx_(const FDCAN_RxHeaderTypeDef& header);
+
+	FDCAN_HandleTypeDef* hfdcan_ = nullptr;
+	bool started_ = false;
+
+	RxRouteBase* routes_[STM32ZERO_CANBUS_MAX_ROUTES] = {};
+	uint8_t route_count_ = 0;
+	int8_t non_matching_ = REJECT;
+	int8_t lease_[2] = { -1, -1 };      // lease route owning RX FIFO0/1
+	volatile uint8_t held_ = 0;         // FIFOs left undrained (bit per FIFO)
+
+	RxFilter std_filters_[STM32ZERO_CANBUS_MAX_STD_FILTERS];
+	RxFilter ext_filters_[STM32ZERO_CANBUS_MAX_EXT_FILTERS];
+	uint8_t std_used_ = 0;
+	uint8_t ext_used_ = 0;
+
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	uint8_t buffer_route_[STM32ZERO_CANBUS_MAX_RX_BUFFERS] = {};
+	uint8_t buffers_used_ = 0;
+#endif
+
+	volatile uint32_t rx_irqs_ = 0;
+	volatile uint32_t rx_frames_ = 0;
+	volatile uint32_t rx_unrouted_ = 0;
+	volatile uint32_t rx_lost_ = 0;
+	volatile uint32_t tx_frames_ = 0;
+	volatile uint32_t tx_full_ = 0;
+	volatile uint32_t tx_waits_ = 0;
+	volatile uint32_t tx_events_ = 0;
+	volatile uint32_t tx_events_lost_ = 0;
+	uint8_t rx_fifo_max_[2] = {};
+
+	QueueHandle_t tx_events_queue_ = nullptr;
+
+	// One writer sleeps at a time; the TX complete interrupt gives
+	// tx_space_ once tx_want_ elements are free
+	freertos::StaticMutex tx_gate_;
+	freertos::StaticBinarySemaphore tx_space_;
+	volatile uint8_t tx_want_ = 0;
+
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	// Reserved IDs (bit 31: extended) by TX buffer index. Writers of
+	// these IDs sleep apart from the FIFO writer: tx_buf_space_ is given
+	// when the TX buffer in tx_buf_want_ completes.
+	uint32_t tx_buf_ids_[STM32ZERO_CANBUS_MAX_TX_BUFFERS] = {};
+	uint8_t tx_buffers_used_ = 0;
+	freertos::StaticMutex tx_buf_gate_;
+	freertos::StaticBinarySemaphore tx_buf_space_;
+	volatile uint32_t tx_buf_want_ = 0;
+#endif
+
+	// Each pending TX element: request time (ustim, low 32 bits) and what
+	// the tap reports when it completes
+	struct TxSlot {
+		uint32_t queued_at;
+		uint32_t id;
+		uint8_t len;
+		uint8_t flags;
+	};
+	TxSlot tx_slots_[32] = {};
+	volatile uint32_t tx_inflight_ = 0;
+	Histogram tx_delay_[TX_PRIORITIES];
+
+	const BusTap* tap_ = nullptr;
+	// LEC / DLEC read by the status callback ahead of the error callback
+	// of the same interrupt (reading PSR resets them)
+	uint8_t lec_seen_[2] = {};
+};
+
+} // namespace fdcan
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
+
+#endif // __STM32ZERO_CANBUS_HPP__
@@ -0,0 +1,276 @@
+/**
+ * STM32ZERO CAN Bus Monitor
+ *
+ * Continuous health figures of one CanBus, for operation rather than
+ * bring-up:
+ *
+ *   - Bus load: bits on the wire per second, from the length and format
+ *     (FD, BRS, ID type) of every frame at the configured bit timing,
+ *     plus an estimate of the stuff bits (STM32ZERO_CANMON_STUFF_PERMILLE).
+ *   - TEC / REC: current, maximum and change per window.
+ *   - Protocol errors by last error code (stuff, form, ACK, bit1, bit0,
+ *     CRC), data phase errors apart; error warning / passive / bus-off
+ *     entries.
+ *   - Frame rates per watched ID (current and maximum per second), and
+ *     the RX FIFO high-water marks.
+ *
+ * The FDCAN interrupt only bumps counters (CanBus tap: a table lookup
+ * and a few adds per frame); a low-priority task turns them into rates
+ * once per window. A burst of protocol errors (a node without ACK, a
+ * wiring fault) would otherwise interrupt for every error frame: past
+ * error_budget errors in one window the error interrupt is masked until
+ * the next window and the window counts as a storm.
+ *
+ * In the loopback modes every received frame is the node's own, so only
+ * the transmitted copy is counted.
+ *
+ * report() and command() write the figures over sio; the application
+ * hands its console lines to command() ("canmon", "canmon ids",
+ * "canmon errors", "canmon reset").
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static CanMonitor<8> mon1;
+ *
+ *   bus1.init(&hfdcan1);
+ *   mon1.attach(bus1);                   // before bus1.start()
+ *   mon1.watch(0x100);
+ *   mon1.watch(0x18DA10F1, true);
+ *   bus1.start();
+ *   mon1.start("CANMON");                // Priority::LOW, 1 s windows
+ *
+ *   mon1.stats().load_permille;
+ *   mon1.command(line);                  // from the console task
+ */
+
+#ifndef __STM32ZERO_CANMON_HPP__
+#define __STM32ZERO_CANMON_HPP__
+
+#include "stm32zero-canbus.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// Stuff bits assumed per 1000 stuffable bits (0: none, 250: worst case;
+// random payloads average about 50)
+#ifndef STM32ZERO_CANMON_STUFF_PERMILLE
+#define STM32ZERO_CANMON_STUFF_PERMILLE  50
+#endif
+
+// Protocol error interrupts per window before they are masked (0: no limit)
+#ifndef STM32ZERO_CANMON_ERROR_BUDGET
+#define STM32ZERO_CANMON_ERROR_BUDGET  100
+#endif
+
+// Monitor task stack (words)
+#ifndef STM32ZERO_CANMON_STACK
+#define STM32ZERO_CANMON_STACK  256
+#endif
+
+namespace stm32zero {
+namespace canmon {
+
+// Last error codes FDCAN_PROTOCOL_ERROR_STUFF..CRC (1..6)
+enum class ErrorKind : uint8_t {
+	STUFF,
+	FORM,
+	ACK,
+	BIT1,
+	BIT0,
+	CRC_ERROR,                  // (CRC is the CMSIS peripheral macro)
+};
+
+constexpr size_t ERROR_KINDS = 6;
+
+struct MonitorStats {
+	uint32_t windows;           // windows aggregated since start / reset
+	uint16_t load_permille;     // bus load in the last window
+	uint16_t load_max_permille;
+	uint32_t rx_per_s;          // frames per second in the last window
+	uint32_t tx_per_s;
+	uint32_t rx_frames;         // since reset
+	uint32_t tx_frames;
+	uint32_t unwatched;         // frames of IDs not in the watch list
+
+	uint16_t tec;               // at the last window
+	uint16_t rec;
+	uint16_t tec_max;
+	uint16_t rec_max;
+	int16_t tec_delta;          // change over the last window
+	int16_t rec_delta;
+
+	uint32_t errors[ERROR_KINDS];       // protocol error interrupts by code
+	uint32_t errors_other;      // code already overwritten (NONE / NO_CHANGE)
+	uint32_t data_errors;       // of them in the data phase (PED)
+	uint32_t storms;            // windows with the error interrupt masked
+
+	uint32_t warnings;          // entries into error warning
+	uint32_t passives;          // entries into error passive
+	uint32_t bus_offs;
+	bool warning;               // current state
+	bool passive;
+	bool bus_off;
+
+	uint32_t rx_fifo_max[2];    // RX FIFO0/1 high-water mark (CanBus)
+};
+
+struct IdRate {
+	uint32_t id;
+	bool ext;
+	uint32_t frames;            // since reset
+	uint32_t per_s;             // in the last window
+	uint32_t max_per_s;
+};
+
+//=============================================================================
+// MonitorBase (ID table size independent part)
+//=============================================================================
+
+class MonitorBase {
+public:
+	MonitorBase(const MonitorBase&) = delete;
+	MonitorBase& operator=(const MonitorBase&) = delete;
+
+	// Sets the bus tap and reads the bit timing; the bus must be
+	// initialized (CanBus::init()) and not started
+	bool attach(fdcan::CanBus& bus);
+
+	// Adds an ID to the per-ID rates; before the bus starts. false when
+	// the table is full or the ID is already watched.
+	bool watch(uint32_t id, bool ext = false);
+
+	// Ask the task to exit and wait for it (task context)
+	void stop();
+	bool is_running() const { return running_; }
+
+	// Closes the current window now (the monitor task does this every
+	// window_ms; call it yourself only without the task)
+	void sample();
+
+	MonitorStats stats() const;
+	size_t id_count() const { return id_count_; }
+	IdRate id_rate(size_t index) const;
+	void reset_stats();
+
+	// Estimated bus time of one frame (ns), as counted into the load
+	uint32_t frame_ns(uint8_t len, uint8_t flags) const;
+
+	// Writes the summary over sio (task context)
+	void report() const;
+
+	// Console command: "canmon", "canmon ids", "canmon errors",
+	// "canmon reset". false if the line is not a canmon command.
+	bool command(const char* line);
+
+protected:
+	struct IdSlot {
+		uint32_t key;               // ID, bit 31: extended
+		volatile uint32_t frames;   // counted by the interrupt
+		uint32_t prev;              // frames at the last window
+		uint32_t per_s;
+		uint32_t max_per_s;
+	};
+
+	MonitorBase(IdSlot* ids, size_t capacity) : ids_(ids), capacity_(capacity) {}
+
+	bool prepare_(const char* name, uint32_t window_ms, uint32_t error_budget);
+	bool created_(TaskHandle_t task);
+
+	static void task_func_(void* param);
+
+	TaskHandle_t task_ = nullptr;
+
+private:
+	// Bus time of len payload bytes: base + len * byte (ns), per format;
+	// FD payloads over 16 bytes add the longer CRC
+	struct FrameTime {
+		uint32_t base_ns;
+		uint32_t byte_ns;
+		uint32_t crc21_ns;
+	};
+
+	static void frame_cb_(void* context, uint32_t id, uint8_t len, uint8_t flags, bool tx);
+	static void error_cb_(void* context, uint32_t code, bool data_phase);
+	static void status_cb_(void* context, uint32_t its, bool warning, bool passive, bool bus_off);
+
+	void run_();
+	int find_(uint32_t key) const;
+	void write_ids_() const;
+	void write_errors_() const;
+
+	fdcan::CanBus* bus_ = nullptr;
+	fdcan::BusTap tap_ = {};
+	FrameTime time_[8] = {};            // by CanFrame::FLAG_EXT | FD | BRS
+	bool echo_ = false;                 // loopback: RX frames are our own
+
+	IdSlot* const ids_;
+	const size_t capacity_;
+	size_t id_count_ = 0;
+
+	const char* name_ = "CANMON";
+	uint32_t window_ms_ = 1000;
+	uint32_t error_budget_ = STM32ZERO_CANMON_ERROR_BUDGET;
+	volatile bool stop_ = false;
+	volatile bool running_ = false;
+
+	// Counted in the FDCAN interrupt
+	volatile uint32_t rx_frames_ = 0;
+	volatile uint32_t tx_frames_ = 0;
+	volatile uint32_t unwatched_ = 0;
+	volatile uint32_t busy_ns_ = 0;     // free running, wraps after 4.29 s of traffic
+	volatile uint32_t errors_[ERROR_KINDS] = {};
+	volatile uint32_t errors_other_ = 0;
+	volatile uint32_t data_errors_ = 0;
+	volatile uint32_t window_errors_ = 0;
+	volatile bool masked_ = false;
+	volatile uint32_t storms_ = 0;
+	volatile uint32_t warnings_ = 0;
+	volatile uint32_t passives_ = 0;
+	volatile uint32_t bus_offs_ = 0;
+	volatile bool warning_ = false;
+	volatile bool passive_ = false;
+	volatile bool bus_off_ = false;
+
+	// Aggregated by sample()
+	uint64_t last_us_ = 0;
+	uint32_t prev_rx_ = 0;
+	uint32_t prev_tx_ = 0;
+	uint32_t prev_busy_ns_ = 0;
+	MonitorStats stats_ = {};
+};
+
+//=============================================================================
+// CanMonitor
+//=============================================================================
+
+template<size_t MaxIds, size_t StackWords = STM32ZERO_CANMON_STACK>
+class CanMonitor : public MonitorBase {
+	static_assert(MaxIds > 0, "CanMonitor: MaxIds must be > 0");
+
+public:
+	CanMonitor() : MonitorBase(ids_storage_, MaxIds) {}
+
+	// Aggregates every window_ms (1..4000) after attach(); false if
+	// already running or not attached
+	bool start(const char* name, freertos::Priority priority = freertos::Priority::LOW,
+		   uint32_t window_ms = 1000, uint32_t error_budget = STM32ZERO_CANMON_ERROR_BUDGET)
+	{
+		if (!prepare_(name, window_ms, error_budget)) {
+			return false;
+		}
+		return created_(task_obj_.create(task_func_, name, priority, static_cast<MonitorBase*>(this)));
+	}
+
+private:
+	IdSlot ids_storage_[MaxIds] = {};
+	freertos::StaticTask<StackWords> task_obj_;
+};
+
+} // namespace canmon
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
+
+#endif // __STM32ZERO_CANMON_HPP__
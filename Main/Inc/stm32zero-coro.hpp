@@ -0,0 +1,368 @@
+/**
+ * STM32ZERO Cooperative Flows (stackless coroutines)
+ *
+ * Many mostly-waiting state machines share one StaticTask. Each flow is a
+ * small object whose resume() runs until it has to wait, then returns; the
+ * flow's "frame" is the object itself, allocated from an ObjectPool.
+ *
+ * The project builds as C++17 (no C++20 coroutines), so flows are written
+ * as resumable functions with the CO_* macros (switch-based, like
+ * protothreads). Variables that must survive a wait are members, not
+ * locals, and CO_* must not be used inside a nested switch.
+ *
+ *   class Blink : public coro::Flow {
+ *       coro::Deadline dl_;
+ *       int n_ = 0;
+ *   public:
+ *       Status resume() override {
+ *           CO_BEGIN();
+ *           for (n_ = 0; n_ < 10; n_++) {
+ *               toggle();
+ *               CO_SLEEP_US(dl_, 500000);
+ *           }
+ *           CO_END();
+ *       }
+ *   };
+ *
+ *   STM32ZERO_DTCM static ObjectPool<Blink, 4> blink_pool;
+ *   STM32ZERO_DTCM static coro::Executor<16, 512> exec;
+ *   exec.start("CORO", Priority::NORMAL);
+ *   exec.spawn(blink_pool.make());
+ *
+ * Waits (inside resume(), as CO_AWAIT conditions):
+ *   expired(dl)              ustim deadline (coro::Deadline)
+ *   signaled(sig)            coro::Signal set from a task or ISR
+ *   receive(queue, item)     TypedQueue<T, N> item
+ *   sio_read(buf, len, n)    bytes from sio
+ *   can_read(can, msg)       frame from fdcan::Fdcan
+ * Conditions combine, e.g. CO_AWAIT(receive(q, v) || expired(timeout)).
+ *
+ * Deadlines, signals and queues wake the executor directly: the first
+ * receive() on a TypedQueue binds it to the executor task (set_reader()),
+ * so every send gives the executor's notification. sio and FDCAN reads
+ * have no RX hook to notify through and are polled every
+ * STM32ZERO_CORO_POLL_TICKS while pending; a producer can call
+ * Executor::wake() to skip the poll delay. The executor task uses its
+ * notification value as a wake-up counter, so a queue bound to it must
+ * not also be read by another executor.
+ */
+
+#ifndef __STM32ZERO_CORO_HPP__
+#define __STM32ZERO_CORO_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-pool.hpp"
+#include "stm32zero-typedqueue.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-sio.hpp"
+#if defined(HAL_FDCAN_MODULE_ENABLED)
+#include "stm32zero-fdcan.hpp"
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Poll interval (ticks) while a flow waits on sio / FDCAN
+#ifndef STM32ZERO_CORO_POLL_TICKS
+#define STM32ZERO_CORO_POLL_TICKS  1
+#endif
+
+//=============================================================================
+// Flow Macros
+//=============================================================================
+
+#define CO_BEGIN() \
+	switch (this->resume_point_) { \
+	case 0:
+
+// Return until cond is true (cond is re-evaluated on every resume)
+#define CO_AWAIT(cond) \
+	do { \
+		this->resume_point_ = __LINE__; \
+		[[fallthrough]]; \
+	case __LINE__: \
+		if (!(cond)) { \
+			return Status::PENDING; \
+		} \
+	} while (0)
+
+// Let other flows run once
+#define CO_YIELD() \
+	do { \
+		this->resume_point_ = __LINE__; \
+		this->yield_(); \
+		return Status::PENDING; \
+	case __LINE__:; \
+	} while (0)
+
+#define CO_SLEEP_US(deadline, us) \
+	do { \
+		(deadline).start(us); \
+		CO_AWAIT(this->expired(deadline)); \
+	} while (0)
+
+#define CO_END() \
+	} \
+	this->resume_point_ = 0; \
+	return Status::DONE
+
+namespace stm32zero {
+namespace coro {
+
+//=============================================================================
+// Deadline
+//=============================================================================
+
+struct Deadline {
+	uint64_t at_us = 0;
+
+	void start(uint64_t us) { at_us = ustim::get() + us; }
+	bool is_expired() const { return ustim::get() >= at_us; }
+};
+
+//=============================================================================
+// Signal (task/ISR -> flow)
+//=============================================================================
+
+class ExecutorBase;
+
+class Signal {
+public:
+	void set();
+	void set_from_isr(BaseType_t* woken = nullptr);
+
+	// Consume the signal (true if it was set)
+	bool take()
+	{
+		CriticalSection cs;
+		bool was = set_;
+		set_ = false;
+		return was;
+	}
+
+private:
+	friend class ExecutorBase;
+	friend class Flow;
+
+	volatile bool set_ = false;
+	ExecutorBase* exec_ = nullptr;
+};
+
+//=============================================================================
+// Flow
+//=============================================================================
+
+class Flow {
+public:
+	enum class Status : uint8_t {
+		PENDING,
+		DONE,
+	};
+
+	virtual ~Flow() = default;
+
+	// Run until the next wait; DONE frees the flow
+	virtual Status resume() = 0;
+
+protected:
+	// Wait conditions: record when the executor has to look again
+
+	bool expired(const Deadline& dl)
+	{
+		if (dl.is_expired()) {
+			return true;
+		}
+		if (dl.at_us < wake_at_us_) {
+			wake_at_us_ = dl.at_us;
+		}
+		return false;
+	}
+
+	bool signaled(Signal& sig);
+
+	template<typename T, size_t N>
+	bool receive(freertos::TypedQueue<T, N>& queue, T& item);
+
+	// n = bytes read (> 0 on success)
+	bool sio_read(void* buf, size_t len, int& n)
+	{
+		IoResult r = sio::read(buf, len);
+		n = r.count;
+		if (r.is_ok() && n > 0) {
+			return true;
+		}
+		poll_ = true;
+		return false;
+	}
+
+#if defined(HAL_FDCAN_MODULE_ENABLED)
+	bool can_read(fdcan::Fdcan& can, fdcan::RxMessage& msg)
+	{
+		if (can.read(&msg, 0).is_ok()) {
+			return true;
+		}
+		poll_ = true;
+		return false;
+	}
+#endif
+
+	void yield_() { wake_at_us_ = 0; }
+
+	uint16_t resume_point_ = 0;
+
+private:
+	friend class ExecutorBase;
+
+	uint64_t wake_at_us_ = UINT64_MAX;
+	bool poll_ = false;
+	ExecutorBase* exec_ = nullptr;
+};
+
+//=============================================================================
+// ExecutorBase (capacity-independent part)
+//=============================================================================
+
+class ExecutorBase {
+public:
+	void wake();
+	void wake_from_isr(BaseType_t* woken = nullptr);
+
+	// Flows currently spawned
+	size_t active() const { return active_; }
+	size_t min_free() const { return min_free_; }
+
+	// Executor passes / flow resumes since start
+	uint32_t passes() const { return passes_; }
+	uint32_t resumes() const { return resumes_; }
+
+	TaskHandle_t task() const { return task_; }
+
+	// Executor bytes per flow slot (RAM accounting)
+	static constexpr size_t slot_size() { return sizeof(Slot); }
+
+	// Signals set before a flow waits on them wake this executor
+	void bind(Signal& sig) { sig.exec_ = this; }
+
+protected:
+	struct Slot {
+		Flow* flow;
+		void (*drop)(void*);
+		alignas(void*) uint8_t owner[2 * sizeof(void*)];   // PoolPtr<T>
+	};
+
+	static_assert(sizeof(PoolPtr<Flow>) == 2 * sizeof(void*), "PoolPtr layout");
+
+	template<typename T>
+	bool spawn_(Slot* slots, size_t n, PoolPtr<T>&& ptr)
+	{
+		static_assert(std::is_base_of<Flow, T>::value, "spawn: T must derive from coro::Flow");
+
+		if (!ptr) {
+			return false;
+		}
+
+		{
+			CriticalSection cs;
+			Slot* slot = nullptr;
+			for (size_t i = 0; i < n; i++) {
+				if (slots[i].flow == nullptr) {
+					slot = &slots[i];
+					break;
+				}
+			}
+			if (slot == nullptr) {
+				return false;
+			}
+
+			T* flow = ptr.get();
+			flow->exec_ = this;
+			new (slot->owner) PoolPtr<T>(std::move(ptr));
+			slot->drop = [](void* owner) { static_cast<PoolPtr<T>*>(owner)->~PoolPtr<T>(); };
+			slot->flow = flow;
+			active_++;
+			if (n - active_ < min_free_) {
+				min_free_ = n - active_;
+			}
+		}
+
+		wake();
+		return true;
+	}
+
+	// One pass over all flows; returns ticks to block
+	TickType_t run_pass_(Slot* slots, size_t n);
+
+	[[noreturn]] void run_(Slot* slots, size_t n);
+
+	TaskHandle_t task_ = nullptr;
+	volatile size_t active_ = 0;
+	size_t min_free_ = 0;
+	uint32_t passes_ = 0;
+	uint32_t resumes_ = 0;
+};
+
+inline bool Flow::signaled(Signal& sig)
+{
+	if (sig.exec_ == nullptr) {
+		exec_->bind(sig);       // first wait binds the signal
+	}
+	return sig.take();
+}
+
+template<typename T, size_t N>
+inline bool Flow::receive(freertos::TypedQueue<T, N>& queue, T& item)
+{
+	// Bind before reading, so a send right after an empty read still wakes
+	if (queue.reader() == nullptr) {
+		queue.set_reader(exec_->task());
+	}
+	return queue.receive(item, 0);
+}
+
+//=============================================================================
+// Executor
+//=============================================================================
+
+template<size_t MaxFlows, size_t StackWords>
+class Executor : public ExecutorBase {
+	static_assert(MaxFlows > 0, "Executor: MaxFlows must be > 0");
+
+public:
+	bool start(const char* name, freertos::Priority priority)
+	{
+		for (auto& s : slots_) {
+			s.flow = nullptr;
+		}
+		min_free_ = MaxFlows;
+		task_ = task_obj_.create(task_func_, name, priority, this);
+		return task_ != nullptr;
+	}
+
+	// Take ownership of a pooled flow; false if empty or no free slot
+	template<typename T>
+	bool spawn(PoolPtr<T>&& flow)
+	{
+		return spawn_(slots_, MaxFlows, std::move(flow));
+	}
+
+	static constexpr size_t capacity() { return MaxFlows; }
+	static constexpr size_t stack_words() { return StackWords; }
+
+private:
+	static void task_func_(void* param)
+	{
+		Executor* self = static_cast<Executor*>(param);
+		self->run_(self->slots_, MaxFlows);
+	}
+
+	freertos::StaticTask<StackWords> task_obj_;
+	Slot slots_[MaxFlows] = {};
+};
+
+} // namespace coro
+} // namespace stm32zero
+
+#endif // __STM32ZERO_CORO_HPP__
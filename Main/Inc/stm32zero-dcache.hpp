@@ -0,0 +1,68 @@
+/**
+ * STM32ZERO D-Cache Maintenance Helpers
+ *
+ * Range-based clean/invalidate wrappers that round to cache lines, plus a
+ * cacheability check matching the board MPU setup. On cores without a
+ * D-cache (e.g. Cortex-M33) every function is a no-op.
+ *
+ *   clean()            CPU wrote, DMA will read
+ *   invalidate()       DMA wrote, CPU will read
+ *   clean_invalidate() before DMA writes a buffer the CPU may have dirtied
+ */
+
+#ifndef __STM32ZERO_DCACHE_HPP__
+#define __STM32ZERO_DCACHE_HPP__
+
+#include "stm32zero.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace stm32zero {
+namespace dcache {
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+
+// AXI SRAM (D1) and SRAM4 (D3) are write-back cacheable; DTCM is not cached,
+// SRAM1-3 are made non-cacheable by the MPU (see board README) and Flash
+// is never dirty.
+inline bool is_cacheable(const void* addr)
+{
+	uintptr_t a = reinterpret_cast<uintptr_t>(addr);
+	return (a >= 0x24000000U && a < 0x24080000U) ||
+	       (a >= 0x38000000U && a < 0x38010000U);
+}
+
+inline void clean(const volatile void* addr, size_t n)
+{
+	uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(uintptr_t)(cache_line_size - 1);
+	uintptr_t end = reinterpret_cast<uintptr_t>(addr) + n;
+	SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(start), static_cast<int32_t>(end - start));
+}
+
+inline void invalidate(const volatile void* addr, size_t n)
+{
+	uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(uintptr_t)(cache_line_size - 1);
+	uintptr_t end = reinterpret_cast<uintptr_t>(addr) + n;
+	SCB_InvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(start), static_cast<int32_t>(end - start));
+}
+
+inline void clean_invalidate(const volatile void* addr, size_t n)
+{
+	uintptr_t start = reinterpret_cast<uintptr_t>(addr) & ~(uintptr_t)(cache_line_size - 1);
+	uintptr_t end = reinterpret_cast<uintptr_t>(addr) + n;
+	SCB_CleanInvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(start), static_cast<int32_t>(end - start));
+}
+
+#else
+
+inline bool is_cacheable(const void*) { return false; }
+inline void clean(const volatile void*, size_t) {}
+inline void invalidate(const volatile void*, size_t) {}
+inline void clean_invalidate(const volatile void*, size_t) {}
+
+#endif
+
+} // namespace dcache
+} // namespace stm32zero
+
+#endif // __STM32ZERO_DCACHE_HPP__
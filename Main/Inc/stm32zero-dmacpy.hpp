@@ -0,0 +1,130 @@
+/**
+ * STM32ZERO Asynchronous DMA memcpy (MDMA)
+ *
+ * Offloads large memory-to-memory copies to the H7 MDMA so the CPU is
+ * free while data moves between AXI SRAM, DTCM, SRAM1-4 and Flash.
+ *
+ *   - Requests are queued (STM32ZERO_DMACPY_QUEUE_LEN) and executed in order
+ *   - Copies below STM32ZERO_DMACPY_THRESHOLD bytes fall back to memcpy()
+ *   - Cacheable endpoints (AXI SRAM, SRAM4) get D-cache maintenance
+ *   - Completion is reported by callback (ISR context) and DmaCopyFuture
+ *
+ * Destination buffers in cacheable memory must not share cache lines with
+ * data the CPU writes during the transfer (use DmaBuffer or cache_align()).
+ *
+ * Usage:
+ *   dmacpy::init();
+ *   auto f = dma_memcpy_async(dst, src, 16384);
+ *   ...                    // CPU does other work
+ *   f.wait(100);           // block task until the copy is done
+ */
+
+#ifndef __STM32ZERO_DMACPY_HPP__
+#define __STM32ZERO_DMACPY_HPP__
+
+#include "stm32zero.hpp"
+
+#if defined(MDMA)
+
+#include "FreeRTOS.h"
+#include <cstddef>
+#include <cstdint>
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// Copies smaller than this are done with memcpy() in the caller
+#ifndef STM32ZERO_DMACPY_THRESHOLD
+#define STM32ZERO_DMACPY_THRESHOLD  256
+#endif
+
+// Maximum number of queued (pending + active) requests
+#ifndef STM32ZERO_DMACPY_QUEUE_LEN
+#define STM32ZERO_DMACPY_QUEUE_LEN  8
+#endif
+
+// MDMA interrupt priority (must be >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+#ifndef STM32ZERO_DMACPY_IRQ_PRIORITY
+#define STM32ZERO_DMACPY_IRQ_PRIORITY  5
+#endif
+
+namespace stm32zero {
+
+// Completion callback, called from the MDMA ISR (or the caller for CPU copies)
+using DmaCopyCallback = void (*)(void* arg);
+
+//=============================================================================
+// DmaCopyFuture
+//=============================================================================
+
+class DmaCopyFuture {
+public:
+	DmaCopyFuture() : slot_(INVALID), seq_(0) {}
+
+	// false if the request was rejected (queue full, not initialized)
+	bool is_valid() const { return slot_ != INVALID; }
+
+	// true once the copy has finished (always true for CPU fallback)
+	bool is_done() const;
+
+	// Block the calling task until done. Returns false on timeout.
+	bool wait(TickType_t timeout = portMAX_DELAY) const;
+
+private:
+	friend DmaCopyFuture dma_memcpy_async(void*, const void*, size_t,
+					      DmaCopyCallback, void*);
+
+	static constexpr uint8_t INVALID = 0xFF;
+	static constexpr uint8_t COMPLETED = 0xFE;
+
+	DmaCopyFuture(uint8_t slot, uint32_t seq) : slot_(slot), seq_(seq) {}
+
+	uint8_t slot_;
+	uint32_t seq_;
+};
+
+//=============================================================================
+// API
+//=============================================================================
+
+/**
+ * Queue an asynchronous copy of n bytes from src to dst.
+ *
+ * Copies below STM32ZERO_DMACPY_THRESHOLD are done immediately with
+ * memcpy() and return an already-completed future. Returns an invalid
+ * future when the queue is full.
+ */
+DmaCopyFuture dma_memcpy_async(void* dst, const void* src, size_t n,
+			       DmaCopyCallback callback = nullptr, void* arg = nullptr);
+
+namespace dmacpy {
+
+// Enable MDMA clock/IRQ and create completion semaphores (call before use)
+void init();
+
+// True if addr lies in memory cached by the D-cache (per MPU configuration)
+bool is_cacheable(const void* addr);
+
+// Number of requests queued or in flight
+size_t pending();
+
+// Statistics
+struct Stats {
+	uint32_t dma_copies;      // completed MDMA requests
+	uint32_t cpu_copies;      // requests below threshold (memcpy)
+	uint32_t rejected;        // queue full
+	uint32_t errors;          // MDMA transfer errors
+	uint64_t dma_bytes;
+	uint64_t cpu_bytes;
+};
+
+const Stats& stats();
+
+} // namespace dmacpy
+
+} // namespace stm32zero
+
+#endif // MDMA
+
+#endif // __STM32ZERO_DMACPY_HPP__
@@ -0,0 +1,211 @@
+/**
+ * STM32ZERO FreeRTOS Event Group
+ *
+ * Statically allocated event group with typed flags, in the style of
+ * stm32zero-freertos.hpp. Flags are an enum (class) whose values are single
+ * bits; combinations are passed as an initializer list:
+ *
+ *   enum class SpiEvent : EventBits_t {
+ *       DMA_DONE    = 1 << 0,
+ *       CS_RELEASED = 1 << 1,
+ *       ERROR       = 1 << 2,
+ *   };
+ *
+ *   STM32ZERO_DTCM static StaticEventGroup<SpiEvent> spi_events;
+ *   spi_events.create();
+ *
+ *   // DMA ISR
+ *   spi_events.set_from_isr(SpiEvent::DMA_DONE, &woken);
+ *
+ *   // task: "DMA done AND CS released"
+ *   if (spi_events.wait_all({ SpiEvent::DMA_DONE, SpiEvent::CS_RELEASED }, pdMS_TO_TICKS(10))) { ... }
+ *
+ * set_from_isr() is deferred to the timer service task (the kernel cannot
+ * walk the waiter list from an ISR). Bits set by several interrupts before
+ * the timer task runs are merged and posted as one timer-queue entry, so a
+ * burst of interrupts costs a single xEventGroupSetBits() call and cannot
+ * overflow the timer command queue.
+ *
+ * Only the low 24 bits are usable (configUSE_16_BIT_TICKS == 0).
+ */
+
+#ifndef __STM32ZERO_EVENTGROUP_HPP__
+#define __STM32ZERO_EVENTGROUP_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-masklock.hpp"
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "timers.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#if (configUSE_TIMERS != 1) || (INCLUDE_xTimerPendFunctionCall != 1)
+#error "StaticEventGroup requires configUSE_TIMERS and INCLUDE_xTimerPendFunctionCall"
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// EventFlags (typed bit set)
+//=============================================================================
+
+template<typename Flag>
+class EventFlags {
+public:
+	static constexpr EventBits_t USABLE_BITS = 0x00FFFFFFU;
+
+	constexpr EventFlags() : bits_(0) {}
+	constexpr EventFlags(Flag flag) : bits_(static_cast<EventBits_t>(flag)) {}
+	constexpr EventFlags(std::initializer_list<Flag> flags) : bits_(0)
+	{
+		for (Flag f : flags) {
+			bits_ |= static_cast<EventBits_t>(f);
+		}
+	}
+
+	static constexpr EventFlags from_bits(EventBits_t bits) { return EventFlags(bits, 0); }
+
+	constexpr EventBits_t bits() const { return bits_; }
+	constexpr bool empty() const { return bits_ == 0; }
+	constexpr bool has(EventFlags other) const { return (bits_ & other.bits_) == other.bits_ && other.bits_ != 0; }
+	constexpr bool has_any(EventFlags other) const { return (bits_ & other.bits_) != 0; }
+
+	constexpr explicit operator bool() const { return bits_ != 0; }
+
+	constexpr EventFlags operator|(EventFlags other) const { return from_bits(bits_ | other.bits_); }
+	constexpr EventFlags operator&(EventFlags other) const { return from_bits(bits_ & other.bits_); }
+	constexpr bool operator==(EventFlags other) const { return bits_ == other.bits_; }
+	constexpr bool operator!=(EventFlags other) const { return bits_ != other.bits_; }
+
+private:
+	constexpr EventFlags(EventBits_t bits, int) : bits_(bits) {}
+
+	EventBits_t bits_;
+};
+
+//=============================================================================
+// StaticEventGroup
+//=============================================================================
+
+template<typename Flag = EventBits_t>
+class StaticEventGroup {
+public:
+	using Flags = EventFlags<Flag>;
+
+	EventGroupHandle_t create()
+	{
+		pending_isr_ = 0;
+		isr_posted_ = false;
+		handle_ = xEventGroupCreateStatic(&cb_);
+		return handle_;
+	}
+
+	bool is_created() const { return handle_ != nullptr; }
+	EventGroupHandle_t handle() const { return handle_; }
+
+	// Returns the flags at the time the call returns
+	Flags set(Flags flags)
+	{
+		configASSERT((flags.bits() & ~Flags::USABLE_BITS) == 0);
+		return Flags::from_bits(xEventGroupSetBits(handle_, flags.bits()));
+	}
+
+	// Returns the flags before clearing
+	Flags clear(Flags flags)
+	{
+		return Flags::from_bits(xEventGroupClearBits(handle_, flags.bits()));
+	}
+
+	Flags get() const { return Flags::from_bits(xEventGroupGetBits(handle_)); }
+	Flags get_from_isr() const { return Flags::from_bits(xEventGroupGetBitsFromISR(handle_)); }
+
+	/**
+	 * Set flags from an ISR via the timer service task.
+	 * Returns false if the timer queue was full: the flags stay pending and
+	 * are delivered with the next successful set_from_isr() or flush().
+	 */
+	bool set_from_isr(Flags flags, BaseType_t* woken = nullptr)
+	{
+		configASSERT((flags.bits() & ~Flags::USABLE_BITS) == 0);
+
+		bool post;
+		{
+			MaskLock lock;
+			pending_isr_ |= flags.bits();
+			isr_sets_++;
+			post = !isr_posted_;
+			isr_posted_ = true;
+		}
+
+		if (!post) {
+			return true;        // merged into the queued flush
+		}
+
+		if (xTimerPendFunctionCallFromISR(flush_callback_, this, 0, woken) != pdPASS) {
+			MaskLock lock;
+			isr_posted_ = false;
+			return false;
+		}
+		isr_posts_++;
+		return true;
+	}
+
+	// Apply flags pending from set_from_isr() now (task context)
+	void flush()
+	{
+		EventBits_t bits;
+		{
+			CriticalSection cs;
+			bits = pending_isr_;
+			pending_isr_ = 0;
+			isr_posted_ = false;
+		}
+		if (bits != 0) {
+			xEventGroupSetBits(handle_, bits);
+		}
+	}
+
+	/**
+	 * Wait until all flags are set. Returns the flags on success, empty on
+	 * timeout. Waited flags are cleared on success if clear is true.
+	 */
+	Flags wait_all(Flags flags, TickType_t timeout = portMAX_DELAY, bool clear = true)
+	{
+		EventBits_t got = xEventGroupWaitBits(handle_, flags.bits(),
+						      clear ? pdTRUE : pdFALSE, pdTRUE, timeout);
+		return ((got & flags.bits()) == flags.bits()) ? flags : Flags();
+	}
+
+	// Wait until any flag is set. Returns the matched flags, empty on timeout.
+	Flags wait_any(Flags flags, TickType_t timeout = portMAX_DELAY, bool clear = true)
+	{
+		EventBits_t got = xEventGroupWaitBits(handle_, flags.bits(),
+						      clear ? pdTRUE : pdFALSE, pdFALSE, timeout);
+		return Flags::from_bits(got & flags.bits());
+	}
+
+	// Batching statistics: ISR calls vs timer-queue entries
+	uint32_t isr_sets() const { return isr_sets_; }
+	uint32_t isr_posts() const { return isr_posts_; }
+
+private:
+	static void flush_callback_(void* self, uint32_t)
+	{
+		static_cast<StaticEventGroup*>(self)->flush();
+	}
+
+	StaticEventGroup_t cb_;
+	EventGroupHandle_t handle_ = nullptr;
+	volatile EventBits_t pending_isr_ = 0;
+	volatile bool isr_posted_ = false;
+	volatile uint32_t isr_sets_ = 0;
+	volatile uint32_t isr_posts_ = 0;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_EVENTGROUP_HPP__
@@ -0,0 +1,244 @@
+/**
+ * STM32ZERO Dual-Channel CAN Gateway
+ *
+ * Forwards frames between two CanBus instances (bus A and bus B) in the
+ * FDCAN RX interrupt, with no task in the path:
+ *
+ *   - Routing table: one Rule per forwarded ID and direction, with an
+ *     optional new ID on the destination bus and an optional rate limit
+ *     (minimum spacing of forwarded frames, on the RX timestamps).
+ *   - The table is built and sorted at compile time (make_table()); the
+ *     interrupt finds a rule by binary search, O(log N), from flash.
+ *   - attach() adds a hook route on each source bus and hardware filters
+ *     for exactly the table's IDs, so other traffic never interrupts.
+ *   - Per-rule counters: forwarded, rate limited, dropped (destination TX
+ *     FIFO full or bus stopped). Nothing is queued in software, so a frame
+ *     is either in the destination TX FIFO or counted as dropped.
+ *
+ * Payload, length and FD/BRS format are kept; the ID may change but not
+ * its type (11/29 bit). Both buses must be able to carry the frames (FD
+ * frames need an FD destination).
+ *
+ * Usage:
+ *   using namespace stm32zero::gateway;
+ *
+ *   static constexpr auto ROUTES = make_table({
+ *       Rule::std_id(Dir::A_TO_B, 0x100),                  // as is
+ *       Rule::std_id(Dir::A_TO_B, 0x101, 0x301),           // rewritten
+ *       Rule::std_id(Dir::A_TO_B, 0x102, Rule::SAME_ID, 10000), // <= 100/s
+ *       Rule::ext_id(Dir::B_TO_A, 0x18DA10F1, 0x18DAF110),
+ *   });
+ *   static_assert(ROUTES.valid(), "gateway table: duplicate or bad ID");
+ *
+ *   STM32ZERO_DTCM static Gateway<ROUTES.size()> gw;
+ *
+ *   bus1.init(&hfdcan1);
+ *   bus2.init(&hfdcan2);
+ *   gw.attach(ROUTES, bus1, bus2);       // before start()
+ *   bus1.start();
+ *   bus2.start();
+ *
+ *   gw.rule_stats(ROUTES.find(Dir::A_TO_B, false, 0x102)).limited;
+ */
+
+#ifndef __STM32ZERO_GATEWAY_HPP__
+#define __STM32ZERO_GATEWAY_HPP__
+
+#include "stm32zero-canbus.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+namespace stm32zero {
+namespace gateway {
+
+//=============================================================================
+// Routing Table
+//=============================================================================
+
+enum class Dir : uint8_t {
+	A_TO_B,
+	B_TO_A,
+};
+
+// Sort / search key: direction, ID type, ID
+constexpr uint64_t key_of(Dir dir, bool ext, uint32_t id)
+{
+	return (static_cast<uint64_t>(dir) << 33) | (static_cast<uint64_t>(ext) << 32) | id;
+}
+
+struct Rule {
+	static constexpr uint32_t SAME_ID = 0xFFFFFFFFU;
+
+	uint32_t id;                // ID on the source bus
+	uint32_t new_id;            // ID on the destination bus, SAME_ID keeps it
+	uint32_t min_gap_us;        // rate limit: spacing of forwarded frames (0: none)
+	Dir dir;
+	bool ext;                   // 29-bit identifiers
+
+	static constexpr Rule std_id(Dir dir, uint32_t id, uint32_t new_id = SAME_ID, uint32_t min_gap_us = 0)
+	{
+		return { id, new_id, min_gap_us, dir, false };
+	}
+
+	static constexpr Rule ext_id(Dir dir, uint32_t id, uint32_t new_id = SAME_ID, uint32_t min_gap_us = 0)
+	{
+		return { id, new_id, min_gap_us, dir, true };
+	}
+
+	constexpr uint64_t key() const { return key_of(dir, ext, id); }
+	constexpr uint32_t out_id() const { return new_id == SAME_ID ? id : new_id; }
+};
+
+// Index of the rule with key in a table sorted by key(), or -1
+constexpr int find_rule(const Rule* rules, size_t count, uint64_t key)
+{
+	size_t lo = 0;
+	size_t hi = count;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		uint64_t k = rules[mid].key();
+		if (k == key) {
+			return static_cast<int>(mid);
+		}
+		if (k < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return -1;
+}
+
+template<size_t N>
+struct Table {
+	static_assert(N > 0, "gateway::Table: no rules");
+
+	Rule rules[N];
+
+	static constexpr size_t size() { return N; }
+
+	constexpr int find(Dir dir, bool ext, uint32_t id) const
+	{
+		return find_rule(rules, N, key_of(dir, ext, id));
+	}
+
+	// Sorted without duplicates, IDs and new IDs in range of their type
+	constexpr bool valid() const
+	{
+		for (size_t i = 0; i < N; i++) {
+			uint32_t id_max = rules[i].ext ? 0x1FFFFFFFU : 0x7FFU;
+			if (rules[i].id > id_max || rules[i].out_id() > id_max) {
+				return false;
+			}
+			if (i > 0 && rules[i - 1].key() >= rules[i].key()) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// Rules sorted by direction, ID type and ID (insertion sort, compile time)
+template<size_t N>
+constexpr Table<N> make_table(const Rule (&rules)[N])
+{
+	Table<N> table = {};
+	for (size_t i = 0; i < N; i++) {
+		Rule r = rules[i];
+		size_t j = i;
+		while (j > 0 && table.rules[j - 1].key() > r.key()) {
+			table.rules[j] = table.rules[j - 1];
+			j--;
+		}
+		table.rules[j] = r;
+	}
+	return table;
+}
+
+//=============================================================================
+// Gateway
+//=============================================================================
+
+struct RuleStats {
+	uint32_t forwarded;         // handed to the destination TX FIFO
+	uint32_t limited;           // within min_gap_us of the previous one
+	uint32_t dropped;           // destination TX FIFO full or bus stopped
+};
+
+struct GatewayStats {
+	uint32_t forwarded;
+	uint32_t limited;
+	uint32_t dropped;
+	uint32_t unmatched;         // reached a gateway route without a rule
+};
+
+class GatewayBase {
+public:
+	GatewayBase(const GatewayBase&) = delete;
+	GatewayBase& operator=(const GatewayBase&) = delete;
+
+	bool is_attached() const { return rules_ != nullptr; }
+
+	size_t rule_count() const { return count_; }
+	const Rule& rule(size_t index) const { return rules_[index]; }
+
+	// Counters of rule index (Table::find()); zero for an invalid index
+	RuleStats rule_stats(int index) const;
+	GatewayStats stats() const;
+	void reset_stats();
+
+protected:
+	struct RuleState {
+		volatile uint32_t forwarded;
+		volatile uint32_t limited;
+		volatile uint32_t dropped;
+		uint64_t last;              // RX timestamp of the last forwarded frame
+		bool armed;                 // last is valid
+	};
+
+	GatewayBase() = default;
+
+	bool attach_(const Rule* rules, size_t count, RuleState* state,
+		     fdcan::CanBus& a, fdcan::CanBus& b, fdcan::RxTarget fifo);
+
+private:
+	static bool hook_a_(void* context, const fdcan::CanFrame& frame, BaseType_t* woken);
+	static bool hook_b_(void* context, const fdcan::CanFrame& frame, BaseType_t* woken);
+
+	bool forward_(Dir dir, const fdcan::CanFrame& frame);
+	static bool add_filters_(fdcan::CanBus& bus, int route, Dir dir, const Rule* rules, size_t count);
+
+	const Rule* rules_ = nullptr;
+	size_t count_ = 0;
+	RuleState* state_ = nullptr;
+
+	fdcan::CanBus* bus_[2] = {};
+	fdcan::RxHookRoute rx_[2];
+	volatile uint32_t unmatched_ = 0;
+};
+
+template<size_t N>
+class Gateway : public GatewayBase {
+public:
+	Gateway() = default;
+
+	// Adds the gateway routes and filters to both buses; they must be
+	// initialized and not started. false if the bus has no free route or
+	// filter elements left, fifo is owned by a lease route, or the table
+	// is not valid(). The table must outlive the gateway.
+	bool attach(const Table<N>& table, fdcan::CanBus& a, fdcan::CanBus& b,
+		    fdcan::RxTarget fifo = fdcan::RxTarget::FIFO1)
+	{
+		return table.valid() && attach_(table.rules, N, state_, a, b, fifo);
+	}
+
+private:
+	RuleState state_[N] = {};
+};
+
+} // namespace gateway
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
+
+#endif // __STM32ZERO_GATEWAY_HPP__
@@ -0,0 +1,94 @@
+/**
+ * STM32ZERO Latency Histogram
+ *
+ * Fixed-size log2 histogram of microsecond samples (no allocation, O(1)
+ * add). Bin 0 holds 0 us, bin i holds [2^(i-1), 2^i) us, and the last bin
+ * collects everything above. min/max/avg are exact; percentiles are
+ * resolved to the upper bound of their bin.
+ *
+ * Not synchronized: the owner guards concurrent add() and reads.
+ *
+ * Usage:
+ *   Histogram jitter;
+ *   jitter.add(start_us - release_us);
+ *   jitter.percentile(990);               // p99 upper bound (us)
+ */
+
+#ifndef __STM32ZERO_HISTOGRAM_HPP__
+#define __STM32ZERO_HISTOGRAM_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+// Bins per histogram (last bin >= 2^(BINS-2) us)
+#ifndef STM32ZERO_HISTOGRAM_BINS
+#define STM32ZERO_HISTOGRAM_BINS  16
+#endif
+
+namespace stm32zero {
+
+class Histogram {
+public:
+	static constexpr size_t BINS = STM32ZERO_HISTOGRAM_BINS;
+
+	static_assert(BINS >= 2 && BINS <= 33, "Histogram: BINS out of range");
+
+	void add(uint32_t us)
+	{
+		bins_[bin_of(us)]++;
+		if (count_ == 0 || us < min_) {
+			min_ = us;
+		}
+		if (us > max_) {
+			max_ = us;
+		}
+		total_ += us;
+		count_++;
+	}
+
+	void reset() { *this = Histogram(); }
+
+	uint32_t count() const { return count_; }
+	uint32_t min() const { return min_; }
+	uint32_t max() const { return max_; }
+	uint32_t avg() const { return count_ ? static_cast<uint32_t>(total_ / count_) : 0; }
+	uint32_t bin(size_t i) const { return bins_[i]; }
+
+	// Smallest sample that falls into bin i
+	static constexpr uint32_t bin_lower(size_t i) { return i == 0 ? 0 : (1UL << (i - 1)); }
+
+	static size_t bin_of(uint32_t us)
+	{
+		size_t i = (us == 0) ? 0 : static_cast<size_t>(32 - __builtin_clz(us));
+		return (i < BINS) ? i : BINS - 1;
+	}
+
+	// Upper bound (us) of the bin holding the permille-th sample, max() for the last bin
+	uint32_t percentile(uint32_t permille) const
+	{
+		if (count_ == 0) {
+			return 0;
+		}
+		uint64_t rank = (static_cast<uint64_t>(count_) * permille + 999) / 1000;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BINS - 1; i++) {
+			seen += bins_[i];
+			if (seen >= rank) {
+				uint32_t upper = bin_lower(i + 1) - 1;
+				return upper < max_ ? upper : max_;
+			}
+		}
+		return max_;
+	}
+
+private:
+	uint32_t bins_[BINS] = {};
+	uint32_t count_ = 0;
+	uint32_t min_ = 0;
+	uint32_t max_ = 0;
+	uint64_t total_ = 0;
+};
+
+} // namespace stm32zero
+
+#endif // __STM32ZERO_HISTOGRAM_HPP__
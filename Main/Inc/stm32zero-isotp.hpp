@@ -0,0 +1,193 @@
+/**
+ * STM32ZERO ISO-TP (ISO 15765-2) Transport over CanBus
+ *
+ * Segmented messages on top of fdcan::CanBus, for payloads beyond one
+ * frame (diagnostics, calibration blocks, firmware chunks):
+ *
+ *   - Classic (TX_DL 8) and CAN FD (TX_DL 12..64) framing, including the
+ *     FD single frame escape and the 32-bit first frame length above
+ *     4095 bytes.
+ *   - Flow control: the receiver advertises its block size (BS) and
+ *     STmin; the sender honours the ones it receives, including WAIT
+ *     frames. STmin is timed with ustim through
+ *     freertos::timer::sleep_until(): the sender blocks, on the compare
+ *     interrupt for the sub-tick rest, on the STM32ZERO_TIMER_NOTIFY_BIT
+ *     of its task notification value.
+ *     With STmin 0 the block goes to CanBus::write_many() in batches.
+ *   - Channels: one per tx/rx ID pair, each with its own RX route, so
+ *     any number of transfers run concurrently in different tasks.
+ *
+ * No buffers of its own: send() segments straight from the caller's data
+ * and receive() reassembles straight into the caller's buffer. On a
+ * lease route (fdcan::RxLeaseRoute) each payload is copied once, from the
+ * slot the RX interrupt filled into that buffer.
+ *
+ * STmin runs from the hand-off of the previous consecutive frame to the
+ * TX FIFO; with the FIFO otherwise idle that is its start on the bus.
+ *
+ * A channel is half duplex and used by one task at a time. Frames that do
+ * not belong to the current step (a flow control frame while receiving,
+ * data frames while waiting for flow control) are counted and dropped.
+ * A new single/first frame during a reception restarts it, as the
+ * standard asks.
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static RxRoute<16> diag_rx;
+ *   STM32ZERO_DTCM static isotp::Channel diag;
+ *
+ *   diag_rx.create("diag", RxTarget::FIFO0);
+ *   int r = bus1.add_route(diag_rx);
+ *   bus1.add_filter(RxFilter::std_id(0x7E0, r));
+ *   bus1.start();
+ *   diag.init(bus1, diag_rx, isotp::Config::fd(0x7E8, 0x7E0));
+ *
+ *   uint32_t len;
+ *   if (diag.receive(request, sizeof(request), len) == isotp::Result::OK) {
+ *       diag.send(response, n);
+ *   }
+ */
+
+#ifndef __STM32ZERO_ISOTP_HPP__
+#define __STM32ZERO_ISOTP_HPP__
+
+#include "stm32zero-canbus.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// Consecutive frames handed to write_many() per call when STmin is 0
+#ifndef STM32ZERO_ISOTP_BATCH
+#define STM32ZERO_ISOTP_BATCH  8
+#endif
+
+namespace stm32zero {
+namespace isotp {
+
+//=============================================================================
+// Types
+//=============================================================================
+
+enum class Result : uint8_t {
+	OK,
+	INVALID,                    // bad length or channel not initialized
+	TX_FAILED,                  // no free TX element before N_As, or bus stopped
+	TIMEOUT_BS,                 // no flow control before N_Bs
+	TIMEOUT_CR,                 // no consecutive frame before N_Cr
+	TIMEOUT,                    // receive(): nothing arrived
+	WRONG_SN,                   // consecutive frame out of sequence
+	BUFFER_OVERFLOW,            // message larger than the receive buffer
+	WFT_OVERRUN,                // more WAIT flow controls than wft_max
+	ABORTED,                    // invalid flow control / frame format
+};
+
+const char* result_name(Result res);
+
+// STmin byte to microseconds (reserved values read as 127 ms) and back
+uint32_t stmin_to_us(uint8_t raw);
+uint8_t stmin_from_us(uint32_t us);
+
+struct Config {
+	uint32_t tx_id = 0;
+	uint32_t rx_id = 0;         // informational; the route's filter selects frames
+	bool ext = false;           // 29-bit identifiers
+	uint8_t tx_dl = 8;          // 8 (classic) or an FD length 12..64
+	bool brs = false;           // FD: bit rate switch
+	uint8_t block_size = 0;     // BS advertised as receiver (0: no further FC)
+	uint8_t st_min = 0;         // STmin advertised as receiver (raw byte)
+	uint8_t wft_max = 8;        // WAIT flow controls accepted per block
+	uint8_t padding = 0xCC;     // fill byte up to the frame length
+	uint16_t n_as_ms = 1000;    // free TX element
+	uint16_t n_bs_ms = 1000;    // flow control after FF / a block
+	uint16_t n_cr_ms = 1000;    // next consecutive frame
+
+	static Config classic(uint32_t tx_id, uint32_t rx_id)
+	{
+		Config c;
+		c.tx_id = tx_id;
+		c.rx_id = rx_id;
+		return c;
+	}
+
+	static Config fd(uint32_t tx_id, uint32_t rx_id, uint8_t tx_dl = 64, bool brs = true)
+	{
+		Config c;
+		c.tx_id = tx_id;
+		c.rx_id = rx_id;
+		c.tx_dl = tx_dl;
+		c.brs = brs;
+		return c;
+	}
+};
+
+struct ChannelStats {
+	uint32_t tx_messages;       // send() completed
+	uint32_t rx_messages;       // receive() completed
+	uint32_t tx_frames;         // SF/FF/CF/FC queued
+	uint32_t rx_frames;         // frames taken from the route
+	uint32_t fc_sent;
+	uint32_t fc_waits;          // WAIT flow controls received
+	uint32_t ignored;           // frames not expected in the current step
+	uint32_t errors;            // send()/receive() that did not return OK
+};
+
+//=============================================================================
+// Channel
+//=============================================================================
+
+class Channel {
+public:
+	Channel() = default;
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+	// The route carries this channel's RX ID only and is already added
+	// to bus. false for an invalid tx_dl or ID.
+	bool init(fdcan::CanBus& bus, fdcan::RxRouteBase& route, const Config& config);
+
+	bool is_initialized() const { return bus_ != nullptr; }
+	const Config& config() const { return cfg_; }
+
+	// Segments data and blocks until the last frame is queued (task
+	// context)
+	Result send(const void* data, uint32_t len);
+
+	// Waits up to timeout for a single/first frame, then reassembles into
+	// buf. len gets the message length (also on BUFFER_OVERFLOW).
+	Result receive(void* buf, uint32_t capacity, uint32_t& len, TickType_t timeout = portMAX_DELAY);
+
+	// Largest payload of a single frame with this tx_dl
+	uint32_t sf_max() const { return cfg_.tx_dl == 8 ? 7 : cfg_.tx_dl - 2U; }
+
+	ChannelStats stats() const { return stats_; }
+	void reset_stats() { stats_ = ChannelStats(); }
+
+private:
+	const fdcan::CanFrame* next_(TickType_t timeout);
+	Result wait_fc_(uint8_t& bs, uint32_t& st_us);
+	Result send_cfs_(const uint8_t* src, uint32_t len, uint32_t& offset, uint8_t& sn, uint8_t bs, uint32_t st_us);
+	Result reassemble_(const fdcan::CanFrame* f, uint8_t* dst, uint32_t capacity, uint32_t& len);
+	bool send_fc_(uint8_t status);
+	bool put_(fdcan::CanFrame& frame, uint32_t used);
+	void frame_(fdcan::CanFrame& frame) const;
+	void pad_(fdcan::CanFrame& frame, uint32_t used) const;
+	Result finish_(Result res, bool tx);
+
+	fdcan::CanBus* bus_ = nullptr;
+	fdcan::RxRouteBase* route_ = nullptr;
+	Config cfg_;
+	ChannelStats stats_ = {};
+
+	fdcan::RxLease lease_;
+	fdcan::CanFrame rx_;
+	fdcan::CanFrame batch_[STM32ZERO_ISOTP_BATCH];
+};
+
+} // namespace isotp
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
+
+#endif // __STM32ZERO_ISOTP_HPP__
@@ -0,0 +1,50 @@
+/**
+ * STM32ZERO Interrupt Mask Lock
+ *
+ * RAII interrupt mask usable from tasks and ISRs alike, for state shared
+ * between a driver's ISR and its task-side API. On target it raises
+ * BASEPRI to configMAX_SYSCALL_INTERRUPT_PRIORITY and restores the
+ * previous mask, so it nests and is legal in ISRs (CriticalSection is
+ * not).
+ *
+ * The host build runs interrupt handlers in a task, which only a task
+ * critical section holds off (the POSIX port's FROM_ISR mask is empty),
+ * so there it takes taskENTER_CRITICAL() instead.
+ *
+ * Usage:
+ *   {
+ *       MaskLock lock;
+ *       head_++;
+ *   }
+ */
+
+#ifndef __STM32ZERO_MASKLOCK_HPP__
+#define __STM32ZERO_MASKLOCK_HPP__
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace stm32zero {
+
+class MaskLock {
+public:
+#if defined(STM32ZERO_HOST)
+	MaskLock() { taskENTER_CRITICAL(); }
+	~MaskLock() { taskEXIT_CRITICAL(); }
+#else
+	MaskLock() : state_(taskENTER_CRITICAL_FROM_ISR()) {}
+	~MaskLock() { taskEXIT_CRITICAL_FROM_ISR(state_); }
+#endif
+
+	MaskLock(const MaskLock&) = delete;
+	MaskLock& operator=(const MaskLock&) = delete;
+
+#if !defined(STM32ZERO_HOST)
+private:
+	UBaseType_t state_;
+#endif
+};
+
+} // namespace stm32zero
+
+#endif // __STM32ZERO_MASKLOCK_HPP__
@@ -0,0 +1,255 @@
+/**
+ * STM32ZERO Task-Notification Primitives
+ *
+ * Lightweight ISR -> single-task signaling built on direct-to-task
+ * notifications instead of queue objects (no kernel object per instance):
+ *
+ *   NotifySemaphore<Bit>              binary semaphore (one bit)
+ *   NotifyCounter<Bit>                counting semaphore (one bit + counter)
+ *   NotifyEventBits<FirstBit, Count>  up to Count event flags
+ *
+ * Each primitive owns a compile-time range of bits in the bound task's
+ * notification value, so several of them can share one task. The kernel
+ * on the H7 (FreeRTOS V10.3.1) has a single notification value per task
+ * (no xTaskNotifyIndexed), so bits are partitioned instead of indices;
+ * use NotifyLayout to check at compile time that the ranges of one task
+ * do not overlap.
+ *
+ * Only the bound task may take()/wait(); any task or ISR may give()/set().
+ * Tasks that also use CMSIS-RTOS2 thread flags (osThreadFlags*) share the
+ * same notification value and must keep those flags out of these ranges.
+ * Tasks that call timer::sleep_until() (periodic tasks, ISO-TP senders)
+ * also lose STM32ZERO_TIMER_NOTIFY_BIT (bit 31) to it.
+ *
+ * Usage:
+ *   using RxDone = NotifySemaphore<0>;
+ *   using TxDone = NotifySemaphore<1>;
+ *   using Events = NotifyEventBits<8, 4>;
+ *   static_assert(NotifyLayout<RxDone, TxDone, Events>::is_valid(), "overlap");
+ *
+ *   static RxDone rx_done;
+ *   rx_done.bind(uart_task);              // StaticTask or TaskHandle_t
+ *   // ISR:  rx_done.give_from_isr(&woken);
+ *   // task: rx_done.take(pdMS_TO_TICKS(10));
+ */
+
+#ifndef __STM32ZERO_NOTIFY_HPP__
+#define __STM32ZERO_NOTIFY_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace stm32zero {
+namespace freertos {
+
+namespace notify {
+
+/**
+ * Wait in the calling task until bits of mask are set in its notification
+ * value (any bit, or all bits if all is true). Matched bits are cleared if
+ * clear is true. Returns the matched bits, 0 on timeout.
+ */
+uint32_t wait_bits(uint32_t mask, bool all, bool clear, TickType_t timeout);
+
+// Clear bits in the calling task's notification value
+void clear_bits(uint32_t bits);
+
+constexpr uint32_t make_mask(size_t first, size_t count)
+{
+	return (count >= 32) ? 0xFFFFFFFFU : (((1U << count) - 1U) << first);
+}
+
+constexpr size_t popcount(uint32_t v)
+{
+	return v ? (v & 1U) + popcount(v >> 1) : 0;
+}
+
+} // namespace notify
+
+//=============================================================================
+// Binding (common base)
+//=============================================================================
+
+template<uint32_t Mask>
+class NotifyBinding {
+	static_assert(Mask != 0, "Notify primitive needs at least one bit");
+
+public:
+	static constexpr uint32_t mask() { return Mask; }
+
+	void bind(TaskHandle_t task) { task_ = task; }
+
+	template<size_t StackWords>
+	void bind(StaticTask<StackWords>& task) { task_ = task.handle(); }
+
+	TaskHandle_t task() const { return task_; }
+	bool is_bound() const { return task_ != nullptr; }
+
+protected:
+	void notify_(uint32_t bits)
+	{
+		xTaskNotify(task_, bits, eSetBits);
+	}
+
+	void notify_from_isr_(uint32_t bits, BaseType_t* woken)
+	{
+		xTaskNotifyFromISR(task_, bits, eSetBits, woken);
+	}
+
+	void assert_owner_() const
+	{
+		configASSERT(xTaskGetCurrentTaskHandle() == task_);
+	}
+
+	TaskHandle_t task_ = nullptr;
+};
+
+//=============================================================================
+// NotifySemaphore
+//=============================================================================
+
+template<size_t Bit>
+class NotifySemaphore : public NotifyBinding<notify::make_mask(Bit, 1)> {
+	static_assert(Bit < 32, "NotifySemaphore: Bit must be 0..31");
+
+	using Base = NotifyBinding<notify::make_mask(Bit, 1)>;
+
+public:
+	void give() { this->notify_(Base::mask()); }
+	void give_from_isr(BaseType_t* woken = nullptr) { this->notify_from_isr_(Base::mask(), woken); }
+
+	// Bound task only
+	bool take(TickType_t timeout = portMAX_DELAY)
+	{
+		this->assert_owner_();
+		return notify::wait_bits(Base::mask(), false, true, timeout) != 0;
+	}
+};
+
+//=============================================================================
+// NotifyCounter
+//=============================================================================
+
+template<size_t Bit>
+class NotifyCounter : public NotifyBinding<notify::make_mask(Bit, 1)> {
+	static_assert(Bit < 32, "NotifyCounter: Bit must be 0..31");
+
+	using Base = NotifyBinding<notify::make_mask(Bit, 1)>;
+
+public:
+	void give()
+	{
+		{
+			CriticalSection cs;
+			count_++;
+		}
+		this->notify_(Base::mask());
+	}
+
+	void give_from_isr(BaseType_t* woken = nullptr)
+	{
+		{
+			CriticalSection cs;
+			count_++;
+		}
+		this->notify_from_isr_(Base::mask(), woken);
+	}
+
+	// Bound task only: decrement the count, waiting while it is zero
+	bool take(TickType_t timeout = portMAX_DELAY)
+	{
+		this->assert_owner_();
+		TickType_t start = xTaskGetTickCount();
+		while (true) {
+			{
+				CriticalSection cs;
+				if (count_ > 0) {
+					count_--;
+					return true;
+				}
+			}
+
+			TickType_t remain = timeout;
+			if (timeout != portMAX_DELAY) {
+				TickType_t elapsed = xTaskGetTickCount() - start;
+				if (elapsed >= timeout) {
+					return false;
+				}
+				remain = timeout - elapsed;
+			}
+			if (notify::wait_bits(Base::mask(), false, true, remain) == 0) {
+				return false;
+			}
+		}
+	}
+
+	uint32_t count() const { return count_; }
+
+private:
+	volatile uint32_t count_ = 0;
+};
+
+//=============================================================================
+// NotifyEventBits
+//=============================================================================
+
+template<size_t FirstBit, size_t Count>
+class NotifyEventBits : public NotifyBinding<notify::make_mask(FirstBit, Count)> {
+	static_assert(Count > 0 && FirstBit + Count <= 32, "NotifyEventBits: bit range exceeds 32 bits");
+
+	using Base = NotifyBinding<notify::make_mask(FirstBit, Count)>;
+
+public:
+	// bits are relative to FirstBit (bit 0 = FirstBit)
+	void set(uint32_t bits) { this->notify_(to_abs_(bits)); }
+	void set_from_isr(uint32_t bits, BaseType_t* woken = nullptr) { this->notify_from_isr_(to_abs_(bits), woken); }
+
+	// Bound task only. Return the matched (relative) bits, 0 on timeout.
+	uint32_t wait_any(uint32_t bits, TickType_t timeout = portMAX_DELAY, bool clear = true)
+	{
+		this->assert_owner_();
+		return notify::wait_bits(to_abs_(bits), false, clear, timeout) >> FirstBit;
+	}
+
+	uint32_t wait_all(uint32_t bits, TickType_t timeout = portMAX_DELAY, bool clear = true)
+	{
+		this->assert_owner_();
+		return notify::wait_bits(to_abs_(bits), true, clear, timeout) >> FirstBit;
+	}
+
+	// Bound task only
+	void clear(uint32_t bits)
+	{
+		this->assert_owner_();
+		notify::clear_bits(to_abs_(bits));
+	}
+
+	static constexpr uint32_t all_bits() { return notify::make_mask(0, Count); }
+
+private:
+	static constexpr uint32_t to_abs_(uint32_t bits) { return (bits << FirstBit) & Base::mask(); }
+};
+
+//=============================================================================
+// NotifyLayout (compile-time collision check)
+//=============================================================================
+
+template<typename... Slots>
+struct NotifyLayout {
+	static constexpr uint32_t mask() { return (Slots::mask() | ... | 0U); }
+
+	// true if no two primitives share a bit
+	static constexpr bool is_valid()
+	{
+		return (notify::popcount(Slots::mask()) + ... + 0U) == notify::popcount(mask());
+	}
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_NOTIFY_HPP__
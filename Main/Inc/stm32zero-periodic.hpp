@@ -0,0 +1,154 @@
+/**
+ * STM32ZERO Periodic Task
+ *
+ * Fixed-rate loop released on ustim deadlines instead of 1 ms ticks, for
+ * control loops up to ~10 kHz. Each release sleeps on ticks, then on the
+ * ustim compare interrupt (timer::sleep_until()), and spins only the last
+ * STM32ZERO_TIMER_SPIN_US, so tasks below the periodic task's priority
+ * keep the CPU between cycles even at periods shorter than a tick. The
+ * wait uses only STM32ZERO_TIMER_NOTIFY_BIT of the task's notification
+ * value; bodies may use the other bits (Notify* primitives).
+ *
+ *   PeriodicTask<Period_us, StackWords>
+ *
+ * Per cycle it records release jitter (actual start - scheduled release)
+ * and execution time into log2 histograms. A cycle that ends after the
+ * next release is a deadline miss, handled by the overrun policy:
+ *   SKIP      drop the releases that already passed, keep the phase
+ *   CATCH_UP  run the missed releases back to back
+ *   NOTIFY    as SKIP, and call the overrun handler with the drop count
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static PeriodicTask<1000, 512> control;   // 1 kHz
+ *   control.start("CTRL", Priority::HIGH, control_step, &state);
+ *   ...
+ *   PeriodicStats st = control.stats();
+ *   st.jitter.percentile(999);            // p99.9 release jitter (us)
+ *   control.stop();                       // returns once the task is gone
+ *
+ * When the loop ends (stop() or a body calling stop()), the task parks
+ * itself and is deleted by the next stop() or start() from another task.
+ * Deleting another task reclaims it at once, so a restart never depends
+ * on IDLE running first.
+ */
+
+#ifndef __STM32ZERO_PERIODIC_HPP__
+#define __STM32ZERO_PERIODIC_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-histogram.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace stm32zero {
+namespace freertos {
+
+enum class OverrunPolicy : uint8_t {
+	SKIP,
+	CATCH_UP,
+	NOTIFY,
+};
+
+struct PeriodicStats {
+	uint32_t cycles;
+	uint32_t misses;            // cycles that ended after the next release
+	uint32_t skipped;           // releases dropped (SKIP / NOTIFY)
+	Histogram jitter;           // release jitter (us)
+	Histogram exec;             // body execution time (us)
+};
+
+//=============================================================================
+// PeriodicBase (period-independent part)
+//=============================================================================
+
+class PeriodicBase {
+public:
+	using Body = void (*)(void* ctx);
+	using OverrunHandler = void (*)(void* ctx, uint32_t missed);
+
+	// Called from the periodic task after a miss (NOTIFY policy only)
+	void set_overrun_handler(OverrunHandler handler, void* ctx)
+	{
+		overrun_handler_ = handler;
+		overrun_ctx_ = ctx;
+	}
+
+	// End the loop after the current cycle. From another task, waits until
+	// the task is deleted; from the body, only requests the exit.
+	void stop();
+	bool is_running() const { return running_; }
+
+	PeriodicStats stats() const
+	{
+		CriticalSection cs;
+		return stats_;
+	}
+
+	void reset_stats()
+	{
+		CriticalSection cs;
+		stats_ = {};
+	}
+
+	TaskHandle_t task() const { return task_; }
+
+protected:
+	explicit PeriodicBase(uint32_t period_us) : period_us_(period_us) {}
+
+	bool prepare_(Body body, void* ctx, OverrunPolicy policy);
+	void started_(TaskHandle_t task);
+
+	static void task_func_(void* param);
+
+	TaskHandle_t task_ = nullptr;
+
+private:
+	void run_();
+	void reap_();
+
+	const uint32_t period_us_;
+	Body body_ = nullptr;
+	void* ctx_ = nullptr;
+	OverrunPolicy policy_ = OverrunPolicy::SKIP;
+	OverrunHandler overrun_handler_ = nullptr;
+	void* overrun_ctx_ = nullptr;
+	volatile bool stop_ = false;
+	volatile bool running_ = false;
+	PeriodicStats stats_ = {};
+};
+
+//=============================================================================
+// PeriodicTask
+//=============================================================================
+
+template<uint32_t Period_us, size_t StackWords>
+class PeriodicTask : public PeriodicBase {
+	static_assert(Period_us > 0, "PeriodicTask: Period_us must be > 0");
+
+public:
+	PeriodicTask() : PeriodicBase(Period_us) {}
+
+	// First release one period after start; false if already running
+	bool start(const char* name, Priority priority, Body body, void* ctx = nullptr,
+		   OverrunPolicy policy = OverrunPolicy::SKIP)
+	{
+		if (!prepare_(body, ctx, policy)) {
+			return false;
+		}
+		started_(task_obj_.create(task_func_, name, priority, static_cast<PeriodicBase*>(this)));
+		return task_ != nullptr;
+	}
+
+	static constexpr uint32_t period_us() { return Period_us; }
+	static constexpr uint32_t rate_hz() { return 1000000 / Period_us; }
+	static constexpr size_t stack_words() { return StackWords; }
+
+private:
+	StaticTask<StackWords> task_obj_;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_PERIODIC_HPP__
@@ -0,0 +1,250 @@
+/**
+ * STM32ZERO Ping-Pong DMA Double Buffer
+ *
+ * Two DMA buffers where the hardware works on one half while the CPU
+ * processes the other. Ownership of each half is tracked explicitly:
+ *
+ *   HW     owned by the DMA (being filled / sent, or queued next)
+ *   READY  handed over by the DMA, waiting for the CPU
+ *   CPU    held by the CPU between wait_ready() and release()
+ *
+ * complete() is called from the DMA half/full transfer interrupt. It hands
+ * the finished half to the CPU and takes the other one back for the
+ * hardware. If the CPU has not released that half yet, the hardware runs
+ * over it anyway (circular DMA cannot wait) and an overrun is counted.
+ *
+ * Cache maintenance is done at handoff when the buffers live in cacheable
+ * memory: RX halves are invalidated in wait_ready(), TX halves are cleaned
+ * in release().
+ *
+ * Usage (UART RX, circular DMA with half-transfer interrupt):
+ *   static PingPong<DmaBuffer<256>> rx;
+ *   rx.init(DmaDir::RX);
+ *   HAL_UART_Receive_DMA(&huart, (uint8_t*)rx.dma_data(), rx.dma_size());
+ *   // HAL_UART_RxHalfCpltCallback / HAL_UART_RxCpltCallback: rx.complete(&woken);
+ *
+ *   while (auto* half = rx.wait_ready(100)) {
+ *       process(half->data(), half->size());
+ *       rx.release();
+ *   }
+ */
+
+#ifndef __STM32ZERO_PINGPONG_HPP__
+#define __STM32ZERO_PINGPONG_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-dcache.hpp"
+#include "stm32zero-freertos.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace stm32zero {
+
+// Transfer direction as seen by the DMA
+enum class DmaDir : uint8_t {
+	RX,     // DMA writes, CPU reads
+	TX,     // CPU writes, DMA reads
+};
+
+template<typename Buffer>
+class PingPong {
+public:
+	enum class Owner : uint8_t { HW, READY, CPU };
+
+	static constexpr uint8_t NONE = 0xFF;
+
+	// Size of one half in bytes
+	static constexpr size_t half_size() { return Buffer::size(); }
+
+	// Contiguous memory for a single circular DMA (half/full interrupts)
+	static constexpr bool is_contiguous() { return Buffer::size() == Buffer::aligned_size(); }
+
+	/**
+	 * Create the ready semaphore and set the initial ownership.
+	 *
+	 * RX: both halves belong to the hardware (DMA fills half 0 first).
+	 * TX: both halves are READY so the CPU can fill them before starting DMA.
+	 */
+	void init(DmaDir dir)
+	{
+		dir_ = dir;
+		cacheable_ = dcache::is_cacheable(const_cast<const uint8_t*>(bufs_[0].data()));
+		if (!ready_sem_.is_created()) {
+			ready_sem_.create();
+		}
+		reset();
+	}
+
+	// Restore the initial ownership and clear statistics (DMA must be stopped)
+	void reset()
+	{
+		CriticalSection cs;
+		hw_ = 0;
+		held_ = NONE;
+		held_overrun_ = false;
+		completions_ = 0;
+		overruns_ = 0;
+		if (dir_ == DmaDir::RX) {
+			owner_[0] = Owner::HW;
+			owner_[1] = Owner::HW;
+		} else {
+			owner_[0] = Owner::READY;
+			owner_[1] = Owner::READY;
+			seq_[0] = 0;
+			seq_[1] = 1;
+		}
+	}
+
+	/**
+	 * Hardware finished the active half (call from the DMA ISR or a task).
+	 *
+	 * The finished half becomes READY; the other half goes back to HW.
+	 */
+	void complete(BaseType_t* woken = nullptr)
+	{
+		{
+			CriticalSection cs;
+			uint8_t done = hw_;
+			uint8_t next = done ^ 1;
+
+			owner_[done] = Owner::READY;
+			seq_[done] = ++completions_;
+			hw_ = next;
+
+			if (owner_[next] != Owner::HW) {
+				overruns_++;
+				if (held_ == next) {
+					held_overrun_ = true;
+				}
+				owner_[next] = Owner::HW;
+			}
+		}
+
+		if (is_in_isr()) {
+			ready_sem_.give_from_isr(woken);
+		} else {
+			ready_sem_.give();
+		}
+	}
+
+	/**
+	 * Wait for the oldest READY half and take CPU ownership of it.
+	 *
+	 * A half still held from the previous call is released first.
+	 * Returns nullptr on timeout.
+	 */
+	Buffer* wait_ready(TickType_t timeout = portMAX_DELAY)
+	{
+		if (held_ != NONE) {
+			release();
+		}
+
+		TickType_t start = xTaskGetTickCount();
+		while (true) {
+			uint8_t idx = acquire_();
+			if (idx != NONE) {
+				if (cacheable_ && dir_ == DmaDir::RX) {
+					dcache::invalidate(bufs_[idx].data(), Buffer::aligned_size());
+				}
+				return &bufs_[idx];
+			}
+
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (timeout != portMAX_DELAY && elapsed >= timeout) {
+				return nullptr;
+			}
+			TickType_t remain = (timeout == portMAX_DELAY) ? portMAX_DELAY : timeout - elapsed;
+			if (!ready_sem_.take(remain)) {
+				return nullptr;
+			}
+		}
+	}
+
+	/**
+	 * Hand the CPU-held half back to the hardware.
+	 *
+	 * Returns false if nothing was held or the hardware overran the half
+	 * while the CPU was still using it (RX data overwritten / TX resent).
+	 */
+	bool release()
+	{
+		uint8_t idx = held_;
+		if (idx == NONE) {
+			return false;
+		}
+
+		if (cacheable_ && dir_ == DmaDir::TX) {
+			dcache::clean(bufs_[idx].data(), Buffer::aligned_size());
+		}
+
+		CriticalSection cs;
+		bool ok = !held_overrun_;
+		if (ok) {
+			owner_[idx] = Owner::HW;
+		}
+		held_ = NONE;
+		held_overrun_ = false;
+		return ok;
+	}
+
+	// Half currently held by the CPU (nullptr if none)
+	Buffer* held() { return (held_ != NONE) ? &bufs_[held_] : nullptr; }
+
+	Buffer& half(size_t i) { return bufs_[i & 1]; }
+	Owner owner(size_t i) const { return owner_[i & 1]; }
+
+	// Index of the half the hardware is working on
+	uint8_t active() const { return hw_; }
+
+	// Start address and length for a single circular DMA over both halves
+	volatile uint8_t* dma_data() { return bufs_[0].data(); }
+
+	static constexpr size_t dma_size()
+	{
+		static_assert(is_contiguous(), "PingPong: Buffer size must be a multiple of cache_line_size");
+		return 2 * Buffer::size();
+	}
+
+	bool is_cacheable() const { return cacheable_; }
+	uint32_t completions() const { return completions_; }
+	uint32_t overruns() const { return overruns_; }
+
+private:
+	// Mark the oldest READY half as CPU-owned, NONE if there is none
+	uint8_t acquire_()
+	{
+		CriticalSection cs;
+		uint8_t idx = NONE;
+		for (uint8_t i = 0; i < 2; i++) {
+			if (owner_[i] == Owner::READY &&
+			    (idx == NONE || (int32_t)(seq_[i] - seq_[idx]) < 0)) {
+				idx = i;
+			}
+		}
+		if (idx != NONE) {
+			owner_[idx] = Owner::CPU;
+			held_ = idx;
+			held_overrun_ = false;
+		}
+		return idx;
+	}
+
+	Buffer bufs_[2];
+	freertos::StaticBinarySemaphore ready_sem_;
+
+	volatile Owner owner_[2] = { Owner::HW, Owner::HW };
+	volatile uint32_t seq_[2] = { 0, 0 };      // completion order of READY halves
+	volatile uint8_t hw_ = 0;                  // half the hardware is working on
+	volatile uint8_t held_ = NONE;             // half held by the CPU
+	volatile bool held_overrun_ = false;       // hardware overran the held half
+
+	volatile uint32_t completions_ = 0;
+	volatile uint32_t overruns_ = 0;
+
+	DmaDir dir_ = DmaDir::RX;
+	bool cacheable_ = false;
+};
+
+} // namespace stm32zero
+
+#endif // __STM32ZERO_PINGPONG_HPP__
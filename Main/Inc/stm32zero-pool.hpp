@@ -0,0 +1,208 @@
+/**
+ * STM32ZERO Static Object Pool
+ *
+ * Fixed-capacity pool of T with an intrusive free list (no heap).
+ * make() returns a PoolPtr<T>: a move-only owning handle that destroys
+ * the object and returns its slot to the pool when it goes out of scope.
+ *
+ * PoolPtr is trivially relocatable (two pointers), so it can be passed
+ * through TypedQueue for zero-copy handoff of large records: only the
+ * handle is copied by the kernel, ownership moves with it.
+ *
+ * allocate/release run in a CriticalSection and are ISR-safe.
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static ObjectPool<Record, 16> pool;
+ *   pool.create();
+ *   PoolPtr<Record> rec = pool.make(args...);
+ *   if (rec) { rec->id = 1; queue.send(std::move(rec)); }
+ */
+
+#ifndef __STM32ZERO_POOL_HPP__
+#define __STM32ZERO_POOL_HPP__
+
+#include "stm32zero.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stm32zero {
+
+//=============================================================================
+// Relocation Trait
+//=============================================================================
+
+/**
+ * True if a T may be moved by copying its bytes and forgetting the source
+ * (no destructor call). FreeRTOS queues copy items this way.
+ * Specialize for owning handles that do not point into themselves.
+ */
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+class ObjectPoolBase;
+
+//=============================================================================
+// PoolPtr
+//=============================================================================
+
+template<typename T>
+class PoolPtr {
+public:
+	PoolPtr() : ptr_(nullptr), pool_(nullptr) {}
+	~PoolPtr() { reset(); }
+
+	PoolPtr(const PoolPtr&) = delete;
+	PoolPtr& operator=(const PoolPtr&) = delete;
+
+	PoolPtr(PoolPtr&& other) : ptr_(other.ptr_), pool_(other.pool_)
+	{
+		other.ptr_ = nullptr;
+		other.pool_ = nullptr;
+	}
+
+	PoolPtr& operator=(PoolPtr&& other)
+	{
+		if (this != &other) {
+			reset();
+			ptr_ = other.ptr_;
+			pool_ = other.pool_;
+			other.ptr_ = nullptr;
+			other.pool_ = nullptr;
+		}
+		return *this;
+	}
+
+	// Destroy the object and return its slot to the pool
+	void reset();
+
+	T* get() const { return ptr_; }
+	T& operator*() const { return *ptr_; }
+	T* operator->() const { return ptr_; }
+	explicit operator bool() const { return ptr_ != nullptr; }
+
+private:
+	friend class ObjectPoolBase<T>;
+
+	PoolPtr(T* ptr, ObjectPoolBase<T>* pool) : ptr_(ptr), pool_(pool) {}
+
+	T* ptr_;
+	ObjectPoolBase<T>* pool_;
+};
+
+template<typename T>
+struct is_trivially_relocatable<PoolPtr<T>> : std::true_type {};
+
+//=============================================================================
+// ObjectPoolBase (capacity-independent part)
+//=============================================================================
+
+template<typename T>
+class ObjectPoolBase {
+public:
+	// Allocate and construct a T; empty PoolPtr when the pool is exhausted
+	template<typename... Args>
+	PoolPtr<T> make(Args&&... args)
+	{
+		void* mem = allocate_();
+		if (mem == nullptr) {
+			return PoolPtr<T>();
+		}
+		T* obj = new (mem) T(std::forward<Args>(args)...);
+		return PoolPtr<T>(obj, this);
+	}
+
+	size_t available() const { return available_; }
+	size_t capacity() const { return capacity_; }
+	size_t in_use() const { return capacity_ - available_; }
+
+	// Lowest number of free slots seen since create()
+	size_t min_available() const { return min_available_; }
+
+protected:
+	union Slot {
+		Slot* next;
+		alignas(T) uint8_t storage[sizeof(T)];
+	};
+
+	void link_(Slot* slots, size_t n)
+	{
+		CriticalSection cs;
+		for (size_t i = 0; i + 1 < n; i++) {
+			slots[i].next = &slots[i + 1];
+		}
+		slots[n - 1].next = nullptr;
+		free_ = slots;
+		capacity_ = n;
+		available_ = n;
+		min_available_ = n;
+	}
+
+private:
+	friend class PoolPtr<T>;
+
+	void* allocate_()
+	{
+		CriticalSection cs;
+		Slot* slot = free_;
+		if (slot == nullptr) {
+			return nullptr;
+		}
+		free_ = slot->next;
+		available_--;
+		if (available_ < min_available_) {
+			min_available_ = available_;
+		}
+		return slot->storage;
+	}
+
+	void release_(T* obj)
+	{
+		obj->~T();
+		Slot* slot = reinterpret_cast<Slot*>(obj);
+		CriticalSection cs;
+		slot->next = free_;
+		free_ = slot;
+		available_++;
+	}
+
+	Slot* free_ = nullptr;
+	volatile size_t available_ = 0;
+	size_t capacity_ = 0;
+	size_t min_available_ = 0;
+};
+
+template<typename T>
+void PoolPtr<T>::reset()
+{
+	if (ptr_ != nullptr) {
+		pool_->release_(ptr_);
+		ptr_ = nullptr;
+		pool_ = nullptr;
+	}
+}
+
+//=============================================================================
+// ObjectPool
+//=============================================================================
+
+template<typename T, size_t N>
+class ObjectPool : public ObjectPoolBase<T> {
+	static_assert(N > 0, "ObjectPool: N must be > 0");
+
+public:
+	// Link the free list (call once before make(); outstanding handles must not exist)
+	void create() { this->link_(slots_, N); }
+
+	static constexpr size_t length() { return N; }
+
+private:
+	typename ObjectPoolBase<T>::Slot slots_[N];
+};
+
+} // namespace stm32zero
+
+#endif // __STM32ZERO_POOL_HPP__
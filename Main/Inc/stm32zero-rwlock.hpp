@@ -0,0 +1,224 @@
+/**
+ * STM32ZERO Reader-Writer Locks
+ *
+ * For data read often by several tasks and written rarely (configuration,
+ * calibration tables):
+ *
+ *   StaticRwLock   readers share the lock, writers are exclusive.
+ *                  Uncontended read_lock() is a critical-section counter
+ *                  (no kernel object taken). A writer holds an internal
+ *                  StaticMutex for the whole write, so tasks blocked
+ *                  behind it (readers or writers) lend it their priority.
+ *                  A waiting writer stops new readers (no writer
+ *                  starvation) and waits for active readers to drain,
+ *                  raising the active readers to its own priority until
+ *                  they read_unlock() (the kernel cannot: readers hold
+ *                  no kernel object). Task context only.
+ *
+ *   SeqLock<T>     lock-free reads of a small trivially copyable T, also
+ *                  from ISRs. Two copies: write() fills the inactive copy
+ *                  and then publishes it, so a reader that preempts the
+ *                  writer (ISR) always gets a consistent value at once;
+ *                  a task reader retries only if a second write started
+ *                  refilling its copy. One writer at a time.
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static StaticRwLock cal_lock;
+ *   cal_lock.create();
+ *   { ReadLock r(cal_lock);  use(table); }
+ *   { WriteLock w(cal_lock); table = fresh; }
+ *
+ *   static SeqLock<Gains> gains;
+ *   gains.write(new_gains);               // task
+ *   Gains g = gains.read();               // task or ISR
+ */
+
+#ifndef __STM32ZERO_RWLOCK_HPP__
+#define __STM32ZERO_RWLOCK_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Reader tasks tracked for priority boosting and nested reads; readers
+// beyond this still share the lock, but are not boosted by a waiting
+// writer and must not nest read_lock()
+#ifndef STM32ZERO_RWLOCK_READERS
+#define STM32ZERO_RWLOCK_READERS  4
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// StaticRwLock
+//=============================================================================
+
+class StaticRwLock {
+public:
+	// Create the writer mutex and drain semaphore; true on success
+	bool create();
+	bool is_created() const { return gate_.is_created(); }
+
+	// A nested read_lock() by a task already reading never blocks
+	bool read_lock(TickType_t timeout = portMAX_DELAY);
+	void read_unlock();
+
+	// timeout applies to the mutex and to draining readers separately.
+	// Active readers run at the writer's priority (as it was when the
+	// wait began) until they leave, even if the writer times out.
+	bool write_lock(TickType_t timeout = portMAX_DELAY);
+	void write_unlock();
+
+	// Readers currently inside (diagnostics)
+	uint32_t readers() const { return readers_; }
+
+	// Reads that had to block behind a writer
+	uint32_t contended_reads() const { return contended_reads_; }
+
+private:
+	struct Holder {
+		TaskHandle_t task;              // nullptr = free
+		UBaseType_t priority;           // base priority before the boost
+		uint16_t depth;                 // nested read_lock() by the same task
+		bool boosted;
+	};
+
+	Holder* find_(TaskHandle_t task);
+	void hold_(TaskHandle_t task);
+	void boost_(UBaseType_t priority);
+
+	StaticMutex gate_;                  // held by the writer (priority inheritance)
+	StaticBinarySemaphore drained_;     // last reader out -> waiting writer
+	volatile uint32_t readers_ = 0;
+	volatile bool writer_ = false;      // writer holds or is draining
+	volatile bool waiting_ = false;     // writer blocked on drained_
+	volatile uint32_t contended_reads_ = 0;
+	Holder holders_[STM32ZERO_RWLOCK_READERS] = {};
+};
+
+class ReadLock {
+public:
+	explicit ReadLock(StaticRwLock& lock, TickType_t timeout = portMAX_DELAY)
+		: lock_(lock), locked_(lock.read_lock(timeout)) {}
+
+	~ReadLock()
+	{
+		if (locked_) {
+			lock_.read_unlock();
+		}
+	}
+
+	ReadLock(const ReadLock&) = delete;
+	ReadLock& operator=(const ReadLock&) = delete;
+
+	bool is_locked() const { return locked_; }
+	explicit operator bool() const { return locked_; }
+
+private:
+	StaticRwLock& lock_;
+	bool locked_;
+};
+
+class WriteLock {
+public:
+	explicit WriteLock(StaticRwLock& lock, TickType_t timeout = portMAX_DELAY)
+		: lock_(lock), locked_(lock.write_lock(timeout)) {}
+
+	~WriteLock()
+	{
+		if (locked_) {
+			lock_.write_unlock();
+		}
+	}
+
+	WriteLock(const WriteLock&) = delete;
+	WriteLock& operator=(const WriteLock&) = delete;
+
+	bool is_locked() const { return locked_; }
+	explicit operator bool() const { return locked_; }
+
+private:
+	StaticRwLock& lock_;
+	bool locked_;
+};
+
+//=============================================================================
+// SeqLock<T>
+//=============================================================================
+
+template<typename T>
+class SeqLock {
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock: T must be trivially copyable");
+
+public:
+	SeqLock() = default;
+	explicit SeqLock(const T& initial)
+	{
+		copy_(slots_[0], initial);
+		copy_(slots_[1], initial);
+	}
+
+	// Single writer (task or ISR); concurrent writers must be serialized
+	void write(const T& value)
+	{
+		// seq odd while the inactive copy is being filled
+		uint32_t s = seq_;
+		seq_ = s + 1;
+		__DMB();
+		copy_(slots_[((s >> 1) + 1) & 1], value);
+		__DMB();
+		seq_ = s + 2;
+	}
+
+	// Read-modify-write by the (single) writer
+	template<typename F>
+	void update(F&& fn)
+	{
+		T value = read();
+		fn(value);
+		write(value);
+	}
+
+	// Retries while writes overtake the copy (an ISR that preempted the writer never retries)
+	T read() const
+	{
+		T out;
+		while (!try_read(out)) {
+		}
+		return out;
+	}
+
+	// One attempt; false if a writer started refilling the copy being read
+	bool try_read(T& out) const
+	{
+		uint32_t s1 = seq_;
+		__DMB();
+		copy_(out, slots_[(s1 >> 1) & 1]);
+		__DMB();
+		uint32_t s2 = seq_;
+
+		// The copy read is overwritten from seq (s1 & ~1) + 3 on
+		return s2 - (s1 & ~1U) < 3;
+	}
+
+	// Completed writes
+	uint32_t version() const { return seq_ >> 1; }
+
+private:
+	static void copy_(T& dst, const T& src)
+	{
+		memcpy(static_cast<void*>(&dst), static_cast<const void*>(&src), sizeof(T));
+	}
+
+	T slots_[2] = {};
+	volatile uint32_t seq_ = 0;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_RWLOCK_HPP__
@@ -0,0 +1,157 @@
+/**
+ * STM32ZERO FreeRTOS Run-Time Statistics
+ *
+ * Clocks configGENERATE_RUN_TIME_STATS from ustim (1 us resolution) and
+ * provides a heap-free view of where the CPU time goes:
+ *
+ *   stats::snapshot(snap)   per-task CPU (permille), stack high-water,
+ *                           state and priority since the previous snapshot
+ *   stats::sample()         one load sample (idle-based) into a ring;
+ *                           stats::start() samples periodically on a timer
+ *   stats::load_average(n)  CPU load over the last n samples
+ *   stats::isr_enter/exit   interrupt time accounting, fed by the trace
+ *                           ISR hooks of every handler
+ *
+ * FreeRTOSConfig.h (USER CODE BEGIN Defines) wires the kernel counter:
+ *   #define configGENERATE_RUN_TIME_STATS  1
+ *   #define portGET_RUN_TIME_COUNTER_VALUE() stm32zero_stats_counter()
+ *
+ * The counter has the kernel's configRUN_TIME_COUNTER_TYPE. FreeRTOS V11
+ * (H503, host) sets it to uint64_t and gets the full ustim value, which
+ * never wraps. V10.3.1 (NUCLEO) has no such option: its 32-bit per-task
+ * counters wrap after ~71 minutes at 1 us, so snapshot() works on
+ * wrap-safe deltas and must be called at least once per wrap period there.
+ *
+ * Interrupt time is also charged by the kernel to the interrupted task;
+ * it is measured separately (outermost handler only when nested) by the
+ * stm32zero_trace_isr_enter() / _exit() hooks that the demo's interrupt
+ * handlers call, whether or not the trace recorder runs. Handlers without
+ * those hooks can use IsrScope:
+ *
+ *   extern "C" void TIM7_IRQHandler(void) {
+ *       stats::IsrScope scope;
+ *       ...
+ *   }
+ */
+
+#ifndef __STM32ZERO_STATS_HPP__
+#define __STM32ZERO_STATS_HPP__
+
+#include "stm32zero.hpp"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <cstddef>
+#include <cstdint>
+
+#if (configGENERATE_RUN_TIME_STATS != 1) || (configUSE_TRACE_FACILITY != 1)
+#error "stm32zero-stats requires configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY"
+#endif
+
+// Task capacity of snapshot() (all tasks must fit)
+#ifndef STM32ZERO_STATS_MAX_TASKS
+#define STM32ZERO_STATS_MAX_TASKS  16
+#endif
+
+// Load samples kept for load_average()
+#ifndef STM32ZERO_STATS_HISTORY
+#define STM32ZERO_STATS_HISTORY  16
+#endif
+
+// Kernel run-time counter width (V10.3.1 has no configRUN_TIME_COUNTER_TYPE)
+#ifdef configRUN_TIME_COUNTER_TYPE
+#define STM32ZERO_STATS_COUNTER_TYPE  configRUN_TIME_COUNTER_TYPE
+#else
+#define STM32ZERO_STATS_COUNTER_TYPE  uint32_t
+#endif
+
+// Run-time counter for portGET_RUN_TIME_COUNTER_VALUE() (ustim, 1 us)
+extern "C" STM32ZERO_STATS_COUNTER_TYPE stm32zero_stats_counter(void);
+
+namespace stm32zero {
+namespace freertos {
+namespace stats {
+
+enum class State : uint8_t {
+	RUNNING,
+	READY,
+	BLOCKED,
+	SUSPENDED,
+	DELETED,
+};
+
+struct TaskInfo {
+	TaskHandle_t handle;
+	const char* name;
+	uint64_t total_us;          // CPU time since boot
+	uint32_t window_us;         // CPU time in this window
+	uint16_t cpu_permille;      // share of this window (0..1000)
+	uint16_t priority;          // current (may be inherited)
+	uint16_t base_priority;
+	State state;
+	uint32_t stack_free;        // high-water mark, in words
+};
+
+struct Snapshot {
+	TaskInfo tasks[STM32ZERO_STATS_MAX_TASKS];
+	size_t count;               // entries in tasks[]
+	size_t total_tasks;         // tasks in the system (> count on failure)
+	uint64_t timestamp_us;
+	uint32_t window_us;         // time since the previous snapshot
+	uint16_t load_permille;     // 1000 - idle share
+	uint16_t isr_permille;      // share spent in IsrScope
+	uint32_t isr_us;
+};
+
+/**
+ * Fill snap with per-task statistics since the previous call (since boot
+ * on the first call). Task context only; suspends the scheduler while the
+ * task list is read. Returns false (count == 0) if there are more than
+ * STM32ZERO_STATS_MAX_TASKS tasks.
+ */
+bool snapshot(Snapshot& snap);
+
+/**
+ * Record one load sample (CPU load since the previous sample). Cheap:
+ * reads only the idle task counter. Task or timer context.
+ */
+void sample();
+
+// Sample every period_ms from the timer service task
+bool start(uint32_t period_ms);
+void stop();
+
+// Average load over the last n samples (n = 0: all kept), permille
+uint16_t load_average(size_t n = 0);
+uint16_t isr_average(size_t n = 0);
+size_t sample_count();
+
+//=============================================================================
+// ISR time accounting
+//=============================================================================
+
+void isr_enter();
+void isr_exit();
+
+// Same with the low 32 bits of ustim already read (trace ISR hooks).
+// Lock-free: a nested handler restores the depth before the outer one
+// resumes, and only the outermost handler adds to the total.
+void isr_enter_at(uint32_t now_us);
+void isr_exit_at(uint32_t now_us);
+
+// Total time spent in IsrScope since boot
+uint64_t isr_total_us();
+
+class IsrScope {
+public:
+	IsrScope() { isr_enter(); }
+	~IsrScope() { isr_exit(); }
+
+	IsrScope(const IsrScope&) = delete;
+	IsrScope& operator=(const IsrScope&) = delete;
+};
+
+} // namespace stats
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_STATS_HPP__
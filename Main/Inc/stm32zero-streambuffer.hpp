@@ -0,0 +1,171 @@
+/**
+ * STM32ZERO FreeRTOS Stream / Message Buffers
+ *
+ * Statically allocated wrappers in the style of stm32zero-freertos.hpp.
+ * Stream and message buffers assume one writer and one reader (task or
+ * ISR) and are the cheapest kernel primitive for byte streams: data is
+ * copied once into a ring and the reader is woken via task notification.
+ *
+ *   StaticStreamBuffer<Size, Trigger>  continuous byte stream; a blocked
+ *                                      reader wakes once Trigger bytes
+ *                                      are available
+ *   StaticMessageBuffer<Size>          discrete messages of variable length;
+ *                                      each costs a length header of
+ *                                      sizeof(configMESSAGE_BUFFER_LENGTH_TYPE)
+ *                                      bytes (size_t unless configured)
+ *
+ * Objects can be placed with the section macros like other primitives:
+ *   STM32ZERO_DTCM static StaticStreamBuffer<256, 16> rx_stream;
+ *   rx_stream.create();
+ *
+ *   // UART RX ISR
+ *   rx_stream.send_from_isr(data, len, &woken);
+ *
+ *   // task
+ *   size_t n = rx_stream.receive(buf, sizeof(buf), pdMS_TO_TICKS(10));
+ */
+
+#ifndef __STM32ZERO_STREAMBUFFER_HPP__
+#define __STM32ZERO_STREAMBUFFER_HPP__
+
+#include "stm32zero.hpp"
+#include "FreeRTOS.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// StaticStreamBuffer
+//=============================================================================
+
+template<size_t Size, size_t Trigger = 1>
+class StaticStreamBuffer {
+	static_assert(Size > 0, "StaticStreamBuffer: Size must be > 0");
+	static_assert(Trigger > 0 && Trigger <= Size, "StaticStreamBuffer: Trigger must be 1..Size");
+
+public:
+	StreamBufferHandle_t create()
+	{
+		handle_ = xStreamBufferCreateStatic(Size, Trigger, storage_, &cb_);
+		return handle_;
+	}
+
+	bool is_created() const { return handle_ != nullptr; }
+	StreamBufferHandle_t handle() const { return handle_; }
+
+	// Returns bytes written (may be less than len on timeout)
+	size_t send(const void* data, size_t len, TickType_t timeout = portMAX_DELAY)
+	{
+		return xStreamBufferSend(handle_, data, len, timeout);
+	}
+
+	size_t send_from_isr(const void* data, size_t len, BaseType_t* woken = nullptr)
+	{
+		return xStreamBufferSendFromISR(handle_, data, len, woken);
+	}
+
+	// Returns bytes read (0 on timeout)
+	size_t receive(void* buf, size_t len, TickType_t timeout = portMAX_DELAY)
+	{
+		return xStreamBufferReceive(handle_, buf, len, timeout);
+	}
+
+	size_t receive_from_isr(void* buf, size_t len, BaseType_t* woken = nullptr)
+	{
+		return xStreamBufferReceiveFromISR(handle_, buf, len, woken);
+	}
+
+	// Change the wake-up threshold at runtime (1..Size)
+	bool set_trigger(size_t level)
+	{
+		return xStreamBufferSetTriggerLevel(handle_, level) == pdTRUE;
+	}
+
+	// Only succeeds when no task is blocked on the buffer
+	bool reset() { return xStreamBufferReset(handle_) == pdPASS; }
+
+	size_t available() const { return xStreamBufferBytesAvailable(handle_); }
+	size_t space() const { return xStreamBufferSpacesAvailable(handle_); }
+	bool is_empty() const { return xStreamBufferIsEmpty(handle_) == pdTRUE; }
+	bool is_full() const { return xStreamBufferIsFull(handle_) == pdTRUE; }
+
+	static constexpr size_t size() { return Size; }
+	static constexpr size_t trigger() { return Trigger; }
+
+private:
+	StaticStreamBuffer_t cb_;
+	uint8_t storage_[Size + 1];     // kernel needs one spare byte
+	StreamBufferHandle_t handle_ = nullptr;
+};
+
+//=============================================================================
+// StaticMessageBuffer
+//=============================================================================
+
+template<size_t Size>
+class StaticMessageBuffer {
+	static constexpr size_t HEADER_SIZE = sizeof(configMESSAGE_BUFFER_LENGTH_TYPE);
+
+	static_assert(Size > HEADER_SIZE, "StaticMessageBuffer: Size too small for one message");
+
+public:
+	MessageBufferHandle_t create()
+	{
+		handle_ = xMessageBufferCreateStatic(Size, storage_, &cb_);
+		return handle_;
+	}
+
+	bool is_created() const { return handle_ != nullptr; }
+	MessageBufferHandle_t handle() const { return handle_; }
+
+	// Whole message or nothing; false on timeout or len > max_message_size()
+	bool send(const void* data, size_t len, TickType_t timeout = portMAX_DELAY)
+	{
+		return xMessageBufferSend(handle_, data, len, timeout) == len;
+	}
+
+	bool send_from_isr(const void* data, size_t len, BaseType_t* woken = nullptr)
+	{
+		return xMessageBufferSendFromISR(handle_, data, len, woken) == len;
+	}
+
+	// Returns message length, 0 on timeout or if buf is smaller than the
+	// next message (the message stays in the buffer)
+	size_t receive(void* buf, size_t len, TickType_t timeout = portMAX_DELAY)
+	{
+		return xMessageBufferReceive(handle_, buf, len, timeout);
+	}
+
+	size_t receive_from_isr(void* buf, size_t len, BaseType_t* woken = nullptr)
+	{
+		return xMessageBufferReceiveFromISR(handle_, buf, len, woken);
+	}
+
+	// Length of the next message (0 if empty)
+	size_t next_length() const { return xStreamBufferNextMessageLengthBytes(static_cast<StreamBufferHandle_t>(handle_)); }
+
+	bool reset() { return xMessageBufferReset(handle_) == pdPASS; }
+
+	// Free bytes, including the per-message length header
+	size_t space() const { return xMessageBufferSpacesAvailable(handle_); }
+	bool is_empty() const { return xMessageBufferIsEmpty(handle_) == pdTRUE; }
+	bool is_full() const { return xMessageBufferIsFull(handle_) == pdTRUE; }
+
+	static constexpr size_t size() { return Size; }
+	static constexpr size_t header_size() { return HEADER_SIZE; }
+	static constexpr size_t max_message_size() { return Size - HEADER_SIZE; }
+
+private:
+	StaticMessageBuffer_t cb_;
+	uint8_t storage_[Size + 1];
+	MessageBufferHandle_t handle_ = nullptr;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_STREAMBUFFER_HPP__
@@ -0,0 +1,257 @@
+/**
+ * STM32ZERO Software Timers
+ *
+ * RAII wrapper over xTimerCreateStatic() whose callback is any small
+ * callable (lambda with captures) stored in place, no heap:
+ *
+ *   StaticTimer    tick timer, the callback runs in the timer daemon task.
+ *                  create_precise() makes a microsecond timer instead: the
+ *                  daemon timer sleeps the coarse part of the delay and
+ *                  hands the last STM32ZERO_TIMER_HANDOFF_US to a compare
+ *                  channel of the ustim LOW timer, whose interrupt runs
+ *                  the callback (ISR context, FromISR APIs only). Delays
+ *                  already shorter than the handoff never touch the daemon.
+ *
+ * start() / stop() / change_period() are batched: requests from any task
+ * or ISR are coalesced per timer (the latest wins) and applied by the
+ * daemon from a single pended call, which throttles itself against the
+ * timer commands and batch calls it knows are queued, so a burst of
+ * requests alone never overflows configTIMER_QUEUE_LENGTH. Pended calls
+ * from elsewhere (xTimerPendFunctionCall(), event group ISR sets) are not
+ * counted; if they fill the queue before the batch's follow-up call, the
+ * daemon resumes the batch after the next timer command it receives, or
+ * the next request does. start_now() / stop_now() send the command
+ * directly, as xTimerStart() / xTimerStop() do.
+ *
+ * timer::sleep_until() blocks a task until a ustim deadline on the same
+ * compare channel: tick sleep, then the compare interrupt wakes the task
+ * STM32ZERO_TIMER_SPIN_US early and it spins out the rest. Used by the
+ * periodic task and ISO-TP STmin, so sub-tick waits never busy-wait. The
+ * wake-up is one reserved notification bit (STM32ZERO_TIMER_NOTIFY_BIT),
+ * so sleeping tasks keep using the other bits for Notify* primitives.
+ *
+ * The timer queue is instrumented through the FreeRTOS trace hooks
+ * (see FreeRTOSConfig.h): depth and its high-water mark, overflows, and
+ * the latency from send to processing by the daemon of every command.
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static StaticTimer blink;
+ *   blink.create("BLINK", pdMS_TO_TICKS(500), true, [] { led_toggle(); });
+ *   blink.start();
+ *
+ *   STM32ZERO_DTCM static StaticTimer strobe;
+ *   strobe.create_precise("STRB", 250, false, [] { gpio_set(); });  // 250 us
+ *   strobe.start();
+ *
+ *   timer::stats().queue_latency.percentile(990);   // p99 command latency (us)
+ *
+ *   timer::sleep_until(ustim::get() + 350);         // task blocked, not spinning
+ */
+
+#ifndef __STM32ZERO_TIMER_HPP__
+#define __STM32ZERO_TIMER_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-histogram.hpp"
+#include "stm32zero-notify.hpp"
+#include "timers.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Callable storage per timer (bytes)
+#ifndef STM32ZERO_TIMER_SBO_SIZE
+#define STM32ZERO_TIMER_SBO_SIZE  16
+#endif
+
+// Precise mode: compare channel 1 of the ustim LOW timer
+#ifndef STM32ZERO_TIMER_PRECISE
+#if defined(STM32ZERO_USTIM_LOW)
+#define STM32ZERO_TIMER_PRECISE  1
+#else
+#define STM32ZERO_TIMER_PRECISE  0
+#endif
+#endif
+
+// Remaining delay (us) handed from the daemon timer to the compare interrupt
+#ifndef STM32ZERO_TIMER_HANDOFF_US
+#define STM32ZERO_TIMER_HANDOFF_US  (2 * 1000000 / configTICK_RATE_HZ)
+#endif
+
+// sleep_until(): the compare interrupt wakes the task this early (us) and
+// the task spins out the rest (interrupt entry and context switch)
+#ifndef STM32ZERO_TIMER_SPIN_US
+#define STM32ZERO_TIMER_SPIN_US  10
+#endif
+
+// sleep_until(): notification bit set by the compare interrupt. Bit 31 is
+// outside the CMSIS-RTOS2 thread flags (osThreadFlags* use bits 0-30)
+#ifndef STM32ZERO_TIMER_NOTIFY_BIT
+#define STM32ZERO_TIMER_NOTIFY_BIT  31
+#endif
+
+// NVIC priority of the compare interrupt (must allow FromISR calls)
+#ifndef STM32ZERO_TIMER_IRQ_PRIORITY
+#define STM32ZERO_TIMER_IRQ_PRIORITY  5
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// Statistics
+//=============================================================================
+
+struct TimerStats {
+	uint32_t sent;              // timer commands queued (all FreeRTOS timers)
+	uint32_t received;          // timer commands processed by the daemon
+	uint32_t overflows;         // commands and batch calls refused (queue full)
+	uint32_t max_depth;         // queue high-water mark
+	uint32_t requests;          // batched requests
+	uint32_t coalesced;         // requests merged into a pending one
+	uint32_t batches;           // batch calls run by the daemon
+	uint32_t deferred;          // batch calls cut short to leave queue space
+	uint32_t precise_fired;     // callbacks from the compare interrupt
+	uint32_t sleeps;            // sleep_until() waits on the compare interrupt
+	Histogram queue_latency;    // command send -> processed (us)
+	Histogram batch_latency;    // request -> command sent by the daemon (us)
+	Histogram precise_late;     // compare callback after deadline (us)
+};
+
+namespace timer {
+
+TimerStats stats();
+void reset_stats();
+
+// Commands waiting in the timer queue (traced commands + pending batch calls)
+uint32_t depth();
+
+// Notification bit of sleep_until(), for NotifyLayout checks of the
+// tasks that sleep:
+//   static_assert(NotifyLayout<RxDone, timer::SleepNotify>::is_valid(), "");
+using SleepNotify = NotifySemaphore<STM32ZERO_TIMER_NOTIFY_BIT>;
+
+// Blocks the calling task until ustim reaches deadline_us (task context).
+// The wait for the compare interrupt uses only the STM32ZERO_TIMER_NOTIFY_BIT
+// of the task notification value; the other bits are left as they are.
+// Without precise mode the tick sleep rounds up: late by up to one tick,
+// never spinning.
+void sleep_until(uint64_t deadline_us);
+
+} // namespace timer
+
+//=============================================================================
+// StaticTimer
+//=============================================================================
+
+class StaticTimer {
+public:
+	static constexpr size_t SBO_SIZE = STM32ZERO_TIMER_SBO_SIZE;
+
+	StaticTimer() = default;
+
+	// Deletes the timer and waits until the daemon no longer references it
+	// (task context, never from the timer's own callback)
+	~StaticTimer();
+
+	StaticTimer(const StaticTimer&) = delete;
+	StaticTimer& operator=(const StaticTimer&) = delete;
+
+	// Tick timer: fn runs in the daemon task every period ticks
+	template<typename F>
+	bool create(const char* name, TickType_t period, bool auto_reload, F&& fn)
+	{
+		if (handle_ != nullptr) {
+			return false;
+		}
+		bind_(std::forward<F>(fn));
+		return create_(name, period, auto_reload, false);
+	}
+
+	// Precise timer: fn runs in the compare interrupt period_us after start
+	template<typename F>
+	bool create_precise(const char* name, uint32_t period_us, bool auto_reload, F&& fn)
+	{
+		if (handle_ != nullptr) {
+			return false;
+		}
+		bind_(std::forward<F>(fn));
+		return create_(name, period_us, auto_reload, true);
+	}
+
+	bool is_created() const { return handle_ != nullptr; }
+	bool is_precise() const { return precise_; }
+	bool is_active() const;
+
+	// Batched (task or ISR); false if the timer is missing or the batch
+	// call could not be queued (the request stays and goes with the next)
+	bool start();
+	bool stop();
+	bool change_period(uint32_t period);    // ticks, or us when precise
+
+	// Direct (task context, tick timers): one queue entry per call
+	bool start_now(TickType_t timeout = 0);
+	bool stop_now(TickType_t timeout = 0);
+
+	// Callback invocations
+	uint32_t fired() const { return fired_; }
+
+	TimerHandle_t handle() const { return handle_; }
+
+private:
+	enum class Op : uint8_t { NONE, START, STOP, PERIOD };
+
+	template<typename F>
+	void bind_(F&& fn)
+	{
+		using Fn = typename std::decay<F>::type;
+		static_assert(sizeof(Fn) <= SBO_SIZE, "StaticTimer: callable exceeds STM32ZERO_TIMER_SBO_SIZE");
+		static_assert(alignof(Fn) <= alignof(std::max_align_t), "StaticTimer: callable over-aligned");
+		static_assert(std::is_trivially_copyable<Fn>::value,
+			      "StaticTimer: callable must be trivially copyable (capture pointers/values)");
+
+		new (storage_) Fn(std::forward<F>(fn));
+		invoke_ = [](void* p) { (*static_cast<Fn*>(p))(); };
+	}
+
+	bool create_(const char* name, uint32_t period, bool auto_reload, bool precise);
+	bool request_(Op op, uint32_t arg);
+	bool apply_(Op op, uint32_t arg, TickType_t tick);
+	void fire_();
+
+	static void daemon_callback_(TimerHandle_t handle);
+	static void flush_(void* unused, uint32_t unused2);
+
+	friend struct TimerAccess;
+
+	TimerHandle_t handle_ = nullptr;
+	StaticTimer_t timer_;
+	void (*invoke_)(void*) = nullptr;
+	alignas(std::max_align_t) uint8_t storage_[SBO_SIZE];
+
+	volatile uint32_t fired_ = 0;
+	uint32_t period_ = 0;               // ticks, or us when precise
+	bool auto_reload_ = false;
+	bool precise_ = false;
+
+	// Batch state (guarded by the interrupt mask)
+	StaticTimer* batch_next_ = nullptr;
+	Op op_ = Op::NONE;
+	uint32_t arg_ = 0;
+	TickType_t tick_ = 0;               // tick of the request (start base)
+	uint32_t request_us_ = 0;
+
+	// Precise state (guarded by the interrupt mask)
+	StaticTimer* armed_next_ = nullptr;
+	uint64_t deadline_ = 0;
+	bool running_ = false;
+	bool armed_ = false;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_TIMER_HPP__
@@ -0,0 +1,180 @@
+/**
+ * STM32ZERO Trace Recorder
+ *
+ * Records scheduler and queue activity into a ring of 8-byte records
+ * stamped with the low 32 bits of ustim (1 us):
+ *
+ *   - context switches        traceTASK_SWITCHED_IN (task number)
+ *   - queue / semaphore ops   traceQUEUE_SEND / RECEIVE (+ FromISR, blocking)
+ *   - ISR entry / exit        trace::IsrScope, or stm32zero_trace_isr_enter()
+ *                             / _exit() in C handlers (exception number)
+ *   - user marks              trace::mark()
+ *
+ * The FreeRTOS hooks are defined in FreeRTOSConfig.h and call
+ * stm32zero_trace_record() with the codes of trace::Event. Writers claim
+ * a slot with LDREX/STREX, so tasks and nested ISRs record without a lock
+ * and without masking interrupts.
+ *
+ *   SNAPSHOT  flight recorder: the ring wraps; trigger() keeps recording
+ *             for a number of records and then freezes the ring for
+ *             dump() or copy()
+ *   STREAM    a low-priority task drains the ring over sio; when the ring
+ *             is full new records are dropped (counted)
+ *
+ * dump() and the stream write text lines over sio: "#" header lines (task
+ * names, dropped count) and "=" lines of hex records. tools/trace2perfetto.py
+ * turns a captured console log into Chrome/Perfetto trace JSON.
+ *
+ * Usage:
+ *   trace::start();                    // snapshot mode, recording
+ *   ...
+ *   if (latency > limit) {
+ *       trace::trigger(64);           // 64 more records, then freeze
+ *   }
+ *   ...
+ *   trace::dump();                     // task context
+ */
+
+#ifndef __STM32ZERO_TRACE_HPP__
+#define __STM32ZERO_TRACE_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include <cstddef>
+#include <cstdint>
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// Ring size in records (power of two, 8 bytes each)
+#ifndef STM32ZERO_TRACE_SIZE
+#define STM32ZERO_TRACE_SIZE  512
+#endif
+
+// Ring placement (DTCM: zero wait states; SRAM4 also survives D1 standby)
+#ifndef STM32ZERO_TRACE_SECTION
+#define STM32ZERO_TRACE_SECTION  STM32ZERO_DTCM
+#endif
+
+// Stream task stack (words) and drain interval (ms)
+#ifndef STM32ZERO_TRACE_STREAM_STACK
+#define STM32ZERO_TRACE_STREAM_STACK  384
+#endif
+
+#ifndef STM32ZERO_TRACE_STREAM_MS
+#define STM32ZERO_TRACE_STREAM_MS  10
+#endif
+
+// Task name table size for dump() / stream
+#ifndef STM32ZERO_TRACE_MAX_TASKS
+#define STM32ZERO_TRACE_MAX_TASKS  24
+#endif
+
+extern "C" {
+void stm32zero_trace_record(uint32_t info);
+uint32_t stm32zero_trace_queue_id(void);
+void stm32zero_trace_isr_enter(void);
+void stm32zero_trace_isr_exit(void);
+}
+
+namespace stm32zero {
+namespace trace {
+
+static_assert((STM32ZERO_TRACE_SIZE & (STM32ZERO_TRACE_SIZE - 1)) == 0,
+	      "STM32ZERO_TRACE_SIZE must be a power of two");
+
+constexpr size_t SIZE = STM32ZERO_TRACE_SIZE;
+
+// Codes used by the hooks in FreeRTOSConfig.h (keep in sync)
+enum class Event : uint8_t {
+	NONE = 0,                   // empty / uncommitted slot
+	TASK_IN = 1,                // arg = task number
+	ISR_ENTER = 2,              // arg = exception number (IRQn + 16)
+	ISR_EXIT = 3,               // arg = exception number
+	QUEUE_SEND = 4,             // arg = queue number, aux = items before
+	QUEUE_SEND_ISR = 5,
+	QUEUE_RECEIVE = 6,
+	QUEUE_RECEIVE_ISR = 7,
+	QUEUE_BLOCK_SEND = 8,
+	QUEUE_BLOCK_RECEIVE = 9,
+	MARK = 10,                  // arg = user id, aux = user value
+	TRIGGER = 11,
+};
+
+struct Record {
+	uint32_t ts;                // ustim, low 32 bits
+	uint32_t info;              // event | aux << 8 | arg << 16
+
+	Event event() const { return static_cast<Event>(info & 0xFF); }
+	uint8_t aux() const { return static_cast<uint8_t>(info >> 8); }
+	uint16_t arg() const { return static_cast<uint16_t>(info >> 16); }
+};
+
+static_assert(sizeof(Record) == 8, "trace::Record must be 8 bytes");
+
+constexpr uint32_t info(Event ev, uint8_t aux, uint16_t arg)
+{
+	return static_cast<uint32_t>(ev) | (static_cast<uint32_t>(aux) << 8) |
+	       (static_cast<uint32_t>(arg) << 16);
+}
+
+enum class Mode : uint8_t {
+	OFF,
+	SNAPSHOT,
+	STREAM,
+	FROZEN,                     // snapshot after the trigger completed
+};
+
+struct Stats {
+	uint32_t recorded;          // records claimed since start()
+	uint32_t dropped;           // stream mode, ring full
+	uint32_t streamed;          // records written by the stream task
+};
+
+// Clear the ring and record in SNAPSHOT mode (STREAM: use stream_start())
+void start();
+void stop();
+
+Mode mode();
+bool is_frozen();
+
+// Snapshot: record a TRIGGER now and freeze after post more records
+void trigger(uint32_t post = SIZE / 2);
+
+// Record timestamp now: low 32 bits of ustim (one timer read with a
+// 32-bit LOW timer, three APB reads with a 16-bit one)
+uint32_t timestamp();
+
+// User event (task or ISR)
+inline void mark(uint16_t id, uint8_t value = 0)
+{
+	stm32zero_trace_record(info(Event::MARK, value, id));
+}
+
+// ISR entry / exit around a handler body
+class IsrScope {
+public:
+	IsrScope() { stm32zero_trace_isr_enter(); }
+	~IsrScope() { stm32zero_trace_isr_exit(); }
+
+	IsrScope(const IsrScope&) = delete;
+	IsrScope& operator=(const IsrScope&) = delete;
+};
+
+// Committed records, oldest first (stop or freeze first); returns count
+size_t copy(Record* out, size_t max);
+
+// Write the ring over sio (task context); returns records written
+size_t dump();
+
+// Stream over sio from a task at the given priority until stream_stop()
+bool stream_start(freertos::Priority priority = freertos::Priority::LOW);
+void stream_stop();
+
+Stats stats();
+
+} // namespace trace
+} // namespace stm32zero
+
+#endif // __STM32ZERO_TRACE_HPP__
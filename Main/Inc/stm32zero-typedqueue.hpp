@@ -0,0 +1,245 @@
+/**
+ * STM32ZERO Typed FreeRTOS Queue
+ *
+ * TypedQueue<T, N> is a statically allocated queue of T with type-checked
+ * send/receive. The kernel still copies items bytewise, so T must be
+ * trivially copyable or trivially relocatable (see stm32zero-pool.hpp):
+ *
+ *   - Trivially copyable T: send() copies, receive() copies out.
+ *   - Relocatable handles (PoolPtr<T>): send(std::move(p)) transfers
+ *     ownership into the queue, receive() transfers it out. Large records
+ *     cross the queue at pointer cost (zero-copy mode).
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static TypedQueue<Event, 8> events;
+ *   events.create();
+ *   events.emplace(portMAX_DELAY, EventType::RX, 42);
+ *
+ *   STM32ZERO_DTCM static ObjectPool<Record, 16> pool;
+ *   STM32ZERO_DTCM static TypedQueue<PoolPtr<Record>, 16> records;
+ *   auto rec = pool.make();
+ *   records.send(std::move(rec));         // only the handle is copied
+ *   PoolPtr<Record> got;
+ *   records.receive(got);                 // slot returns to pool when got dies
+ *
+ * A reader that waits on more than one source (a coro::Executor) binds
+ * its task with set_reader(): every successful send then gives the
+ * task's notification, used as a wake-up counter.
+ */
+
+#ifndef __STM32ZERO_TYPEDQUEUE_HPP__
+#define __STM32ZERO_TYPEDQUEUE_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-pool.hpp"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//=============================================================================
+// Configuration
+//=============================================================================
+
+// Largest item copied through a TypedQueue (use PoolPtr<T> above this)
+#ifndef STM32ZERO_TYPEDQUEUE_MAX_ITEM_SIZE
+#define STM32ZERO_TYPEDQUEUE_MAX_ITEM_SIZE  256
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+template<typename T, size_t N>
+class TypedQueue {
+	static_assert(N > 0, "TypedQueue: N must be > 0");
+	static_assert(is_trivially_relocatable<T>::value,
+		      "TypedQueue: T must be trivially copyable or relocatable (kernel copies bytes)");
+	static_assert(sizeof(T) <= STM32ZERO_TYPEDQUEUE_MAX_ITEM_SIZE,
+		      "TypedQueue: item too large, pass PoolPtr<T> instead");
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+		      "TypedQueue: over-aligned T (e.g. DmaBuffer) should not be copied through a queue");
+
+	static constexpr bool is_copyable_ = std::is_trivially_copyable<T>::value;
+
+public:
+	QueueHandle_t create()
+	{
+		handle_ = xQueueCreateStatic(N, sizeof(T), storage_, &qcb_);
+		return handle_;
+	}
+
+	bool is_created() const { return handle_ != nullptr; }
+	QueueHandle_t handle() const { return handle_; }
+
+	// Task notified after each successful send (nullptr: none)
+	void set_reader(TaskHandle_t task) { reader_ = task; }
+	TaskHandle_t reader() const { return reader_; }
+
+	//-------------------------------------------------------------------------
+	// Send
+	//-------------------------------------------------------------------------
+
+	// Copy item into the queue (trivially copyable T only)
+	bool send(const T& item, TickType_t timeout = portMAX_DELAY)
+	{
+		static_assert(is_copyable_, "TypedQueue: T is move-only, use send(std::move(item))");
+		return sent_(xQueueSend(handle_, &item, timeout) == pdTRUE);
+	}
+
+	bool send_from_isr(const T& item, BaseType_t* woken = nullptr)
+	{
+		static_assert(is_copyable_, "TypedQueue: T is move-only, use send_from_isr(std::move(item))");
+		return sent_from_isr_(xQueueSendFromISR(handle_, &item, woken) == pdTRUE, woken);
+	}
+
+	// Move item into the queue; item is left empty on success, unchanged on failure
+	bool send(T&& item, TickType_t timeout = portMAX_DELAY)
+	{
+		return sent_(relocate_in_(item, [&](const void* p) {
+			return xQueueSend(handle_, p, timeout) == pdTRUE;
+		}));
+	}
+
+	bool send_from_isr(T&& item, BaseType_t* woken = nullptr)
+	{
+		return sent_from_isr_(relocate_in_(item, [&](const void* p) {
+			return xQueueSendFromISR(handle_, p, woken) == pdTRUE;
+		}), woken);
+	}
+
+	// Send to the front (urgent item)
+	bool send_front(T&& item, TickType_t timeout = portMAX_DELAY)
+	{
+		return sent_(relocate_in_(item, [&](const void* p) {
+			return xQueueSendToFront(handle_, p, timeout) == pdTRUE;
+		}));
+	}
+
+	// Construct an item from args and send it
+	template<typename... Args>
+	bool emplace(TickType_t timeout, Args&&... args)
+	{
+		return send(T(std::forward<Args>(args)...), timeout);
+	}
+
+	//-------------------------------------------------------------------------
+	// Receive
+	//-------------------------------------------------------------------------
+
+	// Move the front item out of the queue into out (previous content of out is released)
+	bool receive(T& out, TickType_t timeout = portMAX_DELAY)
+	{
+		if constexpr (is_copyable_) {
+			return xQueueReceive(handle_, &out, timeout) == pdTRUE;
+		} else {
+			return relocate_out_(out, [&](void* p) {
+				return xQueueReceive(handle_, p, timeout) == pdTRUE;
+			});
+		}
+	}
+
+	bool receive_from_isr(T& out, BaseType_t* woken = nullptr)
+	{
+		if constexpr (is_copyable_) {
+			return xQueueReceiveFromISR(handle_, &out, woken) == pdTRUE;
+		} else {
+			return relocate_out_(out, [&](void* p) {
+				return xQueueReceiveFromISR(handle_, p, woken) == pdTRUE;
+			});
+		}
+	}
+
+	// Copy the front item without removing it (trivially copyable T only)
+	bool peek(T& out, TickType_t timeout = 0)
+	{
+		static_assert(is_copyable_, "TypedQueue: cannot peek a move-only item");
+		return xQueuePeek(handle_, &out, timeout) == pdTRUE;
+	}
+
+	//-------------------------------------------------------------------------
+	// State
+	//-------------------------------------------------------------------------
+
+	// Drop all items (owning items are destroyed, releasing their resources)
+	void reset()
+	{
+		if constexpr (is_copyable_) {
+			xQueueReset(handle_);
+		} else {
+			T tmp;
+			while (receive(tmp, 0)) {
+			}
+		}
+	}
+
+	UBaseType_t count() const { return uxQueueMessagesWaiting(handle_); }
+	UBaseType_t available() const { return uxQueueSpacesAvailable(handle_); }
+	bool is_empty() const { return count() == 0; }
+	bool is_full() const { return available() == 0; }
+
+	static constexpr size_t item_size() { return sizeof(T); }
+	static constexpr size_t length() { return N; }
+
+private:
+	bool sent_(bool ok)
+	{
+		if (ok && reader_ != nullptr) {
+			xTaskNotifyGive(reader_);
+		}
+		return ok;
+	}
+
+	bool sent_from_isr_(bool ok, BaseType_t* woken)
+	{
+		if (ok && reader_ != nullptr) {
+			vTaskNotifyGiveFromISR(reader_, woken);
+		}
+		return ok;
+	}
+
+	// Bitwise move item into the kernel; the queue now owns its resources
+	template<typename Fn>
+	bool relocate_in_(T& item, Fn&& kernel_send)
+	{
+		if constexpr (is_copyable_) {
+			return kernel_send(&item);
+		} else {
+			alignas(T) uint8_t raw[sizeof(T)];
+			T* tmp = new (raw) T(std::move(item));
+			if (kernel_send(raw)) {
+				return true;    // ownership now in queue storage, tmp is forgotten
+			}
+			item = std::move(*tmp);
+			tmp->~T();
+			return false;
+		}
+	}
+
+	// Bitwise move an item out of the kernel into out
+	template<typename Fn>
+	bool relocate_out_(T& out, Fn&& kernel_receive)
+	{
+		alignas(T) uint8_t raw[sizeof(T)];
+		if (!kernel_receive(raw)) {
+			return false;
+		}
+		T* tmp = std::launder(reinterpret_cast<T*>(raw));
+		out = std::move(*tmp);
+		tmp->~T();
+		return true;
+	}
+
+	StaticQueue_t qcb_;
+	alignas(T) uint8_t storage_[sizeof(T) * N];
+	QueueHandle_t handle_ = nullptr;
+	TaskHandle_t reader_ = nullptr;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_TYPEDQUEUE_HPP__
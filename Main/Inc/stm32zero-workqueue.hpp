@@ -0,0 +1,270 @@
+/**
+ * STM32ZERO Work Queue
+ *
+ * Deferred work on a fixed pool of pre-created StaticTask workers instead
+ * of one xTaskCreate() per job (no heap, no stack per job, no task
+ * creation on the hot path).
+ *
+ *   WorkQueue<Workers, Depth, StackWords>
+ *     Workers     worker tasks sharing the queue
+ *     Depth       items per priority lane
+ *     StackWords  stack of each worker
+ *
+ * Work items are callables stored in place (small-buffer, no allocation):
+ * they must be trivially copyable and fit STM32ZERO_WORK_SBO_SIZE bytes,
+ * which covers lambdas capturing a few pointers or integers.
+ *
+ * Three lanes (HIGH, NORMAL, LOW): a worker always takes the oldest item
+ * of the highest non-empty lane. After waking, a worker drains up to
+ * STM32ZERO_WORKQUEUE_BATCH items before blocking again. Each lane
+ * records its queue latency (submit -> start of execution).
+ *
+ * Usage:
+ *   STM32ZERO_DTCM static WorkQueue<2, 8, 256> work;
+ *   work.start("WORK", Priority::ABOVE_NORMAL);
+ *
+ *   work.submit(WorkLane::HIGH, [dev]() { dev->flush(); });
+ *   // ISR:
+ *   work.submit_from_isr(WorkLane::NORMAL, [idx]() { process(idx); }, &woken);
+ */
+
+#ifndef __STM32ZERO_WORKQUEUE_HPP__
+#define __STM32ZERO_WORKQUEUE_HPP__
+
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-typedqueue.hpp"
+#include "stm32zero-ustim.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Inline storage for a work item's callable
+#ifndef STM32ZERO_WORK_SBO_SIZE
+#define STM32ZERO_WORK_SBO_SIZE  24
+#endif
+
+// Items a worker runs per wake-up before blocking again
+#ifndef STM32ZERO_WORKQUEUE_BATCH
+#define STM32ZERO_WORKQUEUE_BATCH  8
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+enum class WorkLane : uint8_t {
+	HIGH = 0,
+	NORMAL,
+	LOW,
+};
+
+static constexpr size_t WORK_LANES = 3;
+
+//=============================================================================
+// WorkItem (small-buffer callable)
+//=============================================================================
+
+class WorkItem {
+public:
+	static constexpr size_t SBO_SIZE = STM32ZERO_WORK_SBO_SIZE;
+
+	WorkItem() = default;
+
+	template<typename F>
+	explicit WorkItem(F&& fn)
+	{
+		using Fn = typename std::decay<F>::type;
+		static_assert(sizeof(Fn) <= SBO_SIZE, "WorkItem: callable exceeds STM32ZERO_WORK_SBO_SIZE");
+		static_assert(alignof(Fn) <= alignof(std::max_align_t), "WorkItem: callable over-aligned");
+		static_assert(std::is_trivially_copyable<Fn>::value,
+			      "WorkItem: callable must be trivially copyable (capture pointers/values)");
+
+		new (storage_) Fn(std::forward<F>(fn));
+		invoke_ = [](void* p) { (*static_cast<Fn*>(p))(); };
+	}
+
+	void operator()() { invoke_(storage_); }
+	explicit operator bool() const { return invoke_ != nullptr; }
+
+	uint32_t enqueue_us = 0;    // set by WorkQueue::submit()
+
+private:
+	void (*invoke_)(void*) = nullptr;
+	alignas(std::max_align_t) uint8_t storage_[SBO_SIZE];
+};
+
+static_assert(std::is_trivially_copyable<WorkItem>::value, "WorkItem must be trivially copyable");
+
+//=============================================================================
+// WorkQueue
+//=============================================================================
+
+struct WorkLaneStats {
+	uint32_t submitted;
+	uint32_t executed;
+	uint32_t dropped;           // lane full
+	uint32_t max_wait_us;
+	uint64_t total_wait_us;
+
+	uint32_t avg_wait_us() const { return executed ? static_cast<uint32_t>(total_wait_us / executed) : 0; }
+};
+
+template<size_t Workers, size_t Depth, size_t StackWords>
+class WorkQueue {
+	static_assert(Workers > 0, "WorkQueue: Workers must be > 0");
+	static_assert(Depth > 0, "WorkQueue: Depth must be > 0");
+
+public:
+	// Create lanes and worker tasks (all workers share priority)
+	bool start(const char* name, Priority priority)
+	{
+		for (auto& lane : lanes_) {
+			if (lane.create() == nullptr) {
+				return false;
+			}
+		}
+		if (items_.create(0) == nullptr) {
+			return false;
+		}
+		for (auto& st : stats_) {
+			st = {};
+		}
+		for (auto& w : workers_) {
+			if (w.create(worker_func_, name, priority, this) == nullptr) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Returns false if the lane is still full after timeout
+	template<typename F>
+	bool submit(WorkLane lane, F&& fn, TickType_t timeout = 0)
+	{
+		WorkItem item(std::forward<F>(fn));
+		item.enqueue_us = static_cast<uint32_t>(ustim::get());
+
+		size_t l = static_cast<size_t>(lane);
+		if (!lanes_[l].send(item, timeout)) {
+			count_(stats_[l].dropped);
+			return false;
+		}
+		count_(stats_[l].submitted);
+		items_.give();
+		return true;
+	}
+
+	template<typename F>
+	bool submit_from_isr(WorkLane lane, F&& fn, BaseType_t* woken = nullptr)
+	{
+		WorkItem item(std::forward<F>(fn));
+		item.enqueue_us = static_cast<uint32_t>(ustim::get());
+
+		size_t l = static_cast<size_t>(lane);
+		if (!lanes_[l].send_from_isr(item, woken)) {
+			count_(stats_[l].dropped);
+			return false;
+		}
+		count_(stats_[l].submitted);
+		items_.give_from_isr(woken);
+		return true;
+	}
+
+	// Items waiting in all lanes
+	size_t pending() const
+	{
+		size_t n = 0;
+		for (const auto& lane : lanes_) {
+			n += lane.count();
+		}
+		return n;
+	}
+
+	WorkLaneStats stats(WorkLane lane) const
+	{
+		CriticalSection cs;
+		return stats_[static_cast<size_t>(lane)];
+	}
+
+	void reset_stats()
+	{
+		CriticalSection cs;
+		for (auto& st : stats_) {
+			st = {};
+		}
+	}
+
+	// Worker wake-ups (items / wakeups = achieved batch size)
+	uint32_t wakeups() const { return wakeups_; }
+
+	static constexpr size_t workers() { return Workers; }
+	static constexpr size_t depth() { return Depth; }
+
+private:
+	static void count_(volatile uint32_t& counter)
+	{
+		CriticalSection cs;
+		counter = counter + 1;
+	}
+
+	// Highest non-empty lane first
+	bool take_(WorkItem& item, size_t& lane)
+	{
+		for (size_t l = 0; l < WORK_LANES; l++) {
+			if (lanes_[l].receive(item, 0)) {
+				lane = l;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void run_(WorkItem& item, size_t lane)
+	{
+		uint32_t wait = static_cast<uint32_t>(ustim::get()) - item.enqueue_us;
+		{
+			CriticalSection cs;
+			WorkLaneStats& st = stats_[lane];
+			st.executed++;
+			st.total_wait_us += wait;
+			if (wait > st.max_wait_us) {
+				st.max_wait_us = wait;
+			}
+		}
+		item();
+	}
+
+	static void worker_func_(void* param)
+	{
+		WorkQueue* self = static_cast<WorkQueue*>(param);
+		WorkItem item;
+		size_t lane = 0;
+
+		while (true) {
+			self->items_.take(portMAX_DELAY);
+			count_(self->wakeups_);
+
+			// One semaphore count per item: the item is in some lane
+			size_t batch = 0;
+			do {
+				if (self->take_(item, lane)) {
+					self->run_(item, lane);
+				}
+			} while (++batch < STM32ZERO_WORKQUEUE_BATCH && self->items_.take(0));
+		}
+	}
+
+	TypedQueue<WorkItem, Depth> lanes_[WORK_LANES];
+	StaticCountingSemaphore<Depth * WORK_LANES> items_;
+	StaticTask<StackWords> workers_[Workers];
+	WorkLaneStats stats_[WORK_LANES] = {};
+	volatile uint32_t wakeups_ = 0;
+};
+
+} // namespace freertos
+} // namespace stm32zero
+
+#endif // __STM32ZERO_WORKQUEUE_HPP__
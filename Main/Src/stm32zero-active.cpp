@@ -0,0 +1,121 @@
+/**
+ * STM32ZERO Active Objects
+ *
+ * The kernel task blocks on its notification value (one give per posted
+ * event, cleared on wake) and then drains all mailboxes in priority order.
+ */
+
+#include "stm32zero-active.hpp"
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// ActiveBase
+//=============================================================================
+
+bool ActiveBase::attach_(ActiveKernelBase& kernel, uint8_t priority)
+{
+	return kernel.attach(*this, priority);
+}
+
+void ActiveBase::wake_kernel_()
+{
+	if (kernel_ != nullptr) {
+		kernel_->wake();
+	}
+}
+
+void ActiveBase::wake_kernel_from_isr_(BaseType_t* woken)
+{
+	if (kernel_ != nullptr) {
+		kernel_->wake_from_isr(woken);
+	}
+}
+
+void ActiveBase::record_(uint32_t post_us, uint32_t start_us, uint32_t end_us)
+{
+	uint32_t latency = start_us - post_us;
+	uint32_t run = end_us - start_us;
+
+	CriticalSection cs;
+	stats_.dispatched++;
+	stats_.total_latency_us += latency;
+	if (latency > stats_.max_latency_us) {
+		stats_.max_latency_us = latency;
+	}
+	if (run > stats_.max_run_us) {
+		stats_.max_run_us = run;
+	}
+}
+
+void ActiveBase::count_dropped_()
+{
+	CriticalSection cs;
+	stats_.dropped++;
+}
+
+//=============================================================================
+// ActiveKernelBase
+//=============================================================================
+
+bool ActiveKernelBase::attach(ActiveBase& object, uint8_t priority)
+{
+	CriticalSection cs;
+
+	if (object.kernel_ != nullptr || count_ >= capacity_) {
+		return false;
+	}
+
+	// Insertion sort: highest priority first, FIFO among equals
+	size_t pos = count_;
+	while (pos > 0 && objects_[pos - 1]->priority_ < priority) {
+		objects_[pos] = objects_[pos - 1];
+		pos--;
+	}
+	objects_[pos] = &object;
+	count_++;
+
+	object.priority_ = priority;
+	object.kernel_ = this;
+	return true;
+}
+
+void ActiveKernelBase::wake()
+{
+	if (task_ != nullptr) {
+		xTaskNotifyGive(task_);
+	}
+}
+
+void ActiveKernelBase::wake_from_isr(BaseType_t* woken)
+{
+	if (task_ != nullptr) {
+		vTaskNotifyGiveFromISR(task_, woken);
+	}
+}
+
+bool ActiveKernelBase::dispatch_next_()
+{
+	for (size_t i = 0; i < count_; i++) {
+		if (objects_[i]->dispatch_one_()) {
+			dispatched_ = dispatched_ + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ActiveKernelBase::run_()
+{
+	while (true) {
+		// Events posted before start() or before attach are picked up here too
+		while (dispatch_next_()) {
+		}
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		wakeups_ = wakeups_ + 1;
+	}
+}
+
+} // namespace freertos
+} // namespace stm32zero
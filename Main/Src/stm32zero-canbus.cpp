@@ -0,0 +1,1385 @@
+/**
+ * STM32ZERO FDCAN Bus with Hardware Filter Routing
+ *
+ * Filters are kept in add order and written to consecutive standard /
+ * extended filter elements on start(), so the filter index the controller
+ * stores with every accepted frame maps straight back to its route. Filter
+ * elements beyond the table are disabled. Dedicated RX buffers are
+ * assigned in the same order (standard filters first).
+ *
+ * Lease routes own their RX FIFO, so the interrupt knows the route of
+ * the next element before reading it and reads it straight into a free
+ * slot. Without a free slot it stops draining and marks the FIFO held;
+ * the release() that frees a slot drains it again with the FDCAN
+ * interrupt masked.
+ *
+ * The TX complete interrupt is enabled for the TX FIFO/queue elements
+ * and the reserved TX buffers. Its indexes keep the bits of elements
+ * completed earlier (TXBTO is cleared only by the next request), so the
+ * bus tracks its own requests (tx_inflight_) to find the new ones and
+ * add their queueing delay. A sleeping FIFO writer is woken only when
+ * enough elements are free (tx_want_), a TX buffer writer when its
+ * buffer completes.
+ *
+ * The bus tap reads PSR (GetProtocolStatus()) in the error status
+ * callback for the new state and in the error callback for the last
+ * error code. Reading PSR resets LEC / DLEC, and the HAL runs the status
+ * callback first when both interrupts are pending, so that one keeps the
+ * codes it read for the error callback.
+ *
+ * RX and TX event stamps are 16-bit TIM3 counts latched by the
+ * controller. The interrupt reads them well within one 65.5 ms wrap, so
+ * extending against the current ustim time gives the full value.
+ */
+
+#include "stm32zero-canbus.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-masklock.hpp"
+#include <cstring>
+
+#if STM32ZERO_CANBUS_TIMESTAMPS && defined(STM32ZERO_USTIM_LOW) && (STM32ZERO_USTIM_LOW != 3)
+#error "STM32ZERO_CANBUS_TIMESTAMPS needs TIM3 as the ustim low stage (FDCAN external timestamp)"
+#endif
+
+namespace stm32zero {
+namespace fdcan {
+
+//=============================================================================
+// Internal State
+//=============================================================================
+
+namespace {
+
+constexpr uint32_t STD_ID_MAX = 0x7FFU;
+constexpr uint32_t EXT_ID_MAX = 0x1FFFFFFFU;
+
+constexpr uint32_t RX_ITS = FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_RX_FIFO0_MESSAGE_LOST |
+			    FDCAN_IT_RX_FIFO1_NEW_MESSAGE | FDCAN_IT_RX_FIFO1_MESSAGE_LOST;
+
+constexpr uint32_t TX_EVENT_ITS = FDCAN_IT_TX_EVT_FIFO_NEW_DATA | FDCAN_IT_TX_EVT_FIFO_ELT_LOST;
+
+constexpr uint32_t ERROR_ITS = FDCAN_IT_ARB_PROTOCOL_ERROR | FDCAN_IT_DATA_PROTOCOL_ERROR;
+constexpr uint32_t STATUS_ITS = FDCAN_IT_ERROR_WARNING | FDCAN_IT_ERROR_PASSIVE | FDCAN_IT_BUS_OFF;
+constexpr uint32_t PROTOCOL_ERRORS = HAL_FDCAN_ERROR_PROTOCOL_ARBT | HAL_FDCAN_ERROR_PROTOCOL_DATA;
+
+constexpr uint8_t TAP_FLAGS = CanFrame::FLAG_EXT | CanFrame::FLAG_FD | CanFrame::FLAG_BRS;
+
+const uint8_t DLC_LEN[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+CanBus* buses_[STM32ZERO_CANBUS_MAX_BUSES] = {};
+
+inline uint32_t filter_type_(FilterKind kind)
+{
+	switch (kind) {
+	case FilterKind::MASK:
+		return FDCAN_FILTER_MASK;
+	case FilterKind::RANGE:
+		return FDCAN_FILTER_RANGE;
+	default:
+		return FDCAN_FILTER_DUAL;
+	}
+}
+
+inline uint32_t filter_config_(RxTarget target)
+{
+	switch (target) {
+	case RxTarget::FIFO1:
+		return FDCAN_FILTER_TO_RXFIFO1;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	case RxTarget::BUFFER:
+		return FDCAN_FILTER_TO_RXBUFFER;
+#endif
+	default:
+		return FDCAN_FILTER_TO_RXFIFO0;
+	}
+}
+
+// TX FIFO/queue size and its TX buffer index bits. The H7 message RAM
+// places the FIFO after the dedicated TX buffers; the H5 FDCAN has three
+// fixed elements.
+inline uint32_t tx_fifo_size_(const FDCAN_HandleTypeDef* hfdcan)
+{
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	return hfdcan->Init.TxFifoQueueElmtsNbr;
+#else
+	(void)hfdcan;
+	return 3;
+#endif
+}
+
+inline uint32_t tx_fifo_mask_(const FDCAN_HandleTypeDef* hfdcan)
+{
+	uint64_t bits = (1ULL << tx_fifo_size_(hfdcan)) - 1U;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	bits <<= hfdcan->Init.TxBuffersNbr;
+#endif
+	return static_cast<uint32_t>(bits);
+}
+
+// Free TX FIFO/queue elements. In queue mode (TXBC.TFQM = 1, TxOrder::
+// PRIORITY) the M_CAN reads TXFQS.TFFL as 0: there only TFQF is valid and
+// the free elements are those without a pending request in TXBRP.
+inline uint32_t tx_free_(FDCAN_HandleTypeDef* hfdcan)
+{
+	if (hfdcan->Init.TxFifoQueueMode != FDCAN_TX_QUEUE_OPERATION) {
+		return HAL_FDCAN_GetTxFifoFreeLevel(hfdcan);
+	}
+	if ((hfdcan->Instance->TXFQS & FDCAN_TXFQS_TFQF) != 0U) {
+		return 0;
+	}
+	return static_cast<uint32_t>(__builtin_popcount(tx_fifo_mask_(hfdcan) & ~hfdcan->Instance->TXBRP));
+}
+
+// Reserved TX buffer key: ID, bit 31 for extended IDs
+inline uint32_t tx_key_(uint32_t id, bool ext)
+{
+	return ext ? (id | 0x80000000U) : id;
+}
+
+// Ticks left of a timeout that started at start; false once it passed
+inline bool remaining_(TickType_t start, TickType_t timeout, TickType_t& remain)
+{
+	remain = timeout;
+	if (timeout != portMAX_DELAY) {
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= timeout) {
+			return false;
+		}
+		remain = timeout - elapsed;
+	}
+	return true;
+}
+
+inline uint32_t fifo_index_(uint32_t fifo)
+{
+	return fifo == FDCAN_RX_FIFO0 ? 0 : 1;
+}
+
+inline bool tx_valid_(const CanFrame& frame)
+{
+	if (frame.id > (frame.is_ext() ? EXT_ID_MAX : STD_ID_MAX)) {
+		return false;
+	}
+	return frame.len <= (frame.is_fd() ? 64 : 8);
+}
+
+void tx_header_(const CanFrame& frame, FDCAN_TxHeaderTypeDef& header)
+{
+	memset(&header, 0, sizeof(header));
+	header.Identifier = frame.id;
+	header.IdType = frame.is_ext() ? FDCAN_EXTENDED_ID : FDCAN_STANDARD_ID;
+	header.TxFrameType = FDCAN_DATA_FRAME;
+	header.DataLength = len_to_dlc(frame.len);
+	header.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
+	header.BitRateSwitch = (frame.flags & CanFrame::FLAG_BRS) != 0 ? FDCAN_BRS_ON : FDCAN_BRS_OFF;
+	header.FDFormat = frame.is_fd() ? FDCAN_FD_CAN : FDCAN_CLASSIC_CAN;
+	if ((frame.flags & CanFrame::FLAG_EVENT) != 0) {
+		header.TxEventFifoControl = FDCAN_STORE_TX_EVENTS;
+		header.MessageMarker = frame.filter;
+	} else {
+		header.TxEventFifoControl = FDCAN_NO_TX_EVENTS;
+		header.MessageMarker = 0;
+	}
+}
+
+// Frame format flags of a received frame (CanFrame::FLAG_EXT / FD / BRS)
+inline uint8_t rx_flags_(const FDCAN_RxHeaderTypeDef& header)
+{
+	uint8_t flags = 0;
+	if (header.IdType == FDCAN_EXTENDED_ID) {
+		flags |= CanFrame::FLAG_EXT;
+	}
+	if (header.FDFormat == FDCAN_FD_CAN) {
+		flags |= CanFrame::FLAG_FD;
+	}
+	if (header.BitRateSwitch == FDCAN_BRS_ON) {
+		flags |= CanFrame::FLAG_BRS;
+	}
+	return flags;
+}
+
+// Controller stamp (TIM3 count at SOF) in ustim microseconds
+inline uint64_t stamp_(uint32_t stamp)
+{
+#if STM32ZERO_CANBUS_TIMESTAMPS
+	return extend_stamp(stamp, ustim::get());
+#else
+	(void)stamp;
+	return ustim::get();
+#endif
+}
+
+} // namespace
+
+//=============================================================================
+// DLC
+//=============================================================================
+
+uint32_t len_to_dlc(uint8_t len)
+{
+	if (len <= 8) {
+		return len;
+	}
+	for (uint32_t dlc = 9; dlc < 16; dlc++) {
+		if (len <= DLC_LEN[dlc]) {
+			return dlc;
+		}
+	}
+	return 15;
+}
+
+uint8_t dlc_to_len(uint32_t dlc)
+{
+	return DLC_LEN[dlc & 0x0FU];
+}
+
+//=============================================================================
+// RxRoute
+//=============================================================================
+
+bool RxRouteBase::create_lease_(QueueHandle_t queue, CanFrame* slots, CanFrame** free, size_t count,
+				const char* name, RxTarget target)
+{
+	if (!create_(queue, name, target)) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		free[i] = &slots[i];
+	}
+	free_ = free;
+	slots_ = slots;
+	free_count_ = static_cast<uint32_t>(count);
+	min_free_ = free_count_;
+	return true;
+}
+
+bool RxRouteBase::receive(CanFrame& frame, TickType_t timeout)
+{
+	if (is_hook()) {
+		return false;
+	}
+	if (!is_lease()) {
+		return xQueueReceive(queue_, &frame, timeout) == pdPASS;
+	}
+	RxLease lease = read_lease(timeout);
+	if (!lease) {
+		return false;
+	}
+	frame = *lease;
+	return true;
+}
+
+RxLease RxRouteBase::read_lease(TickType_t timeout)
+{
+	CanFrame* frame = nullptr;
+	if (!is_lease() || xQueueReceive(queue_, &frame, timeout) != pdPASS) {
+		return RxLease();
+	}
+	return RxLease(frame, this);
+}
+
+CanFrame* RxRouteBase::take_slot_()
+{
+	if (free_count_ == 0) {
+		held_++;
+		return nullptr;
+	}
+	CanFrame* frame = free_[--free_count_];
+	if (free_count_ < min_free_) {
+		min_free_ = free_count_;
+	}
+	return frame;
+}
+
+void RxRouteBase::give_slot_(CanFrame* frame)
+{
+	free_[free_count_++] = frame;
+}
+
+void RxRouteBase::release_(CanFrame* frame)
+{
+	{
+		MaskLock lock;
+		give_slot_(frame);
+	}
+	if (bus_ != nullptr) {
+		bus_->resume_(target_);
+	}
+}
+
+void RxRouteBase::reset_stats()
+{
+	MaskLock lock;
+	frames_ = 0;
+	dropped_ = 0;
+	held_ = 0;
+	min_free_ = free_count_;
+}
+
+void RxLease::release()
+{
+	if (frame_ == nullptr) {
+		return;
+	}
+	CanFrame* frame = frame_;
+	RxRouteBase* route = route_;
+	frame_ = nullptr;
+	route_ = nullptr;
+	route->release_(frame);
+}
+
+//=============================================================================
+// Setup
+//=============================================================================
+
+bool CanBus::init(FDCAN_HandleTypeDef* hfdcan, uint32_t mode, TxOrder order)
+{
+	if (hfdcan == nullptr || started_) {
+		return false;
+	}
+	if (HAL_FDCAN_GetState(hfdcan) != HAL_FDCAN_STATE_READY) {
+		return false;                   // not initialized, or started elsewhere
+	}
+
+	// One CanBus per handle
+	int slot = -1;
+	for (int i = 0; i < STM32ZERO_CANBUS_MAX_BUSES; i++) {
+		if (buses_[i] == this || (buses_[i] != nullptr && buses_[i]->hfdcan_ == hfdcan)) {
+			if (buses_[i] != this) {
+				return false;
+			}
+			slot = i;
+			break;
+		}
+		if (buses_[i] == nullptr && slot < 0) {
+			slot = i;
+		}
+	}
+	if (slot < 0) {
+		return false;
+	}
+
+	uint32_t tx_mode = order == TxOrder::PRIORITY ? FDCAN_TX_QUEUE_OPERATION : FDCAN_TX_FIFO_OPERATION;
+	if (hfdcan->Init.Mode != mode || hfdcan->Init.TxFifoQueueMode != tx_mode) {
+		hfdcan->Init.Mode = mode;
+		hfdcan->Init.TxFifoQueueMode = tx_mode;
+		if (HAL_FDCAN_Init(hfdcan) != HAL_OK) {
+			return false;
+		}
+	}
+
+	if (HAL_FDCAN_RegisterRxFifo0Callback(hfdcan, rx_fifo0_cb_) != HAL_OK ||
+	    HAL_FDCAN_RegisterRxFifo1Callback(hfdcan, rx_fifo1_cb_) != HAL_OK) {
+		return false;
+	}
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	if (HAL_FDCAN_RegisterCallback(hfdcan, HAL_FDCAN_RX_BUFFER_NEW_MSG_CB_ID, rx_buffer_cb_) != HAL_OK) {
+		return false;
+	}
+#endif
+	if (HAL_FDCAN_RegisterTxBufferCompleteCallback(hfdcan, tx_complete_cb_) != HAL_OK ||
+	    HAL_FDCAN_RegisterTxEventFifoCallback(hfdcan, tx_event_cb_) != HAL_OK) {
+		return false;
+	}
+	if (HAL_FDCAN_RegisterCallback(hfdcan, HAL_FDCAN_ERROR_CALLBACK_CB_ID, error_cb_) != HAL_OK ||
+	    HAL_FDCAN_RegisterErrorStatusCallback(hfdcan, error_status_cb_) != HAL_OK) {
+		return false;
+	}
+	if (!tx_gate_.is_created() && tx_gate_.create() == nullptr) {
+		return false;
+	}
+	if (!tx_space_.is_created() && tx_space_.create() == nullptr) {
+		return false;
+	}
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	if (!tx_buf_gate_.is_created() && tx_buf_gate_.create() == nullptr) {
+		return false;
+	}
+	if (!tx_buf_space_.is_created() && tx_buf_space_.create() == nullptr) {
+		return false;
+	}
+#endif
+
+	hfdcan_ = hfdcan;
+	buses_[slot] = this;
+
+	for (auto& route : routes_) {
+		route = nullptr;
+	}
+	route_count_ = 0;
+	non_matching_ = REJECT;
+	lease_[0] = -1;
+	lease_[1] = -1;
+	held_ = 0;
+	tx_events_queue_ = nullptr;
+	tap_ = nullptr;
+	std_used_ = 0;
+	ext_used_ = 0;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	buffers_used_ = 0;
+#endif
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	tx_buffers_used_ = 0;
+#endif
+	tx_inflight_ = 0;
+	reset_stats();
+	return true;
+}
+
+void CanBus::deinit()
+{
+	stop();
+	for (auto& bus : buses_) {
+		if (bus == this) {
+			bus = nullptr;
+		}
+	}
+	hfdcan_ = nullptr;
+}
+
+int CanBus::add_route(RxRouteBase& route)
+{
+	if (hfdcan_ == nullptr || started_ || !route.is_created()) {
+		return -1;
+	}
+	if (route_count_ >= STM32ZERO_CANBUS_MAX_ROUTES) {
+		return -1;
+	}
+#if !STM32ZERO_CANBUS_RX_BUFFERS
+	if (route.target() == RxTarget::BUFFER) {
+		return -1;
+	}
+#endif
+
+	// A lease route is the only route of its FIFO
+	if (route.target() != RxTarget::BUFFER) {
+		uint32_t fifo = route.target() == RxTarget::FIFO1 ? 1 : 0;
+		if (lease_[fifo] >= 0) {
+			return -1;
+		}
+		if (route.is_lease()) {
+			for (uint32_t i = 0; i < route_count_; i++) {
+				if (routes_[i]->target() == route.target()) {
+					return -1;
+				}
+			}
+			lease_[fifo] = static_cast<int8_t>(route_count_);
+		}
+	}
+
+	route.bus_ = this;
+	routes_[route_count_] = &route;
+	return route_count_++;
+}
+
+bool CanBus::add_filter(const RxFilter& filter)
+{
+	if (hfdcan_ == nullptr || started_ || filter.route >= route_count_) {
+		return false;
+	}
+
+	uint32_t id_max = filter.ext ? EXT_ID_MAX : STD_ID_MAX;
+	if (filter.id1 > id_max || filter.id2 > id_max) {
+		return false;
+	}
+	if (filter.kind == FilterKind::RANGE && filter.id1 > filter.id2) {
+		return false;
+	}
+
+	if (routes_[filter.route]->target() == RxTarget::BUFFER) {
+#if STM32ZERO_CANBUS_RX_BUFFERS
+		// A buffer element stores one exact ID
+		if (filter.kind != FilterKind::DUAL || filter.id1 != filter.id2) {
+			return false;
+		}
+		uint32_t limit = hfdcan_->Init.RxBuffersNbr;
+		if (limit > STM32ZERO_CANBUS_MAX_RX_BUFFERS) {
+			limit = STM32ZERO_CANBUS_MAX_RX_BUFFERS;
+		}
+		if (buffers_used_ >= limit) {
+			return false;
+		}
+		buffers_used_++;
+#else
+		return false;
+#endif
+	}
+
+	if (filter.ext) {
+		uint32_t limit = hfdcan_->Init.ExtFiltersNbr;
+		if (limit > STM32ZERO_CANBUS_MAX_EXT_FILTERS) {
+			limit = STM32ZERO_CANBUS_MAX_EXT_FILTERS;
+		}
+		if (ext_used_ >= limit) {
+			return false;
+		}
+		ext_filters_[ext_used_++] = filter;
+	} else {
+		uint32_t limit = hfdcan_->Init.StdFiltersNbr;
+		if (limit > STM32ZERO_CANBUS_MAX_STD_FILTERS) {
+			limit = STM32ZERO_CANBUS_MAX_STD_FILTERS;
+		}
+		if (std_used_ >= limit) {
+			return false;
+		}
+		std_filters_[std_used_++] = filter;
+	}
+	return true;
+}
+
+bool CanBus::add_ids(int route, const uint32_t* ids, size_t count, bool ext)
+{
+	for (size_t i = 0; i < count; i += 2) {
+		uint32_t b = (i + 1 < count) ? ids[i + 1] : ids[i];
+		RxFilter f = ext ? RxFilter::ext_ids(ids[i], b, route) : RxFilter::std_ids(ids[i], b, route);
+		if (!add_filter(f)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CanBus::set_non_matching(int route)
+{
+	if (hfdcan_ == nullptr || started_) {
+		return false;
+	}
+	if (route != REJECT) {
+		if (route < 0 || route >= route_count_ || routes_[route]->target() == RxTarget::BUFFER) {
+			return false;
+		}
+	}
+	non_matching_ = static_cast<int8_t>(route);
+	return true;
+}
+
+bool CanBus::set_tx_events_(QueueHandle_t queue)
+{
+	if (hfdcan_ == nullptr || started_ || queue == nullptr) {
+		return false;
+	}
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	if (hfdcan_->Init.TxEventsNbr == 0U) {
+		return false;
+	}
+#endif
+	tx_events_queue_ = queue;
+	return true;
+}
+
+bool CanBus::write_filters_()
+{
+	FDCAN_FilterTypeDef cfg;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	uint32_t buffer = 0;
+#endif
+
+	for (int ext = 0; ext < 2; ext++) {
+		const RxFilter* table = ext ? ext_filters_ : std_filters_;
+		uint32_t used = ext ? ext_used_ : std_used_;
+		uint32_t total = ext ? hfdcan_->Init.ExtFiltersNbr : hfdcan_->Init.StdFiltersNbr;
+
+		for (uint32_t i = 0; i < total; i++) {
+			memset(&cfg, 0, sizeof(cfg));
+			cfg.IdType = ext ? FDCAN_EXTENDED_ID : FDCAN_STANDARD_ID;
+			cfg.FilterIndex = i;
+			cfg.FilterType = FDCAN_FILTER_DUAL;
+			cfg.FilterConfig = FDCAN_FILTER_DISABLE;
+
+			if (i < used) {
+				const RxFilter& f = table[i];
+				RxTarget target = routes_[f.route]->target();
+				cfg.FilterType = filter_type_(f.kind);
+				cfg.FilterConfig = filter_config_(target);
+				cfg.FilterID1 = f.id1;
+				cfg.FilterID2 = f.id2;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+				if (target == RxTarget::BUFFER) {
+					buffer_route_[buffer] = f.route;
+					cfg.RxBufferIndex = buffer++;
+				}
+#endif
+			}
+
+			if (HAL_FDCAN_ConfigFilter(hfdcan_, &cfg) != HAL_OK) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int CanBus::add_tx_buffer(uint32_t id, bool ext)
+{
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	if (hfdcan_ == nullptr || started_ || id > (ext ? EXT_ID_MAX : STD_ID_MAX)) {
+		return -1;
+	}
+	uint32_t limit = hfdcan_->Init.TxBuffersNbr;
+	if (limit > STM32ZERO_CANBUS_MAX_TX_BUFFERS) {
+		limit = STM32ZERO_CANBUS_MAX_TX_BUFFERS;
+	}
+	if (tx_buffers_used_ >= limit) {
+		return -1;
+	}
+	uint32_t key = tx_key_(id, ext);
+	for (uint32_t i = 0; i < tx_buffers_used_; i++) {
+		if (tx_buf_ids_[i] == key) {
+			return -1;
+		}
+	}
+	tx_buf_ids_[tx_buffers_used_] = key;
+	return tx_buffers_used_++;
+#else
+	(void)id;
+	(void)ext;
+	return -1;
+#endif
+}
+
+bool CanBus::set_tap(const BusTap* tap)
+{
+	if (hfdcan_ == nullptr || started_) {
+		return false;
+	}
+	tap_ = tap;
+	return true;
+}
+
+void CanBus::set_error_its(bool on)
+{
+	if (!started_ || tap_ == nullptr) {
+		return;
+	}
+	MaskLock lock;
+	if (on) {
+		HAL_FDCAN_ActivateNotification(hfdcan_, ERROR_ITS, 0);
+	} else {
+		HAL_FDCAN_DeactivateNotification(hfdcan_, ERROR_ITS);
+	}
+}
+
+uint32_t CanBus::tx_buffers_used() const
+{
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	return tx_buffers_used_;
+#else
+	return 0;
+#endif
+}
+
+bool CanBus::start()
+{
+	if (hfdcan_ == nullptr || started_) {
+		return false;
+	}
+	if (!write_filters_()) {
+		return false;
+	}
+
+	uint32_t non_matching = FDCAN_REJECT;
+	if (non_matching_ != REJECT) {
+		non_matching = routes_[non_matching_]->target() == RxTarget::FIFO1 ? FDCAN_ACCEPT_IN_RX_FIFO1
+										  : FDCAN_ACCEPT_IN_RX_FIFO0;
+	}
+	if (HAL_FDCAN_ConfigGlobalFilter(hfdcan_, non_matching, non_matching,
+					 FDCAN_REJECT_REMOTE, FDCAN_REJECT_REMOTE) != HAL_OK) {
+		return false;
+	}
+
+#if STM32ZERO_CANBUS_TIMESTAMPS
+	if (HAL_FDCAN_ConfigTimestampCounter(hfdcan_, FDCAN_TIMESTAMP_PRESC_1) != HAL_OK ||
+	    HAL_FDCAN_EnableTimestampCounter(hfdcan_, FDCAN_TIMESTAMP_EXTERNAL) != HAL_OK) {
+		return false;
+	}
+#endif
+
+	uint32_t its = RX_ITS;
+#if STM32ZERO_CANBUS_RX_BUFFERS
+	if (buffers_used_ > 0) {
+		its |= FDCAN_IT_RX_BUFFER_NEW_MESSAGE;
+	}
+#endif
+	its |= FDCAN_IT_TX_COMPLETE;
+	if (tx_events_queue_ != nullptr) {
+		its |= TX_EVENT_ITS;
+	}
+	if (tap_ != nullptr) {
+		its |= ERROR_ITS | STATUS_ITS;
+		lec_seen_[0] = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+		lec_seen_[1] = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+	}
+	uint32_t tx_its = tx_fifo_mask_(hfdcan_);
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	tx_its |= (1U << tx_buffers_used_) - 1U;
+#endif
+	if (HAL_FDCAN_ActivateNotification(hfdcan_, its, tx_its) != HAL_OK) {
+		return false;
+	}
+	if (HAL_FDCAN_Start(hfdcan_) != HAL_OK) {
+		return false;
+	}
+	started_ = true;
+	return true;
+}
+
+void CanBus::stop()
+{
+	if (!started_) {
+		return;
+	}
+	HAL_FDCAN_Stop(hfdcan_);
+	HAL_FDCAN_DeactivateNotification(hfdcan_, RX_ITS | FDCAN_IT_TX_COMPLETE | TX_EVENT_ITS | ERROR_ITS | STATUS_ITS
+#if STM32ZERO_CANBUS_RX_BUFFERS
+					  | FDCAN_IT_RX_BUFFER_NEW_MESSAGE
+#endif
+	);
+	started_ = false;
+	held_ = 0;
+	tx_inflight_ = 0;
+
+	// A sleeping writer finds the bus stopped
+	if (tx_want_ != 0) {
+		tx_want_ = 0;
+		tx_space_.give();
+	}
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	if (tx_buf_want_ != 0) {
+		tx_buf_want_ = 0;
+		tx_buf_space_.give();
+	}
+#endif
+}
+
+RxRouteBase* CanBus::route(int index) const
+{
+	if (index < 0 || index >= route_count_) {
+		return nullptr;
+	}
+	return routes_[index];
+}
+
+//=============================================================================
+// Transmit
+//=============================================================================
+
+// TX buffer reserved for the frame's ID, or -1
+int CanBus::tx_buffer_(const CanFrame& frame) const
+{
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	uint32_t key = tx_key_(frame.id, frame.is_ext());
+	for (uint32_t i = 0; i < tx_buffers_used_; i++) {
+		if (tx_buf_ids_[i] == key) {
+			return static_cast<int>(i);
+		}
+	}
+#else
+	(void)frame;
+#endif
+	return -1;
+}
+
+bool CanBus::put_(const CanFrame& frame)
+{
+	FDCAN_TxHeaderTypeDef header;
+	tx_header_(frame, header);
+	int buffer = tx_buffer_(frame);
+
+	MaskLock lock;
+	uint32_t bit = 0;
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	if (buffer >= 0) {
+		bit = 1U << buffer;
+		if (HAL_FDCAN_IsTxBufferMessagePending(hfdcan_, bit) != 0U ||
+		    HAL_FDCAN_AddMessageToTxBuffer(hfdcan_, &header, frame.data, bit) != HAL_OK ||
+		    HAL_FDCAN_EnableTxBufferRequest(hfdcan_, bit) != HAL_OK) {
+			return false;
+		}
+	}
+#else
+	(void)buffer;
+#endif
+	if (bit == 0U) {
+		if (tx_free_(hfdcan_) == 0U ||
+		    HAL_FDCAN_AddMessageToTxFifoQ(hfdcan_, &header, frame.data) != HAL_OK) {
+			return false;
+		}
+		bit = HAL_FDCAN_GetLatestTxFifoQRequestBuffer(hfdcan_);
+	}
+	if (bit != 0U) {
+		TxSlot& slot = tx_slots_[__builtin_ctz(bit)];
+		slot.queued_at = static_cast<uint32_t>(ustim::get());
+		slot.id = frame.id;
+		slot.len = frame.len;
+		slot.flags = frame.flags & TAP_FLAGS;
+		tx_inflight_ |= bit;
+	}
+	tx_frames_++;
+	return true;
+}
+
+bool CanBus::send(const CanFrame& frame)
+{
+	if (!started_ || !tx_valid_(frame)) {
+		return false;
+	}
+	if (!put_(frame)) {
+		tx_full_++;
+		return false;
+	}
+	return true;
+}
+
+bool CanBus::send(uint32_t id, const void* data, uint8_t len, uint8_t flags)
+{
+	CanFrame frame;
+	frame.id = id;
+	frame.len = len;
+	frame.flags = flags;
+	frame.filter = CanFrame::NO_FILTER;
+	frame.route = 0;
+	if (len > sizeof(frame.data)) {
+		return false;
+	}
+	memcpy(frame.data, data, len);
+	if (len < sizeof(frame.data)) {
+		memset(frame.data + len, 0, dlc_to_len(len_to_dlc(len)) - len);     // FD padding
+	}
+	return send(frame);
+}
+
+bool CanBus::write(const CanFrame& frame, TickType_t timeout)
+{
+	return write_many(&frame, 1, timeout) == 1;
+}
+
+size_t CanBus::write_many(const CanFrame* frames, size_t count, TickType_t timeout, TxResult* results)
+{
+	TickType_t start = xTaskGetTickCount();
+	bool gated = false;
+	size_t queued = 0;
+	size_t i = 0;
+
+	while (i < count && started_) {
+		TxResult res = TxResult::QUEUED;
+		if (!tx_valid_(frames[i])) {
+			res = TxResult::INVALID;
+		} else if (put_(frames[i])) {
+			queued++;
+		} else if (tx_buffer_(frames[i]) >= 0) {
+			// Its TX buffer is still pending: wait for that one only
+			if (!wait_buffer_(tx_buffer_(frames[i]), start, timeout)) {
+				break;
+			}
+			continue;
+		} else {
+			// FIFO full: sleep until a batch of elements has drained
+			if (!gated) {
+				if (!tx_gate_.lock(timeout)) {
+					break;
+				}
+				gated = true;
+			}
+			if (!wait_space_(count - i, start, timeout)) {
+				break;
+			}
+			continue;
+		}
+		if (results != nullptr) {
+			results[i] = res;
+		}
+		i++;
+	}
+
+	if (results != nullptr) {
+		TxResult rest = started_ ? TxResult::TIMEOUT : TxResult::STOPPED;
+		for (; i < count; i++) {
+			results[i] = rest;
+		}
+	}
+	if (gated) {
+		tx_gate_.unlock();
+	}
+	return queued;
+}
+
+bool CanBus::wait_space_(size_t wanted, TickType_t start, TickType_t timeout)
+{
+	TickType_t remain;
+	if (!remaining_(start, timeout, remain)) {
+		return false;
+	}
+
+	// Half the FIFO keeps the bus busy while this task refills the rest
+	uint32_t level = tx_fifo_size_(hfdcan_) / 2;
+	if (level == 0) {
+		level = 1;
+	}
+	if (wanted < level) {
+		level = static_cast<uint32_t>(wanted);
+	}
+
+	tx_space_.take(0);                  // stale give of an earlier timeout
+	{
+		MaskLock lock;
+		if (tx_free_(hfdcan_) >= level) {
+			return true;
+		}
+		tx_want_ = static_cast<uint8_t>(level);
+	}
+	tx_waits_++;
+
+	bool woken = tx_space_.take(remain);
+	tx_want_ = 0;
+	return woken;
+}
+
+bool CanBus::wait_buffer_(int buffer, TickType_t start, TickType_t timeout)
+{
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	TickType_t remain;
+	if (!remaining_(start, timeout, remain) || !tx_buf_gate_.lock(remain)) {
+		return false;
+	}
+	if (!remaining_(start, timeout, remain)) {
+		tx_buf_gate_.unlock();
+		return false;
+	}
+
+	uint32_t bit = 1U << buffer;
+	bool ok = true;
+	tx_buf_space_.take(0);              // stale give of an earlier timeout
+	{
+		MaskLock lock;
+		if (HAL_FDCAN_IsTxBufferMessagePending(hfdcan_, bit) == 0U) {
+			bit = 0;
+		} else {
+			tx_buf_want_ = bit;
+		}
+	}
+	if (bit != 0U) {
+		tx_waits_++;
+		ok = tx_buf_space_.take(remain);
+		tx_buf_want_ = 0;
+	}
+	tx_buf_gate_.unlock();
+	return ok;
+#else
+	(void)buffer;
+	(void)start;
+	(void)timeout;
+	return false;
+#endif
+}
+
+uint32_t CanBus::tx_pending() const
+{
+	if (hfdcan_ == nullptr || !started_) {
+		return 0;
+	}
+	uint32_t pending = tx_fifo_size_(hfdcan_) - tx_free_(hfdcan_);
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	for (uint32_t i = 0; i < tx_buffers_used_; i++) {
+		pending += HAL_FDCAN_IsTxBufferMessagePending(hfdcan_, 1U << i);
+	}
+#endif
+	return pending;
+}
+
+uint32_t CanBus::fifo_level(RxTarget fifo) const
+{
+	if (hfdcan_ == nullptr || fifo == RxTarget::BUFFER) {
+		return 0;
+	}
+	return HAL_FDCAN_GetRxFifoFillLevel(hfdcan_, fifo == RxTarget::FIFO1 ? FDCAN_RX_FIFO1 : FDCAN_RX_FIFO0);
+}
+
+//=============================================================================
+// FDCAN Interrupt
+//=============================================================================
+
+CanBus* CanBus::from_(FDCAN_HandleTypeDef* hfdcan)
+{
+	for (CanBus* bus : buses_) {
+		if (bus != nullptr && bus->hfdcan_ == hfdcan) {
+			return bus;
+		}
+	}
+	return nullptr;
+}
+
+void CanBus::deliver_(const FDCAN_RxHeaderTypeDef& header, CanFrame& frame, BaseType_t* woken)
+{
+	frame.id = header.Identifier;
+	frame.len = dlc_to_len(header.DataLength);
+	frame.timestamp = stamp_(header.RxTimestamp);
+	frame.flags = rx_flags_(header);
+	if (header.ErrorStateIndicator == FDCAN_ESI_PASSIVE) {
+		frame.flags |= CanFrame::FLAG_ESI;
+	}
+
+	RxRouteBase* route = (frame.route < route_count_) ? routes_[frame.route] : nullptr;
+	if (route == nullptr) {
+		rx_unrouted_++;
+		return;
+	}
+
+	if (route->is_hook()) {
+		if (route->hook_(route->context_, frame, woken)) {
+			route->frames_++;
+		} else {
+			route->dropped_++;
+		}
+		return;
+	}
+
+	// Lease routes queue the slot address
+	CanFrame* slot = &frame;
+	const void* item = route->is_lease() ? static_cast<const void*>(&slot) : &frame;
+	if (xQueueSendFromISR(route->queue_, item, woken) == pdPASS) {
+		route->frames_++;
+	} else {
+		route->dropped_++;
+	}
+}
+
+void CanBus::drain_fifo_(uint32_t fifo, BaseType_t* woken)
+{
+	FDCAN_RxHeaderTypeDef header;
+	CanFrame local;
+
+	int8_t lease = lease_[fifo_index_(fifo)];
+	RxRouteBase* owner = lease >= 0 ? routes_[lease] : nullptr;
+
+	uint32_t level = HAL_FDCAN_GetRxFifoFillLevel(hfdcan_, fifo);
+	uint8_t& high = rx_fifo_max_[fifo_index_(fifo)];
+	if (level > high) {
+		high = static_cast<uint8_t>(level);
+	}
+
+	while (HAL_FDCAN_GetRxFifoFillLevel(hfdcan_, fifo) > 0U) {
+		CanFrame* frame = &local;
+		if (owner != nullptr) {
+			frame = owner->take_slot_();
+			if (frame == nullptr) {
+				held_ |= 1U << fifo_index_(fifo);       // left in the FIFO
+				break;
+			}
+		}
+		if (HAL_FDCAN_GetRxMessage(hfdcan_, fifo, &header, frame->data) != HAL_OK) {
+			if (owner != nullptr) {
+				owner->give_slot_(frame);
+			}
+			break;
+		}
+		rx_frames_++;
+		tap_rx_(header);
+
+		uint8_t route;
+		if (header.IsFilterMatchingFrame != 0U) {
+			frame->filter = CanFrame::NO_FILTER;
+			route = static_cast<uint8_t>(non_matching_);        // REJECT -> 0xFF
+		} else {
+			bool ext = header.IdType == FDCAN_EXTENDED_ID;
+			uint32_t used = ext ? ext_used_ : std_used_;
+			frame->filter = static_cast<uint8_t>(header.FilterIndex);
+			route = header.FilterIndex < used
+				? (ext ? ext_filters_ : std_filters_)[header.FilterIndex].route
+				: CanFrame::NO_FILTER;
+		}
+		if (owner != nullptr && route != static_cast<uint8_t>(lease)) {
+			owner->give_slot_(frame);
+			rx_unrouted_++;
+			continue;
+		}
+		frame->route = route;
+		deliver_(header, *frame, woken);
+	}
+}
+
+void CanBus::rx_fifo_(uint32_t fifo, uint32_t its)
+{
+	BaseType_t woken = pdFALSE;
+
+	rx_irqs_++;
+	if ((its & (FDCAN_IT_RX_FIFO0_MESSAGE_LOST | FDCAN_IT_RX_FIFO1_MESSAGE_LOST)) != 0U) {
+		rx_lost_++;
+	}
+	drain_fifo_(fifo, &woken);
+
+	portYIELD_FROM_ISR(woken);
+}
+
+// Task context, after a lease slot was returned
+void CanBus::resume_(RxTarget fifo)
+{
+	uint32_t index = fifo == RxTarget::FIFO1 ? 1 : 0;
+	if ((held_ & (1U << index)) == 0U || !started_) {
+		return;
+	}
+
+	BaseType_t woken = pdFALSE;
+	{
+		MaskLock lock;
+		held_ &= ~(1U << index);
+		drain_fifo_(index == 0 ? FDCAN_RX_FIFO0 : FDCAN_RX_FIFO1, &woken);
+	}
+	if (woken != pdFALSE) {
+		taskYIELD();
+	}
+}
+
+void CanBus::rx_fifo0_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus != nullptr) {
+		bus->rx_fifo_(FDCAN_RX_FIFO0, its);
+	}
+}
+
+void CanBus::rx_fifo1_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus != nullptr) {
+		bus->rx_fifo_(FDCAN_RX_FIFO1, its);
+	}
+}
+
+#if STM32ZERO_CANBUS_RX_BUFFERS
+void CanBus::rx_buffer_cb_(FDCAN_HandleTypeDef* hfdcan)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus == nullptr) {
+		return;
+	}
+
+	BaseType_t woken = pdFALSE;
+	FDCAN_RxHeaderTypeDef header;
+	CanFrame frame;
+
+	bus->rx_irqs_++;
+	for (uint32_t b = 0; b < bus->buffers_used_; b++) {
+		if (HAL_FDCAN_IsRxBufferMessageAvailable(hfdcan, FDCAN_RX_BUFFER0 + b) == 0U) {
+			continue;
+		}
+		if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_BUFFER0 + b, &header, frame.data) != HAL_OK) {
+			continue;
+		}
+		bus->rx_frames_++;
+		bus->tap_rx_(header);
+		frame.filter = static_cast<uint8_t>(header.FilterIndex);
+		frame.route = bus->buffer_route_[b];
+		bus->deliver_(header, frame, &woken);
+	}
+
+	portYIELD_FROM_ISR(woken);
+}
+#endif
+
+void CanBus::tx_complete_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t indexes)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus == nullptr) {
+		return;
+	}
+	BaseType_t woken = pdFALSE;
+	bus->tx_done_(indexes, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+void CanBus::tx_done_(uint32_t indexes, BaseType_t* woken)
+{
+	uint32_t done = indexes & tx_inflight_;
+	if (done != 0U) {
+		tx_inflight_ &= ~done;
+		uint32_t now = static_cast<uint32_t>(ustim::get());
+		uint32_t buffers = 0;
+#if STM32ZERO_CANBUS_TX_BUFFERS
+		buffers = (1U << tx_buffers_used_) - 1U;
+#endif
+		while (done != 0U) {
+			uint32_t i = static_cast<uint32_t>(__builtin_ctz(done));
+			done &= done - 1U;
+			TxPriority prio = (buffers >> i) & 1U ? TxPriority::CRITICAL : TxPriority::NORMAL;
+			const TxSlot& slot = tx_slots_[i];
+			tx_delay_[static_cast<size_t>(prio)].add(now - slot.queued_at);
+			if (tap_ != nullptr && tap_->frame != nullptr) {
+				tap_->frame(tap_->context, slot.id, slot.len, slot.flags, true);
+			}
+		}
+	}
+
+#if STM32ZERO_CANBUS_TX_BUFFERS
+	if ((indexes & tx_buf_want_) != 0U) {
+		tx_buf_want_ = 0;
+		tx_buf_space_.give_from_isr(woken);
+	}
+#endif
+	if (tx_want_ != 0 && tx_free_(hfdcan_) >= tx_want_) {
+		tx_want_ = 0;
+		tx_space_.give_from_isr(woken);
+	}
+}
+
+void CanBus::tap_rx_(const FDCAN_RxHeaderTypeDef& header)
+{
+	if (tap_ != nullptr && tap_->frame != nullptr) {
+		tap_->frame(tap_->context, header.Identifier, dlc_to_len(header.DataLength), rx_flags_(header), false);
+	}
+}
+
+void CanBus::tx_event_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus == nullptr) {
+		return;
+	}
+	if ((its & FDCAN_IT_TX_EVT_FIFO_ELT_LOST) != 0U) {
+		bus->tx_events_lost_++;
+	}
+
+	BaseType_t woken = pdFALSE;
+	FDCAN_TxEventFifoTypeDef event;
+	while (HAL_FDCAN_GetTxEvent(hfdcan, &event) == HAL_OK) {
+		if (bus->tx_events_queue_ == nullptr) {
+			continue;
+		}
+		TxEvent ev;
+		ev.timestamp = stamp_(event.TxTimestamp);
+		ev.id = event.Identifier;
+		ev.len = dlc_to_len(event.DataLength);
+		ev.flags = CanFrame::FLAG_EVENT;
+		if (event.IdType == FDCAN_EXTENDED_ID) {
+			ev.flags |= CanFrame::FLAG_EXT;
+		}
+		if (event.FDFormat == FDCAN_FD_CAN) {
+			ev.flags |= CanFrame::FLAG_FD;
+		}
+		if (event.BitRateSwitch == FDCAN_BRS_ON) {
+			ev.flags |= CanFrame::FLAG_BRS;
+		}
+		ev.marker = static_cast<uint8_t>(event.MessageMarker);
+		if (xQueueSendFromISR(bus->tx_events_queue_, &ev, &woken) == pdPASS) {
+			bus->tx_events_++;
+		} else {
+			bus->tx_events_lost_++;
+		}
+	}
+
+	portYIELD_FROM_ISR(woken);
+}
+
+void CanBus::error_status_cb_(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	CanBus* bus = from_(hfdcan);
+	if (bus == nullptr || bus->tap_ == nullptr) {
+		return;
+	}
+	FDCAN_ProtocolStatusTypeDef ps;
+	if (HAL_FDCAN_GetProtocolStatus(hfdcan, &ps) != HAL_OK) {
+		return;
+	}
+	if (ps.LastErrorCode != FDCAN_PROTOCOL_ERROR_NO_CHANGE) {
+		bus->lec_seen_[0] = static_cast<uint8_t>(ps.LastErrorCode);
+	}
+	if (ps.DataLastErrorCode != FDCAN_PROTOCOL_ERROR_NO_CHANGE) {
+		bus->lec_seen_[1] = static_cast<uint8_t>(ps.DataLastErrorCode);
+	}
+	if (bus->tap_->status != nullptr) {
+		bus->tap_->status(bus->tap_->context, its, ps.Warning != 0U, ps.ErrorPassive != 0U, ps.BusOff != 0U);
+	}
+}
+
+// The HAL calls this for every interrupt while ErrorCode is set, so the
+// protocol error bits are cleared here
+void CanBus::error_cb_(FDCAN_HandleTypeDef* hfdcan)
+{
+	uint32_t errors = hfdcan->ErrorCode & PROTOCOL_ERRORS;
+	if (errors == 0U) {
+		return;
+	}
+	hfdcan->ErrorCode &= ~PROTOCOL_ERRORS;
+
+	CanBus* bus = from_(hfdcan);
+	if (bus == nullptr || bus->tap_ == nullptr) {
+		return;
+	}
+	FDCAN_ProtocolStatusTypeDef ps;
+	if (HAL_FDCAN_GetProtocolStatus(hfdcan, &ps) != HAL_OK) {
+		return;
+	}
+	uint32_t code[2] = { ps.LastErrorCode, ps.DataLastErrorCode };
+	for (uint32_t i = 0; i < 2; i++) {
+		if (code[i] == FDCAN_PROTOCOL_ERROR_NO_CHANGE) {
+			code[i] = bus->lec_seen_[i];
+		}
+		bus->lec_seen_[i] = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+	}
+	if (bus->tap_->error == nullptr) {
+		return;
+	}
+	if ((errors & HAL_FDCAN_ERROR_PROTOCOL_ARBT) != 0U) {
+		bus->tap_->error(bus->tap_->context, code[0], false);
+	}
+	if ((errors & HAL_FDCAN_ERROR_PROTOCOL_DATA) != 0U) {
+		bus->tap_->error(bus->tap_->context, code[1], true);
+	}
+}
+
+//=============================================================================
+// Statistics
+//=============================================================================
+
+CanBusStats CanBus::stats() const
+{
+	CanBusStats s;
+	MaskLock lock;
+	s.rx_irqs = rx_irqs_;
+	s.rx_frames = rx_frames_;
+	s.rx_unrouted = rx_unrouted_;
+	s.rx_lost = rx_lost_;
+	s.tx_frames = tx_frames_;
+	s.tx_full = tx_full_;
+	s.tx_waits = tx_waits_;
+	s.tx_events = tx_events_;
+	s.tx_events_lost = tx_events_lost_;
+	s.rx_fifo_max[0] = rx_fifo_max_[0];
+	s.rx_fifo_max[1] = rx_fifo_max_[1];
+	return s;
+}
+
+void CanBus::reset_stats()
+{
+	MaskLock lock;
+	rx_irqs_ = 0;
+	rx_frames_ = 0;
+	rx_unrouted_ = 0;
+	rx_lost_ = 0;
+	tx_frames_ = 0;
+	tx_full_ = 0;
+	tx_waits_ = 0;
+	tx_events_ = 0;
+	tx_events_lost_ = 0;
+	rx_fifo_max_[0] = 0;
+	rx_fifo_max_[1] = 0;
+	for (auto& h : tx_delay_) {
+		h.reset();
+	}
+	for (uint32_t i = 0; i < route_count_; i++) {
+		routes_[i]->reset_stats();
+	}
+}
+
+Histogram CanBus::tx_delay(TxPriority prio) const
+{
+	MaskLock lock;
+	return tx_delay_[static_cast<size_t>(prio)];
+}
+
+} // namespace fdcan
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
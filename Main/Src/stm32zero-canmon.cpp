@@ -0,0 +1,567 @@
+/**
+ * STM32ZERO CAN Bus Monitor
+ *
+ * The interrupt side keeps free-running counters only; sample() takes
+ * wrap-safe deltas against the previous window and divides by the
+ * elapsed ustim time, so a late or early window does not skew the rates.
+ *
+ * Frame bus time is base + len * byte per format (ID type, FD, BRS),
+ * precomputed in attach() from the nominal and data bit timing: SOF to
+ * the end of the intermission, with the stuff estimate applied to the
+ * dynamically stuffed fields (SOF to the CRC of classic frames, SOF to
+ * the payload of FD frames, whose CRC field has fixed stuff bits).
+ *
+ * The error budget masks PEA / PED through CanBus::set_error_its() in
+ * the interrupt; the next sample() unmasks them.
+ */
+
+#include "stm32zero-canmon.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-sio.hpp"
+#include <cstring>
+
+namespace stm32zero {
+namespace canmon {
+
+using fdcan::CanBus;
+using fdcan::CanFrame;
+
+namespace {
+
+constexpr uint32_t EXT_KEY = 0x80000000U;
+constexpr uint8_t FORMAT_FLAGS = CanFrame::FLAG_EXT | CanFrame::FLAG_FD | CanFrame::FLAG_BRS;
+
+const char* const ERROR_NAMES[ERROR_KINDS] = { "stuff", "form", "ack", "bit1", "bit0", "crc" };
+
+char fmt_buf_[96];
+
+// Bus time (ns) of bits / 1000 bits (bits_milli) at one bit timing
+uint32_t bits_ns_(uint64_t bits_milli, uint32_t prescaler, uint32_t seg1, uint32_t seg2, uint32_t clock_hz)
+{
+	uint64_t tq = static_cast<uint64_t>(prescaler) * (1U + seg1 + seg2);
+	return static_cast<uint32_t>(bits_milli * tq * 1000000ULL / clock_hz);
+}
+
+inline uint64_t stuffed_(uint32_t bits)
+{
+	return static_cast<uint64_t>(bits) * (1000U + STM32ZERO_CANMON_STUFF_PERMILLE);
+}
+
+inline uint64_t plain_(uint32_t bits)
+{
+	return static_cast<uint64_t>(bits) * 1000U;
+}
+
+// Frames per second of count frames in us microseconds
+inline uint32_t per_s_(uint32_t count, uint32_t us)
+{
+	return static_cast<uint32_t>(static_cast<uint64_t>(count) * 1000000U / us);
+}
+
+// Word after "canmon" (empty at the end of the line), nullptr if the
+// line is not a canmon command
+const char* subcommand_(const char* line)
+{
+	static const char WORD[] = "canmon";
+	while (*line == ' ') {
+		line++;
+	}
+	if (strncmp(line, WORD, sizeof(WORD) - 1) != 0) {
+		return nullptr;
+	}
+	line += sizeof(WORD) - 1;
+	if (*line != '\0' && *line != ' ' && *line != '\r' && *line != '\n') {
+		return nullptr;
+	}
+	while (*line == ' ') {
+		line++;
+	}
+	return line;
+}
+
+inline bool is_word_(const char* arg, const char* word)
+{
+	size_t n = strlen(word);
+	return strncmp(arg, word, n) == 0 && (arg[n] == '\0' || arg[n] == ' ' || arg[n] == '\r' || arg[n] == '\n');
+}
+
+} // namespace
+
+//=============================================================================
+// Setup
+//=============================================================================
+
+bool MonitorBase::attach(CanBus& bus)
+{
+	FDCAN_HandleTypeDef* hfdcan = bus.handle();
+	if (hfdcan == nullptr || bus.is_started() || running_) {
+		return false;
+	}
+
+	const FDCAN_InitTypeDef& init = hfdcan->Init;
+	uint32_t clock = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_FDCAN);
+	// The H5 FDCAN divides its kernel clock first (Init.ClockDivider)
+#if defined(FDCAN_CKDIV_PDIV)
+	if (init.ClockDivider != FDCAN_CLOCK_DIV1) {
+		clock /= init.ClockDivider * 2U;            // DIV2, DIV4, ... DIV30
+	}
+#endif
+	if (clock == 0U) {
+		return false;
+	}
+	bool brs = init.FrameFormat == FDCAN_FRAME_FD_BRS;
+
+	for (uint32_t flags = 0; flags < 8; flags++) {
+		bool ext = (flags & CanFrame::FLAG_EXT) != 0;
+		bool fd = (flags & CanFrame::FLAG_FD) != 0;
+		bool switched = fd && brs && (flags & CanFrame::FLAG_BRS) != 0;
+		uint64_t nominal;
+		uint64_t data = 0;
+		uint64_t crc21 = 0;
+
+		if (!fd) {
+			// SOF..CRC stuffed, CRC delimiter..IFS (13 bits) fixed
+			nominal = stuffed_(ext ? 54U : 34U) + plain_(13U);
+		} else {
+			// SOF..BRS and ESI, DLC stuffed; stuff count, 17-bit CRC with
+			// its fixed stuff bits; the 21-bit CRC (over 16 bytes) adds 5
+			nominal = stuffed_(ext ? 36U : 17U) + plain_(13U);
+			data = stuffed_(5U) + plain_(4U + 17U + 5U);
+			crc21 = plain_(5U);
+		}
+
+		FrameTime& t = time_[flags];
+		if (switched) {
+			t.base_ns = bits_ns_(nominal, init.NominalPrescaler, init.NominalTimeSeg1, init.NominalTimeSeg2, clock) +
+				    bits_ns_(data, init.DataPrescaler, init.DataTimeSeg1, init.DataTimeSeg2, clock);
+			t.byte_ns = bits_ns_(stuffed_(8U), init.DataPrescaler, init.DataTimeSeg1, init.DataTimeSeg2, clock);
+			t.crc21_ns = bits_ns_(crc21, init.DataPrescaler, init.DataTimeSeg1, init.DataTimeSeg2, clock);
+		} else {
+			t.base_ns = bits_ns_(nominal + data, init.NominalPrescaler, init.NominalTimeSeg1,
+					     init.NominalTimeSeg2, clock);
+			t.byte_ns = bits_ns_(stuffed_(8U), init.NominalPrescaler, init.NominalTimeSeg1,
+					     init.NominalTimeSeg2, clock);
+			t.crc21_ns = bits_ns_(crc21, init.NominalPrescaler, init.NominalTimeSeg1, init.NominalTimeSeg2, clock);
+		}
+	}
+
+	tap_.frame = frame_cb_;
+	tap_.error = error_cb_;
+	tap_.status = status_cb_;
+	tap_.context = this;
+	if (!bus.set_tap(&tap_)) {
+		return false;
+	}
+	bus_ = &bus;
+	echo_ = init.Mode == FDCAN_MODE_INTERNAL_LOOPBACK || init.Mode == FDCAN_MODE_EXTERNAL_LOOPBACK;
+	id_count_ = 0;
+	reset_stats();
+	return true;
+}
+
+bool MonitorBase::watch(uint32_t id, bool ext)
+{
+	if (bus_ == nullptr || bus_->is_started() || id_count_ >= capacity_) {
+		return false;
+	}
+	if (id > (ext ? 0x1FFFFFFFU : 0x7FFU)) {
+		return false;
+	}
+	uint32_t key = ext ? (id | EXT_KEY) : id;
+	if (find_(key) >= 0) {
+		return false;
+	}
+
+	// Sorted insert for the binary search in the interrupt
+	size_t i = id_count_;
+	while (i > 0 && ids_[i - 1].key > key) {
+		ids_[i] = ids_[i - 1];
+		i--;
+	}
+	ids_[i] = {};
+	ids_[i].key = key;
+	id_count_++;
+	return true;
+}
+
+int MonitorBase::find_(uint32_t key) const
+{
+	size_t lo = 0;
+	size_t hi = id_count_;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		uint32_t k = ids_[mid].key;
+		if (k == key) {
+			return static_cast<int>(mid);
+		}
+		if (k < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return -1;
+}
+
+uint32_t MonitorBase::frame_ns(uint8_t len, uint8_t flags) const
+{
+	const FrameTime& t = time_[flags & FORMAT_FLAGS];
+	return t.base_ns + len * t.byte_ns + (len > 16 ? t.crc21_ns : 0U);
+}
+
+//=============================================================================
+// Task
+//=============================================================================
+
+bool MonitorBase::prepare_(const char* name, uint32_t window_ms, uint32_t error_budget)
+{
+	if (running_ || bus_ == nullptr || window_ms == 0 || window_ms > 4000) {
+		return false;
+	}
+	name_ = name;
+	window_ms_ = window_ms;
+	error_budget_ = error_budget;
+	stop_ = false;
+	running_ = true;
+	reset_stats();
+	return true;
+}
+
+bool MonitorBase::created_(TaskHandle_t task)
+{
+	task_ = task;
+	if (task == nullptr) {
+		running_ = false;
+	}
+	return running_;
+}
+
+void MonitorBase::task_func_(void* param)
+{
+	MonitorBase* self = static_cast<MonitorBase*>(param);
+	self->run_();
+	self->running_ = false;
+	vTaskDelete(nullptr);
+}
+
+void MonitorBase::run_()
+{
+	const TickType_t window = pdMS_TO_TICKS(window_ms_);
+	TickType_t next = xTaskGetTickCount() + window;
+	while (!stop_) {
+		TickType_t now = xTaskGetTickCount();
+		TickType_t left = next - now;
+		if (left != 0 && left <= window) {
+			ulTaskNotifyTake(pdTRUE, left);     // stop() wakes it early
+			continue;
+		}
+		sample();
+		next = (left == 0) ? next + window : now + window;     // late: new phase
+	}
+}
+
+void MonitorBase::stop()
+{
+	if (!running_) {
+		return;
+	}
+	stop_ = true;
+	xTaskNotifyGive(task_);
+	while (running_) {
+		vTaskDelay(1);
+	}
+	vTaskDelay(2);          // let IDLE reclaim the task before a restart
+}
+
+//=============================================================================
+// Counters (FDCAN Interrupt)
+//=============================================================================
+
+void MonitorBase::frame_cb_(void* context, uint32_t id, uint8_t len, uint8_t flags, bool tx)
+{
+	MonitorBase* self = static_cast<MonitorBase*>(context);
+	if (!tx && self->echo_) {
+		return;
+	}
+	self->busy_ns_ += self->frame_ns(len, flags);
+	if (tx) {
+		self->tx_frames_++;
+	} else {
+		self->rx_frames_++;
+	}
+	int i = self->find_((flags & CanFrame::FLAG_EXT) != 0 ? (id | EXT_KEY) : id);
+	if (i >= 0) {
+		self->ids_[i].frames++;
+	} else {
+		self->unwatched_++;
+	}
+}
+
+void MonitorBase::error_cb_(void* context, uint32_t code, bool data_phase)
+{
+	MonitorBase* self = static_cast<MonitorBase*>(context);
+	if (code >= FDCAN_PROTOCOL_ERROR_STUFF && code <= FDCAN_PROTOCOL_ERROR_CRC) {
+		self->errors_[code - FDCAN_PROTOCOL_ERROR_STUFF]++;
+	} else {
+		self->errors_other_++;
+	}
+	if (data_phase) {
+		self->data_errors_++;
+	}
+
+	// Storm: no more error interrupts until the next window
+	self->window_errors_++;
+	if (self->error_budget_ != 0 && self->window_errors_ >= self->error_budget_ && !self->masked_) {
+		self->masked_ = true;
+		self->storms_++;
+		self->bus_->set_error_its(false);
+	}
+}
+
+void MonitorBase::status_cb_(void* context, uint32_t its, bool warning, bool passive, bool bus_off)
+{
+	MonitorBase* self = static_cast<MonitorBase*>(context);
+	if ((its & FDCAN_IT_ERROR_WARNING) != 0U && warning && !self->warning_) {
+		self->warnings_++;
+	}
+	if ((its & FDCAN_IT_ERROR_PASSIVE) != 0U && passive && !self->passive_) {
+		self->passives_++;
+	}
+	if ((its & FDCAN_IT_BUS_OFF) != 0U && bus_off && !self->bus_off_) {
+		self->bus_offs_++;
+	}
+	self->warning_ = warning;
+	self->passive_ = passive;
+	self->bus_off_ = bus_off;
+}
+
+//=============================================================================
+// Aggregation (Task)
+//=============================================================================
+
+void MonitorBase::sample()
+{
+	if (bus_ == nullptr) {
+		return;
+	}
+
+	FDCAN_ErrorCountersTypeDef ec = {};
+	HAL_FDCAN_GetErrorCounters(bus_->handle(), &ec);
+	fdcan::CanBusStats bs = bus_->stats();
+
+	bool unmask = false;
+	uint64_t now = ustim::get();
+
+	taskENTER_CRITICAL();
+	uint32_t us = static_cast<uint32_t>(now - last_us_);
+	if (us == 0) {
+		us = 1;
+	}
+	last_us_ = now;
+
+	uint32_t rx = rx_frames_;
+	uint32_t tx = tx_frames_;
+	uint32_t busy = busy_ns_;
+	MonitorStats& s = stats_;
+
+	uint32_t load = (busy - prev_busy_ns_) / us;          // ns per us: permille
+	s.load_permille = static_cast<uint16_t>(load > 1000U ? 1000U : load);
+	if (s.load_permille > s.load_max_permille) {
+		s.load_max_permille = s.load_permille;
+	}
+	s.rx_per_s = per_s_(rx - prev_rx_, us);
+	s.tx_per_s = per_s_(tx - prev_tx_, us);
+	prev_rx_ = rx;
+	prev_tx_ = tx;
+	prev_busy_ns_ = busy;
+
+	for (size_t i = 0; i < id_count_; i++) {
+		IdSlot& slot = ids_[i];
+		uint32_t frames = slot.frames;
+		slot.per_s = per_s_(frames - slot.prev, us);
+		slot.prev = frames;
+		if (slot.per_s > slot.max_per_s) {
+			slot.max_per_s = slot.per_s;
+		}
+	}
+
+	uint16_t tec = static_cast<uint16_t>(ec.TxErrorCnt);
+	uint16_t rec = static_cast<uint16_t>(ec.RxErrorCnt);
+	if (s.windows > 0) {
+		s.tec_delta = static_cast<int16_t>(tec - s.tec);
+		s.rec_delta = static_cast<int16_t>(rec - s.rec);
+	}
+	s.tec = tec;
+	s.rec = rec;
+	if (tec > s.tec_max) {
+		s.tec_max = tec;
+	}
+	if (rec > s.rec_max) {
+		s.rec_max = rec;
+	}
+
+	s.rx_fifo_max[0] = bs.rx_fifo_max[0];
+	s.rx_fifo_max[1] = bs.rx_fifo_max[1];
+	s.windows++;
+
+	window_errors_ = 0;
+	if (masked_) {
+		masked_ = false;
+		unmask = true;
+	}
+	taskEXIT_CRITICAL();
+
+	if (unmask) {
+		bus_->set_error_its(true);
+	}
+}
+
+MonitorStats MonitorBase::stats() const
+{
+	MonitorStats s;
+	taskENTER_CRITICAL();
+	s = stats_;
+	s.rx_frames = rx_frames_;
+	s.tx_frames = tx_frames_;
+	s.unwatched = unwatched_;
+	for (size_t k = 0; k < ERROR_KINDS; k++) {
+		s.errors[k] = errors_[k];
+	}
+	s.errors_other = errors_other_;
+	s.data_errors = data_errors_;
+	s.storms = storms_;
+	s.warnings = warnings_;
+	s.passives = passives_;
+	s.bus_offs = bus_offs_;
+	s.warning = warning_;
+	s.passive = passive_;
+	s.bus_off = bus_off_;
+	taskEXIT_CRITICAL();
+	return s;
+}
+
+IdRate MonitorBase::id_rate(size_t index) const
+{
+	IdRate r = {};
+	if (index >= id_count_) {
+		return r;
+	}
+	taskENTER_CRITICAL();
+	const IdSlot& slot = ids_[index];
+	r.id = slot.key & ~EXT_KEY;
+	r.ext = (slot.key & EXT_KEY) != 0;
+	r.frames = slot.frames;
+	r.per_s = slot.per_s;
+	r.max_per_s = slot.max_per_s;
+	taskEXIT_CRITICAL();
+	return r;
+}
+
+void MonitorBase::reset_stats()
+{
+	taskENTER_CRITICAL();
+	rx_frames_ = 0;
+	tx_frames_ = 0;
+	unwatched_ = 0;
+	busy_ns_ = 0;
+	for (auto& e : errors_) {
+		e = 0;
+	}
+	errors_other_ = 0;
+	data_errors_ = 0;
+	storms_ = 0;
+	warnings_ = 0;
+	passives_ = 0;
+	bus_offs_ = 0;
+	for (size_t i = 0; i < id_count_; i++) {
+		ids_[i].frames = 0;
+		ids_[i].prev = 0;
+		ids_[i].per_s = 0;
+		ids_[i].max_per_s = 0;
+	}
+	prev_rx_ = 0;
+	prev_tx_ = 0;
+	prev_busy_ns_ = 0;
+	stats_ = {};
+	last_us_ = ustim::get();
+	taskEXIT_CRITICAL();
+}
+
+//=============================================================================
+// Console (sio)
+//=============================================================================
+
+void MonitorBase::report() const
+{
+	MonitorStats s = stats();
+	sio::writef(fmt_buf_, "%s load %lu.%lu%% (max %lu.%lu%%) rx %lu/s tx %lu/s\r\n", name_,
+		    static_cast<unsigned long>(s.load_permille / 10), static_cast<unsigned long>(s.load_permille % 10),
+		    static_cast<unsigned long>(s.load_max_permille / 10),
+		    static_cast<unsigned long>(s.load_max_permille % 10),
+		    static_cast<unsigned long>(s.rx_per_s), static_cast<unsigned long>(s.tx_per_s));
+	sio::writef(fmt_buf_, "%s tec %u (max %u, %+d) rec %u (max %u, %+d) %s\r\n", name_,
+		    static_cast<unsigned>(s.tec), static_cast<unsigned>(s.tec_max), s.tec_delta,
+		    static_cast<unsigned>(s.rec), static_cast<unsigned>(s.rec_max), s.rec_delta,
+		    s.bus_off ? "bus-off" : s.passive ? "passive" : s.warning ? "warning" : "active");
+	uint32_t errors = s.errors_other;
+	for (uint32_t e : s.errors) {
+		errors += e;
+	}
+	sio::writef(fmt_buf_, "%s errors %lu storms %lu fifo0 max %lu fifo1 max %lu\r\n", name_,
+		    static_cast<unsigned long>(errors), static_cast<unsigned long>(s.storms),
+		    static_cast<unsigned long>(s.rx_fifo_max[0]), static_cast<unsigned long>(s.rx_fifo_max[1]));
+}
+
+void MonitorBase::write_ids_() const
+{
+	for (size_t i = 0; i < id_count_; i++) {
+		IdRate r = id_rate(i);
+		sio::writef(fmt_buf_, r.ext ? "%s id %08lX %lu/s (max %lu/s) %lu\r\n" : "%s id %03lX %lu/s (max %lu/s) %lu\r\n",
+			    name_, static_cast<unsigned long>(r.id), static_cast<unsigned long>(r.per_s),
+			    static_cast<unsigned long>(r.max_per_s), static_cast<unsigned long>(r.frames));
+	}
+	sio::writef(fmt_buf_, "%s id other %lu\r\n", name_, static_cast<unsigned long>(stats().unwatched));
+}
+
+void MonitorBase::write_errors_() const
+{
+	MonitorStats s = stats();
+	for (size_t k = 0; k < ERROR_KINDS; k++) {
+		sio::writef(fmt_buf_, "%s error %-5s %lu\r\n", name_, ERROR_NAMES[k],
+			    static_cast<unsigned long>(s.errors[k]));
+	}
+	sio::writef(fmt_buf_, "%s error other %lu data %lu\r\n", name_,
+		    static_cast<unsigned long>(s.errors_other), static_cast<unsigned long>(s.data_errors));
+	sio::writef(fmt_buf_, "%s state warning %lu passive %lu bus-off %lu\r\n", name_,
+		    static_cast<unsigned long>(s.warnings), static_cast<unsigned long>(s.passives),
+		    static_cast<unsigned long>(s.bus_offs));
+}
+
+bool MonitorBase::command(const char* line)
+{
+	const char* arg = subcommand_(line);
+	if (arg == nullptr) {
+		return false;
+	}
+	if (*arg == '\0' || *arg == '\r' || *arg == '\n') {
+		report();
+	} else if (is_word_(arg, "ids")) {
+		write_ids_();
+	} else if (is_word_(arg, "errors")) {
+		write_errors_();
+	} else if (is_word_(arg, "reset")) {
+		reset_stats();
+		sio::writef(fmt_buf_, "%s reset\r\n", name_);
+	} else {
+		sio::writef(fmt_buf_, "usage: canmon [ids|errors|reset]\r\n");
+	}
+	return true;
+}
+
+} // namespace canmon
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
@@ -0,0 +1,119 @@
+/**
+ * STM32ZERO Cooperative Flows (stackless coroutines)
+ *
+ * The executor runs every spawned flow once per pass, then blocks on its
+ * task notification until the earliest deadline, the poll interval, or a
+ * wake() from a Signal / spawn() / bound queue / producer.
+ */
+
+#include "stm32zero-coro.hpp"
+
+namespace stm32zero {
+namespace coro {
+
+//=============================================================================
+// Signal
+//=============================================================================
+
+void Signal::set()
+{
+	{
+		CriticalSection cs;
+		set_ = true;
+	}
+	if (exec_ != nullptr) {
+		exec_->wake();
+	}
+}
+
+void Signal::set_from_isr(BaseType_t* woken)
+{
+	{
+		CriticalSection cs;
+		set_ = true;
+	}
+	if (exec_ != nullptr) {
+		exec_->wake_from_isr(woken);
+	}
+}
+
+//=============================================================================
+// ExecutorBase
+//=============================================================================
+
+void ExecutorBase::wake()
+{
+	if (task_ != nullptr) {
+		xTaskNotifyGive(task_);
+	}
+}
+
+void ExecutorBase::wake_from_isr(BaseType_t* woken)
+{
+	if (task_ != nullptr) {
+		vTaskNotifyGiveFromISR(task_, woken);
+	}
+}
+
+TickType_t ExecutorBase::run_pass_(Slot* slots, size_t n)
+{
+	uint64_t wake_at = UINT64_MAX;
+	bool poll = false;
+
+	passes_++;
+	for (size_t i = 0; i < n; i++) {
+		Flow* flow = slots[i].flow;
+		if (flow == nullptr) {
+			continue;
+		}
+
+		flow->wake_at_us_ = UINT64_MAX;
+		flow->poll_ = false;
+		resumes_++;
+
+		if (flow->resume() == Flow::Status::DONE) {
+			// Destroy and return to its pool before the slot can be reused
+			slots[i].drop(slots[i].owner);
+			CriticalSection cs;
+			slots[i].flow = nullptr;
+			active_--;
+			continue;
+		}
+
+		if (flow->wake_at_us_ < wake_at) {
+			wake_at = flow->wake_at_us_;
+		}
+		poll = poll || flow->poll_;
+	}
+
+	if (poll) {
+		return STM32ZERO_CORO_POLL_TICKS;
+	}
+	if (wake_at == UINT64_MAX) {
+		return portMAX_DELAY;
+	}
+
+	uint64_t now = ustim::get();
+	if (wake_at <= now) {
+		return 0;
+	}
+
+	// Round up so the block covers the deadline: the flow resumes up to a
+	// tick late (a block that ends short of it only costs one more pass)
+	const uint64_t us_per_tick = 1000000 / configTICK_RATE_HZ;
+	uint64_t ticks = (wake_at - now + us_per_tick - 1) / us_per_tick;
+	return (ticks >= portMAX_DELAY) ? portMAX_DELAY - 1 : static_cast<TickType_t>(ticks);
+}
+
+void ExecutorBase::run_(Slot* slots, size_t n)
+{
+	while (true) {
+		TickType_t ticks = run_pass_(slots, n);
+		if (ticks != 0) {
+			ulTaskNotifyTake(pdTRUE, ticks);
+		}
+	}
+}
+
+} // namespace coro
+} // namespace stm32zero
@@ -0,0 +1,385 @@
+/**
+ * STM32ZERO Asynchronous DMA memcpy (MDMA)
+ *
+ * One MDMA channel serves a FIFO of copy requests. Requests larger than
+ * one MDMA block are split into CHUNK_SIZE pieces that are chained from
+ * the transfer-complete interrupt. SRAM4 (D3) is reached through the
+ * MDMA AHB master as well, so no separate BDMA path is needed.
+ */
+
+#include "stm32zero-dmacpy.hpp"
+
+#if defined(MDMA)
+
+#include "stm32zero-dcache.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-trace.hpp"
+#include <cstring>
+
+using namespace stm32zero::freertos;
+
+namespace stm32zero {
+
+//=============================================================================
+// Internal State
+//=============================================================================
+
+namespace {
+
+constexpr size_t QUEUE_LEN = STM32ZERO_DMACPY_QUEUE_LEN;
+constexpr size_t CHUNK_SIZE = 0x8000;  // CBNDTR.BNDT is 17 bits, keep word-aligned
+
+static_assert(QUEUE_LEN > 0 && QUEUE_LEN < 0xFE, "STM32ZERO_DMACPY_QUEUE_LEN out of range");
+
+struct Request {
+	uint8_t* dst;
+	const uint8_t* src;
+	size_t total;
+	size_t done;
+	DmaCopyCallback callback;
+	void* arg;
+	bool dst_cacheable;
+};
+
+enum class Mode : uint8_t { NONE, BYTE, WORD };
+
+Request requests_[QUEUE_LEN];
+volatile uint32_t slot_seq_[QUEUE_LEN];  // incremented when a slot completes
+StaticBinarySemaphore done_sem_[QUEUE_LEN];
+
+volatile size_t head_ = 0;               // active request
+volatile size_t tail_ = 0;               // next free slot
+volatile size_t count_ = 0;
+
+MDMA_HandleTypeDef hmdma_;
+Mode mode_ = Mode::NONE;
+bool initialized_ = false;
+
+dmacpy::Stats stats_;
+
+// Reconfigure the channel data size only when alignment mode changes
+void configure_(Mode mode)
+{
+	if (mode == mode_) {
+		return;
+	}
+
+	hmdma_.Init.Request = MDMA_REQUEST_SW;
+	hmdma_.Init.TransferTriggerMode = MDMA_FULL_TRANSFER;
+	hmdma_.Init.Priority = MDMA_PRIORITY_HIGH;
+	hmdma_.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+	hmdma_.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+	hmdma_.Init.BufferTransferLength = 128;
+	hmdma_.Init.SourceBlockAddressOffset = 0;
+	hmdma_.Init.DestBlockAddressOffset = 0;
+
+	if (mode == Mode::WORD) {
+		hmdma_.Init.SourceInc = MDMA_SRC_INC_WORD;
+		hmdma_.Init.DestinationInc = MDMA_DEST_INC_WORD;
+		hmdma_.Init.SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+		hmdma_.Init.DestDataSize = MDMA_DEST_DATASIZE_WORD;
+		hmdma_.Init.SourceBurst = MDMA_SOURCE_BURST_32BEATS;  // 128 bytes
+		hmdma_.Init.DestBurst = MDMA_DEST_BURST_32BEATS;
+	} else {
+		hmdma_.Init.SourceInc = MDMA_SRC_INC_BYTE;
+		hmdma_.Init.DestinationInc = MDMA_DEST_INC_BYTE;
+		hmdma_.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+		hmdma_.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+		hmdma_.Init.SourceBurst = MDMA_SOURCE_BURST_128BEATS;  // 128 bytes
+		hmdma_.Init.DestBurst = MDMA_DEST_BURST_128BEATS;
+	}
+
+	HAL_MDMA_Init(&hmdma_);
+	mode_ = mode;
+}
+
+// Start the next chunk of the request at head_ (channel must be idle)
+bool start_chunk_()
+{
+	Request& r = requests_[head_];
+	size_t n = r.total - r.done;
+	if (n > CHUNK_SIZE) {
+		n = CHUNK_SIZE;
+	}
+
+	uintptr_t src = reinterpret_cast<uintptr_t>(r.src + r.done);
+	uintptr_t dst = reinterpret_cast<uintptr_t>(r.dst + r.done);
+	configure_(((src | dst | n) & 3U) == 0 ? Mode::WORD : Mode::BYTE);
+
+	return HAL_MDMA_Start_IT(&hmdma_, static_cast<uint32_t>(src), static_cast<uint32_t>(dst),
+				 static_cast<uint32_t>(n), 1) == HAL_OK;
+}
+
+// Completion of a retired request, delivered after the queue is updated
+struct Retired {
+	DmaCopyCallback callback;
+	void* arg;
+	size_t slot;
+};
+
+// Drop stale destination lines before the request is seen as done
+void invalidate_head_()
+{
+	Request& r = requests_[head_];
+	if (r.dst_cacheable) {
+		dcache::invalidate(r.dst, r.total);
+	}
+}
+
+// Remove the request at head_ and complete its sequence (queue state only)
+Retired pop_head_()
+{
+	Request& r = requests_[head_];
+	Retired done = { r.callback, r.arg, head_ };
+
+	head_ = (head_ + 1) % QUEUE_LEN;
+	count_ = count_ - 1;
+	slot_seq_[done.slot] = slot_seq_[done.slot] + 1;
+	return done;
+}
+
+// Callback and waiter; woken == nullptr from task context
+void notify_(const Retired& done, BaseType_t* woken)
+{
+	if (done.callback != nullptr) {
+		done.callback(done.arg);
+	}
+	if (woken != nullptr) {
+		done_sem_[done.slot].give_from_isr(woken);
+	} else {
+		done_sem_[done.slot].give();
+	}
+}
+
+// Retire the request at head_: cache, sequence, callback, waiter
+void retire_head_(BaseType_t* woken)
+{
+	invalidate_head_();
+	notify_(pop_head_(), woken);
+}
+
+// Start the request at head_; requests that fail to start are retired
+void start_next_(BaseType_t* woken)
+{
+	while (count_ > 0 && !start_chunk_()) {
+		stats_.errors++;
+		mode_ = Mode::NONE;
+		retire_head_(woken);
+	}
+}
+
+// Task context: retire the request at head_ that failed to start and try
+// the next ones. The channel is idle, so head_ stays put outside the lock;
+// only the queue update and the next start run masked, the cache
+// maintenance and the callback run unmasked as in the interrupt path.
+void start_failed_()
+{
+	bool failed = true;
+	while (failed) {
+		invalidate_head_();
+		Retired done;
+		{
+			CriticalSection cs;
+			stats_.errors++;
+			mode_ = Mode::NONE;
+			done = pop_head_();
+			failed = count_ > 0 && !start_chunk_();
+		}
+		notify_(done, nullptr);
+	}
+}
+
+void xfer_cplt_(MDMA_HandleTypeDef*)
+{
+	BaseType_t woken = pdFALSE;
+	Request& r = requests_[head_];
+
+	size_t n = r.total - r.done;
+	r.done += (n > CHUNK_SIZE) ? CHUNK_SIZE : n;
+
+	if (r.done < r.total) {
+		if (!start_chunk_()) {
+			stats_.errors++;
+			mode_ = Mode::NONE;
+			retire_head_(&woken);
+			start_next_(&woken);
+		}
+	} else {
+		stats_.dma_copies++;
+		stats_.dma_bytes += r.total;
+		retire_head_(&woken);
+		start_next_(&woken);
+	}
+
+	portYIELD_FROM_ISR(woken);
+}
+
+void xfer_error_(MDMA_HandleTypeDef*)
+{
+	BaseType_t woken = pdFALSE;
+
+	// Channel is disabled by HAL; drop the request and move on
+	stats_.errors++;
+	mode_ = Mode::NONE;
+	retire_head_(&woken);
+	start_next_(&woken);
+
+	portYIELD_FROM_ISR(woken);
+}
+
+} // namespace
+
+//=============================================================================
+// MDMA Interrupt
+//=============================================================================
+
+extern "C" void MDMA_IRQHandler(void)
+{
+	trace::IsrScope trace_isr;
+	HAL_MDMA_IRQHandler(&hmdma_);
+}
+
+//=============================================================================
+// DmaCopyFuture
+//=============================================================================
+
+bool DmaCopyFuture::is_done() const
+{
+	if (slot_ == COMPLETED) {
+		return true;
+	}
+	if (slot_ == INVALID) {
+		return false;
+	}
+	return slot_seq_[slot_] != seq_;
+}
+
+bool DmaCopyFuture::wait(TickType_t timeout) const
+{
+	if (slot_ == INVALID) {
+		return false;
+	}
+
+	TickType_t start = xTaskGetTickCount();
+	while (!is_done()) {
+		TickType_t waited = xTaskGetTickCount() - start;
+		if (timeout != portMAX_DELAY && waited >= timeout) {
+			return false;
+		}
+		// Semaphore may have been given for an earlier request in the same slot;
+		// loop re-checks the sequence number.
+		done_sem_[slot_].take(timeout == portMAX_DELAY ? portMAX_DELAY : timeout - waited);
+	}
+	return true;
+}
+
+//=============================================================================
+// API
+//=============================================================================
+
+DmaCopyFuture dma_memcpy_async(void* dst, const void* src, size_t n,
+			       DmaCopyCallback callback, void* arg)
+{
+	if (n < STM32ZERO_DMACPY_THRESHOLD || !initialized_) {
+		memcpy(dst, src, n);
+		stats_.cpu_copies++;
+		stats_.cpu_bytes += n;
+		if (callback != nullptr) {
+			callback(arg);
+		}
+		return DmaCopyFuture(DmaCopyFuture::COMPLETED, 0);
+	}
+
+	// Write back source, drop stale destination lines before the MDMA runs
+	if (dmacpy::is_cacheable(src)) {
+		dcache::clean(src, n);
+	}
+	bool dst_cacheable = dmacpy::is_cacheable(dst);
+	if (dst_cacheable) {
+		dcache::clean_invalidate(dst, n);
+	}
+
+	size_t slot;
+	uint32_t seq;
+	bool failed = false;
+	{
+		CriticalSection cs;
+
+		if (count_ >= QUEUE_LEN) {
+			stats_.rejected++;
+			return DmaCopyFuture();
+		}
+
+		slot = tail_;
+		tail_ = (tail_ + 1) % QUEUE_LEN;
+
+		Request& r = requests_[slot];
+		r.dst = static_cast<uint8_t*>(dst);
+		r.src = static_cast<const uint8_t*>(src);
+		r.total = n;
+		r.done = 0;
+		r.callback = callback;
+		r.arg = arg;
+		r.dst_cacheable = dst_cacheable;
+
+		seq = slot_seq_[slot];
+		done_sem_[slot].take(0);  // discard a give nobody waited for
+
+		count_ = count_ + 1;
+		if (count_ == 1) {
+			failed = !start_chunk_();
+		}
+	}
+	if (failed) {
+		start_failed_();
+	}
+
+	return DmaCopyFuture(static_cast<uint8_t>(slot), seq);
+}
+
+namespace dmacpy {
+
+void init()
+{
+	if (initialized_) {
+		return;
+	}
+
+	for (size_t i = 0; i < QUEUE_LEN; i++) {
+		done_sem_[i].create();
+	}
+
+	__HAL_RCC_MDMA_CLK_ENABLE();
+
+	hmdma_.Instance = MDMA_Channel0;
+	mode_ = Mode::NONE;
+	configure_(Mode::WORD);
+	hmdma_.XferCpltCallback = xfer_cplt_;
+	hmdma_.XferErrorCallback = xfer_error_;
+
+	HAL_NVIC_SetPriority(MDMA_IRQn, STM32ZERO_DMACPY_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(MDMA_IRQn);
+
+	initialized_ = true;
+}
+
+bool is_cacheable(const void* addr)
+{
+	return dcache::is_cacheable(addr);
+}
+
+size_t pending()
+{
+	return count_;
+}
+
+const Stats& stats()
+{
+	return stats_;
+}
+
+} // namespace dmacpy
+
+} // namespace stm32zero
+
+#endif // MDMA
@@ -0,0 +1,225 @@
+/**
+ * STM32ZERO Dual-Channel CAN Gateway
+ *
+ * Each source bus gets one hook route; its filters list the table's IDs
+ * of that direction two per element (rules are sorted, so the IDs of one
+ * direction and type are adjacent). The hook runs in the source bus RX
+ * interrupt, looks the frame up in the table and send()s the copy on the
+ * other bus. Both FDCAN interrupts are expected at one NVIC priority (as
+ * CubeMX sets them), so the two hooks never preempt each other and the
+ * per-rule state needs no lock.
+ *
+ * The rate limit compares RX timestamps (SOF on the ustim timebase), not
+ * the time the interrupt ran, so a burst drained late from the FIFO is
+ * limited the same as one seen frame by frame.
+ */
+
+#include "stm32zero-gateway.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#include <cstring>
+
+namespace stm32zero {
+namespace gateway {
+
+using fdcan::CanBus;
+using fdcan::CanFrame;
+using fdcan::RxFilter;
+using fdcan::RxTarget;
+
+namespace {
+
+constexpr uint8_t FORWARD_FLAGS = CanFrame::FLAG_EXT | CanFrame::FLAG_FD | CanFrame::FLAG_BRS;
+
+} // namespace
+
+//=============================================================================
+// Setup
+//=============================================================================
+
+bool GatewayBase::attach_(const Rule* rules, size_t count, RuleState* state,
+			  CanBus& a, CanBus& b, RxTarget fifo)
+{
+	if (fifo == RxTarget::BUFFER || &a == &b) {
+		return false;
+	}
+	for (uint32_t i = 0; i < 2; i++) {
+		if (rx_[i].is_created() && rx_[i].target() != fifo) {
+			return false;
+		}
+	}
+
+	rules_ = nullptr;               // hooks ignore frames until attached
+	bus_[0] = &a;
+	bus_[1] = &b;
+
+	static const char* const NAMES[2] = { "gw_a", "gw_b" };
+	static const fdcan::RxHook HOOKS[2] = { hook_a_, hook_b_ };
+
+	for (uint32_t i = 0; i < 2; i++) {
+		Dir dir = i == 0 ? Dir::A_TO_B : Dir::B_TO_A;
+		bool used = false;
+		for (size_t r = 0; r < count; r++) {
+			used = used || rules[r].dir == dir;
+		}
+		if (!used) {
+			continue;
+		}
+		if (!rx_[i].is_created() && !rx_[i].create(NAMES[i], fifo, HOOKS[i], this)) {
+			return false;
+		}
+		int route = bus_[i]->add_route(rx_[i]);
+		if (route < 0) {
+			return false;
+		}
+		if (!add_filters_(*bus_[i], route, dir, rules, count)) {
+			return false;
+		}
+	}
+
+	memset(static_cast<void*>(state), 0, sizeof(RuleState) * count);
+	state_ = state;
+	count_ = count;
+	unmatched_ = 0;
+	rules_ = rules;
+	return true;
+}
+
+bool GatewayBase::add_filters_(CanBus& bus, int route, Dir dir, const Rule* rules, size_t count)
+{
+	for (bool ext : { false, true }) {
+		bool pending = false;
+		uint32_t first = 0;
+		for (size_t r = 0; r < count; r++) {
+			if (rules[r].dir != dir || rules[r].ext != ext) {
+				continue;
+			}
+			if (!pending) {
+				first = rules[r].id;
+				pending = true;
+				continue;
+			}
+			uint32_t second = rules[r].id;
+			if (!bus.add_filter(ext ? RxFilter::ext_ids(first, second, route)
+						: RxFilter::std_ids(first, second, route))) {
+				return false;
+			}
+			pending = false;
+		}
+		if (pending && !bus.add_filter(ext ? RxFilter::ext_id(first, route)
+						   : RxFilter::std_id(first, route))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//=============================================================================
+// Forwarding (FDCAN Interrupt)
+//=============================================================================
+
+bool GatewayBase::hook_a_(void* context, const CanFrame& frame, BaseType_t* woken)
+{
+	(void)woken;
+	return static_cast<GatewayBase*>(context)->forward_(Dir::A_TO_B, frame);
+}
+
+bool GatewayBase::hook_b_(void* context, const CanFrame& frame, BaseType_t* woken)
+{
+	(void)woken;
+	return static_cast<GatewayBase*>(context)->forward_(Dir::B_TO_A, frame);
+}
+
+bool GatewayBase::forward_(Dir dir, const CanFrame& frame)
+{
+	if (rules_ == nullptr) {
+		return false;
+	}
+	int index = find_rule(rules_, count_, key_of(dir, frame.is_ext(), frame.id));
+	if (index < 0) {
+		unmatched_++;
+		return false;
+	}
+
+	const Rule& rule = rules_[index];
+	RuleState& st = state_[index];
+	if (rule.min_gap_us != 0 && st.armed && frame.timestamp - st.last < rule.min_gap_us) {
+		st.limited++;
+		return false;
+	}
+
+	CanFrame out;
+	out.id = rule.out_id();
+	out.len = frame.len;
+	out.flags = frame.flags & FORWARD_FLAGS;
+	out.filter = CanFrame::NO_FILTER;
+	out.route = 0;
+	out.timestamp = frame.timestamp;
+	memcpy(out.data, frame.data, frame.len);
+
+	CanBus* dest = bus_[dir == Dir::A_TO_B ? 1 : 0];
+	if (!dest->send(out)) {
+		st.dropped++;
+		return false;
+	}
+	st.last = frame.timestamp;
+	st.armed = true;
+	st.forwarded++;
+	return true;
+}
+
+//=============================================================================
+// Statistics
+//=============================================================================
+
+RuleStats GatewayBase::rule_stats(int index) const
+{
+	RuleStats s = {};
+	if (index < 0 || static_cast<size_t>(index) >= count_ || state_ == nullptr) {
+		return s;
+	}
+	taskENTER_CRITICAL();
+	s.forwarded = state_[index].forwarded;
+	s.limited = state_[index].limited;
+	s.dropped = state_[index].dropped;
+	taskEXIT_CRITICAL();
+	return s;
+}
+
+GatewayStats GatewayBase::stats() const
+{
+	GatewayStats s = {};
+	if (state_ == nullptr) {
+		return s;
+	}
+	taskENTER_CRITICAL();
+	for (size_t i = 0; i < count_; i++) {
+		s.forwarded += state_[i].forwarded;
+		s.limited += state_[i].limited;
+		s.dropped += state_[i].dropped;
+	}
+	s.unmatched = unmatched_;
+	taskEXIT_CRITICAL();
+	return s;
+}
+
+void GatewayBase::reset_stats()
+{
+	if (state_ == nullptr) {
+		return;
+	}
+	taskENTER_CRITICAL();
+	for (size_t i = 0; i < count_; i++) {
+		state_[i].forwarded = 0;
+		state_[i].limited = 0;
+		state_[i].dropped = 0;
+	}
+	unmatched_ = 0;
+	taskEXIT_CRITICAL();
+}
+
+} // namespace gateway
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
@@ -0,0 +1,489 @@
+/**
+ * STM32ZERO ISO-TP (ISO 15765-2) Transport over CanBus
+ *
+ * Protocol control information (first data byte, high nibble):
+ *
+ *   SF  0L             payload <= 7 (L = length)
+ *       00 LL          FD escape: payload 8..62 (TX_DL > 8)
+ *   FF  1H LL          message length 8..4095 (12 bits)
+ *       10 00 LLLLLLLL escape: 32-bit length above 4095
+ *   CF  2N             sequence number, 1 after the FF, wraps at 15
+ *   FC  3S BS ST       S: 0 CTS, 1 WAIT, 2 overflow
+ *
+ * Every frame but the last CF is TX_DL long; short frames are padded to
+ * 8 bytes or the next FD length. The receiver takes RX_DL from the first
+ * frame and rejects a shorter CF before the end of the message.
+ */
+
+#include "stm32zero-isotp.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-timer.hpp"
+#include <cstring>
+
+namespace stm32zero {
+namespace isotp {
+
+using fdcan::CanFrame;
+
+//=============================================================================
+// Internal State
+//=============================================================================
+
+namespace {
+
+constexpr uint8_t PCI_SF = 0x0;
+constexpr uint8_t PCI_FF = 0x1;
+constexpr uint8_t PCI_CF = 0x2;
+constexpr uint8_t PCI_FC = 0x3;
+
+constexpr uint8_t FS_CTS = 0x0;
+constexpr uint8_t FS_WAIT = 0x1;
+constexpr uint8_t FS_OVFLW = 0x2;
+
+constexpr uint32_t FF_DL_12BIT = 4095;
+
+inline uint8_t pci_(const CanFrame& f)
+{
+	return f.len > 0 ? static_cast<uint8_t>(f.data[0] >> 4) : 0xFF;
+}
+
+inline void put_be32_(uint8_t* p, uint32_t v)
+{
+	p[0] = static_cast<uint8_t>(v >> 24);
+	p[1] = static_cast<uint8_t>(v >> 16);
+	p[2] = static_cast<uint8_t>(v >> 8);
+	p[3] = static_cast<uint8_t>(v);
+}
+
+inline uint32_t get_be32_(const uint8_t* p)
+{
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Single frame length and payload offset; false if malformed
+bool parse_sf_(const CanFrame& f, uint32_t& len, uint32_t& off)
+{
+	uint32_t low = f.data[0] & 0x0FU;
+	if (low != 0) {
+		len = low;
+		off = 1;
+		return low <= 7 && low + 1 <= f.len;
+	}
+	if (f.len <= 8) {
+		return false;                   // escape only in FD frames
+	}
+	len = f.data[1];
+	off = 2;
+	return len > 7 && len + 2 <= f.len;
+}
+
+} // namespace
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+const char* result_name(Result res)
+{
+	switch (res) {
+	case Result::OK:              return "OK";
+	case Result::INVALID:         return "INVALID";
+	case Result::TX_FAILED:       return "TX_FAILED";
+	case Result::TIMEOUT_BS:      return "TIMEOUT_BS";
+	case Result::TIMEOUT_CR:      return "TIMEOUT_CR";
+	case Result::TIMEOUT:         return "TIMEOUT";
+	case Result::WRONG_SN:        return "WRONG_SN";
+	case Result::BUFFER_OVERFLOW: return "BUFFER_OVERFLOW";
+	case Result::WFT_OVERRUN:     return "WFT_OVERRUN";
+	case Result::ABORTED:         return "ABORTED";
+	}
+	return "?";
+}
+
+uint32_t stmin_to_us(uint8_t raw)
+{
+	if (raw <= 0x7F) {
+		return raw * 1000U;
+	}
+	if (raw >= 0xF1 && raw <= 0xF9) {
+		return (raw - 0xF0U) * 100U;
+	}
+	return 127000U;                     // reserved: longest STmin
+}
+
+uint8_t stmin_from_us(uint32_t us)
+{
+	if (us == 0) {
+		return 0;
+	}
+	if (us <= 900) {
+		return static_cast<uint8_t>(0xF0 + (us + 99) / 100);
+	}
+	uint32_t ms = (us + 999) / 1000;
+	return static_cast<uint8_t>(ms > 0x7F ? 0x7F : ms);
+}
+
+//=============================================================================
+// Channel
+//=============================================================================
+
+bool Channel::init(fdcan::CanBus& bus, fdcan::RxRouteBase& route, const Config& config)
+{
+	if (!route.is_created()) {
+		return false;
+	}
+	if (config.tx_dl < 8 || config.tx_dl > 64 ||
+	    fdcan::dlc_to_len(fdcan::len_to_dlc(config.tx_dl)) != config.tx_dl) {
+		return false;
+	}
+	if (config.tx_id > (config.ext ? 0x1FFFFFFFU : 0x7FFU)) {
+		return false;
+	}
+
+	lease_.release();
+	bus_ = &bus;
+	route_ = &route;
+	cfg_ = config;
+	reset_stats();
+	return true;
+}
+
+void Channel::frame_(CanFrame& frame) const
+{
+	frame.id = cfg_.tx_id;
+	frame.flags = cfg_.ext ? CanFrame::FLAG_EXT : 0;
+	if (cfg_.tx_dl > 8) {
+		frame.flags |= CanFrame::FLAG_FD;
+		if (cfg_.brs) {
+			frame.flags |= CanFrame::FLAG_BRS;
+		}
+	}
+	frame.filter = CanFrame::NO_FILTER;
+	frame.route = 0;
+}
+
+void Channel::pad_(CanFrame& frame, uint32_t used) const
+{
+	uint32_t len = fdcan::dlc_to_len(fdcan::len_to_dlc(static_cast<uint8_t>(used < 8 ? 8 : used)));
+	memset(frame.data + used, cfg_.padding, len - used);
+	frame.len = static_cast<uint8_t>(len);
+}
+
+bool Channel::put_(CanFrame& frame, uint32_t used)
+{
+	pad_(frame, used);
+	if (!bus_->write(frame, pdMS_TO_TICKS(cfg_.n_as_ms))) {
+		return false;
+	}
+	stats_.tx_frames++;
+	return true;
+}
+
+bool Channel::send_fc_(uint8_t status)
+{
+	CanFrame& fc = batch_[0];
+	frame_(fc);
+	fc.data[0] = static_cast<uint8_t>((PCI_FC << 4) | status);
+	fc.data[1] = cfg_.block_size;
+	fc.data[2] = cfg_.st_min;
+	if (!put_(fc, 3)) {
+		return false;
+	}
+	stats_.fc_sent++;
+	return true;
+}
+
+// Next frame of the route: the lease slot in place, or a copy in rx_
+const CanFrame* Channel::next_(TickType_t timeout)
+{
+	lease_.release();
+	if (route_->is_lease()) {
+		lease_ = route_->read_lease(timeout);
+		if (!lease_) {
+			return nullptr;
+		}
+		stats_.rx_frames++;
+		return lease_.get();
+	}
+	if (!route_->receive(rx_, timeout)) {
+		return nullptr;
+	}
+	stats_.rx_frames++;
+	return &rx_;
+}
+
+Result Channel::finish_(Result res, bool tx)
+{
+	lease_.release();
+	if (res == Result::OK) {
+		if (tx) {
+			stats_.tx_messages++;
+		} else {
+			stats_.rx_messages++;
+		}
+	} else if (res != Result::TIMEOUT) {
+		stats_.errors++;
+	}
+	return res;
+}
+
+//=============================================================================
+// Transmit
+//=============================================================================
+
+Result Channel::send(const void* data, uint32_t len)
+{
+	if (bus_ == nullptr || data == nullptr || len == 0) {
+		return finish_(Result::INVALID, true);
+	}
+	const uint8_t* src = static_cast<const uint8_t*>(data);
+	CanFrame& f = batch_[0];
+	frame_(f);
+
+	if (len <= sf_max()) {
+		uint32_t off = 1;
+		if (len <= 7) {
+			f.data[0] = static_cast<uint8_t>((PCI_SF << 4) | len);
+		} else {
+			f.data[0] = PCI_SF << 4;
+			f.data[1] = static_cast<uint8_t>(len);
+			off = 2;
+		}
+		memcpy(f.data + off, src, len);
+		return finish_(put_(f, off + len) ? Result::OK : Result::TX_FAILED, true);
+	}
+
+	// First frame
+	uint32_t off = 2;
+	if (len <= FF_DL_12BIT) {
+		f.data[0] = static_cast<uint8_t>((PCI_FF << 4) | (len >> 8));
+		f.data[1] = static_cast<uint8_t>(len);
+	} else {
+		f.data[0] = PCI_FF << 4;
+		f.data[1] = 0;
+		put_be32_(f.data + 2, len);
+		off = 6;
+	}
+	uint32_t offset = cfg_.tx_dl - off;
+	memcpy(f.data + off, src, offset);
+	if (!put_(f, cfg_.tx_dl)) {
+		return finish_(Result::TX_FAILED, true);
+	}
+
+	uint8_t sn = 1;
+	while (offset < len) {
+		uint8_t bs;
+		uint32_t st_us;
+		Result res = wait_fc_(bs, st_us);
+		if (res == Result::OK) {
+			res = send_cfs_(src, len, offset, sn, bs, st_us);
+		}
+		if (res != Result::OK) {
+			return finish_(res, true);
+		}
+	}
+	return finish_(Result::OK, true);
+}
+
+Result Channel::wait_fc_(uint8_t& bs, uint32_t& st_us)
+{
+	const TickType_t limit = pdMS_TO_TICKS(cfg_.n_bs_ms);
+	TickType_t start = xTaskGetTickCount();
+	uint32_t waits = 0;
+
+	while (true) {
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= limit) {
+			return Result::TIMEOUT_BS;
+		}
+		const CanFrame* f = next_(limit - elapsed);
+		if (f == nullptr) {
+			return Result::TIMEOUT_BS;
+		}
+		if (pci_(*f) != PCI_FC || f->len < 3) {
+			stats_.ignored++;
+			continue;
+		}
+
+		switch (f->data[0] & 0x0F) {
+		case FS_CTS:
+			bs = f->data[1];
+			st_us = stmin_to_us(f->data[2]);
+			lease_.release();
+			return Result::OK;
+		case FS_WAIT:
+			stats_.fc_waits++;
+			if (++waits > cfg_.wft_max) {
+				return Result::WFT_OVERRUN;
+			}
+			start = xTaskGetTickCount();        // N_Bs restarts
+			continue;
+		case FS_OVFLW:
+			return Result::BUFFER_OVERFLOW;
+		default:
+			return Result::ABORTED;
+		}
+	}
+}
+
+// One block (bs frames, or the rest with bs 0). Without STmin the frames
+// go out in write_many() batches; with STmin one by one, the first at once.
+Result Channel::send_cfs_(const uint8_t* src, uint32_t len, uint32_t& offset, uint8_t& sn,
+			  uint8_t bs, uint32_t st_us)
+{
+	const uint32_t payload = cfg_.tx_dl - 1U;
+	uint32_t block = 0;
+	uint64_t next_us = 0;
+
+	while (offset < len && (bs == 0 || block < bs)) {
+		size_t n = 0;
+		size_t batch = st_us == 0 ? STM32ZERO_ISOTP_BATCH : 1;
+		while (n < batch && offset < len && (bs == 0 || block < bs)) {
+			CanFrame& f = batch_[n++];
+			uint32_t chunk = len - offset < payload ? len - offset : payload;
+			frame_(f);
+			f.data[0] = static_cast<uint8_t>((PCI_CF << 4) | sn);
+			memcpy(f.data + 1, src + offset, chunk);
+			pad_(f, 1 + chunk);
+			offset += chunk;
+			sn = (sn + 1) & 0x0F;
+			block++;
+		}
+
+		if (next_us != 0) {
+			freertos::timer::sleep_until(next_us);
+		}
+		if (bus_->write_many(batch_, n, pdMS_TO_TICKS(cfg_.n_as_ms)) != n) {
+			return Result::TX_FAILED;
+		}
+		stats_.tx_frames += n;
+		if (st_us != 0) {
+			next_us = ustim::get() + st_us;
+		}
+	}
+	return Result::OK;
+}
+
+//=============================================================================
+// Receive
+//=============================================================================
+
+Result Channel::receive(void* buf, uint32_t capacity, uint32_t& len, TickType_t timeout)
+{
+	len = 0;
+	if (bus_ == nullptr || buf == nullptr) {
+		return finish_(Result::INVALID, false);
+	}
+
+	TickType_t start = xTaskGetTickCount();
+	while (true) {
+		TickType_t remain = timeout;
+		if (timeout != portMAX_DELAY) {
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			remain = elapsed < timeout ? timeout - elapsed : 0;
+		}
+		const CanFrame* f = next_(remain);
+		if (f == nullptr) {
+			return finish_(Result::TIMEOUT, false);
+		}
+		uint8_t pci = pci_(*f);
+		if (pci == PCI_SF || pci == PCI_FF) {
+			return finish_(reassemble_(f, static_cast<uint8_t*>(buf), capacity, len), false);
+		}
+		stats_.ignored++;
+	}
+}
+
+Result Channel::reassemble_(const CanFrame* f, uint8_t* dst, uint32_t capacity, uint32_t& len)
+{
+	while (true) {
+		if (pci_(*f) == PCI_SF) {
+			uint32_t off;
+			if (!parse_sf_(*f, len, off)) {
+				return Result::ABORTED;
+			}
+			if (len > capacity) {
+				return Result::BUFFER_OVERFLOW;
+			}
+			memcpy(dst, f->data + off, len);
+			return Result::OK;
+		}
+
+		// First frame: its length is RX_DL
+		const uint32_t rx_dl = f->len;
+		if (rx_dl < 8) {
+			return Result::ABORTED;
+		}
+		uint32_t off = 2;
+		uint32_t total = ((f->data[0] & 0x0FU) << 8) | f->data[1];
+		if (total == 0) {
+			total = get_be32_(f->data + 2);
+			off = 6;
+		}
+		len = total;
+		if (total <= rx_dl - off) {
+			return Result::ABORTED;             // fits a single frame
+		}
+		if (total > capacity) {
+			send_fc_(FS_OVFLW);
+			return Result::BUFFER_OVERFLOW;
+		}
+
+		uint32_t got = rx_dl - off;
+		memcpy(dst, f->data + off, got);
+		if (!send_fc_(FS_CTS)) {
+			return Result::TX_FAILED;
+		}
+
+		uint8_t sn = 1;
+		uint32_t block = 0;
+		bool restart = false;
+		while (got < total) {
+			f = next_(pdMS_TO_TICKS(cfg_.n_cr_ms));
+			if (f == nullptr) {
+				return Result::TIMEOUT_CR;
+			}
+			uint8_t pci = pci_(*f);
+			if (pci == PCI_SF || pci == PCI_FF) {
+				restart = true;                 // new message replaces this one
+				break;
+			}
+			if (pci != PCI_CF) {
+				stats_.ignored++;
+				continue;
+			}
+			if ((f->data[0] & 0x0F) != sn) {
+				return Result::WRONG_SN;
+			}
+
+			uint32_t n = total - got;
+			if (n > f->len - 1U) {
+				if (f->len != rx_dl) {
+					return Result::ABORTED;     // short CF before the last
+				}
+				n = f->len - 1U;
+			}
+			memcpy(dst + got, f->data + 1, n);
+			got += n;
+			sn = (sn + 1) & 0x0F;
+
+			if (cfg_.block_size != 0 && ++block == cfg_.block_size && got < total) {
+				block = 0;
+				if (!send_fc_(FS_CTS)) {
+					return Result::TX_FAILED;
+				}
+			}
+		}
+		if (!restart) {
+			return Result::OK;
+		}
+	}
+}
+
+} // namespace isotp
+} // namespace stm32zero
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
@@ -0,0 +1,71 @@
+/**
+ * STM32ZERO Task-Notification Primitives
+ *
+ * Several primitives share one notification value, but the kernel keeps a
+ * single "pending" state per task. A wait for one range can consume the
+ * pending state raised for another range, leaving that range's bits set
+ * without a pending notification. wait_bits() therefore always inspects
+ * the value before blocking, and only blocks when its own bits are absent.
+ */
+
+#include "stm32zero-notify.hpp"
+
+namespace stm32zero {
+namespace freertos {
+namespace notify {
+
+void clear_bits(uint32_t bits)
+{
+#if (tskKERNEL_VERSION_MAJOR > 10) || (tskKERNEL_VERSION_MAJOR == 10 && tskKERNEL_VERSION_MINOR >= 4)
+	ulTaskNotifyValueClear(nullptr, bits);
+#else
+	// V10.3: no atomic clear; read-modify-write with notifiers locked out
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	uint32_t value = 0;
+
+	taskENTER_CRITICAL();
+	xTaskNotifyAndQuery(self, 0, eNoAction, &value);
+	xTaskNotify(self, value & ~bits, eSetValueWithOverwrite);
+	taskEXIT_CRITICAL();
+#endif
+}
+
+uint32_t wait_bits(uint32_t mask, bool all, bool clear, TickType_t timeout)
+{
+	// For "any" the kernel clears the matched range atomically on exit
+	uint32_t exit_clear = (clear && !all) ? mask : 0;
+	TickType_t start = xTaskGetTickCount();
+	TickType_t wait = 0;    // first pass only samples the value
+
+	while (true) {
+		uint32_t value = 0;
+		BaseType_t received = xTaskNotifyWait(0, exit_clear, &value, wait);
+
+		uint32_t got = value & mask;
+		bool ok = all ? (got == mask) : (got != 0);
+		if (ok) {
+			// Cleared by the kernel only if a notification was pending
+			if (clear && (all || received != pdTRUE)) {
+				clear_bits(got);
+			}
+			return got;
+		}
+
+		if (timeout == 0) {
+			return 0;
+		}
+		if (timeout == portMAX_DELAY) {
+			wait = portMAX_DELAY;
+		} else {
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) {
+				return 0;
+			}
+			wait = timeout - elapsed;
+		}
+	}
+}
+
+} // namespace notify
+} // namespace freertos
+} // namespace stm32zero
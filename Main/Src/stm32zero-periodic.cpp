@@ -0,0 +1,116 @@
+/**
+ * STM32ZERO Periodic Task
+ *
+ * Releases are kept as absolute ustim deadlines (release += period), so
+ * jitter in one cycle never accumulates into drift. The wait between
+ * releases is timer::sleep_until(): blocked, not spinning, down to the
+ * last STM32ZERO_TIMER_SPIN_US.
+ *
+ * The task never deletes itself: vTaskDelete(nullptr) leaves the TCB on
+ * the termination list until IDLE runs, and recreating the StaticTask
+ * before that corrupts the kernel lists. It suspends instead, and the
+ * owner deletes it from outside, which frees it immediately.
+ */
+
+#include "stm32zero-periodic.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-timer.hpp"
+
+namespace stm32zero {
+namespace freertos {
+
+bool PeriodicBase::prepare_(Body body, void* ctx, OverrunPolicy policy)
+{
+	if (running_ || body == nullptr) {
+		return false;
+	}
+	reap_();
+	body_ = body;
+	ctx_ = ctx;
+	policy_ = policy;
+	stop_ = false;
+	running_ = true;
+	return true;
+}
+
+void PeriodicBase::started_(TaskHandle_t task)
+{
+	task_ = task;
+	if (task == nullptr) {
+		running_ = false;
+	}
+}
+
+void PeriodicBase::stop()
+{
+	stop_ = true;
+	if (task_ == nullptr || xTaskGetCurrentTaskHandle() == task_) {
+		return;
+	}
+	while (running_) {
+		vTaskDelay(1);
+	}
+	reap_();
+}
+
+void PeriodicBase::reap_()
+{
+	if (task_ != nullptr) {
+		vTaskDelete(task_);
+		task_ = nullptr;
+	}
+}
+
+void PeriodicBase::task_func_(void* param)
+{
+	PeriodicBase* self = static_cast<PeriodicBase*>(param);
+	self->run_();
+	self->running_ = false;
+	for (;;) {
+		vTaskSuspend(nullptr);      // deleted by stop() or the next start()
+	}
+}
+
+void PeriodicBase::run_()
+{
+	uint64_t release = ustim::get() + period_us_;
+
+	while (!stop_) {
+		timer::sleep_until(release);
+
+		uint64_t start = ustim::get();
+		body_(ctx_);
+		uint64_t end = ustim::get();
+
+		uint64_t next = release + period_us_;
+		uint32_t missed = 0;
+		if (end > next) {
+			// Releases at next, next + period, ... that already passed
+			missed = static_cast<uint32_t>((end - next) / period_us_) + 1;
+		}
+
+		{
+			CriticalSection cs;
+			stats_.cycles++;
+			stats_.jitter.add(static_cast<uint32_t>(start - release));
+			stats_.exec.add(static_cast<uint32_t>(end - start));
+			if (missed != 0) {
+				stats_.misses++;
+				if (policy_ != OverrunPolicy::CATCH_UP) {
+					stats_.skipped += missed;
+				}
+			}
+		}
+
+		if (missed != 0 && policy_ != OverrunPolicy::CATCH_UP) {
+			next += static_cast<uint64_t>(missed) * period_us_;
+			if (policy_ == OverrunPolicy::NOTIFY && overrun_handler_ != nullptr) {
+				overrun_handler_(overrun_ctx_, missed);
+			}
+		}
+		release = next;
+	}
+}
+
+} // namespace freertos
+} // namespace stm32zero
@@ -0,0 +1,205 @@
+/**
+ * STM32ZERO Reader-Writer Locks
+ *
+ * readers_ / writer_ / waiting_ / holders_ change only inside critical
+ * sections; the kernel objects are touched only when a writer is involved.
+ *
+ * A boost is applied with the scheduler suspended, so a reader cannot
+ * leave between being marked boosted and vTaskPrioritySet(); it restores
+ * its own priority after handing the lock to the writer. The priority
+ * saved and restored is the base priority (vTaskPrioritySet() sets the
+ * base), never one inherited from a mutex the reader holds.
+ */
+
+#include "stm32zero-rwlock.hpp"
+
+namespace stm32zero {
+namespace freertos {
+
+bool StaticRwLock::create()
+{
+	if (gate_.create() == nullptr) {
+		return false;
+	}
+	return drained_.create() != nullptr;
+}
+
+namespace {
+
+// Priority without mutex inheritance (V10.3.1 has no uxTaskBasePriorityGet)
+UBaseType_t base_priority_(TaskHandle_t task)
+{
+#if (tskKERNEL_VERSION_MAJOR >= 11)
+	return uxTaskBasePriorityGet(task);
+#else
+	TaskStatus_t st;
+	vTaskGetInfo(task, &st, pdFALSE, eReady);   // eReady: skip state lookup
+	return st.uxBasePriority;
+#endif
+}
+
+} // namespace
+
+// Called inside a critical section
+StaticRwLock::Holder* StaticRwLock::find_(TaskHandle_t task)
+{
+	for (Holder& h : holders_) {
+		if (h.task == task) {
+			return &h;
+		}
+	}
+	return nullptr;
+}
+
+// Called inside a critical section
+void StaticRwLock::hold_(TaskHandle_t task)
+{
+	for (Holder& h : holders_) {
+		if (h.task == nullptr) {
+			h = { task, 0, 1, false };
+			return;
+		}
+	}
+}
+
+void StaticRwLock::boost_(UBaseType_t priority)
+{
+	TaskHandle_t raise[STM32ZERO_RWLOCK_READERS];
+	size_t count = 0;
+
+	vTaskSuspendAll();
+	{
+		CriticalSection cs;
+		for (Holder& h : holders_) {
+			if (h.task != nullptr && uxTaskPriorityGet(h.task) < priority) {
+				if (!h.boosted) {
+					h.priority = base_priority_(h.task);
+					h.boosted = true;
+				}
+				raise[count++] = h.task;
+			}
+		}
+	}
+	for (size_t i = 0; i < count; i++) {
+		vTaskPrioritySet(raise[i], priority);
+	}
+	(void)xTaskResumeAll();
+}
+
+bool StaticRwLock::read_lock(TickType_t timeout)
+{
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+	{
+		CriticalSection cs;
+		// Nested read: a waiting writer may be draining this very reader
+		Holder* h = find_(self);
+		if (h != nullptr) {
+			readers_ = readers_ + 1;
+			h->depth++;
+			return true;
+		}
+		if (!writer_) {
+			readers_ = readers_ + 1;
+			hold_(self);
+			return true;
+		}
+		contended_reads_ = contended_reads_ + 1;
+	}
+
+	// Queue behind the writer on its mutex: it inherits our priority
+	if (!gate_.lock(timeout)) {
+		return false;
+	}
+	{
+		CriticalSection cs;
+		readers_ = readers_ + 1;
+		hold_(self);
+	}
+	gate_.unlock();
+	return true;
+}
+
+void StaticRwLock::read_unlock()
+{
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	bool wake = false;
+	bool restore = false;
+	UBaseType_t priority = 0;
+	{
+		CriticalSection cs;
+		readers_ = readers_ - 1;
+		if (readers_ == 0 && waiting_) {
+			waiting_ = false;
+			wake = true;
+		}
+		for (Holder& h : holders_) {
+			if (h.task == self) {
+				if (--h.depth == 0) {
+					restore = h.boosted;
+					priority = h.priority;
+					h.task = nullptr;
+				}
+				break;
+			}
+		}
+	}
+	// Hand over first: dropping priority before the give could let a
+	// medium-priority task run ahead of the writer again
+	if (wake) {
+		drained_.give();
+	}
+	if (restore) {
+		vTaskPrioritySet(nullptr, priority);
+	}
+}
+
+bool StaticRwLock::write_lock(TickType_t timeout)
+{
+	if (!gate_.lock(timeout)) {
+		return false;
+	}
+
+	{
+		CriticalSection cs;
+		writer_ = true;
+		if (readers_ == 0) {
+			return true;
+		}
+		waiting_ = true;
+	}
+
+	// Active readers finish at our priority; new readers block on gate_
+	boost_(uxTaskPriorityGet(nullptr));
+	if (drained_.take(timeout)) {
+		return true;
+	}
+
+	bool drained;
+	{
+		CriticalSection cs;
+		drained = !waiting_;        // last reader left right after the timeout
+		waiting_ = false;
+		if (!drained) {
+			writer_ = false;
+		}
+	}
+	if (drained) {
+		drained_.take(0);           // consume the late give
+		return true;
+	}
+	gate_.unlock();
+	return false;
+}
+
+void StaticRwLock::write_unlock()
+{
+	{
+		CriticalSection cs;
+		writer_ = false;
+	}
+	gate_.unlock();
+}
+
+} // namespace freertos
+} // namespace stm32zero
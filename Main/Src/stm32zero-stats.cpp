@@ -0,0 +1,311 @@
+/**
+ * STM32ZERO FreeRTOS Run-Time Statistics
+ *
+ * Per-task history is keyed by xTaskNumber (unique per task creation), so
+ * a static TCB reused by a new task does not inherit the old task's time.
+ */
+
+#include "stm32zero-stats.hpp"
+#include "stm32zero-ustim.hpp"
+#include "timers.h"
+
+extern "C" STM32ZERO_STATS_COUNTER_TYPE stm32zero_stats_counter(void)
+{
+	return static_cast<STM32ZERO_STATS_COUNTER_TYPE>(stm32zero::ustim::get());
+}
+
+namespace stm32zero {
+namespace freertos {
+namespace stats {
+
+namespace {
+
+using Counter = STM32ZERO_STATS_COUNTER_TYPE;
+
+struct History {
+	UBaseType_t number;         // xTaskNumber, 0 = unused
+	Counter last_counter;
+	uint64_t total_us;
+};
+
+struct LoadSample {
+	uint16_t load_permille;
+	uint16_t isr_permille;
+};
+
+// snapshot() state
+TaskStatus_t status_[STM32ZERO_STATS_MAX_TASKS];
+History history_[STM32ZERO_STATS_MAX_TASKS];
+uint64_t snap_last_us_ = 0;
+uint64_t snap_last_isr_us_ = 0;
+
+// sample() state
+LoadSample samples_[STM32ZERO_STATS_HISTORY];
+size_t sample_head_ = 0;
+size_t sample_count_ = 0;
+uint64_t sample_last_us_ = 0;
+uint64_t sample_last_isr_us_ = 0;
+Counter sample_last_idle_ = 0;
+
+StaticTimer_t timer_cb_;
+TimerHandle_t timer_ = nullptr;
+
+// ISR accounting state (written by interrupt handlers)
+volatile uint32_t isr_depth_ = 0;
+volatile uint32_t isr_start_us_ = 0;
+volatile uint64_t isr_total_us_ = 0;
+
+State to_state(eTaskState s)
+{
+	switch (s) {
+	case eRunning:   return State::RUNNING;
+	case eReady:     return State::READY;
+	case eBlocked:   return State::BLOCKED;
+	case eSuspended: return State::SUSPENDED;
+	default:         return State::DELETED;
+	}
+}
+
+uint16_t permille(uint64_t part, uint64_t whole)
+{
+	if (whole == 0) {
+		return 0;
+	}
+	uint64_t p = part * 1000 / whole;
+	return static_cast<uint16_t>(p > 1000 ? 1000 : p);
+}
+
+History* find_history(UBaseType_t number)
+{
+	for (History& h : history_) {
+		if (h.number == number) {
+			return &h;
+		}
+	}
+	return nullptr;
+}
+
+// New task: take a slot whose task is gone (not in the current status list)
+History* alloc_history(UBaseType_t number, size_t task_count)
+{
+	for (History& h : history_) {
+		bool alive = false;
+		for (size_t i = 0; i < task_count && h.number != 0; i++) {
+			if (status_[i].xTaskNumber == h.number) {
+				alive = true;
+				break;
+			}
+		}
+		if (!alive) {
+			h = { number, 0, 0 };
+			return &h;
+		}
+	}
+	return nullptr;
+}
+
+void timer_callback(TimerHandle_t)
+{
+	sample();
+}
+
+} // namespace
+
+//=============================================================================
+// snapshot()
+//=============================================================================
+
+bool snapshot(Snapshot& snap)
+{
+	snap.count = 0;
+
+	vTaskSuspendAll();
+
+	Counter total_counter = 0;
+	UBaseType_t n = uxTaskGetSystemState(status_, STM32ZERO_STATS_MAX_TASKS, &total_counter);
+	uint64_t now = ustim::get();
+	uint64_t isr_now = isr_total_us();
+
+	snap.total_tasks = uxTaskGetNumberOfTasks();
+	snap.timestamp_us = now;
+	snap.window_us = static_cast<uint32_t>(now - snap_last_us_);
+	snap.isr_us = static_cast<uint32_t>(isr_now - snap_last_isr_us_);
+	snap_last_us_ = now;
+	snap_last_isr_us_ = isr_now;
+
+	TaskHandle_t idle = xTaskGetIdleTaskHandle();
+	Counter idle_us = 0;
+
+	for (UBaseType_t i = 0; i < n; i++) {
+		const TaskStatus_t& st = status_[i];
+
+		History* h = find_history(st.xTaskNumber);
+		if (h == nullptr) {
+			h = alloc_history(st.xTaskNumber, n);
+		}
+		// Wrap-safe on the 32-bit V10.3.1 counter (window < ~71 minutes)
+		Counter delta = st.ulRunTimeCounter;
+		if (h != nullptr) {
+			delta = st.ulRunTimeCounter - h->last_counter;
+			h->last_counter = st.ulRunTimeCounter;
+			h->total_us += delta;
+		}
+
+		TaskInfo& t = snap.tasks[snap.count++];
+		t.handle = st.xHandle;
+		t.name = st.pcTaskName;
+		t.total_us = h ? h->total_us : delta;
+		t.window_us = delta;
+		t.cpu_permille = permille(delta, snap.window_us);
+		t.priority = static_cast<uint16_t>(st.uxCurrentPriority);
+		t.base_priority = static_cast<uint16_t>(st.uxBasePriority);
+		t.state = to_state(st.eCurrentState);
+		t.stack_free = st.usStackHighWaterMark;
+
+		if (st.xHandle == idle) {
+			idle_us = delta;
+		}
+	}
+
+	(void)xTaskResumeAll();
+
+	snap.load_permille = static_cast<uint16_t>(1000 - permille(idle_us, snap.window_us));
+	snap.isr_permille = permille(snap.isr_us, snap.window_us);
+
+	// uxTaskGetSystemState() returns 0 if the array is too small
+	return n != 0;
+}
+
+//=============================================================================
+// Load Average
+//=============================================================================
+
+void sample()
+{
+	TaskStatus_t idle;
+	vTaskGetInfo(xTaskGetIdleTaskHandle(), &idle, pdFALSE, eReady);  // eReady: skip state lookup
+
+	uint64_t now = ustim::get();
+	uint64_t isr_now = isr_total_us();
+
+	CriticalSection cs;
+
+	uint64_t window = now - sample_last_us_;
+	Counter idle_delta = idle.ulRunTimeCounter - sample_last_idle_;
+
+	LoadSample& s = samples_[sample_head_];
+	s.load_permille = static_cast<uint16_t>(1000 - permille(idle_delta, window));
+	s.isr_permille = permille(isr_now - sample_last_isr_us_, window);
+
+	sample_head_ = (sample_head_ + 1) % STM32ZERO_STATS_HISTORY;
+	if (sample_count_ < STM32ZERO_STATS_HISTORY) {
+		sample_count_++;
+	}
+
+	sample_last_us_ = now;
+	sample_last_isr_us_ = isr_now;
+	sample_last_idle_ = idle.ulRunTimeCounter;
+}
+
+bool start(uint32_t period_ms)
+{
+	TickType_t period = pdMS_TO_TICKS(period_ms);
+	if (period == 0) {
+		return false;
+	}
+
+	if (timer_ == nullptr) {
+		timer_ = xTimerCreateStatic("STATS", period, pdTRUE, nullptr, timer_callback, &timer_cb_);
+		if (timer_ == nullptr) {
+			return false;
+		}
+	} else if (xTimerChangePeriod(timer_, period, 0) != pdPASS) {
+		return false;
+	}
+	return xTimerStart(timer_, 0) == pdPASS;
+}
+
+void stop()
+{
+	if (timer_ != nullptr) {
+		xTimerStop(timer_, 0);
+	}
+}
+
+static uint16_t average(size_t n, bool isr)
+{
+	CriticalSection cs;
+
+	if (n == 0 || n > sample_count_) {
+		n = sample_count_;
+	}
+	if (n == 0) {
+		return 0;
+	}
+
+	uint32_t sum = 0;
+	size_t idx = sample_head_;
+	for (size_t i = 0; i < n; i++) {
+		idx = (idx + STM32ZERO_STATS_HISTORY - 1) % STM32ZERO_STATS_HISTORY;
+		sum += isr ? samples_[idx].isr_permille : samples_[idx].load_permille;
+	}
+	return static_cast<uint16_t>(sum / n);
+}
+
+uint16_t load_average(size_t n)
+{
+	return average(n, false);
+}
+
+uint16_t isr_average(size_t n)
+{
+	return average(n, true);
+}
+
+size_t sample_count()
+{
+	return sample_count_;
+}
+
+//=============================================================================
+// ISR time accounting
+//=============================================================================
+
+// The depth changes with single atomic operations (LDREX/STREX), so an
+// interrupt of any priority may nest between the read and the write.
+// Start and total are touched only by the outermost ISR while it holds
+// depth 1; nested ones see depth > 1 and leave them alone.
+void isr_enter_at(uint32_t now_us)
+{
+	if (__atomic_fetch_add(&isr_depth_, 1, __ATOMIC_RELAXED) == 0) {
+		isr_start_us_ = now_us;
+	}
+}
+
+void isr_exit_at(uint32_t now_us)
+{
+	if (isr_depth_ == 1) {
+		isr_total_us_ = isr_total_us_ + (now_us - isr_start_us_);
+	}
+	__atomic_fetch_sub(&isr_depth_, 1, __ATOMIC_RELAXED);
+}
+
+void isr_enter()
+{
+	isr_enter_at(static_cast<uint32_t>(ustim::get()));
+}
+
+void isr_exit()
+{
+	isr_exit_at(static_cast<uint32_t>(ustim::get()));
+}
+
+uint64_t isr_total_us()
+{
+	CriticalSection cs;
+	return isr_total_us_;
+}
+
+} // namespace stats
+} // namespace freertos
+} // namespace stm32zero
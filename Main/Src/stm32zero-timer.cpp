@@ -0,0 +1,875 @@
+/**
+ * STM32ZERO Software Timers
+ *
+ * Batched requests are linked into one FIFO that a single pended function
+ * drains in the daemon. Precise timers waiting for their last
+ * STM32ZERO_TIMER_HANDOFF_US sit in a deadline-sorted list; compare
+ * channel 1 of the ustim LOW timer is programmed with the low bits of the
+ * earliest deadline (ustim counts the LOW timer in its low bits).
+ * Tasks in sleep_until() share the channel through a second sorted list
+ * of waiters on their own stacks; the compare is set to the earlier head.
+ */
+
+#include "stm32zero-timer.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-trace.hpp"
+#include "stm32zero-masklock.hpp"
+
+#if STM32ZERO_TIMER_PRECISE
+#include "stm32zero-tim.hpp"
+#endif
+
+namespace stm32zero {
+namespace freertos {
+
+//=============================================================================
+// Internal State
+//=============================================================================
+
+namespace {
+
+constexpr uint32_t QUEUE_LEN = configTIMER_QUEUE_LENGTH;
+constexpr uint32_t US_PER_TICK = 1000000 / configTICK_RATE_HZ;
+
+static_assert(STM32ZERO_TIMER_HANDOFF_US >= 2 * US_PER_TICK,
+	      "STM32ZERO_TIMER_HANDOFF_US must cover two ticks");
+
+TimerStats stats_;
+
+// Queue occupancy (not reset with the statistics)
+uint32_t sent_us_[QUEUE_LEN];          // send time of each traced command, FIFO
+uint32_t sent_head_ = 0;
+uint32_t sent_tail_ = 0;
+uint32_t in_queue_ = 0;                 // traced commands in the queue
+uint32_t early_ = 0;                    // processed before their send hook ran
+uint32_t pends_ = 0;                    // our pended calls in the queue
+
+StaticTimer* batch_head_ = nullptr;
+StaticTimer* batch_tail_ = nullptr;
+bool flush_pending_ = false;
+bool stalled_ = false;                  // batch left without a follow-up call
+
+#if STM32ZERO_TIMER_PRECISE
+StaticTimer* armed_head_ = nullptr;
+bool precise_init_ = false;
+
+// Task blocked in sleep_until() (on its stack while it waits)
+struct Waiter {
+	Waiter* next;
+	uint64_t wake;                      // deadline - STM32ZERO_TIMER_SPIN_US
+	TaskHandle_t task;
+	volatile bool done;
+};
+
+Waiter* waiters_ = nullptr;
+constexpr uint32_t WAKE_BIT = timer::SleepNotify::mask();
+#endif
+
+inline uint32_t now32_()
+{
+	return static_cast<uint32_t>(ustim::get());
+}
+
+// Called with the mask held
+inline void note_depth_()
+{
+	uint32_t depth = in_queue_ + pends_;
+	if (depth > stats_.max_depth) {
+		stats_.max_depth = depth;
+	}
+}
+
+void sync_done_(void* param, uint32_t)
+{
+	{
+		MaskLock lock;
+		pends_--;
+	}
+	*static_cast<volatile bool*>(param) = true;
+}
+
+// Returns once the daemon has processed everything queued before the call
+void sync_daemon_()
+{
+	volatile bool done = false;
+	{
+		MaskLock lock;
+		pends_++;
+		note_depth_();
+	}
+	xTimerPendFunctionCall(sync_done_, const_cast<bool*>(&done), 0, portMAX_DELAY);
+	while (!done) {
+		vTaskDelay(1);
+	}
+}
+
+} // namespace
+
+//=============================================================================
+// Trace Hooks (traceTIMER_COMMAND_SEND / traceTIMER_COMMAND_RECEIVED)
+//=============================================================================
+
+static void cmd_sent_(long result)
+{
+	uint32_t now = now32_();
+	MaskLock lock;
+
+	if (result == pdFAIL) {
+		stats_.overflows++;
+		return;
+	}
+	stats_.sent++;
+
+	if (early_ != 0) {
+		early_--;
+		return;
+	}
+	sent_us_[sent_tail_] = now;
+	sent_tail_ = (sent_tail_ + 1) % QUEUE_LEN;
+	in_queue_++;
+	note_depth_();
+}
+
+static void resume_();
+
+static void cmd_received_()
+{
+	uint32_t now = now32_();
+	{
+		MaskLock lock;
+
+		stats_.received++;
+
+		// The daemon preempted the sender before its send hook ran
+		if (in_queue_ == 0) {
+			early_++;
+			stats_.queue_latency.add(0);
+		} else {
+			stats_.queue_latency.add(now - sent_us_[sent_head_]);
+			sent_head_ = (sent_head_ + 1) % QUEUE_LEN;
+			in_queue_--;
+		}
+		if (!stalled_) {
+			return;
+		}
+	}
+	resume_();
+}
+
+//=============================================================================
+// Internal Access
+//=============================================================================
+
+struct TimerAccess {
+	// Batch FIFO (mask held)
+	static void batch_push_(StaticTimer* t)
+	{
+		t->batch_next_ = nullptr;
+		if (batch_tail_ == nullptr) {
+			batch_head_ = t;
+		} else {
+			batch_tail_->batch_next_ = t;
+		}
+		batch_tail_ = t;
+	}
+
+	static void batch_push_front_(StaticTimer* t)
+	{
+		t->batch_next_ = batch_head_;
+		batch_head_ = t;
+		if (batch_tail_ == nullptr) {
+			batch_tail_ = t;
+		}
+	}
+
+	static StaticTimer* batch_pop_()
+	{
+		StaticTimer* t = batch_head_;
+		if (t != nullptr) {
+			batch_head_ = t->batch_next_;
+			if (batch_head_ == nullptr) {
+				batch_tail_ = nullptr;
+			}
+			t->batch_next_ = nullptr;
+		}
+		return t;
+	}
+
+	static void batch_unlink_(StaticTimer* t)
+	{
+		if (t->op_ == StaticTimer::Op::NONE) {
+			return;
+		}
+		StaticTimer* prev = nullptr;
+		for (StaticTimer* p = batch_head_; p != nullptr; prev = p, p = p->batch_next_) {
+			if (p == t) {
+				if (prev == nullptr) {
+					batch_head_ = t->batch_next_;
+				} else {
+					prev->batch_next_ = t->batch_next_;
+				}
+				if (batch_tail_ == t) {
+					batch_tail_ = prev;
+				}
+				break;
+			}
+		}
+		t->batch_next_ = nullptr;
+		t->op_ = StaticTimer::Op::NONE;
+	}
+
+	// Queue one batch call; the caller has set flush_pending_
+	static bool pend_flush_(bool isr)
+	{
+		{
+			MaskLock lock;
+			pends_++;
+			note_depth_();
+		}
+
+		BaseType_t ok;
+		if (isr) {
+			BaseType_t woken = pdFALSE;
+			ok = xTimerPendFunctionCallFromISR(StaticTimer::flush_, nullptr, 0, &woken);
+			portYIELD_FROM_ISR(woken);
+		} else {
+			ok = xTimerPendFunctionCall(StaticTimer::flush_, nullptr, 0, 0);
+		}
+
+		if (ok != pdPASS) {
+			MaskLock lock;
+			pends_--;
+			flush_pending_ = false;
+			stats_.overflows++;
+			return false;
+		}
+		return true;
+	}
+
+#if STM32ZERO_TIMER_PRECISE
+	using LowTim = TIM<STM32ZERO_USTIM_LOW>;
+
+	static constexpr uint32_t LOW_MASK = static_cast<uint32_t>((1ULL << LowTim::bits) - 1);
+
+	static_assert(STM32ZERO_TIMER_HANDOFF_US + 2 * US_PER_TICK < LOW_MASK / 2,
+		      "STM32ZERO_TIMER_HANDOFF_US exceeds the ustim LOW timer range");
+
+	static void init_()
+	{
+		if (precise_init_) {
+			return;
+		}
+		TIM_TypeDef* tim = LowTim::ptr();
+
+		// Channel 1 as frozen output compare: flag only, no pin
+		tim->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
+		tim->DIER &= ~TIM_DIER_CC1IE;
+
+		HAL_NVIC_SetPriority(irqn_(), STM32ZERO_TIMER_IRQ_PRIORITY, 0);
+		HAL_NVIC_EnableIRQ(irqn_());
+
+		precise_init_ = true;
+	}
+
+	static IRQn_Type irqn_();
+
+	// Compare on the head deadline (mask held)
+	static void program_(uint64_t deadline)
+	{
+		TIM_TypeDef* tim = LowTim::ptr();
+
+		tim->CCR1 = static_cast<uint32_t>(deadline) & LOW_MASK;
+		tim->SR = ~TIM_SR_CC1IF;
+		tim->DIER |= TIM_DIER_CC1IE;
+
+		// Counter may already be past the compare value
+		if (ustim::get() + 2 > deadline) {
+			tim->EGR = TIM_EGR_CC1G;
+		}
+	}
+
+	// Compare on the earlier of the timer and waiter heads, or off (mask held)
+	static void reprogram_()
+	{
+		if (armed_head_ == nullptr && waiters_ == nullptr) {
+			LowTim::ptr()->DIER &= ~TIM_DIER_CC1IE;
+			return;
+		}
+		uint64_t deadline = armed_head_ != nullptr ? armed_head_->deadline_ : UINT64_MAX;
+		if (waiters_ != nullptr && waiters_->wake < deadline) {
+			deadline = waiters_->wake;
+		}
+		program_(deadline);
+	}
+
+	// Sorted insert into the compare list (mask held)
+	static void arm_(StaticTimer* t)
+	{
+		if (t->armed_) {
+			return;
+		}
+		StaticTimer** link = &armed_head_;
+		while (*link != nullptr && (*link)->deadline_ <= t->deadline_) {
+			link = &(*link)->armed_next_;
+		}
+		t->armed_next_ = *link;
+		*link = t;
+		t->armed_ = true;
+
+		if (armed_head_ == t) {
+			reprogram_();
+		}
+	}
+
+	// (mask held)
+	static void disarm_(StaticTimer* t)
+	{
+		if (!t->armed_) {
+			return;
+		}
+		bool was_head = armed_head_ == t;
+		for (StaticTimer** link = &armed_head_; *link != nullptr; link = &(*link)->armed_next_) {
+			if (*link == t) {
+				*link = t->armed_next_;
+				break;
+			}
+		}
+		t->armed_next_ = nullptr;
+		t->armed_ = false;
+
+		if (was_head) {
+			reprogram_();
+		}
+	}
+
+	// Sorted insert into the waiter list (mask held)
+	static void wait_(Waiter* w)
+	{
+		Waiter** link = &waiters_;
+		while (*link != nullptr && (*link)->wake <= w->wake) {
+			link = &(*link)->next;
+		}
+		w->next = *link;
+		*link = w;
+		if (waiters_ == w) {
+			reprogram_();
+		}
+	}
+
+	// Timed-out waiter (mask held)
+	static void unwait_(Waiter* w)
+	{
+		bool was_head = waiters_ == w;
+		for (Waiter** link = &waiters_; *link != nullptr; link = &(*link)->next) {
+			if (*link == w) {
+				*link = w->next;
+				break;
+			}
+		}
+		if (was_head) {
+			reprogram_();
+		}
+	}
+
+	// Notify the waiters that are due (compare interrupt)
+	static void wake_waiters_()
+	{
+		BaseType_t woken = pdFALSE;
+		{
+			MaskLock lock;
+			uint64_t now = ustim::get();
+			while (waiters_ != nullptr && waiters_->wake <= now) {
+				Waiter* w = waiters_;
+				waiters_ = w->next;
+				w->done = true;
+				xTaskNotifyFromISR(w->task, WAKE_BIT, eSetBits, &woken);
+			}
+		}
+		portYIELD_FROM_ISR(woken);
+	}
+
+	// Arm now if within the handoff, else let the daemon sleep the rest
+	static bool schedule_(StaticTimer* t)
+	{
+		{
+			MaskLock lock;
+			if (!t->running_) {
+				return true;
+			}
+			if (t->deadline_ <= ustim::get() + STM32ZERO_TIMER_HANDOFF_US) {
+				arm_(t);
+				return true;
+			}
+		}
+		return t->request_(StaticTimer::Op::START, 0);
+	}
+
+	// Daemon side of a precise START
+	static bool coarse_(StaticTimer* t)
+	{
+		uint64_t remaining;
+		{
+			MaskLock lock;
+			if (!t->running_) {
+				return true;
+			}
+			uint64_t now = ustim::get();
+			remaining = t->deadline_ > now ? t->deadline_ - now : 0;
+			if (remaining <= STM32ZERO_TIMER_HANDOFF_US) {
+				arm_(t);
+				return true;
+			}
+		}
+
+		// Expires within (n - 1, n] ticks: at least one tick before the deadline
+		TickType_t n = static_cast<TickType_t>((remaining - US_PER_TICK) / US_PER_TICK);
+		return xTimerGenericCommand(t->handle_, tmrCOMMAND_CHANGE_PERIOD, n, nullptr, 0) != pdFAIL;
+	}
+
+	static void on_compare_()
+	{
+		LowTim::ptr()->SR = ~TIM_SR_CC1IF;
+		wake_waiters_();
+
+		while (true) {
+			StaticTimer* t;
+			bool again;
+			{
+				MaskLock lock;
+				uint64_t now = ustim::get();
+
+				t = armed_head_;
+				if (t == nullptr || t->deadline_ > now) {
+					reprogram_();
+					return;
+				}
+
+				armed_head_ = t->armed_next_;
+				t->armed_next_ = nullptr;
+				t->armed_ = false;
+
+				stats_.precise_fired++;
+				stats_.precise_late.add(static_cast<uint32_t>(now - t->deadline_));
+
+				again = t->auto_reload_;
+				if (again) {
+					// Skip periods that already passed, keep the phase
+					do {
+						t->deadline_ += t->period_;
+					} while (t->deadline_ <= now);
+				} else {
+					t->running_ = false;
+				}
+			}
+
+			t->fire_();
+
+			if (again) {
+				schedule_(t);
+			}
+		}
+	}
+#endif // STM32ZERO_TIMER_PRECISE
+};
+
+#if STM32ZERO_TIMER_PRECISE
+
+#define STM32ZERO_TIMER_PASTE_(a, b, c)   a##b##c
+#define STM32ZERO_TIMER_XPASTE_(a, b, c)  STM32ZERO_TIMER_PASTE_(a, b, c)
+
+// The LOW timer needs its own vector (TIM2..TIM5)
+#define STM32ZERO_TIMER_IRQn        STM32ZERO_TIMER_XPASTE_(TIM, STM32ZERO_USTIM_LOW, _IRQn)
+#define STM32ZERO_TIMER_IRQHandler  STM32ZERO_TIMER_XPASTE_(TIM, STM32ZERO_USTIM_LOW, _IRQHandler)
+
+IRQn_Type TimerAccess::irqn_()
+{
+	return STM32ZERO_TIMER_IRQn;
+}
+
+extern "C" void STM32ZERO_TIMER_IRQHandler(void)
+{
+	trace::IsrScope trace_isr;
+	TimerAccess::on_compare_();
+}
+
+#endif // STM32ZERO_TIMER_PRECISE
+
+//=============================================================================
+// StaticTimer
+//=============================================================================
+
+StaticTimer::~StaticTimer()
+{
+	if (handle_ == nullptr) {
+		return;
+	}
+	{
+		MaskLock lock;
+		running_ = false;
+#if STM32ZERO_TIMER_PRECISE
+		TimerAccess::disarm_(this);
+#endif
+		TimerAccess::batch_unlink_(this);
+	}
+
+	// A batch call already applying this timer queues its command first
+	sync_daemon_();
+	xTimerDelete(handle_, portMAX_DELAY);
+	sync_daemon_();
+	handle_ = nullptr;
+}
+
+bool StaticTimer::create_(const char* name, uint32_t period, bool auto_reload, bool precise)
+{
+	if (handle_ != nullptr || period == 0) {
+		return false;
+	}
+#if !STM32ZERO_TIMER_PRECISE
+	if (precise) {
+		return false;
+	}
+#endif
+
+	period_ = period;
+	auto_reload_ = auto_reload;
+	precise_ = precise;
+
+	// Precise: the daemon timer is only the one-shot coarse stage
+	handle_ = xTimerCreateStatic(name, precise ? 1 : static_cast<TickType_t>(period),
+				     (auto_reload && !precise) ? pdTRUE : pdFALSE,
+				     this, daemon_callback_, &timer_);
+
+#if STM32ZERO_TIMER_PRECISE
+	if (handle_ != nullptr && precise) {
+		TimerAccess::init_();
+	}
+#endif
+	return handle_ != nullptr;
+}
+
+bool StaticTimer::is_active() const
+{
+	if (handle_ == nullptr) {
+		return false;
+	}
+	if (precise_) {
+		return running_;
+	}
+	Op op = op_;
+	if (op != Op::NONE) {
+		return op != Op::STOP;
+	}
+	return xTimerIsTimerActive(handle_) != pdFALSE;
+}
+
+bool StaticTimer::start()
+{
+#if STM32ZERO_TIMER_PRECISE
+	if (precise_ && handle_ != nullptr) {
+		{
+			MaskLock lock;
+			TimerAccess::disarm_(this);
+			deadline_ = ustim::get() + period_;
+			running_ = true;
+		}
+		return TimerAccess::schedule_(this);
+	}
+#endif
+	return request_(Op::START, 0);
+}
+
+bool StaticTimer::stop()
+{
+#if STM32ZERO_TIMER_PRECISE
+	if (precise_ && handle_ != nullptr) {
+		MaskLock lock;
+		running_ = false;
+		TimerAccess::disarm_(this);
+	}
+#endif
+	return request_(Op::STOP, 0);
+}
+
+bool StaticTimer::change_period(uint32_t period)
+{
+	if (period == 0) {
+		return false;
+	}
+	period_ = period;
+	if (precise_) {
+		return start();
+	}
+	return request_(Op::PERIOD, period);
+}
+
+bool StaticTimer::start_now(TickType_t timeout)
+{
+	if (handle_ == nullptr || precise_) {
+		return false;
+	}
+	return xTimerStart(handle_, timeout) != pdFAIL;
+}
+
+bool StaticTimer::stop_now(TickType_t timeout)
+{
+	if (handle_ == nullptr || precise_) {
+		return false;
+	}
+	return xTimerStop(handle_, timeout) != pdFAIL;
+}
+
+bool StaticTimer::request_(Op op, uint32_t arg)
+{
+	if (handle_ == nullptr) {
+		return false;
+	}
+
+	bool isr = is_in_isr();
+	TickType_t tick = isr ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+	uint32_t now = now32_();
+	bool pend;
+	{
+		MaskLock lock;
+		stats_.requests++;
+
+		if (op_ == Op::NONE) {
+			TimerAccess::batch_push_(this);
+			request_us_ = now;
+		} else {
+			stats_.coalesced++;
+		}
+
+		// A pending period change already restarts the timer
+		if (!(op == Op::START && op_ == Op::PERIOD)) {
+			op_ = op;
+			arg_ = arg;
+		}
+		tick_ = tick;
+
+		pend = !flush_pending_;
+		flush_pending_ = true;
+	}
+	return pend ? TimerAccess::pend_flush_(isr) : true;
+}
+
+bool StaticTimer::apply_(Op op, uint32_t arg, TickType_t tick)
+{
+#if STM32ZERO_TIMER_PRECISE
+	if (precise_ && op == Op::START) {
+		return TimerAccess::coarse_(this);
+	}
+#endif
+
+	BaseType_t ok = pdFAIL;
+	switch (op) {
+	case Op::START:
+		// Period counts from the request, not from the batch call
+		ok = xTimerGenericCommand(handle_, tmrCOMMAND_START, tick, nullptr, 0);
+		break;
+	case Op::STOP:
+		ok = xTimerGenericCommand(handle_, tmrCOMMAND_STOP, 0, nullptr, 0);
+		break;
+	case Op::PERIOD:
+		ok = xTimerGenericCommand(handle_, tmrCOMMAND_CHANGE_PERIOD, arg, nullptr, 0);
+		break;
+	case Op::NONE:
+		ok = pdPASS;
+		break;
+	}
+	return ok != pdFAIL;
+}
+
+void StaticTimer::fire_()
+{
+	fired_ = fired_ + 1;
+	invoke_(storage_);
+}
+
+void StaticTimer::daemon_callback_(TimerHandle_t handle)
+{
+	StaticTimer* self = static_cast<StaticTimer*>(pvTimerGetTimerID(handle));
+
+#if STM32ZERO_TIMER_PRECISE
+	if (self->precise_) {
+		// Coarse stage done: the rest is under STM32ZERO_TIMER_HANDOFF_US
+		MaskLock lock;
+		if (self->running_) {
+			TimerAccess::arm_(self);
+		}
+		return;
+	}
+#endif
+
+	self->fire_();
+}
+
+void StaticTimer::flush_(void*, uint32_t)
+{
+	{
+		MaskLock lock;
+		pends_--;
+		stats_.batches++;
+		stalled_ = false;
+	}
+
+	while (true) {
+		StaticTimer* t;
+		Op op;
+		uint32_t arg;
+		TickType_t tick;
+		uint32_t request_us;
+		{
+			MaskLock lock;
+			if (batch_head_ == nullptr) {
+				flush_pending_ = false;
+				return;
+			}
+
+			// Leave room for this command and the follow-up batch call
+			if (in_queue_ + pends_ + 2 > QUEUE_LEN) {
+				stats_.deferred++;
+				break;
+			}
+
+			t = TimerAccess::batch_pop_();
+			op = t->op_;
+			arg = t->arg_;
+			tick = t->tick_;
+			request_us = t->request_us_;
+			t->op_ = Op::NONE;
+		}
+
+		uint32_t now = now32_();
+		if (!t->apply_(op, arg, tick)) {
+			// Another sender took the space: retry behind the queued commands
+			MaskLock lock;
+			if (t->op_ == Op::NONE) {
+				t->op_ = op;
+				t->arg_ = arg;
+				t->tick_ = tick;
+				TimerAccess::batch_push_front_(t);
+			}
+			stats_.deferred++;
+			break;
+		}
+
+		MaskLock lock;
+		stats_.batch_latency.add(now - request_us);
+	}
+
+	if (!TimerAccess::pend_flush_(false)) {
+		// Other senders filled the queue: the daemon frees a slot with
+		// each timer command it receives, and resumes from there
+		MaskLock lock;
+		stalled_ = batch_head_ != nullptr && !flush_pending_;
+	}
+}
+
+// Daemon context, after receiving a timer command (one slot free)
+static void resume_()
+{
+	{
+		MaskLock lock;
+		if (!stalled_ || flush_pending_) {
+			stalled_ = false;
+			return;
+		}
+		stalled_ = false;
+		flush_pending_ = true;
+	}
+	if (!TimerAccess::pend_flush_(false)) {
+		MaskLock lock;
+		stalled_ = batch_head_ != nullptr && !flush_pending_;
+	}
+}
+
+//=============================================================================
+// Statistics
+//=============================================================================
+
+namespace timer {
+
+TimerStats stats()
+{
+	MaskLock lock;
+	return stats_;
+}
+
+void reset_stats()
+{
+	MaskLock lock;
+	stats_ = {};
+}
+
+uint32_t depth()
+{
+	MaskLock lock;
+	return in_queue_ + pends_;
+}
+
+void sleep_until(uint64_t deadline_us)
+{
+	// Ticks while the rest exceeds the handoff: vTaskDelay(n) returns
+	// within (n - 1, n] ticks, so at least one tick stays for the compare
+	while (true) {
+		uint64_t now = ustim::get();
+		if (now >= deadline_us) {
+			return;
+		}
+		uint64_t remaining = deadline_us - now;
+#if STM32ZERO_TIMER_PRECISE
+		if (remaining <= STM32ZERO_TIMER_HANDOFF_US) {
+			break;
+		}
+		vTaskDelay(static_cast<TickType_t>((remaining - US_PER_TICK) / US_PER_TICK));
+#else
+		vTaskDelay(static_cast<TickType_t>((remaining + US_PER_TICK - 1) / US_PER_TICK));
+#endif
+	}
+
+#if STM32ZERO_TIMER_PRECISE
+	Waiter w = {};
+	w.wake = deadline_us - STM32ZERO_TIMER_SPIN_US;
+	w.task = xTaskGetCurrentTaskHandle();
+	if (w.wake > ustim::get()) {
+		{
+			MaskLock lock;
+			TimerAccess::init_();
+			stats_.sleeps++;
+			TimerAccess::wait_(&w);
+		}
+
+		// Bounded: a lost compare costs the handoff, not the task
+		const TickType_t limit = static_cast<TickType_t>(STM32ZERO_TIMER_HANDOFF_US / US_PER_TICK + 2);
+		TickType_t start = xTaskGetTickCount();
+		while (!w.done && xTaskGetTickCount() - start < limit) {
+			notify::wait_bits(WAKE_BIT, false, true, limit - (xTaskGetTickCount() - start));
+		}
+		if (!w.done) {
+			MaskLock lock;
+			TimerAccess::unwait_(&w);
+		}
+		// The interrupt may have set the bit after the last wait: drop it,
+		// and only it, so no stray wake-up reaches the next sleep
+		notify::clear_bits(WAKE_BIT);
+	}
+
+	while (ustim::get() < deadline_us) {
+	}
+#endif
+}
+
+} // namespace timer
+
+} // namespace freertos
+} // namespace stm32zero
+
+extern "C" void stm32zero_timer_cmd_sent(long result)
+{
+	stm32zero::freertos::cmd_sent_(result);
+}
+
+extern "C" void stm32zero_timer_cmd_received(void)
+{
+	stm32zero::freertos::cmd_received_();
+}
@@ -0,0 +1,419 @@
+/**
+ * STM32ZERO Trace Recorder
+ *
+ * A writer takes its timestamp, claims the next index with LDREX/STREX
+ * (an interrupt between the two makes STREX fail and the claim retry),
+ * then fills the slot and commits it by writing info last. The stream
+ * reader frees a slot by zeroing info, so a claimed but uncommitted slot
+ * (writer preempted) stops the drain until the writer resumes.
+ */
+
+#include "stm32zero-trace.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-stats.hpp"
+#include "stm32zero-masklock.hpp"
+
+#if defined(STM32ZERO_USTIM_LOW)
+#include "stm32zero-tim.hpp"
+#endif
+
+namespace stm32zero {
+namespace trace {
+
+//=============================================================================
+// Internal State
+//=============================================================================
+
+namespace {
+
+constexpr uint32_t MASK = SIZE - 1;
+constexpr size_t RECORDS_PER_LINE = 4;
+
+STM32ZERO_TRACE_SECTION Record ring_[SIZE];
+
+volatile uint32_t head_ = 0;            // next index to claim
+volatile uint32_t tail_ = 0;            // stream: next index to send
+volatile uint32_t stop_at_ = 0;         // snapshot: freeze when claimed
+volatile bool triggered_ = false;
+volatile Mode mode_ = Mode::OFF;
+volatile uint32_t dropped_ = 0;
+volatile uint32_t streamed_ = 0;
+uint32_t queue_ids_ = 0;
+
+STM32ZERO_DTCM freertos::StaticTask<STM32ZERO_TRACE_STREAM_STACK> stream_task_;
+volatile bool stream_stop_ = false;
+volatile bool streaming_ = false;
+
+TaskStatus_t tasks_[STM32ZERO_TRACE_MAX_TASKS];
+char line_[2 + RECORDS_PER_LINE * 16 + 2];
+char fmt_buf_[48];
+
+#if defined(STM32ZERO_USTIM_LOW)
+using LowTim = TIM<STM32ZERO_USTIM_LOW>;
+#if defined(STM32ZERO_USTIM_MID)
+using NextTim = TIM<STM32ZERO_USTIM_MID>;
+#else
+using NextTim = TIM<STM32ZERO_USTIM_HIGH>;
+#endif
+#endif
+
+// Low 32 bits of ustim with the fewest timer reads
+inline uint32_t now_()
+{
+#if defined(STM32ZERO_USTIM_LOW)
+	if (LowTim::bits >= 32) {
+		return LowTim::ptr()->CNT;
+	}
+	uint32_t hi = NextTim::ptr()->CNT;
+	uint32_t lo = LowTim::ptr()->CNT;
+	uint32_t hi2 = NextTim::ptr()->CNT;
+	if (hi2 != hi) {
+		lo = LowTim::ptr()->CNT;    // LOW wrapped between the reads
+	}
+	return (hi2 << 16) | (lo & 0xFFFF);
+#else
+	return static_cast<uint32_t>(ustim::get());
+#endif
+}
+
+void reset_(Mode mode)
+{
+	MaskLock lock;
+	mode_ = Mode::OFF;
+	for (auto& r : ring_) {
+		r.ts = 0;
+		r.info = 0;
+	}
+	head_ = 0;
+	tail_ = 0;
+	stop_at_ = 0;
+	triggered_ = false;
+	dropped_ = 0;
+	streamed_ = 0;
+	mode_ = mode;
+}
+
+//=============================================================================
+// Output
+//=============================================================================
+
+char* hex8_(char* p, uint32_t v)
+{
+	static const char digits[] = "0123456789abcdef";
+	for (int shift = 28; shift >= 0; shift -= 4) {
+		*p++ = digits[(v >> shift) & 0xF];
+	}
+	return p;
+}
+
+void write_header_()
+{
+	sio::writef(fmt_buf_, "#trace stm32zero 1 us %u\r\n", static_cast<unsigned>(SIZE));
+}
+
+void write_tasks_()
+{
+	UBaseType_t n = uxTaskGetSystemState(tasks_, STM32ZERO_TRACE_MAX_TASKS, nullptr);
+	for (UBaseType_t i = 0; i < n; i++) {
+		sio::writef(fmt_buf_, "#task %lu %s\r\n",
+			    static_cast<unsigned long>(tasks_[i].xTaskNumber), tasks_[i].pcTaskName);
+	}
+}
+
+void write_footer_()
+{
+	sio::writef(fmt_buf_, "#dropped %lu\r\n#end\r\n", static_cast<unsigned long>(dropped_));
+}
+
+// One "=" line from up to RECORDS_PER_LINE records
+void write_line_(const Record* records, size_t n)
+{
+	char* p = line_;
+	*p++ = '=';
+	for (size_t i = 0; i < n; i++) {
+		p = hex8_(p, records[i].ts);
+		p = hex8_(p, records[i].info);
+	}
+	*p++ = '\r';
+	*p++ = '\n';
+	sio::write(line_, static_cast<size_t>(p - line_));
+}
+
+// Send committed records from tail_; stops at an uncommitted slot
+void drain_()
+{
+	Record batch[RECORDS_PER_LINE];
+
+	while (true) {
+		uint32_t tail = tail_;
+		size_t n = 0;
+		while (n < RECORDS_PER_LINE && tail != head_) {
+			volatile Record& r = ring_[tail & MASK];
+			uint32_t info = r.info;
+			if ((info & 0xFF) == 0) {
+				break;
+			}
+			batch[n].ts = r.ts;
+			batch[n].info = info;
+			r.info = 0;
+			tail++;
+			n++;
+		}
+		if (n == 0) {
+			return;
+		}
+		tail_ = tail;
+		streamed_ = streamed_ + n;
+		write_line_(batch, n);
+	}
+}
+
+void stream_func_(void*)
+{
+	write_header_();
+	UBaseType_t known = 0;
+
+	while (!stream_stop_) {
+		UBaseType_t n = uxTaskGetNumberOfTasks();
+		if (n != known) {
+			write_tasks_();
+			known = n;
+		}
+		drain_();
+		vTaskDelay(pdMS_TO_TICKS(STM32ZERO_TRACE_STREAM_MS));
+	}
+
+	mode_ = Mode::OFF;
+	drain_();
+	write_footer_();
+	streaming_ = false;
+	vTaskDelete(nullptr);
+}
+
+} // namespace
+
+//=============================================================================
+// Control
+//=============================================================================
+
+void start()
+{
+	if (streaming_) {
+		return;
+	}
+	reset_(Mode::SNAPSHOT);
+}
+
+void stop()
+{
+	if (streaming_) {
+		stream_stop();
+		return;
+	}
+	mode_ = Mode::OFF;
+}
+
+Mode mode()
+{
+	return mode_;
+}
+
+bool is_frozen()
+{
+	return mode_ == Mode::FROZEN;
+}
+
+void trigger(uint32_t post)
+{
+	if (mode_ != Mode::SNAPSHOT || triggered_) {
+		return;
+	}
+	stm32zero_trace_record(info(Event::TRIGGER, 0, 0));
+
+	MaskLock lock;
+	if (post == 0) {
+		mode_ = Mode::FROZEN;
+		return;
+	}
+	stop_at_ = head_ + post;
+	triggered_ = true;
+}
+
+size_t copy(Record* out, size_t max)
+{
+	if (mode_ == Mode::STREAM) {
+		return 0;
+	}
+	uint32_t head = head_;
+	uint32_t n = head < SIZE ? head : static_cast<uint32_t>(SIZE);
+	if (n > max) {
+		n = static_cast<uint32_t>(max);     // newest max records
+	}
+
+	size_t count = 0;
+	for (uint32_t i = head - n; i != head; i++) {
+		const Record& r = ring_[i & MASK];
+		if (r.event() != Event::NONE) {
+			out[count++] = r;
+		}
+	}
+	return count;
+}
+
+size_t dump()
+{
+	if (mode_ == Mode::STREAM) {
+		return 0;
+	}
+	if (mode_ == Mode::SNAPSHOT) {
+		mode_ = Mode::FROZEN;
+	}
+
+	write_header_();
+	write_tasks_();
+
+	uint32_t head = head_;
+	uint32_t n = head < SIZE ? head : static_cast<uint32_t>(SIZE);
+	Record batch[RECORDS_PER_LINE];
+	size_t count = 0;
+	size_t k = 0;
+
+	for (uint32_t i = head - n; i != head; i++) {
+		const Record& r = ring_[i & MASK];
+		if (r.event() == Event::NONE) {
+			continue;
+		}
+		batch[k++] = r;
+		count++;
+		if (k == RECORDS_PER_LINE) {
+			write_line_(batch, k);
+			k = 0;
+		}
+	}
+	if (k != 0) {
+		write_line_(batch, k);
+	}
+
+	write_footer_();
+	return count;
+}
+
+bool stream_start(freertos::Priority priority)
+{
+	if (streaming_) {
+		return false;
+	}
+	reset_(Mode::STREAM);
+	stream_stop_ = false;
+	streaming_ = true;
+
+	if (stream_task_.create(stream_func_, "TRACE", priority) == nullptr) {
+		streaming_ = false;
+		mode_ = Mode::OFF;
+		return false;
+	}
+	return true;
+}
+
+void stream_stop()
+{
+	if (!streaming_) {
+		return;
+	}
+	stream_stop_ = true;
+	while (streaming_) {
+		vTaskDelay(1);
+	}
+	vTaskDelay(2);          // let IDLE reclaim the stream task before a restart
+}
+
+Stats stats()
+{
+	Stats st;
+	st.recorded = head_;
+	st.dropped = dropped_;
+	st.streamed = streamed_;
+	return st;
+}
+
+uint32_t timestamp()
+{
+	return now_();
+}
+
+} // namespace trace
+} // namespace stm32zero
+
+//=============================================================================
+// Hooks (FreeRTOSConfig.h, interrupt handlers)
+//=============================================================================
+
+using namespace stm32zero::trace;
+
+namespace {
+
+void record_at_(Mode mode, uint32_t info, uint32_t ts)
+{
+	uint32_t idx;
+	do {
+		idx = __LDREXW(&head_);
+		if (mode == Mode::STREAM && idx - tail_ >= SIZE) {
+			__CLREX();
+			dropped_ = dropped_ + 1;
+			return;
+		}
+	} while (__STREXW(idx + 1, &head_) != 0);
+
+	volatile Record& r = ring_[idx & MASK];
+	r.info = 0;
+	r.ts = ts;
+	r.info = info;          // commit
+
+	if (triggered_ && idx + 1 == stop_at_) {
+		mode_ = Mode::FROZEN;
+	}
+}
+
+inline bool recording_(Mode mode)
+{
+	return mode != Mode::OFF && mode != Mode::FROZEN;
+}
+
+} // namespace
+
+extern "C" void stm32zero_trace_record(uint32_t info)
+{
+	Mode mode = mode_;
+	if (recording_(mode)) {
+		record_at_(mode, info, now_());
+	}
+}
+
+extern "C" uint32_t stm32zero_trace_queue_id(void)
+{
+	stm32zero::MaskLock lock;
+	return ++queue_ids_;
+}
+
+// One timestamp for the record and the ISR time accounting
+// (stats::isr_us), which runs whether or not the recorder does
+extern "C" void stm32zero_trace_isr_enter(void)
+{
+	uint32_t ts = now_();
+	stm32zero::freertos::stats::isr_enter_at(ts);
+	Mode mode = mode_;
+	if (recording_(mode)) {
+		record_at_(mode, info(Event::ISR_ENTER, 0, static_cast<uint16_t>(__get_IPSR())), ts);
+	}
+}
+
+extern "C" void stm32zero_trace_isr_exit(void)
+{
+	uint32_t ts = now_();
+	Mode mode = mode_;
+	if (recording_(mode)) {
+		record_at_(mode, info(Event::ISR_EXIT, 0, static_cast<uint16_t>(__get_IPSR())), ts);
+	}
+	stm32zero::freertos::stats::isr_exit_at(ts);
+}
@@ -0,0 +1,452 @@
+/**
+ * STM32ZERO CAN Bus Monitor Runtime Tests
+ *
+ * Tests for stm32zero-canmon.hpp on FDCAN1 in internal loopback (every
+ * received frame is the node's own, so only the transmitted copy counts):
+ *   - Setup: attach / watch order, duplicate and out-of-range IDs
+ *   - Frame time against the stuff-free frame length at 2M/2M
+ *   - Per-ID rates and bus load over 100 ms windows from a fixed-rate
+ *     sender (1000, 500 and 250 frames/s), unwatched IDs
+ *   - RX FIFO high-water mark with frames held back by a lease route
+ *   - Stand-in HAL only: protocol errors by code and phase, TEC trend,
+ *     error storm masking, warning / passive / bus-off entries
+ *   - Console commands over sio
+ *
+ * Output:
+ *   [CANMON] A 1000/s B 500/s EXT 250/s  load 112 permille (stuff-free 110)
+ *   CANMON load 11.2% (max 11.3%) rx 0/s tx 1750/s
+ *   CANMON tec 0 (max 24, -3) rec 0 (max 0, +0) active
+ *   CANMON errors 9 storms 1 fifo0 max 0 fifo1 max 3
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-canbus.hpp"
+#include "stm32zero-canmon.hpp"
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#if __has_include("fdcan.h")
+#include "fdcan.h"
+#else
+extern FDCAN_HandleTypeDef hfdcan1;
+#endif
+
+using namespace stm32zero;
+using namespace stm32zero::fdcan;
+using namespace stm32zero::freertos;
+using namespace stm32zero::canmon;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Configuration
+//=============================================================================
+
+#define RATE_A_ID       0x120           // every tick
+#define RATE_B_ID       0x121           // every 2nd tick
+#define RATE_EXT_ID     0x18DA10F1      // every 4th tick
+#define OTHER_ID        0x130           // not watched
+#define LEASE_ID        0x200           // FIFO1, held back
+
+#define RATE_WINDOW_MS  100
+#define RATE_TICKS      600             // sender run (1 ms ticks)
+#define RATE_TOL_PCT    15
+#define OTHER_FRAMES    5
+#define LEASE_SLOTS     2
+#define LEASE_HELD      3               // fits the 3-element FIFOs of the H5
+
+#define STORM_BUDGET    3
+#define STORM_ERRORS    8
+#define STORM_WINDOW_MS 4000
+
+#define FRAME_BYTES     8
+
+// FDCAN1: 80 MHz kernel clock, prescaler 2, 20 tq -> 2 Mbit/s nominal and data
+#define NOMINAL_BIT_NS  500
+#define DATA_BIT_NS     500
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+static const uint8_t FD_BRS = CanFrame::FLAG_FD | CanFrame::FLAG_BRS;
+
+STM32ZERO_DTCM static CanBus bus_;
+STM32ZERO_DTCM static CanMonitor<3> mon_;
+STM32ZERO_DTCM static RxLeaseRoute<LEASE_SLOTS> lease_;
+static char fmt_buf_[128];
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static bool send_(uint32_t id, uint8_t flags, uint8_t tag)
+{
+	uint8_t data[FRAME_BYTES];
+	for (uint32_t i = 0; i < FRAME_BYTES; i++) {
+		data[i] = static_cast<uint8_t>(tag + i);
+	}
+	return bus_.send(id, data, FRAME_BYTES, flags);
+}
+
+// Frames without dynamic stuff bits
+static uint32_t classic_ns_(uint32_t len)
+{
+	return (47 + len * 8) * NOMINAL_BIT_NS;
+}
+
+static uint32_t fd_ns_(uint32_t len, bool ext)
+{
+	uint32_t nominal = (ext ? 36 : 17) + 13;        // SOF..BRS, CRC delimiter..IFS
+	uint32_t crc = len <= 16 ? 17 : 21;
+	uint32_t data = 1 + 4 + len * 8 + 4 + crc + (crc + 3) / 4;
+	return nominal * NOMINAL_BIT_NS + data * DATA_BIT_NS;
+}
+
+// Monitor estimate: the plain frame plus at most the stuff estimate
+static bool near_ns_(uint32_t estimate, uint32_t plain)
+{
+	return estimate >= plain && estimate <= plain + plain * STM32ZERO_CANMON_STUFF_PERMILLE / 1000U;
+}
+
+static bool within_(uint32_t actual, uint32_t expected)
+{
+	uint32_t tol = expected * RATE_TOL_PCT / 100U;
+	return actual + tol >= expected && actual <= expected + tol;
+}
+
+static uint32_t errors_(const MonitorStats& s)
+{
+	uint32_t n = s.errors_other;
+	for (uint32_t e : s.errors) {
+		n += e;
+	}
+	return n;
+}
+
+static uint32_t error_(const MonitorStats& s, ErrorKind kind)
+{
+	return s.errors[static_cast<size_t>(kind)];
+}
+
+//=============================================================================
+// Setup
+//=============================================================================
+
+static void test_canmon_setup(void)
+{
+	TEST_ASSERT(!mon_.attach(bus_), "attach() needs an initialized bus");
+	TEST_ASSERT(!mon_.watch(RATE_A_ID), "watch() needs attach()");
+	TEST_ASSERT(!mon_.start("CANMON"), "start() needs attach()");
+
+	TEST_ASSERT(lease_.create("lease", RxTarget::FIFO1), "Lease route create()");
+	TEST_ASSERT(bus_.init(&hfdcan1, FDCAN_MODE_INTERNAL_LOOPBACK), "FDCAN1 internal loopback");
+	int l = bus_.add_route(lease_);
+	TEST_ASSERT(l >= 0, "Lease route added");
+	bus_.add_filter(RxFilter::std_range(LEASE_ID, LEASE_ID + 0xF, l));
+
+	TEST_ASSERT(mon_.attach(bus_), "attach()");
+	TEST_ASSERT(mon_.watch(RATE_EXT_ID, true), "watch() extended ID");
+	TEST_ASSERT(!mon_.watch(RATE_EXT_ID, true), "watch() refuses a duplicate");
+	TEST_ASSERT(!mon_.watch(0x800), "watch() refuses a 12-bit standard ID");
+	TEST_ASSERT(mon_.watch(RATE_B_ID), "watch() standard ID");
+	TEST_ASSERT(mon_.watch(RATE_A_ID), "watch() standard ID, out of order");
+	TEST_ASSERT(!mon_.watch(OTHER_ID), "watch() refuses a full table");
+	TEST_ASSERT_EQ(mon_.id_count(), 3, "Three IDs watched");
+	TEST_ASSERT(mon_.id_rate(0).id == RATE_A_ID && mon_.id_rate(1).id == RATE_B_ID &&
+		    mon_.id_rate(2).id == RATE_EXT_ID && mon_.id_rate(2).ext, "Table sorted, extended IDs last");
+	TEST_ASSERT_EQ(mon_.id_rate(3).id, 0, "id_rate() of an invalid index is zero");
+
+	TEST_ASSERT(bus_.start(), "Bus started");
+	TEST_ASSERT(!mon_.attach(bus_), "attach() refuses a started bus");
+	TEST_ASSERT(!mon_.watch(OTHER_ID), "watch() refuses a started bus");
+}
+
+//=============================================================================
+// Frame Time
+//=============================================================================
+
+static void test_canmon_frame_time(void)
+{
+	TEST_ASSERT(near_ns_(mon_.frame_ns(0, 0), classic_ns_(0)), "Classic 0B frame time");
+	TEST_ASSERT(near_ns_(mon_.frame_ns(8, 0), classic_ns_(8)), "Classic 8B frame time");
+	TEST_ASSERT(near_ns_(mon_.frame_ns(8, FD_BRS), fd_ns_(8, false)), "FD 8B frame time");
+	TEST_ASSERT(near_ns_(mon_.frame_ns(64, FD_BRS), fd_ns_(64, false)), "FD 64B frame time (21-bit CRC)");
+	TEST_ASSERT(near_ns_(mon_.frame_ns(8, FD_BRS | CanFrame::FLAG_EXT), fd_ns_(8, true)),
+		    "FD 8B extended frame time");
+	TEST_ASSERT(mon_.frame_ns(8, CanFrame::FLAG_EXT) > mon_.frame_ns(8, 0), "Extended ID adds arbitration bits");
+}
+
+//=============================================================================
+// Rates and Load
+//=============================================================================
+
+static void test_canmon_rates(void)
+{
+	TEST_ASSERT(mon_.start("CANMON", Priority::LOW, RATE_WINDOW_MS), "start()");
+	TEST_ASSERT(mon_.is_running(), "Monitor task running");
+	TEST_ASSERT(!mon_.start("CANMON"), "start() refuses a running monitor");
+
+	TickType_t wake = xTaskGetTickCount();
+	for (uint32_t t = 0; t < RATE_TICKS; t++) {
+		send_(RATE_A_ID, FD_BRS, static_cast<uint8_t>(t));
+		if (t % 2 == 0) {
+			send_(RATE_B_ID, FD_BRS, static_cast<uint8_t>(t));
+		}
+		if (t % 4 == 0) {
+			send_(RATE_EXT_ID, FD_BRS | CanFrame::FLAG_EXT, static_cast<uint8_t>(t));
+		}
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(1));
+	}
+
+	// The last closed window lies inside the sender run
+	MonitorStats s = mon_.stats();
+	IdRate a = mon_.id_rate(0);
+	IdRate b = mon_.id_rate(1);
+	IdRate e = mon_.id_rate(2);
+	TEST_ASSERT(s.windows >= RATE_TICKS / RATE_WINDOW_MS - 1, "Windows closed by the task");
+	TEST_ASSERT(within_(a.per_s, 1000), "RATE_A_ID: 1000 frames/s");
+	TEST_ASSERT(within_(b.per_s, 500), "RATE_B_ID: 500 frames/s");
+	TEST_ASSERT(within_(e.per_s, 250), "RATE_EXT_ID: 250 frames/s");
+	TEST_ASSERT(a.max_per_s >= a.per_s && e.max_per_s >= e.per_s, "Maximum rate kept");
+	uint32_t sum = a.per_s + b.per_s + e.per_s;
+	TEST_ASSERT(s.tx_per_s + 3 >= sum && s.tx_per_s <= sum + 3, "TX rate is the sum of the ID rates");
+	TEST_ASSERT_EQ(s.rx_per_s, 0, "Loopback: received copies not counted");
+
+	// Load of the same window from the stuff-free frame times
+	uint64_t busy = uint64_t(a.per_s) * fd_ns_(FRAME_BYTES, false) + uint64_t(b.per_s) * fd_ns_(FRAME_BYTES, false) +
+			uint64_t(e.per_s) * fd_ns_(FRAME_BYTES, true);
+	uint32_t plain = static_cast<uint32_t>(busy / 1000000U);
+	sio::writef(fmt_buf_, "[CANMON] A %lu/s B %lu/s EXT %lu/s  load %u permille (stuff-free %lu)\r\n",
+		    a.per_s, b.per_s, e.per_s, static_cast<unsigned>(s.load_permille), plain);
+	uint32_t load = s.load_permille;
+	TEST_ASSERT(load + 3 >= plain && load <= plain + plain * STM32ZERO_CANMON_STUFF_PERMILLE / 1000U + 3,
+		    "Bus load matches the frame times");
+	TEST_ASSERT(s.load_max_permille >= s.load_permille, "Maximum load kept");
+
+	mon_.stop();
+	TEST_ASSERT(!mon_.is_running(), "stop()");
+
+	vTaskDelay(pdMS_TO_TICKS(5));
+	TEST_ASSERT_EQ(mon_.id_rate(0).frames, RATE_TICKS, "RATE_A_ID: every frame counted");
+	TEST_ASSERT_EQ(mon_.id_rate(1).frames, RATE_TICKS / 2, "RATE_B_ID: every frame counted");
+	TEST_ASSERT_EQ(mon_.id_rate(2).frames, RATE_TICKS / 4, "RATE_EXT_ID: every frame counted");
+
+	for (uint32_t i = 0; i < OTHER_FRAMES; i++) {
+		send_(OTHER_ID, 0, static_cast<uint8_t>(i));
+	}
+	vTaskDelay(pdMS_TO_TICKS(5));
+	s = mon_.stats();
+	TEST_ASSERT_EQ(s.unwatched, OTHER_FRAMES, "Unwatched IDs counted apart");
+	TEST_ASSERT_EQ(s.tx_frames, RATE_TICKS + RATE_TICKS / 2 + RATE_TICKS / 4 + OTHER_FRAMES, "TX frames");
+	TEST_ASSERT_EQ(s.rx_frames, 0, "RX frames (loopback)");
+}
+
+//=============================================================================
+// RX FIFO High-Water Mark
+//=============================================================================
+
+static void test_canmon_fifo(void)
+{
+	bus_.reset_stats();
+
+	// Two frames take the lease slots, the next ones wait in RX FIFO1
+	for (uint32_t i = 0; i < LEASE_SLOTS + LEASE_HELD; i++) {
+		send_(LEASE_ID + i, FD_BRS, static_cast<uint8_t>(i));
+		vTaskDelay(pdMS_TO_TICKS(2));
+	}
+	TEST_ASSERT_EQ(bus_.fifo_level(RxTarget::FIFO1), LEASE_HELD, "Frames held in RX FIFO1");
+
+	mon_.sample();
+	MonitorStats s = mon_.stats();
+	TEST_ASSERT(s.rx_fifo_max[1] >= LEASE_HELD, "FIFO1 high-water mark");
+	TEST_ASSERT_EQ(s.rx_fifo_max[0], 0, "FIFO0 unused");
+
+	CanFrame f;
+	uint32_t n = 0;
+	while (lease_.receive(f, 0)) {
+		n++;
+	}
+	TEST_ASSERT_EQ(n, LEASE_SLOTS + LEASE_HELD, "Held frames delivered");
+	TEST_ASSERT(mon_.stats().rx_fifo_max[1] >= LEASE_HELD, "High-water mark kept after draining");
+}
+
+//=============================================================================
+// Protocol Errors and Error States (stand-in HAL)
+//=============================================================================
+
+#if defined(STM32ZERO_HOST)
+static void test_canmon_errors(void)
+{
+	mon_.sample();
+	MonitorStats before = mon_.stats();
+
+	// One error frame each, then the retransmission succeeds
+	host_fdcan_inject_tx_errors(&hfdcan1, 1, FDCAN_PROTOCOL_ERROR_CRC);
+	send_(RATE_A_ID, FD_BRS, 0);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	host_fdcan_inject_tx_errors(&hfdcan1, 1, FDCAN_PROTOCOL_ERROR_STUFF);
+	send_(RATE_A_ID, 0, 0);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	host_fdcan_inject_tx_errors(&hfdcan1, 1, FDCAN_PROTOCOL_ERROR_FORM);
+	send_(RATE_A_ID, FD_BRS, 0);
+	vTaskDelay(pdMS_TO_TICKS(5));
+
+	MonitorStats s = mon_.stats();
+	TEST_ASSERT_EQ(error_(s, ErrorKind::CRC_ERROR) - error_(before, ErrorKind::CRC_ERROR), 1, "CRC error counted");
+	TEST_ASSERT_EQ(error_(s, ErrorKind::STUFF) - error_(before, ErrorKind::STUFF), 1, "Stuff error counted");
+	TEST_ASSERT_EQ(error_(s, ErrorKind::FORM) - error_(before, ErrorKind::FORM), 1, "Form error counted");
+	TEST_ASSERT_EQ(s.errors_other, before.errors_other, "Every error code read");
+	TEST_ASSERT_EQ(s.data_errors - before.data_errors, 1, "CRC error of a BRS frame in the data phase");
+	TEST_ASSERT_EQ(s.tx_frames - before.tx_frames, 3, "Retransmitted frames counted once");
+
+	// TEC: +8 per error, -1 per good frame
+	FDCAN_ErrorCountersTypeDef ec = {};
+	HAL_FDCAN_GetErrorCounters(&hfdcan1, &ec);
+	mon_.sample();
+	s = mon_.stats();
+	TEST_ASSERT_EQ(s.tec, ec.TxErrorCnt, "TEC as read from the controller");
+	TEST_ASSERT(s.tec >= 10 && s.tec_max >= s.tec, "TEC raised by the errors");
+	TEST_ASSERT(s.tec_delta > 0, "TEC rises over the error window");
+
+	for (uint32_t i = 0; i < 10; i++) {
+		send_(RATE_A_ID, FD_BRS, static_cast<uint8_t>(i));
+	}
+	vTaskDelay(pdMS_TO_TICKS(5));
+	mon_.sample();
+	s = mon_.stats();
+	TEST_ASSERT_EQ(s.tec_delta, -10, "TEC falls with good frames");
+}
+
+static void test_canmon_storm(void)
+{
+	TEST_ASSERT(mon_.start("CANMON", Priority::LOW, STORM_WINDOW_MS, STORM_BUDGET), "start() with an error budget");
+
+	for (uint32_t i = 0; i < STORM_ERRORS; i++) {
+		host_fdcan_inject_tx_errors(&hfdcan1, 1, FDCAN_PROTOCOL_ERROR_STUFF);
+		send_(RATE_A_ID, 0, static_cast<uint8_t>(i));
+		vTaskDelay(pdMS_TO_TICKS(2));
+	}
+	MonitorStats s = mon_.stats();
+	TEST_ASSERT_EQ(errors_(s), STORM_BUDGET, "Error interrupts stop at the budget");
+	TEST_ASSERT_EQ(s.storms, 1, "Window counted as a storm");
+	TEST_ASSERT_EQ(s.tx_frames, STORM_ERRORS, "Frames still delivered");
+
+	mon_.stop();
+	TEST_ASSERT(!mon_.is_running(), "stop() wakes the task within its window");
+
+	// The next window unmasks (the pending flag of the masked errors
+	// raises one more interrupt)
+	mon_.sample();
+	host_fdcan_inject_tx_errors(&hfdcan1, 1, FDCAN_PROTOCOL_ERROR_STUFF);
+	send_(RATE_A_ID, 0, 0);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	s = mon_.stats();
+	TEST_ASSERT(errors_(s) > STORM_BUDGET, "Error interrupts counted again after sample()");
+	TEST_ASSERT_EQ(s.storms, 1, "One storm");
+}
+
+static void test_canmon_states(void)
+{
+	mon_.reset_stats();
+
+	host_fdcan_inject_error(&hfdcan1, 130, 0, false);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	MonitorStats s = mon_.stats();
+	TEST_ASSERT(s.warnings == 1 && s.passives == 1, "TEC 130: warning and passive entered");
+	TEST_ASSERT(s.warning && s.passive && !s.bus_off, "State: passive");
+
+	host_fdcan_inject_error(&hfdcan1, 0, 0, false);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	s = mon_.stats();
+	TEST_ASSERT(!s.warning && !s.passive, "State: active again");
+	TEST_ASSERT(s.warnings == 1 && s.passives == 1, "Leaving a state is not an entry");
+
+	host_fdcan_inject_error(&hfdcan1, 255, 0, true);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	s = mon_.stats();
+	TEST_ASSERT_EQ(s.bus_offs, 1, "Bus-off entered");
+	TEST_ASSERT(s.bus_off, "State: bus-off");
+
+	// Recovery starts when the driver leaves init mode
+	hfdcan1.Instance->CCCR &= ~FDCAN_CCCR_INIT;
+	vTaskDelay(pdMS_TO_TICKS(5));
+	s = mon_.stats();
+	TEST_ASSERT(!s.bus_off, "Bus-off recovered");
+	TEST_ASSERT_EQ(s.bus_offs, 1, "One bus-off");
+}
+#endif // STM32ZERO_HOST
+
+//=============================================================================
+// Console
+//=============================================================================
+
+static void test_canmon_console(void)
+{
+	TEST_ASSERT(mon_.command("canmon"), "\"canmon\" writes the summary");
+	TEST_ASSERT(mon_.command("canmon ids\r\n"), "\"canmon ids\"");
+	TEST_ASSERT(mon_.command("  canmon errors"), "\"canmon errors\"");
+	TEST_ASSERT(mon_.command("canmon bogus"), "Unknown subcommand: usage");
+	TEST_ASSERT(!mon_.command("canmonitor"), "Other commands left alone");
+	TEST_ASSERT(!mon_.command("status"), "Other commands left alone");
+
+	TEST_ASSERT(mon_.command("canmon reset"), "\"canmon reset\"");
+	MonitorStats s = mon_.stats();
+	TEST_ASSERT(s.tx_frames == 0 && errors_(s) == 0 && mon_.id_rate(0).frames == 0, "Counters reset");
+
+	// Leave FDCAN1 as CubeMX configured it, free for other tests
+	bus_.stop();
+	bus_.init(&hfdcan1, FDCAN_MODE_NORMAL);
+	bus_.deinit();
+}
+
+//=============================================================================
+// Runtime Test Entry
+//=============================================================================
+
+extern "C" void test_canmon_runtime(void)
+{
+	test_canmon_setup();
+	test_canmon_frame_time();
+	test_canmon_rates();
+	test_canmon_fifo();
+#if defined(STM32ZERO_HOST)
+	test_canmon_errors();
+	test_canmon_storm();
+	test_canmon_states();
+#endif
+	test_canmon_console();
+}
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
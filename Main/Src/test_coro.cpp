@@ -0,0 +1,355 @@
+/**
+ * STM32ZERO Cooperative Flow Runtime Tests
+ *
+ * Tests for stm32zero-coro.hpp functionality:
+ *   - CO_SLEEP_US deadlines (executor blocks until the nearest deadline)
+ *   - receive() from a TypedQueue, woken by each send (no polling)
+ *   - Signal set from a task and from ISR context (simulated)
+ *   - sio_read() combined with a deadline (timeout path)
+ *   - Many concurrent flows on one executor task
+ *   - Pool-allocated frames: spawn() failure, slot and frame reuse
+ *   - RAM per flow vs one StaticTask per state machine
+ *
+ * Output:
+ *   [CORO] 8 flows, 40 resumes in 11 passes
+ *   [CORO] RAM per flow: 56 B (frame 40 + slot 16), per task: 608 B
+ *   [CORO] 8 flows: 448 B + executor task 1120 B, vs 4864 B as tasks
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-pool.hpp"
+#include "stm32zero-typedqueue.hpp"
+#include "stm32zero-coro.hpp"
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Flows
+//=============================================================================
+
+#define MAX_FLOWS	8
+#define SLEEP_US	2000
+#define SLEEP_COUNT	5
+
+static volatile uint32_t sleep_done_ = 0;
+static volatile uint32_t queue_sum_ = 0;
+static volatile bool queue_done_ = false;
+static volatile int signal_result_ = -1;       // 1 = signaled, 0 = timeout
+static volatile int sio_result_ = -1;
+static char fmt_buf_[128];
+
+// Sleeps count times, then finishes
+class SleepFlow : public coro::Flow {
+public:
+	SleepFlow(uint32_t period_us, uint32_t count) : period_us_(period_us), count_(count) {}
+
+	Status resume() override
+	{
+		CO_BEGIN();
+		for (i_ = 0; i_ < count_; i_++) {
+			CO_SLEEP_US(dl_, period_us_);
+		}
+		sleep_done_ = sleep_done_ + 1;
+		CO_END();
+	}
+
+private:
+	coro::Deadline dl_;
+	uint32_t period_us_;
+	uint32_t count_;
+	uint32_t i_ = 0;
+};
+
+// Sums queue items until a 0 arrives
+class QueueFlow : public coro::Flow {
+public:
+	explicit QueueFlow(TypedQueue<uint32_t, 4>& queue) : queue_(queue) {}
+
+	Status resume() override
+	{
+		CO_BEGIN();
+		while (true) {
+			CO_AWAIT(receive(queue_, value_));
+			if (value_ == 0) {
+				break;
+			}
+			queue_sum_ = queue_sum_ + value_;
+		}
+		queue_done_ = true;
+		CO_END();
+	}
+
+private:
+	TypedQueue<uint32_t, 4>& queue_;
+	uint32_t value_ = 0;
+};
+
+// Waits for a signal or a timeout
+class SignalFlow : public coro::Flow {
+public:
+	SignalFlow(coro::Signal& sig, uint32_t timeout_us) : sig_(sig), timeout_us_(timeout_us) {}
+
+	Status resume() override
+	{
+		CO_BEGIN();
+		timeout_.start(timeout_us_);
+		CO_AWAIT(signaled(sig_) || expired(timeout_));
+		signal_result_ = timeout_.is_expired() ? 0 : 1;
+		CO_END();
+	}
+
+private:
+	coro::Signal& sig_;
+	coro::Deadline timeout_;
+	uint32_t timeout_us_;
+};
+
+// Reads sio with a deadline (no input expected during the test)
+class SioFlow : public coro::Flow {
+public:
+	Status resume() override
+	{
+		CO_BEGIN();
+		timeout_.start(20000);
+		CO_AWAIT(sio_read(buf_, sizeof(buf_), n_) || expired(timeout_));
+		sio_result_ = (n_ > 0) ? n_ : 0;
+		CO_END();
+	}
+
+private:
+	coro::Deadline timeout_;
+	uint8_t buf_[8];
+	int n_ = 0;
+};
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+STM32ZERO_DTCM static coro::Executor<MAX_FLOWS, 256> exec_;
+STM32ZERO_DTCM static ObjectPool<SleepFlow, MAX_FLOWS> sleep_pool_;
+STM32ZERO_DTCM static ObjectPool<QueueFlow, 1> queue_pool_;
+STM32ZERO_DTCM static ObjectPool<SignalFlow, 1> signal_pool_;
+STM32ZERO_DTCM static ObjectPool<SioFlow, 1> sio_pool_;
+STM32ZERO_DTCM static TypedQueue<uint32_t, 4> queue_;
+static coro::Signal signal_;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static bool wait_for_(volatile const bool& flag, uint32_t timeout_ms)
+{
+	TickType_t start = get_tick_count();
+	while (!flag) {
+		if (get_tick_count() - start > pdMS_TO_TICKS(timeout_ms)) {
+			return false;
+		}
+		vTaskDelay(1);
+	}
+	return true;
+}
+
+static bool wait_idle_(uint32_t timeout_ms)
+{
+	TickType_t start = get_tick_count();
+	while (exec_.active() != 0) {
+		if (get_tick_count() - start > pdMS_TO_TICKS(timeout_ms)) {
+			return false;
+		}
+		vTaskDelay(1);
+	}
+	return true;
+}
+
+//=============================================================================
+// Basic Tests
+//=============================================================================
+
+static void test_coro_start(void)
+{
+	sleep_pool_.create();
+	queue_pool_.create();
+	signal_pool_.create();
+	sio_pool_.create();
+	queue_.create();
+
+	TEST_ASSERT(exec_.start("CORO", Priority::HIGH), "Executor::start() creates task");
+	TEST_ASSERT_EQ(exec_.active(), 0, "Executor initially empty");
+}
+
+static void test_coro_sleep(void)
+{
+	sleep_done_ = 0;
+	uint64_t start = ustim::get();
+
+	TEST_ASSERT(exec_.spawn(sleep_pool_.make(SLEEP_US, SLEEP_COUNT)), "Executor::spawn() pooled flow");
+	TEST_ASSERT(wait_idle_(100), "Sleep flow finishes");
+
+	uint64_t elapsed = ustim::elapsed(start);
+	TEST_ASSERT_EQ(sleep_done_, 1, "Sleep flow ran to CO_END");
+	TEST_ASSERT(elapsed >= SLEEP_US * SLEEP_COUNT, "CO_SLEEP_US waits at least the deadline");
+	TEST_ASSERT_EQ(sleep_pool_.available(), MAX_FLOWS, "Finished flow returned to pool");
+}
+
+static void test_coro_queue(void)
+{
+	queue_sum_ = 0;
+	queue_done_ = false;
+
+	TEST_ASSERT(exec_.spawn(queue_pool_.make(queue_)), "Spawn queue flow");
+	vTaskDelay(2);
+	TEST_ASSERT(queue_.reader() == exec_.task(), "First receive() binds the queue to the executor");
+
+	// Empty queue: the executor blocks instead of polling
+	uint32_t passes = exec_.passes();
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(exec_.passes() - passes, 0, "No executor pass while the queue is empty");
+
+	queue_.send(40, 0);
+	queue_.send(2, 0);
+	queue_.send(0, 0);
+
+	TEST_ASSERT(wait_for_(queue_done_, 50), "Queue flow receives until 0");
+	TEST_ASSERT_EQ(queue_sum_, 42, "Queue flow sum");
+	wait_idle_(10);
+}
+
+static void test_coro_signal(void)
+{
+	// Task context
+	signal_result_ = -1;
+	exec_.spawn(signal_pool_.make(signal_, 100000));
+	vTaskDelay(2);
+	signal_.set();
+	wait_idle_(20);
+	TEST_ASSERT_EQ(signal_result_, 1, "Signal::set() wakes waiting flow");
+
+	// ISR context (simulated), set before the flow waits
+	signal_result_ = -1;
+	BaseType_t woken = pdFALSE;
+	signal_.set_from_isr(&woken);
+	uint64_t start = ustim::get();
+	exec_.spawn(signal_pool_.make(signal_, 100000));
+	wait_idle_(20);
+	TEST_ASSERT_EQ(signal_result_, 1, "Signal::set_from_isr() latched for later wait");
+	TEST_ASSERT(ustim::elapsed(start) < 10000, "Latched signal completes without timeout");
+
+	// Timeout
+	signal_result_ = -1;
+	exec_.spawn(signal_pool_.make(signal_, 5000));
+	wait_idle_(50);
+	TEST_ASSERT_EQ(signal_result_, 0, "Signal wait times out via deadline");
+}
+
+static void test_coro_sio_timeout(void)
+{
+	sio_result_ = -1;
+	uint64_t start = ustim::get();
+
+	exec_.spawn(sio_pool_.make());
+	TEST_ASSERT(wait_idle_(100), "sio_read() flow finishes");
+	uint64_t elapsed = ustim::elapsed(start);
+
+	TEST_ASSERT_EQ(sio_result_, 0, "sio_read() || expired(): timeout path");
+	TEST_ASSERT(elapsed >= 20000 && elapsed < 40000, "sio_read() timeout duration");
+}
+
+//=============================================================================
+// Concurrency / Pool Tests
+//=============================================================================
+
+static void test_coro_many(void)
+{
+	sleep_done_ = 0;
+	uint32_t passes = exec_.passes();
+	uint32_t resumes = exec_.resumes();
+
+	for (uint32_t i = 0; i < MAX_FLOWS; i++) {
+		exec_.spawn(sleep_pool_.make(1000 + i * 250, SLEEP_COUNT));
+	}
+	TEST_ASSERT_EQ(exec_.active(), MAX_FLOWS, "All slots in use");
+	TEST_ASSERT_EQ(exec_.min_free(), 0, "Executor::min_free() low-water mark");
+
+	TEST_ASSERT(!exec_.spawn(sleep_pool_.make(1000, 1)), "spawn() fails with empty pool handle");
+
+	TEST_ASSERT(wait_idle_(200), "Concurrent flows finish");
+	TEST_ASSERT_EQ(sleep_done_, MAX_FLOWS, "Every concurrent flow completed");
+	TEST_ASSERT_EQ(sleep_pool_.available(), MAX_FLOWS, "All frames returned to pool");
+
+	sio::writef(fmt_buf_, "[CORO] %u flows, %lu resumes in %lu passes\r\n",
+		    (unsigned)MAX_FLOWS, exec_.resumes() - resumes, exec_.passes() - passes);
+
+	// Slots and frames are reusable
+	sleep_done_ = 0;
+	TEST_ASSERT(exec_.spawn(sleep_pool_.make(1000, 1)), "Slot reused after flows finish");
+	wait_idle_(20);
+	TEST_ASSERT_EQ(sleep_done_, 1, "Reused slot runs flow");
+}
+
+static void test_coro_ram(void)
+{
+	// Frame (pool slot) + executor slot, vs a task with the smallest usable stack
+	size_t frame = sizeof(sleep_pool_) / MAX_FLOWS;
+	size_t per_flow = frame + coro::ExecutorBase::slot_size();
+	size_t per_task = sizeof(StaticTask<128>);
+
+	sio::writef(fmt_buf_, "[CORO] RAM per flow: %u B (frame %u + slot %u), per task: %u B\r\n",
+		    (unsigned)per_flow, (unsigned)frame, (unsigned)coro::ExecutorBase::slot_size(),
+		    (unsigned)per_task);
+	sio::writef(fmt_buf_, "[CORO] %u flows: %u B + executor task %u B, vs %u B as tasks\r\n",
+		    (unsigned)MAX_FLOWS, (unsigned)(MAX_FLOWS * per_flow),
+		    (unsigned)sizeof(StaticTask<256>), (unsigned)(MAX_FLOWS * per_task));
+
+	TEST_ASSERT(per_flow * 4 < per_task, "Flow uses far less RAM than a task");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_coro_runtime(void)
+{
+	test_coro_start();
+	test_coro_sleep();
+	test_coro_queue();
+	test_coro_signal();
+	test_coro_sio_timeout();
+	test_coro_many();
+	test_coro_ram();
+}
@@ -6,6 +6,10 @@
  *   - Echoes back on ID 0x180 (0x100 + 0x80)
  *   - Uses 64-byte DLC with BRS (500K nominal / 2M data)
  *   - Runs until any key is pressed
+ *   - Host build: FDCAN2 is the remote node on the in-process bus; it
+ *     sends PEER_ROUNDS requests, checks every echo and ends the loop
+ *     (or PEER_TIMEOUT_MS); its first PEER_ERRORS transmissions are
+ *     destroyed by injected CRC errors and retransmitted
  *
  * Requirements:
  *   - FDCAN1 configured in STM32CubeMX (80MHz clock)
@@ -27,6 +31,11 @@ extern FDCAN_HandleTypeDef hfdcan1;
 #include "stm32zero-fdcan.hpp"
 #include "stm32zero-freertos.hpp"
 
+#if defined(STM32ZERO_HOST)
+#include "stm32zero-ustim.hpp"
+#include <cstring>
+#endif
+
 using namespace stm32zero;
 using namespace stm32zero::fdcan;
 using namespace stm32zero::freertos;
@@ -39,6 +48,9 @@ using namespace stm32zero::freertos;
 #define FDCAN_TX_ID_OFFSET	0x80
 #define FDCAN_QUEUE_LEN		16
 #define FDCAN_TIMEOUT_MS	100
+#define PEER_ROUNDS		64
+#define PEER_TIMEOUT_MS		2000
+#define PEER_ERRORS		3
 
 //=============================================================================
 // FDCAN Instance
@@ -69,6 +81,89 @@ static void fdcan_error_callback(Fdcan* self, uint32_t error_code)
 	fdcan_last_error = error_code;
 }
 
+#if defined(STM32ZERO_HOST)
+//=============================================================================
+// Remote Node (host build)
+//=============================================================================
+
+// FDCAN2 sends one request at a time from its RX interrupt: the next one
+// goes out when the echo of the previous one is back and matches
+
+static volatile uint32_t peer_sent = 0;
+static volatile uint32_t peer_echoed = 0;
+static volatile uint32_t peer_bad = 0;
+static volatile bool peer_done = false;
+static uint8_t peer_data[64];
+
+static bool peer_send(void)
+{
+	FDCAN_TxHeaderTypeDef header = {};
+	header.Identifier = FDCAN_RX_ID;
+	header.IdType = FDCAN_STANDARD_ID;
+	header.TxFrameType = FDCAN_DATA_FRAME;
+	header.DataLength = FDCAN_DLC_BYTES_64;
+	header.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
+	header.BitRateSwitch = FDCAN_BRS_ON;
+	header.FDFormat = FDCAN_FD_CAN;
+	header.TxEventFifoControl = FDCAN_NO_TX_EVENTS;
+
+	for (uint32_t i = 0; i < sizeof(peer_data); i++) {
+		peer_data[i] = static_cast<uint8_t>(peer_sent + i);
+	}
+	if (HAL_FDCAN_AddMessageToTxFifoQ(&hfdcan2, &header, peer_data) != HAL_OK) {
+		return false;
+	}
+	peer_sent++;
+	return true;
+}
+
+static void peer_rx_callback(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	if ((its & FDCAN_IT_RX_FIFO0_NEW_MESSAGE) == 0) {
+		return;
+	}
+
+	FDCAN_RxHeaderTypeDef header;
+	uint8_t data[64];
+	while (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &header, data) == HAL_OK) {
+		if (header.DataLength != FDCAN_DLC_BYTES_64 || memcmp(data, peer_data, sizeof(peer_data)) != 0) {
+			peer_bad++;
+			peer_done = true;
+			continue;
+		}
+		peer_echoed++;
+		if (peer_echoed >= PEER_ROUNDS || !peer_send()) {
+			peer_done = true;
+		}
+	}
+}
+
+static bool peer_start(void)
+{
+	FDCAN_FilterTypeDef filter = {};
+	filter.IdType = FDCAN_STANDARD_ID;
+	filter.FilterIndex = 0;
+	filter.FilterType = FDCAN_FILTER_MASK;
+	filter.FilterConfig = FDCAN_FILTER_TO_RXFIFO0;
+	filter.FilterID1 = FDCAN_RX_ID + FDCAN_TX_ID_OFFSET;
+	filter.FilterID2 = 0x7FF;
+
+	peer_sent = 0;
+	peer_echoed = 0;
+	peer_bad = 0;
+	peer_done = false;
+	host_fdcan_inject_tx_errors(&hfdcan2, PEER_ERRORS, FDCAN_PROTOCOL_ERROR_CRC);
+
+	return HAL_FDCAN_ConfigFilter(&hfdcan2, &filter) == HAL_OK &&
+	       HAL_FDCAN_ConfigGlobalFilter(&hfdcan2, FDCAN_REJECT, FDCAN_REJECT,
+					    FDCAN_REJECT_REMOTE, FDCAN_REJECT_REMOTE) == HAL_OK &&
+	       HAL_FDCAN_RegisterRxFifo0Callback(&hfdcan2, peer_rx_callback) == HAL_OK &&
+	       HAL_FDCAN_ActivateNotification(&hfdcan2, FDCAN_IT_RX_FIFO0_NEW_MESSAGE, 0) == HAL_OK &&
+	       HAL_FDCAN_Start(&hfdcan2) == HAL_OK &&
+	       peer_send();
+}
+#endif // STM32ZERO_HOST
+
 //=============================================================================
 // Runtime Tests
 //=============================================================================
@@ -143,7 +238,18 @@ extern "C" void test_fdcan_runtime(void)
 	sio::writef(fmt_buf, "\r\n");
 	sio::writef(fmt_buf, "[FDCAN] Echo started (RX:0x%03lX -> TX:0x%03lX)\r\n",
 		    (uint32_t)FDCAN_RX_ID, (uint32_t)(FDCAN_RX_ID + FDCAN_TX_ID_OFFSET));
+#if defined(STM32ZERO_HOST)
+	sio::writef(fmt_buf, "[FDCAN] FDCAN2 sends %d requests, %d CRC errors injected...\r\n",
+		    PEER_ROUNDS, PEER_ERRORS);
+	uint64_t peer_start_us = ustim::get();
+	if (!peer_start()) {
+		test_report_fail("FDCAN2 remote node started");
+		can1.close();
+		return;
+	}
+#else
 	sio::writef(fmt_buf, "[FDCAN] Press any key to stop...\r\n");
+#endif
 	sio::writef(fmt_buf, "\r\n");
 
 	RxMessage rx_msg;
@@ -157,6 +263,11 @@ extern "C" void test_fdcan_runtime(void)
 			sio::read(&c, 1);
 			break;
 		}
+#if defined(STM32ZERO_HOST)
+		if (peer_done || ustim::get() - peer_start_us > PEER_TIMEOUT_MS * 1000ULL) {
+			break;
+		}
+#endif
 
 		// Try to receive CAN message
 		IoResult result = can1.read(&rx_msg, FDCAN_TIMEOUT_MS);
@@ -198,6 +309,24 @@ extern "C" void test_fdcan_runtime(void)
 	can1.close();
 
 	test_report_pass("FDCAN echo loop completed");
+
+#if defined(STM32ZERO_HOST)
+	uint32_t elapsed_us = static_cast<uint32_t>(ustim::get() - peer_start_us);
+	sio::writef(fmt_buf, "[FDCAN] FDCAN2: %lu sent, %lu echoed, %lu bad, %lu us per round trip\r\n",
+		    peer_sent, peer_echoed, peer_bad, elapsed_us / (peer_echoed ? peer_echoed : 1));
+
+	if (peer_echoed == PEER_ROUNDS && peer_bad == 0) {
+		test_report_pass("FDCAN echo of every FDCAN2 request");
+	} else {
+		test_report_fail("FDCAN echo of every FDCAN2 request");
+	}
+
+	// Leave FDCAN1/FDCAN2 as CubeMX configured them, free for other tests
+	HAL_FDCAN_DeInit(&hfdcan2);
+	MX_FDCAN2_Init();
+	HAL_FDCAN_DeInit(&hfdcan1);
+	MX_FDCAN1_Init();
+#endif
 }
 
 #endif // HAL_FDCAN_MODULE_ENABLED
@@ -0,0 +1,576 @@
+/**
+ * STM32ZERO ISO-TP Runtime Tests
+ *
+ * Tests for stm32zero-isotp.hpp over one CanBus on FDCAN1 in internal
+ * loopback: tester and ECU channels sit on the same controller and see
+ * each other's frames (on the host, the in-process FDCAN bus):
+ *   - STmin encoding
+ *   - Classic and FD framing: single frame, FD escape single frame,
+ *     12-bit and 32-bit first frames; data reassembled in place
+ *   - Flow control: block size and STmin as advertised by the receiver,
+ *     WAIT frames and wft_max
+ *   - Errors: receive buffer overflow (FC overflow), N_Bs timeout, wrong
+ *     sequence number, a new first frame restarting a reception
+ *   - Two channel pairs transferring at the same time (one on a lease
+ *     route)
+ *   - Throughput at 500 kbit/s nominal, 2 Mbit/s data: classic 8-byte vs.
+ *     FD 64-byte frames with BRS
+ *
+ * Output:
+ *   [ISOTP] 500K/2M classic  4095 B  134 ms   30 kB/s  bus 97%
+ *   [ISOTP] 500K/2M FD64     4095 B   23 ms  178 kB/s  bus 95%
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-canbus.hpp"
+#include "stm32zero-isotp.hpp"
+#include <cstring>
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+
+#if __has_include("fdcan.h")
+#include "fdcan.h"
+#else
+extern FDCAN_HandleTypeDef hfdcan1;
+#endif
+
+using namespace stm32zero;
+using namespace stm32zero::fdcan;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define TESTER_ID       0x7E0           // tester -> ECU
+#define ECU_ID          0x7E8           // ECU -> tester
+#define TESTER2_ID      0x7E1
+#define ECU2_ID         0x7E9
+#define NOBODY_ID       0x7E5           // no filter: rejected by the controller
+
+#define MSG_MAX         6000            // > 4095: 32-bit first frame
+#define MSG2_MAX        1024
+#define BENCH_BYTES     4095
+
+// FDCAN1 kernel clock 80 MHz, 20 tq per bit
+#define BENCH_NOMINAL_PRESC  8          // 500 kbit/s
+#define BENCH_DATA_PRESC     2          // 2 Mbit/s
+#define BENCH_NOMINAL_NS     2000
+#define BENCH_DATA_NS        500
+
+STM32ZERO_DTCM static CanBus bus_;
+STM32ZERO_DTCM static RxRoute<16> tester_rx_;
+STM32ZERO_DTCM static RxLeaseRoute<16> ecu_rx_;
+STM32ZERO_DTCM static RxRoute<16> tester2_rx_;
+STM32ZERO_DTCM static RxRoute<16> ecu2_rx_;
+
+STM32ZERO_DTCM static isotp::Channel tester_;
+STM32ZERO_DTCM static isotp::Channel ecu_;
+STM32ZERO_DTCM static isotp::Channel tester2_;
+STM32ZERO_DTCM static isotp::Channel ecu2_;
+
+STM32ZERO_DTCM static StaticTask<512> rx_task_;
+STM32ZERO_DTCM static StaticTask<512> rx2_task_;
+STM32ZERO_DTCM static StaticTask<512> tx_task_;
+
+STM32ZERO_DTCM static uint8_t tx_buf_[MSG_MAX];
+STM32ZERO_DTCM static uint8_t rx_buf_[MSG_MAX];
+STM32ZERO_DTCM static uint8_t tx2_buf_[MSG2_MAX];
+STM32ZERO_DTCM static uint8_t rx2_buf_[MSG2_MAX];
+
+static char fmt_buf_[128];
+
+// One send() or receive() run in a helper task
+struct Job {
+	isotp::Channel* ch;
+	uint8_t* buf;
+	uint32_t size;                      // send: length, receive: capacity
+	uint32_t len;                       // receive: message length
+	TickType_t timeout;
+	isotp::Result res;
+	volatile bool done;
+};
+
+STM32ZERO_DTCM static Job rx_job_;
+STM32ZERO_DTCM static Job rx2_job_;
+STM32ZERO_DTCM static Job tx_job_;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static bool wait_flag_(volatile bool& flag, uint32_t timeout_ms)
+{
+	TickType_t start = get_tick_count();
+	while (!flag) {
+		if (get_tick_count() - start > pdMS_TO_TICKS(timeout_ms)) {
+			return false;
+		}
+		vTaskDelay(1);
+	}
+	return true;
+}
+
+static void rx_func_(void* param)
+{
+	Job* job = static_cast<Job*>(param);
+	job->res = job->ch->receive(job->buf, job->size, job->len, job->timeout);
+	job->done = true;
+	vTaskDelete(nullptr);
+}
+
+static void tx_func_(void* param)
+{
+	Job* job = static_cast<Job*>(param);
+	job->res = job->ch->send(job->buf, job->size);
+	job->done = true;
+	vTaskDelete(nullptr);
+}
+
+static void start_rx_(StaticTask<512>& task, Job& job, isotp::Channel& ch, uint8_t* buf, uint32_t capacity)
+{
+	job.ch = &ch;
+	job.buf = buf;
+	job.size = capacity;
+	job.len = 0;
+	job.timeout = pdMS_TO_TICKS(500);
+	job.res = isotp::Result::INVALID;
+	job.done = false;
+	memset(buf, 0, capacity);
+	task.create(rx_func_, "ISOR", Priority::HIGH, &job);
+}
+
+static void start_tx_(Job& job, isotp::Channel& ch, uint8_t* buf, uint32_t len)
+{
+	job.ch = &ch;
+	job.buf = buf;
+	job.size = len;
+	job.res = isotp::Result::INVALID;
+	job.done = false;
+	tx_task_.create(tx_func_, "ISOT", Priority::ABOVE_NORMAL, &job);
+}
+
+// Blocks until the job task has finished and been reclaimed
+static bool join_(Job& job)
+{
+	bool ok = wait_flag_(job.done, 3000);
+	vTaskDelay(2);      // let IDLE reclaim the task before a restart
+	return ok;
+}
+
+static void fill_(uint8_t* buf, uint32_t len, uint8_t seed)
+{
+	for (uint32_t i = 0; i < len; i++) {
+		buf[i] = static_cast<uint8_t>(i * 7 + seed + (i >> 8));
+	}
+}
+
+static void flush_(RxRouteBase& route)
+{
+	CanFrame f;
+	while (route.receive(f, 0)) {
+	}
+}
+
+static void bus_setup_()
+{
+	bus_.stop();
+	bus_.init(&hfdcan1, FDCAN_MODE_INTERNAL_LOOPBACK);
+	int t = bus_.add_route(tester_rx_);
+	int e = bus_.add_route(ecu_rx_);
+	int t2 = bus_.add_route(tester2_rx_);
+	int e2 = bus_.add_route(ecu2_rx_);
+	bus_.add_filter(RxFilter::std_id(ECU_ID, t));
+	bus_.add_filter(RxFilter::std_id(TESTER_ID, e));
+	bus_.add_filter(RxFilter::std_id(ECU2_ID, t2));
+	bus_.add_filter(RxFilter::std_id(TESTER2_ID, e2));
+	bus_.start();
+}
+
+// tester -> ECU with the given configs; the ECU receives in a helper task
+static isotp::Result transfer_(const isotp::Config& tc, const isotp::Config& ec, uint32_t len,
+			       uint32_t capacity, uint8_t seed)
+{
+	tester_.init(bus_, tester_rx_, tc);
+	ecu_.init(bus_, ecu_rx_, ec);
+	fill_(tx_buf_, len, seed);
+	start_rx_(rx_task_, rx_job_, ecu_, rx_buf_, capacity);
+	isotp::Result res = tester_.send(tx_buf_, len);
+	join_(rx_job_);
+	return res;
+}
+
+static bool delivered_(uint32_t len)
+{
+	return rx_job_.res == isotp::Result::OK && rx_job_.len == len && memcmp(rx_buf_, tx_buf_, len) == 0;
+}
+
+// ECU -> tester frame with an arbitrary payload (protocol error injection)
+static bool raw_(uint32_t id, const uint8_t* data, uint8_t len)
+{
+	uint8_t frame[8];
+	memset(frame, 0xCC, sizeof(frame));
+	memcpy(frame, data, len);
+	return bus_.send(id, frame, 8);
+}
+
+//=============================================================================
+// Encoding
+//=============================================================================
+
+static void test_isotp_stmin(void)
+{
+	TEST_ASSERT_EQ(isotp::stmin_to_us(0), 0, "STmin 0x00 = 0 us");
+	TEST_ASSERT_EQ(isotp::stmin_to_us(0x7F), 127000, "STmin 0x7F = 127 ms");
+	TEST_ASSERT_EQ(isotp::stmin_to_us(0xF1), 100, "STmin 0xF1 = 100 us");
+	TEST_ASSERT_EQ(isotp::stmin_to_us(0xF9), 900, "STmin 0xF9 = 900 us");
+	TEST_ASSERT_EQ(isotp::stmin_to_us(0x80), 127000, "STmin reserved = 127 ms");
+	TEST_ASSERT_EQ(isotp::stmin_from_us(450), 0xF5, "stmin_from_us(450) rounds up to 500 us");
+	TEST_ASSERT_EQ(isotp::stmin_from_us(1500), 2, "stmin_from_us(1500) rounds up to 2 ms");
+	TEST_ASSERT_EQ(isotp::stmin_from_us(500000), 0x7F, "stmin_from_us() saturates");
+}
+
+//=============================================================================
+// Framing
+//=============================================================================
+
+static void test_isotp_setup(void)
+{
+	TEST_ASSERT(tester_rx_.create("tester", RxTarget::FIFO0), "Tester route create()");
+	TEST_ASSERT(ecu_rx_.create("ecu", RxTarget::FIFO1), "ECU lease route create()");
+	TEST_ASSERT(tester2_rx_.create("tester2", RxTarget::FIFO0), "Tester2 route create()");
+	TEST_ASSERT(ecu2_rx_.create("ecu2", RxTarget::FIFO0), "ECU2 route create()");
+	bus_setup_();
+	TEST_ASSERT(bus_.is_started(), "Loopback bus started");
+
+	isotp::Config bad = isotp::Config::fd(TESTER_ID, ECU_ID, 10);
+	TEST_ASSERT(!tester_.init(bus_, tester_rx_, bad), "init() rejects TX_DL 10");
+	bad = isotp::Config::classic(0x800, ECU_ID);
+	TEST_ASSERT(!tester_.init(bus_, tester_rx_, bad), "init() rejects an 11-bit ID above 0x7FF");
+	TEST_ASSERT(tester_.init(bus_, tester_rx_, isotp::Config::classic(TESTER_ID, ECU_ID)), "init() classic");
+	TEST_ASSERT(tester_.send(tx_buf_, 0) == isotp::Result::INVALID, "send() of 0 bytes rejected");
+}
+
+static void test_isotp_classic(void)
+{
+	isotp::Config tc = isotp::Config::classic(TESTER_ID, ECU_ID);
+	isotp::Config ec = isotp::Config::classic(ECU_ID, TESTER_ID);
+	static const uint32_t lens[] = { 1, 7, 8, 100, 4095, 5000 };
+
+	uint32_t ok = 0;
+	for (uint32_t len : lens) {
+		if (transfer_(tc, ec, len, MSG_MAX, static_cast<uint8_t>(len)) == isotp::Result::OK && delivered_(len)) {
+			ok++;
+		} else {
+			sio::writef(fmt_buf_, "[ISOTP] classic %lu B: send/receive %s\r\n",
+				    len, isotp::result_name(rx_job_.res));
+		}
+	}
+	TEST_ASSERT_EQ(ok, 6, "Classic: 1..5000 bytes delivered intact");
+
+	// 100 bytes: FF (6) + 14 CF (7 each), one FC with BS 0
+	transfer_(tc, ec, 100, MSG_MAX, 1);
+	TEST_ASSERT_EQ(tester_.stats().tx_frames, 15, "Classic 100 B: FF + 14 CF");
+	TEST_ASSERT_EQ(ecu_.stats().fc_sent, 1, "Classic 100 B: one FC with BS 0");
+	TEST_ASSERT_EQ(ecu_rx_.slots_free(), 16, "Lease slots all returned");
+}
+
+static void test_isotp_fd(void)
+{
+	isotp::Config tc = isotp::Config::fd(TESTER_ID, ECU_ID);
+	isotp::Config ec = isotp::Config::fd(ECU_ID, TESTER_ID);
+	static const uint32_t lens[] = { 7, 8, 62, 63, 1000, 5000 };
+
+	uint32_t ok = 0;
+	for (uint32_t len : lens) {
+		if (transfer_(tc, ec, len, MSG_MAX, static_cast<uint8_t>(len)) == isotp::Result::OK && delivered_(len)) {
+			ok++;
+		} else {
+			sio::writef(fmt_buf_, "[ISOTP] FD %lu B: receive %s\r\n", len, isotp::result_name(rx_job_.res));
+		}
+	}
+	TEST_ASSERT_EQ(ok, 6, "FD64: 7..5000 bytes delivered intact");
+
+	transfer_(tc, ec, 62, MSG_MAX, 2);
+	TEST_ASSERT_EQ(tester_.stats().tx_frames, 1, "FD 62 B: one escape single frame");
+
+	// 1000 bytes: FF (62) + 15 CF (63 each)
+	transfer_(tc, ec, 1000, MSG_MAX, 3);
+	TEST_ASSERT_EQ(tester_.stats().tx_frames, 16, "FD 1000 B: FF + 15 CF");
+
+	// TX_DL 12 on the sender; RX_DL follows the first frame
+	tc.tx_dl = 12;
+	bool mixed = transfer_(tc, ec, 300, MSG_MAX, 4) == isotp::Result::OK && delivered_(300);
+	TEST_ASSERT(mixed, "FD TX_DL 12 -> receiver with TX_DL 64");
+}
+
+//=============================================================================
+// Flow Control
+//=============================================================================
+
+static void test_isotp_flow(void)
+{
+	isotp::Config tc = isotp::Config::classic(TESTER_ID, ECU_ID);
+	isotp::Config ec = isotp::Config::classic(ECU_ID, TESTER_ID);
+
+	// BS 4, STmin 500 us: 1000 B = FF + 142 CF in 36 blocks
+	ec.block_size = 4;
+	ec.st_min = isotp::stmin_from_us(500);
+	uint64_t start = ustim::get();
+	isotp::Result res = transfer_(tc, ec, 1000, MSG_MAX, 5);
+	uint32_t elapsed = static_cast<uint32_t>(ustim::elapsed(start));
+	TEST_ASSERT(res == isotp::Result::OK && delivered_(1000), "BS 4 / STmin 500 us: delivered");
+	TEST_ASSERT_EQ(ecu_.stats().fc_sent, 36, "BS 4: one FC per block");
+	TEST_ASSERT(elapsed >= (142 - 36) * 500U, "STmin kept between CFs of a block");
+	sio::writef(fmt_buf_, "[ISOTP] BS 4 / STmin 500 us: 1000 B in %lu us (>= %lu)\r\n",
+		    elapsed, (142 - 36) * 500U);
+
+	// STmin 2 ms, BS 0: 50 B = FF + 7 CF
+	ec.block_size = 0;
+	ec.st_min = 2;
+	start = ustim::get();
+	res = transfer_(tc, ec, 50, MSG_MAX, 6);
+	elapsed = static_cast<uint32_t>(ustim::elapsed(start));
+	TEST_ASSERT(res == isotp::Result::OK && delivered_(50), "STmin 2 ms: delivered");
+	TEST_ASSERT(elapsed >= 6 * 2000U, "STmin 2 ms between CFs");
+
+	// WAIT flow control: the sender holds until CTS (FCs injected by hand)
+	tester_.init(bus_, tester_rx_, tc);
+	fill_(tx_buf_, 20, 7);
+	start_tx_(tx_job_, tester_, tx_buf_, 20);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	static const uint8_t fc_wait[] = { 0x31, 0, 0 };
+	static const uint8_t fc_cts[] = { 0x30, 0, 0 };
+	for (int i = 0; i < 3; i++) {
+		raw_(ECU_ID, fc_wait, 3);
+		vTaskDelay(pdMS_TO_TICKS(2));
+	}
+	TEST_ASSERT(!tx_job_.done, "Sender holds on WAIT");
+	raw_(ECU_ID, fc_cts, 3);
+	join_(tx_job_);
+	TEST_ASSERT(tx_job_.res == isotp::Result::OK, "Sender resumes on CTS");
+	TEST_ASSERT_EQ(tester_.stats().fc_waits, 3, "WAIT frames counted");
+
+	tc.wft_max = 2;
+	tester_.init(bus_, tester_rx_, tc);
+	start_tx_(tx_job_, tester_, tx_buf_, 20);
+	vTaskDelay(pdMS_TO_TICKS(5));
+	for (int i = 0; i < 3; i++) {
+		raw_(ECU_ID, fc_wait, 3);
+		vTaskDelay(pdMS_TO_TICKS(2));
+	}
+	join_(tx_job_);
+	TEST_ASSERT(tx_job_.res == isotp::Result::WFT_OVERRUN, "wft_max exceeded");
+	flush_(ecu_rx_);
+}
+
+//=============================================================================
+// Errors
+//=============================================================================
+
+static void test_isotp_errors(void)
+{
+	isotp::Config tc = isotp::Config::classic(TESTER_ID, ECU_ID);
+	isotp::Config ec = isotp::Config::classic(ECU_ID, TESTER_ID);
+
+	// Receive buffer too small: FC overflow back to the sender
+	isotp::Result res = transfer_(tc, ec, 500, 100, 8);
+	TEST_ASSERT(res == isotp::Result::BUFFER_OVERFLOW, "Sender sees FC overflow");
+	TEST_ASSERT(rx_job_.res == isotp::Result::BUFFER_OVERFLOW && rx_job_.len == 500,
+		    "Receiver reports overflow with the message length");
+
+	// No receiver: N_Bs expires
+	isotp::Config lost = tc;
+	lost.tx_id = NOBODY_ID;
+	lost.n_bs_ms = 50;
+	tester_.init(bus_, tester_rx_, lost);
+	TEST_ASSERT(tester_.send(tx_buf_, 100) == isotp::Result::TIMEOUT_BS, "No FC: TIMEOUT_BS");
+	TEST_ASSERT(tester_.send(tx_buf_, 7) == isotp::Result::OK, "Single frame needs no FC");
+
+	uint32_t len;
+	ecu_.init(bus_, ecu_rx_, ec);
+	TEST_ASSERT(ecu_.receive(rx_buf_, MSG_MAX, len, pdMS_TO_TICKS(10)) == isotp::Result::TIMEOUT,
+		    "receive() times out on a quiet bus");
+
+	// Wrong sequence number (FF, then CF 2 instead of 1)
+	static const uint8_t ff[] = { 0x10, 20, 1, 2, 3, 4, 5, 6 };
+	static const uint8_t cf2[] = { 0x22, 7, 8, 9, 10, 11, 12, 13 };
+	start_rx_(rx_task_, rx_job_, ecu_, rx_buf_, MSG_MAX);
+	vTaskDelay(1);
+	raw_(TESTER_ID, ff, 8);
+	vTaskDelay(pdMS_TO_TICKS(2));
+	raw_(TESTER_ID, cf2, 8);
+	join_(rx_job_);
+	TEST_ASSERT(rx_job_.res == isotp::Result::WRONG_SN, "Out-of-sequence CF: WRONG_SN");
+
+	// A single frame during a reception replaces it
+	static const uint8_t sf[] = { 0x03, 0xA1, 0xA2, 0xA3 };
+	start_rx_(rx_task_, rx_job_, ecu_, rx_buf_, MSG_MAX);
+	vTaskDelay(1);
+	raw_(TESTER_ID, ff, 8);
+	vTaskDelay(pdMS_TO_TICKS(2));
+	raw_(TESTER_ID, sf, 4);
+	join_(rx_job_);
+	TEST_ASSERT(rx_job_.res == isotp::Result::OK && rx_job_.len == 3 && rx_buf_[0] == 0xA1,
+		    "New SF restarts the reception");
+
+	// Receiver FC frames went to the tester route
+	flush_(tester_rx_);
+	TEST_ASSERT(ecu_.stats().errors >= 1, "Receiver error counted");
+}
+
+//=============================================================================
+// Concurrent Channels
+//=============================================================================
+
+static void test_isotp_concurrent(void)
+{
+	// Pair 1: FD 3000 B onto the lease route; pair 2: classic 1000 B
+	tester_.init(bus_, tester_rx_, isotp::Config::fd(TESTER_ID, ECU_ID));
+	ecu_.init(bus_, ecu_rx_, isotp::Config::fd(ECU_ID, TESTER_ID));
+	isotp::Config ec2 = isotp::Config::classic(ECU2_ID, TESTER2_ID);
+	ec2.block_size = 8;
+	tester2_.init(bus_, tester2_rx_, isotp::Config::classic(TESTER2_ID, ECU2_ID));
+	ecu2_.init(bus_, ecu2_rx_, ec2);
+
+	fill_(tx_buf_, 3000, 9);
+	fill_(tx2_buf_, 1000, 10);
+	start_rx_(rx_task_, rx_job_, ecu_, rx_buf_, MSG_MAX);
+	start_rx_(rx2_task_, rx2_job_, ecu2_, rx2_buf_, MSG2_MAX);
+	start_tx_(tx_job_, tester2_, tx2_buf_, 1000);
+	isotp::Result res = tester_.send(tx_buf_, 3000);
+
+	join_(tx_job_);
+	join_(rx_job_);
+	join_(rx2_job_);
+	TEST_ASSERT(res == isotp::Result::OK && delivered_(3000), "Pair 1 (FD, lease route) delivered");
+	TEST_ASSERT(tx_job_.res == isotp::Result::OK && rx2_job_.res == isotp::Result::OK &&
+		    rx2_job_.len == 1000 && memcmp(rx2_buf_, tx2_buf_, 1000) == 0,
+		    "Pair 2 (classic, BS 8) delivered at the same time");
+	TEST_ASSERT_EQ(ecu2_.stats().fc_sent, 18, "Pair 2: FC per block of 8 (142 CF)");
+	TEST_ASSERT_EQ(ecu_rx_.dropped() + ecu2_rx_.dropped(), 0, "No route overflow");
+}
+
+//=============================================================================
+// Throughput Benchmark
+//=============================================================================
+
+// Standard ID frames without dynamic stuff bits
+static uint32_t classic_ns_(uint32_t len)
+{
+	return (47 + len * 8) * BENCH_NOMINAL_NS;
+}
+
+static uint32_t fd_ns_(uint32_t len)
+{
+	uint32_t nominal = 17 + 13;                     // SOF..BRS, CRC delimiter..IFS
+	uint32_t crc = len <= 16 ? 17 : 21;
+	uint32_t data = 1 + 4 + len * 8 + 4 + crc + (crc + 3) / 4;
+	return nominal * BENCH_NOMINAL_NS + data * BENCH_DATA_NS;
+}
+
+static void bench_(const char* name, const isotp::Config& tc, const isotp::Config& ec, uint32_t frame_ns,
+		   uint32_t& bytes_per_s)
+{
+	uint64_t start = ustim::get();
+	isotp::Result res = transfer_(tc, ec, BENCH_BYTES, MSG_MAX, 11);
+	uint32_t us = static_cast<uint32_t>(ustim::elapsed(start));
+	if (us == 0) {
+		us = 1;
+	}
+
+	// Frames on the bus: the sender's plus the receiver's flow controls
+	uint32_t frames = tester_.stats().tx_frames + ecu_.stats().fc_sent;
+	uint32_t bus_pct = static_cast<uint32_t>(uint64_t(frames) * frame_ns / 10U / us);
+	bytes_per_s = static_cast<uint32_t>(uint64_t(BENCH_BYTES) * 1000000U / us);
+
+	TEST_ASSERT(res == isotp::Result::OK && delivered_(BENCH_BYTES), name);
+	sio::writef(fmt_buf_, "[ISOTP] 500K/2M %-7s %lu B  %3lu ms  %3lu kB/s  bus %lu%%\r\n",
+		    name, BENCH_BYTES, us / 1000, bytes_per_s / 1000, bus_pct > 100 ? 100 : bus_pct);
+}
+
+static void test_isotp_bench(void)
+{
+	uint32_t nominal = hfdcan1.Init.NominalPrescaler;
+	uint32_t data = hfdcan1.Init.DataPrescaler;
+
+	bus_.stop();
+	hfdcan1.Init.NominalPrescaler = BENCH_NOMINAL_PRESC;
+	hfdcan1.Init.DataPrescaler = BENCH_DATA_PRESC;
+	HAL_FDCAN_Init(&hfdcan1);
+	bus_setup_();
+
+	uint32_t classic = 0;
+	uint32_t fd = 0;
+	bench_("classic", isotp::Config::classic(TESTER_ID, ECU_ID), isotp::Config::classic(ECU_ID, TESTER_ID),
+	       classic_ns_(8), classic);
+	bench_("FD64", isotp::Config::fd(TESTER_ID, ECU_ID), isotp::Config::fd(ECU_ID, TESTER_ID),
+	       fd_ns_(64), fd);
+#if !defined(STM32ZERO_HOST)
+	// The stand-in HAL completes frames on its tick, so flow control round
+	// trips, not the bit rate, set the host throughput
+	TEST_ASSERT(fd > classic * 4, "FD64/BRS moves > 4x the classic throughput");
+#else
+	(void)classic;
+	(void)fd;
+#endif
+
+	// Leave FDCAN1 as CubeMX configured it, free for other tests
+	bus_.deinit();
+	hfdcan1.Init.Mode = FDCAN_MODE_NORMAL;
+	hfdcan1.Init.NominalPrescaler = nominal;
+	hfdcan1.Init.DataPrescaler = data;
+	HAL_FDCAN_Init(&hfdcan1);
+}
+
+//=============================================================================
+// Runtime Test Entry
+//=============================================================================
+
+extern "C" void test_isotp_runtime(void)
+{
+	test_isotp_stmin();
+	test_isotp_setup();
+	test_isotp_classic();
+	test_isotp_fd();
+	test_isotp_flow();
+	test_isotp_errors();
+	test_isotp_concurrent();
+	test_isotp_bench();
+}
+
+#endif // HAL_FDCAN_MODULE_ENABLED && USE_HAL_FDCAN_REGISTER_CALLBACKS
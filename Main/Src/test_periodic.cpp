@@ -0,0 +1,336 @@
+/**
+ * STM32ZERO Periodic Task Runtime Tests
+ *
+ * Tests for stm32zero-periodic.hpp / stm32zero-histogram.hpp functionality:
+ *   - Histogram bins, min/max/avg and percentiles
+ *   - 1 kHz and 10 kHz loops under a busy lower-priority task:
+ *     cycle count, no deadline misses, release jitter histogram
+ *   - CPU left to a lower-priority task while a 1 kHz loop runs (the
+ *     wait between releases blocks, it does not spin)
+ *   - Overrun policies with a body that overruns every 10th cycle:
+ *     SKIP (phase kept), CATCH_UP (all releases run), NOTIFY (handler)
+ *
+ * Output:
+ *   [PERIODIC] 1 kHz  cycles 200, misses 0, 200210 us
+ *   [PERIODIC]   jitter n=200 min 2 avg 3 p99 7 max 7 us | 2:31 4:169
+ *   [PERIODIC]   exec   n=200 min 0 avg 0 p99 1 max 1 us | 0:180 1:20
+ *   [PERIODIC] 1 kHz  lower-priority task got 196 of 200 ms (98%)
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-histogram.hpp"
+#include "stm32zero-periodic.hpp"
+#include "stm32zero-timer.hpp"
+#include <cstdio>
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+extern void test_report_hist(const char* prefix, const char* name, int width, const Histogram& h);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define CYCLES_1K	200
+#define CYCLES_10K	1000
+#define OVERRUN_CYCLES	100
+#define OVERRUN_EVERY	10
+#define OVERRUN_US	1500
+#define MAX_JITTER_US	200
+#define BURN_GAP_US	20		// longer ustim gaps are preemptions
+#define BURN_MIN_PCT	80
+
+STM32ZERO_DTCM static PeriodicTask<1000, 256> p1k_;
+STM32ZERO_DTCM static PeriodicTask<100, 256> p10k_;
+STM32ZERO_DTCM static StaticTask<256> burner_task_;
+
+struct LoopCtx {
+	PeriodicBase* task;
+	volatile uint32_t count;
+	uint32_t limit;
+	bool overrun;
+};
+
+static LoopCtx ctx_;
+static volatile uint32_t overrun_calls_ = 0;
+static volatile uint32_t overrun_missed_ = 0;
+static volatile bool burn_stop_ = false;
+static volatile bool burn_done_ = false;
+static volatile uint32_t burn_us_ = 0;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static void loop_body_(void* p)
+{
+	LoopCtx* ctx = static_cast<LoopCtx*>(p);
+	uint32_t n = ctx->count + 1;
+	ctx->count = n;
+
+	if (ctx->overrun && n % OVERRUN_EVERY == 0) {
+		ustim::spin(OVERRUN_US);
+	}
+	if (n >= ctx->limit) {
+		ctx->task->stop();
+	}
+}
+
+static void on_overrun_(void*, uint32_t missed)
+{
+	overrun_calls_ = overrun_calls_ + 1;
+	overrun_missed_ = overrun_missed_ + missed;
+}
+
+// Busy lower-priority load until the loop stops; returns us since start
+static uint64_t load_until_stopped_(PeriodicBase& task, uint64_t start)
+{
+	while (task.is_running()) {
+		ustim::spin(200);
+	}
+	uint64_t elapsed = ustim::elapsed(start);
+
+	task.stop();        // deletes the parked task, ready for a restart
+	return elapsed;
+}
+
+// Lower-priority task: sums the ustim time it runs (gaps are preemptions)
+static void burner_func_(void*)
+{
+	uint64_t last = ustim::get();
+	uint64_t cpu = 0;
+	while (!burn_stop_) {
+		uint64_t now = ustim::get();
+		if (now - last < BURN_GAP_US) {
+			cpu += now - last;
+		}
+		last = now;
+		burn_us_ = static_cast<uint32_t>(cpu);
+	}
+	burn_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+static void start_loop_(PeriodicBase& task, uint32_t limit, bool overrun)
+{
+	ctx_.task = &task;
+	ctx_.count = 0;
+	ctx_.limit = limit;
+	ctx_.overrun = overrun;
+	task.reset_stats();
+}
+
+//=============================================================================
+// Histogram Tests
+//=============================================================================
+
+static void test_periodic_histogram(void)
+{
+	Histogram h;
+	TEST_ASSERT_EQ(h.percentile(500), 0, "Histogram empty percentile");
+
+	TEST_ASSERT_EQ(Histogram::bin_of(0), 0, "Histogram::bin_of(0)");
+	TEST_ASSERT_EQ(Histogram::bin_of(1), 1, "Histogram::bin_of(1)");
+	TEST_ASSERT_EQ(Histogram::bin_of(3), 2, "Histogram::bin_of(3)");
+	TEST_ASSERT_EQ(Histogram::bin_of(4), 3, "Histogram::bin_of(4)");
+	TEST_ASSERT_EQ(Histogram::bin_of(0xFFFFFFFF), Histogram::BINS - 1, "Histogram::bin_of() saturates");
+
+	for (uint32_t i = 0; i < 99; i++) {
+		h.add(5);
+	}
+	h.add(1000);
+	TEST_ASSERT_EQ(h.count(), 100, "Histogram::count()");
+	TEST_ASSERT(h.min() == 5 && h.max() == 1000, "Histogram::min() / max()");
+	TEST_ASSERT_EQ(h.avg(), (99 * 5 + 1000) / 100, "Histogram::avg()");
+	TEST_ASSERT_EQ(h.percentile(990), 7, "Histogram p99 = upper bound of bin [4, 8)");
+	TEST_ASSERT_EQ(h.percentile(1000), 1000, "Histogram p100 = max");
+
+	h.reset();
+	TEST_ASSERT_EQ(h.count(), 0, "Histogram::reset()");
+}
+
+//=============================================================================
+// Rate Tests (under load)
+//=============================================================================
+
+static void test_periodic_1khz(void)
+{
+	start_loop_(p1k_, CYCLES_1K, false);
+	uint64_t start = ustim::get();
+	TEST_ASSERT(p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_), "PeriodicTask<1000>::start()");
+	TEST_ASSERT(!p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_), "start() while running fails");
+
+	uint64_t elapsed = load_until_stopped_(p1k_, start);
+
+	PeriodicStats st = p1k_.stats();
+	printf("[PERIODIC] 1 kHz  cycles %lu, misses %lu, %lu us\r\n", st.cycles, st.misses, (uint32_t)elapsed);
+	test_report_hist("[PERIODIC]  ", "jitter", 6, st.jitter);
+	test_report_hist("[PERIODIC]  ", "exec", 6, st.exec);
+
+	TEST_ASSERT_EQ(st.cycles, CYCLES_1K, "1 kHz cycle count");
+	TEST_ASSERT_EQ(st.misses, 0, "1 kHz no deadline misses under load");
+	TEST_ASSERT(elapsed >= CYCLES_1K * 1000 && elapsed < CYCLES_1K * 1000 + 3000, "1 kHz no drift");
+	TEST_ASSERT(st.jitter.max() < MAX_JITTER_US, "1 kHz release jitter bounded");
+}
+
+static void test_periodic_share(void)
+{
+	// The runner blocks; only the burner is below the 1 kHz loop
+	burn_stop_ = false;
+	burn_done_ = false;
+	burn_us_ = 0;
+	TEST_ASSERT(burner_task_.create(burner_func_, "BURN", Priority::LOW) != nullptr, "Burner task create()");
+
+	uint32_t sleeps = timer::stats().sleeps;
+	start_loop_(p1k_, CYCLES_1K, false);
+	uint64_t start = ustim::get();
+	p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_);
+	while (p1k_.is_running()) {
+		vTaskDelay(1);
+	}
+	uint32_t elapsed = static_cast<uint32_t>(ustim::elapsed(start));
+	p1k_.stop();        // deletes the parked task, ready for a restart
+	TEST_ASSERT(p1k_.task() == nullptr, "stop() returns with the task deleted");
+	uint32_t burned = burn_us_;
+
+	burn_stop_ = true;
+	while (!burn_done_) {
+		vTaskDelay(1);
+	}
+
+	uint32_t pct = static_cast<uint32_t>(uint64_t(burned) * 100 / (elapsed ? elapsed : 1));
+	printf("[PERIODIC] 1 kHz  lower-priority task got %lu of %lu ms (%lu%%)\r\n",
+	       burned / 1000, elapsed / 1000, pct);
+
+	TEST_ASSERT_EQ(p1k_.stats().cycles, CYCLES_1K, "1 kHz cycle count with a lower-priority burner");
+	TEST_ASSERT(pct >= BURN_MIN_PCT, "Lower-priority task keeps the CPU between releases");
+#if STM32ZERO_TIMER_PRECISE
+	TEST_ASSERT(timer::stats().sleeps - sleeps >= CYCLES_1K / 2, "Sub-tick rest waited on the compare interrupt");
+#else
+	(void)sleeps;
+#endif
+}
+
+static void test_periodic_10khz(void)
+{
+	// Sub-tick period: the loop blocks on the compare interrupt between releases
+	start_loop_(p10k_, CYCLES_10K, false);
+	uint64_t start = ustim::get();
+	TEST_ASSERT(p10k_.start("P10K", Priority::HIGH, loop_body_, &ctx_), "PeriodicTask<100>::start()");
+
+	uint64_t elapsed = load_until_stopped_(p10k_, start);
+
+	PeriodicStats st = p10k_.stats();
+	printf("[PERIODIC] 10 kHz cycles %lu, misses %lu, %lu us\r\n", st.cycles, st.misses, (uint32_t)elapsed);
+	test_report_hist("[PERIODIC]  ", "jitter", 6, st.jitter);
+	test_report_hist("[PERIODIC]  ", "exec", 6, st.exec);
+
+	TEST_ASSERT_EQ(st.cycles, CYCLES_10K, "10 kHz cycle count");
+	TEST_ASSERT_EQ(st.misses, 0, "10 kHz no deadline misses");
+	TEST_ASSERT(st.jitter.percentile(990) < 64, "10 kHz p99 release jitter < 64 us");
+}
+
+//=============================================================================
+// Overrun Policy Tests
+//=============================================================================
+
+static void test_periodic_skip(void)
+{
+	start_loop_(p1k_, OVERRUN_CYCLES, true);
+	uint64_t start = ustim::get();
+	p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_, OverrunPolicy::SKIP);
+	uint64_t elapsed = load_until_stopped_(p1k_, start);
+
+	PeriodicStats st = p1k_.stats();
+	printf("[PERIODIC] SKIP     cycles %lu, misses %lu, skipped %lu, %lu us\r\n",
+	       st.cycles, st.misses, st.skipped, (uint32_t)elapsed);
+
+	TEST_ASSERT_EQ(st.misses, OVERRUN_CYCLES / OVERRUN_EVERY, "SKIP: every overrun counted as miss");
+	TEST_ASSERT_EQ(st.skipped, st.misses, "SKIP: one release dropped per overrun");
+	// Phase kept: the loop ends on the release grid
+	uint32_t releases = (uint32_t)(elapsed / 1000);
+	TEST_ASSERT(releases >= st.cycles + st.skipped - 1 && releases <= st.cycles + st.skipped + 2,
+		    "SKIP: phase kept (releases = cycles + skipped)");
+}
+
+static void test_periodic_catch_up(void)
+{
+	start_loop_(p1k_, OVERRUN_CYCLES, true);
+	uint64_t start = ustim::get();
+	p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_, OverrunPolicy::CATCH_UP);
+	uint64_t elapsed = load_until_stopped_(p1k_, start);
+
+	PeriodicStats st = p1k_.stats();
+	printf("[PERIODIC] CATCH_UP cycles %lu, misses %lu, jitter max %lu us, %lu us\r\n",
+	       st.cycles, st.misses, st.jitter.max(), (uint32_t)elapsed);
+
+	TEST_ASSERT_EQ(st.skipped, 0, "CATCH_UP: no release dropped");
+	TEST_ASSERT(st.misses >= OVERRUN_CYCLES / OVERRUN_EVERY, "CATCH_UP: overruns counted");
+	TEST_ASSERT(st.jitter.max() >= OVERRUN_US - 1000, "CATCH_UP: late release shows as jitter");
+	TEST_ASSERT(elapsed < OVERRUN_CYCLES * 1000 + 3000, "CATCH_UP: finishes on schedule");
+}
+
+static void test_periodic_notify(void)
+{
+	overrun_calls_ = 0;
+	overrun_missed_ = 0;
+	p1k_.set_overrun_handler(on_overrun_, nullptr);
+
+	start_loop_(p1k_, OVERRUN_CYCLES, true);
+	p1k_.start("P1K", Priority::HIGH, loop_body_, &ctx_, OverrunPolicy::NOTIFY);
+	load_until_stopped_(p1k_, ustim::get());
+
+	PeriodicStats st = p1k_.stats();
+	TEST_ASSERT_EQ(overrun_calls_, st.misses, "NOTIFY: handler called per miss");
+	TEST_ASSERT_EQ(overrun_missed_, st.skipped, "NOTIFY: handler gets dropped releases");
+
+	p1k_.set_overrun_handler(nullptr, nullptr);
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_periodic_runtime(void)
+{
+	test_periodic_histogram();
+	test_periodic_1khz();
+	test_periodic_share();
+	test_periodic_10khz();
+	test_periodic_skip();
+	test_periodic_catch_up();
+	test_periodic_notify();
+}
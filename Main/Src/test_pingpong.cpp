@@ -0,0 +1,299 @@
+/**
+ * STM32ZERO Ping-Pong Buffer Runtime Tests
+ *
+ * Tests for stm32zero-pingpong.hpp functionality using a simulated DMA
+ * engine (no peripheral needed):
+ *   - RX/TX initial ownership
+ *   - Half alternation and data ordering
+ *   - Overrun when the CPU is too slow (READY half and held half)
+ *   - TX underrun (hardware resends an unrefilled half)
+ *   - wait_ready() blocking / timeout with a DMA task at higher priority
+ *   - Cache maintenance at handoff (buffers in AXI SRAM on H7)
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-pingpong.hpp"
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects
+//=============================================================================
+
+using TestBuffer = DmaBuffer<64>;
+using TestPingPong = PingPong<TestBuffer>;
+using Owner = TestPingPong::Owner;
+
+// Default .bss (AXI SRAM on H7) so the cache maintenance path is exercised
+static TestPingPong pp_;
+
+STM32ZERO_DTCM static StaticTask<256> dma_task_;
+
+static_assert(TestPingPong::half_size() == 64, "half_size");
+static_assert(TestPingPong::is_contiguous(), "64-byte halves are contiguous");
+static_assert(TestPingPong::dma_size() == 128, "dma_size covers both halves");
+
+//=============================================================================
+// Simulated DMA Engine
+//=============================================================================
+
+// Block n is written as bytes (n + i); byte 0 identifies the block
+static void sim_fill(TestBuffer& buf, uint8_t block)
+{
+	for (size_t i = 0; i < buf.size(); i++) {
+		buf[i] = static_cast<uint8_t>(block + i);
+	}
+}
+
+static bool sim_check(TestBuffer& buf, uint8_t block)
+{
+	for (size_t i = 0; i < buf.size(); i++) {
+		if (buf[i] != static_cast<uint8_t>(block + i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// RX: "hardware" fills the active half, writes it to memory, then interrupts
+static void sim_rx_step(uint8_t block)
+{
+	TestBuffer& buf = pp_.half(pp_.active());
+	sim_fill(buf, block);
+	dcache::clean(buf.data(), buf.aligned_size());   // DMA writes bypass the cache
+	pp_.complete();
+}
+
+// TX: "hardware" reads the active half, then interrupts. Returns byte 0.
+static uint8_t sim_tx_step(void)
+{
+	TestBuffer& buf = pp_.half(pp_.active());
+	uint8_t first = buf[0];
+	pp_.complete();
+	return first;
+}
+
+//=============================================================================
+// RX Tests
+//=============================================================================
+
+static void test_pingpong_rx_init(void)
+{
+	pp_.init(DmaDir::RX);
+
+	TEST_ASSERT(pp_.owner(0) == Owner::HW && pp_.owner(1) == Owner::HW, "PingPong RX init: both halves owned by HW");
+	TEST_ASSERT_EQ(pp_.active(), 0, "PingPong RX init: active half 0");
+	TEST_ASSERT(pp_.wait_ready(0) == nullptr, "PingPong::wait_ready(0) returns nullptr when nothing ready");
+	TEST_ASSERT(!pp_.release(), "PingPong::release() without held half returns false");
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	TEST_ASSERT(pp_.is_cacheable(), "PingPong in AXI SRAM detected as cacheable");
+#endif
+}
+
+static void test_pingpong_rx_handoff(void)
+{
+	pp_.init(DmaDir::RX);
+
+	sim_rx_step(10);
+	TEST_ASSERT(pp_.owner(0) == Owner::READY, "PingPong::complete() half 0 -> READY");
+	TEST_ASSERT_EQ(pp_.active(), 1, "PingPong::complete() hardware moves to half 1");
+
+	TestBuffer* half = pp_.wait_ready(0);
+	TEST_ASSERT(half == &pp_.half(0), "PingPong::wait_ready() returns half 0");
+	TEST_ASSERT(pp_.owner(0) == Owner::CPU, "PingPong::wait_ready() half 0 -> CPU");
+	TEST_ASSERT(pp_.held() == half, "PingPong::held() matches");
+	TEST_ASSERT(half != nullptr && sim_check(*half, 10), "PingPong RX data intact after invalidate");
+
+	TEST_ASSERT(pp_.release(), "PingPong::release() returns true");
+	TEST_ASSERT(pp_.owner(0) == Owner::HW, "PingPong::release() half 0 -> HW");
+	TEST_ASSERT(pp_.held() == nullptr, "PingPong::held() nullptr after release");
+	TEST_ASSERT_EQ(pp_.overruns(), 0, "PingPong no overrun in lockstep");
+}
+
+static void test_pingpong_rx_alternation(void)
+{
+	pp_.init(DmaDir::RX);
+
+	bool order_ok = true;
+	bool data_ok = true;
+	for (uint8_t n = 0; n < 20; n++) {
+		sim_rx_step(n);
+		TestBuffer* half = pp_.wait_ready(0);
+		order_ok = order_ok && (half == &pp_.half(n & 1));
+		data_ok = data_ok && (half != nullptr) && sim_check(*half, n);
+		pp_.release();
+	}
+
+	TEST_ASSERT(order_ok, "PingPong halves alternate 0,1,0,1...");
+	TEST_ASSERT(data_ok, "PingPong 20 blocks received in order");
+	TEST_ASSERT_EQ(pp_.completions(), 20, "PingPong::completions() counts blocks");
+	TEST_ASSERT_EQ(pp_.overruns(), 0, "PingPong::overruns() is 0");
+}
+
+static void test_pingpong_rx_overrun_ready(void)
+{
+	pp_.init(DmaDir::RX);
+
+	// CPU does not pick up anything for 3 blocks
+	sim_rx_step(1);   // half 0 READY
+	sim_rx_step(2);   // half 1 READY, half 0 taken back (block 1 lost)
+	sim_rx_step(3);   // half 0 READY, half 1 taken back (block 2 lost)
+
+	TEST_ASSERT_EQ(pp_.overruns(), 2, "PingPong overrun counted when READY half is reclaimed");
+
+	TestBuffer* half = pp_.wait_ready(0);
+	TEST_ASSERT(half == &pp_.half(0) && sim_check(*half, 3), "PingPong after overrun returns newest block");
+	pp_.release();
+	TEST_ASSERT(pp_.wait_ready(0) == nullptr, "PingPong no stale block after overrun");
+}
+
+static void test_pingpong_rx_overrun_held(void)
+{
+	pp_.init(DmaDir::RX);
+
+	sim_rx_step(1);
+	TestBuffer* half = pp_.wait_ready(0);   // CPU holds half 0
+	sim_rx_step(2);                         // half 1 READY, HW reclaims held half 0
+
+	TEST_ASSERT(half == &pp_.half(0), "PingPong CPU holds half 0");
+	TEST_ASSERT_EQ(pp_.overruns(), 1, "PingPong overrun counted when held half is reclaimed");
+	TEST_ASSERT(!pp_.release(), "PingPong::release() returns false after overrun");
+	TEST_ASSERT(pp_.owner(0) == Owner::HW, "PingPong overrun half stays with HW");
+
+	half = pp_.wait_ready(0);
+	TEST_ASSERT(half == &pp_.half(1) && sim_check(*half, 2), "PingPong next wait_ready() returns half 1");
+	TEST_ASSERT(pp_.release(), "PingPong::release() true for intact half");
+}
+
+//=============================================================================
+// TX Tests
+//=============================================================================
+
+static void test_pingpong_tx(void)
+{
+	pp_.init(DmaDir::TX);
+
+	TEST_ASSERT(pp_.owner(0) == Owner::READY && pp_.owner(1) == Owner::READY, "PingPong TX init: both halves READY for CPU");
+
+	// Prime both halves before "starting DMA"
+	uint8_t block = 0;
+	for (int i = 0; i < 2; i++) {
+		TestBuffer* half = pp_.wait_ready(0);
+		TEST_ASSERT(half == &pp_.half(i), "PingPong TX wait_ready() returns halves in order");
+		sim_fill(*half, block++);
+		pp_.release();
+	}
+	TEST_ASSERT(pp_.owner(0) == Owner::HW && pp_.owner(1) == Owner::HW, "PingPong TX primed: both halves HW");
+
+	// Streaming: hardware sends a half, CPU refills it
+	bool seq_ok = true;
+	for (uint8_t expect = 0; expect < 10; expect++) {
+		seq_ok = seq_ok && (sim_tx_step() == expect);
+		TestBuffer* half = pp_.wait_ready(0);
+		if (half == nullptr) {
+			seq_ok = false;
+			break;
+		}
+		sim_fill(*half, block++);
+		pp_.release();
+	}
+	TEST_ASSERT(seq_ok, "PingPong TX 10 blocks sent in order");
+	TEST_ASSERT_EQ(pp_.overruns(), 0, "PingPong TX no underrun in lockstep");
+
+	// CPU misses two refills: hardware resends a stale half
+	sim_tx_step();
+	sim_tx_step();
+	TEST_ASSERT_EQ(pp_.overruns(), 1, "PingPong TX underrun counted");
+}
+
+//=============================================================================
+// Blocking Tests (DMA task)
+//=============================================================================
+
+#define LIVE_BLOCKS	50
+
+static void dma_task_func_(void*)
+{
+	for (uint8_t n = 0; n < LIVE_BLOCKS; n++) {
+		vTaskDelay(1);
+		sim_rx_step(n);
+	}
+	vTaskDelete(nullptr);
+}
+
+static void test_pingpong_blocking(void)
+{
+	pp_.init(DmaDir::RX);
+
+	TickType_t start = get_tick_count();
+	TEST_ASSERT(pp_.wait_ready(pdMS_TO_TICKS(20)) == nullptr, "PingPong::wait_ready() times out");
+	TickType_t elapsed = get_tick_count() - start;
+	TEST_ASSERT(elapsed >= pdMS_TO_TICKS(20) && elapsed <= pdMS_TO_TICKS(25), "PingPong::wait_ready() timeout ~20ms");
+
+	dma_task_.create(dma_task_func_, "PPDma", Priority::HIGH);
+
+	uint8_t received = 0;
+	bool data_ok = true;
+	while (received < LIVE_BLOCKS) {
+		TestBuffer* half = pp_.wait_ready(pdMS_TO_TICKS(100));
+		if (half == nullptr) {
+			break;
+		}
+		data_ok = data_ok && sim_check(*half, received);
+		received++;
+	}
+	pp_.release();
+
+	TEST_ASSERT_EQ(received, LIVE_BLOCKS, "PingPong blocking consumer received all blocks");
+	TEST_ASSERT(data_ok, "PingPong blocking consumer data in order");
+	TEST_ASSERT_EQ(pp_.overruns(), 0, "PingPong blocking consumer no overrun");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_pingpong_runtime(void)
+{
+	test_pingpong_rx_init();
+	test_pingpong_rx_handoff();
+	test_pingpong_rx_alternation();
+	test_pingpong_rx_overrun_ready();
+	test_pingpong_rx_overrun_held();
+	test_pingpong_tx();
+	test_pingpong_blocking();
+}
@@ -10,6 +10,7 @@
 #include "stm32zero.hpp"
 #include "stm32zero-sio.hpp"
 #include "stm32zero-freertos.hpp"
+#include "stm32zero-histogram.hpp"
 #include <cstring>
 
 using namespace stm32zero;
@@ -55,6 +56,27 @@ extern "C" void test_sio_runtime(void);
 extern "C" void test_freertos_runtime(void);
 extern "C" void test_ustim_runtime(void);
 extern "C" void test_fdcan_runtime(void);
+extern "C" void test_pingpong_runtime(void);
+extern "C" void test_typedqueue_runtime(void);
+extern "C" void test_streambuffer_runtime(void);
+extern "C" void test_eventgroup_runtime(void);
+extern "C" void test_stats_runtime(void);
+extern "C" void test_workqueue_runtime(void);
+extern "C" void test_coro_runtime(void);
+extern "C" void test_active_runtime(void);
+extern "C" void test_periodic_runtime(void);
+extern "C" void test_rwlock_runtime(void);
+extern "C" void test_timer_runtime(void);
+extern "C" void test_trace_runtime(void);
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+extern "C" void test_canbus_runtime(void);
+extern "C" void test_isotp_runtime(void);
+extern "C" void test_gateway_runtime(void);
+extern "C" void test_canmon_runtime(void);
+#endif
+#if defined(MDMA)
+extern "C" void test_dmacpy_runtime(void);
+#endif
 
 //=============================================================================
 // Test Runner Task
@@ -69,7 +91,11 @@ static __NO_RETURN void test_runner_func_(void*)
 
 
 	sio::writef(fmt_buf_, "--- FDCAN Tests ---\r\n");
+#if defined(STM32ZERO_HOST)
+	test_fdcan_runtime();           // FDCAN2 is the remote node
+#else
 	//test_fdcan_runtime();
+#endif
 	sio::writef(fmt_buf_, "\r\n");
 
 	sio::writef(fmt_buf_, "\r\n");
@@ -95,6 +121,78 @@ static __NO_RETURN void test_runner_func_(void*)
 	test_ustim_runtime();
 	sio::writef(fmt_buf_, "\r\n");
 
+	sio::writef(fmt_buf_, "--- TypedQueue Tests ---\r\n");
+	test_typedqueue_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- StreamBuffer Tests ---\r\n");
+	test_streambuffer_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- EventGroup Tests ---\r\n");
+	test_eventgroup_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- Run-Time Stats Tests ---\r\n");
+	test_stats_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- WorkQueue Tests ---\r\n");
+	test_workqueue_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- Coroutine Flow Tests ---\r\n");
+	test_coro_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- Active Object Tests ---\r\n");
+	test_active_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- PeriodicTask Tests ---\r\n");
+	test_periodic_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- RwLock / SeqLock Tests ---\r\n");
+	test_rwlock_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- StaticTimer Tests ---\r\n");
+	test_timer_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- Trace Tests ---\r\n");
+	test_trace_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+#if defined(HAL_FDCAN_MODULE_ENABLED) && (USE_HAL_FDCAN_REGISTER_CALLBACKS == 1)
+	sio::writef(fmt_buf_, "--- CanBus Filter Routing Tests ---\r\n");
+	test_canbus_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- ISO-TP Tests ---\r\n");
+	test_isotp_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- CAN Gateway Tests ---\r\n");
+	test_gateway_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+	sio::writef(fmt_buf_, "--- CAN Bus Monitor Tests ---\r\n");
+	test_canmon_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+#endif
+
+	sio::writef(fmt_buf_, "--- PingPong Tests ---\r\n");
+	test_pingpong_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+
+#if defined(MDMA)
+	sio::writef(fmt_buf_, "--- DMA memcpy Tests ---\r\n");
+	test_dmacpy_runtime();
+	sio::writef(fmt_buf_, "\r\n");
+#endif
+
 	// Print summary
 	sio::writef(fmt_buf_, "========================================\r\n");
 	sio::writef(fmt_buf_, "Test Summary\r\n");
@@ -111,6 +209,12 @@ static __NO_RETURN void test_runner_func_(void*)
 	}
 
 	sio::writef(fmt_buf_, "\r\n");
+
+#if defined(STM32ZERO_HOST)
+	// Host build: exits with the fail count unless the console is interactive
+	stm32zero_host_tests_done(test_fail_count);
+#endif
+
 	sio::writef(fmt_buf_, "Press any key to run interactive SIO tests...\r\n");
 
 	// Wait for user input to run interactive tests
@@ -204,3 +308,16 @@ void test_report_fail_stats(const char* desc, int count, long min, long max, lon
 		    desc, count, min, max, avg, expected_min, expected_max);
 	test_fail_count++;
 }
+
+// One line per histogram: summary, then the non-empty bins as lower:count
+void test_report_hist(const char* prefix, const char* name, int width, const Histogram& h)
+{
+	sio::writef(fmt_buf_, "%s %-*s n=%lu min %lu avg %lu p99 %lu max %lu us |",
+		    prefix, width, name, h.count(), h.min(), h.avg(), h.percentile(990), h.max());
+	for (size_t i = 0; i < Histogram::BINS; i++) {
+		if (h.bin(i) != 0) {
+			sio::writef(fmt_buf_, " %lu:%lu", Histogram::bin_lower(i), h.bin(i));
+		}
+	}
+	sio::writef(fmt_buf_, "\r\n");
+}
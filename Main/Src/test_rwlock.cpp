@@ -0,0 +1,495 @@
+/**
+ * STM32ZERO Reader-Writer Lock Runtime Tests
+ *
+ * Tests for stm32zero-rwlock.hpp functionality:
+ *   - StaticRwLock: shared readers, ReadLock / WriteLock RAII
+ *   - Writer waits for active readers and blocks new ones; nested reads
+ *     by an active reader pass
+ *   - Writer priority inheritance from a blocked reader
+ *   - Active reader boosted to a waiting writer's priority
+ *   - SeqLock<T>: write/read/version, consistency under preemption
+ *   - Benchmark: reader throughput with 1-4 reader tasks and a 1 kHz
+ *     writer, MutexLock vs StaticRwLock vs SeqLock
+ *
+ * Benchmark output:
+ *   [RWLOCK] 1 reader : mutex 1480, rwlock 2210, seqlock 3950 reads/ms
+ *   [RWLOCK] 4 readers: mutex 1390, rwlock 2190, seqlock 3930 reads/ms
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-rwlock.hpp"
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define TABLE_WORDS	32
+#define MAX_READERS	4
+#define BENCH_MS	20
+
+struct Table {
+	uint32_t v[TABLE_WORDS];
+};
+
+enum class Mode : uint8_t {
+	MUTEX,
+	RWLOCK,
+	SEQLOCK,
+};
+
+STM32ZERO_DTCM static StaticRwLock rwlock_;
+STM32ZERO_DTCM static StaticMutex mutex_;
+STM32ZERO_DTCM static StaticTask<256> helper_task_;
+STM32ZERO_DTCM static StaticTask<256> reader_tasks_[MAX_READERS];
+STM32ZERO_DTCM static StaticCountingSemaphore<MAX_READERS> start_sem_;
+STM32ZERO_DTCM static StaticCountingSemaphore<MAX_READERS> done_sem_;
+
+static Table table_;
+static SeqLock<Table> seq_table_;
+
+static volatile bool helper_done_ = false;
+static volatile bool helper_locked_ = false;
+static volatile UBaseType_t helper_prio_ = 0;
+static volatile UBaseType_t helper_after_prio_ = 0;
+static volatile int probe_ = -1;
+
+static volatile Mode mode_ = Mode::MUTEX;
+static volatile bool stop_ = false;
+static volatile bool quit_ = false;
+static volatile uint32_t reads_[MAX_READERS];
+static volatile uint32_t torn_ = 0;
+static char fmt_buf_[128];
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static void fill_(Table& t, uint32_t value)
+{
+	for (uint32_t i = 0; i < TABLE_WORDS; i++) {
+		t.v[i] = value;
+	}
+}
+
+static bool consistent_(const Table& t)
+{
+	for (uint32_t i = 1; i < TABLE_WORDS; i++) {
+		if (t.v[i] != t.v[0]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool wait_flag_(volatile bool& flag, uint32_t timeout_ms)
+{
+	TickType_t start = get_tick_count();
+	while (!flag) {
+		if (get_tick_count() - start > pdMS_TO_TICKS(timeout_ms)) {
+			return false;
+		}
+		vTaskDelay(1);
+	}
+	return true;
+}
+
+//=============================================================================
+// StaticRwLock Tests
+//=============================================================================
+
+static void test_rwlock_create(void)
+{
+	TEST_ASSERT(rwlock_.create(), "StaticRwLock::create()");
+	TEST_ASSERT(rwlock_.is_created(), "StaticRwLock::is_created()");
+	mutex_.create();
+	start_sem_.create(0);
+	done_sem_.create(0);
+}
+
+static void test_rwlock_shared_readers(void)
+{
+	{
+		ReadLock r1(rwlock_, 0);
+		ReadLock r2(rwlock_, 0);
+		TEST_ASSERT(r1 && r2, "Two ReadLocks held at once");
+		TEST_ASSERT_EQ(rwlock_.readers(), 2, "StaticRwLock::readers() counts both");
+
+		TEST_ASSERT(!rwlock_.write_lock(0), "write_lock(0) fails while readers active");
+	}
+	TEST_ASSERT_EQ(rwlock_.readers(), 0, "ReadLock RAII releases");
+
+	{
+		WriteLock w(rwlock_, 0);
+		TEST_ASSERT(w.is_locked(), "WriteLock succeeds after readers left");
+	}
+	ReadLock r(rwlock_, 0);
+	TEST_ASSERT(r.is_locked(), "ReadLock succeeds after WriteLock released");
+}
+
+// HIGH: blocks until the test's reader leaves
+static void writer_waiter_func_(void*)
+{
+	if (rwlock_.write_lock(pdMS_TO_TICKS(100))) {
+		helper_locked_ = true;
+		rwlock_.write_unlock();
+	}
+	helper_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+// LOW: one non-blocking read attempt
+static void reader_probe_func_(void*)
+{
+	bool locked = rwlock_.read_lock(0);
+	if (locked) {
+		rwlock_.read_unlock();
+	}
+	probe_ = locked ? 1 : 0;
+	vTaskDelete(nullptr);
+}
+
+static void test_rwlock_writer_waits(void)
+{
+	helper_done_ = false;
+	helper_locked_ = false;
+
+	rwlock_.read_lock();
+	helper_task_.create(writer_waiter_func_, "RWW", Priority::HIGH);
+
+	// Writer now holds the gate and waits for us to drain
+	TEST_ASSERT(!helper_locked_, "Writer waits for active reader");
+	uint32_t contended = rwlock_.contended_reads();
+	TEST_ASSERT(rwlock_.read_lock(0), "Nested read by the active reader does not block");
+	rwlock_.read_unlock();
+	TEST_ASSERT(!helper_locked_, "Writer still waits after the nested read");
+
+	probe_ = -1;
+	reader_tasks_[0].create(reader_probe_func_, "RWP", Priority::LOW);
+	vTaskDelay(2);      // probe runs while we and the writer block
+	TEST_ASSERT_EQ(probe_, 0, "New reader blocked while writer waits");
+	TEST_ASSERT_EQ(rwlock_.contended_reads() - contended, 1, "Contended read counted");
+
+	rwlock_.read_unlock();
+	TEST_ASSERT(helper_locked_, "Writer runs as soon as last reader leaves");
+	wait_flag_(helper_done_, 50);
+	vTaskDelay(2);      // let IDLE reclaim the helper
+}
+
+// LOW: holds the write lock until a blocked reader raises its priority
+static void writer_holder_func_(void*)
+{
+	rwlock_.write_lock();
+	helper_locked_ = true;
+
+	uint64_t start = ustim::get();
+	while (uxTaskPriorityGet(nullptr) == +Priority::LOW && ustim::elapsed(start) < 50000) {
+	}
+	helper_prio_ = uxTaskPriorityGet(nullptr);
+
+	rwlock_.write_unlock();
+	helper_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+static void test_rwlock_priority_inheritance(void)
+{
+	helper_done_ = false;
+	helper_locked_ = false;
+	helper_prio_ = 0;
+
+	helper_task_.create(writer_holder_func_, "RWH", Priority::LOW);
+	wait_flag_(helper_locked_, 50);
+
+	// Blocks on the writer's mutex: writer inherits our priority
+	TEST_ASSERT(rwlock_.read_lock(pdMS_TO_TICKS(100)), "Reader gets lock after writer");
+	rwlock_.read_unlock();
+
+	TEST_ASSERT_EQ(helper_prio_, +Priority::NORMAL, "Writer inherited blocked reader's priority");
+	wait_flag_(helper_done_, 50);
+	vTaskDelay(2);
+}
+
+// LOW: holds a read lock until a waiting writer raises its priority
+static void reader_holder_func_(void*)
+{
+	rwlock_.read_lock();
+	helper_locked_ = true;
+
+	uint64_t start = ustim::get();
+	while (uxTaskPriorityGet(nullptr) == +Priority::LOW && ustim::elapsed(start) < 50000) {
+	}
+	helper_prio_ = uxTaskPriorityGet(nullptr);
+
+	rwlock_.read_unlock();
+	helper_after_prio_ = uxTaskPriorityGet(nullptr);
+	helper_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+static void test_rwlock_reader_boost(void)
+{
+	helper_done_ = false;
+	helper_locked_ = false;
+	helper_prio_ = 0;
+	helper_after_prio_ = 0;
+
+	helper_task_.create(reader_holder_func_, "RWR", Priority::LOW);
+	wait_flag_(helper_locked_, 50);
+
+	// Waits on the reader to drain: reader runs at our priority meanwhile
+	TEST_ASSERT(rwlock_.write_lock(pdMS_TO_TICKS(100)), "Writer gets lock after boosted reader");
+	rwlock_.write_unlock();
+
+	wait_flag_(helper_done_, 50);
+	TEST_ASSERT_EQ(helper_prio_, +Priority::NORMAL, "Reader boosted to waiting writer's priority");
+	TEST_ASSERT_EQ(helper_after_prio_, +Priority::LOW, "Reader priority restored at read_unlock()");
+	vTaskDelay(2);
+}
+
+//=============================================================================
+// SeqLock Tests
+//=============================================================================
+
+static void test_seqlock_basic(void)
+{
+	SeqLock<uint64_t> seq(5);
+	TEST_ASSERT_EQ(seq.read(), 5, "SeqLock initial value");
+	TEST_ASSERT_EQ(seq.version(), 0, "SeqLock initial version");
+
+	seq.write(7);
+	seq.write(9);
+	TEST_ASSERT_EQ(seq.read(), 9, "SeqLock::read() returns last write");
+	TEST_ASSERT_EQ(seq.version(), 2, "SeqLock::version() counts writes");
+
+	seq.update([](uint64_t& v) { v += 1; });
+	uint64_t v = 0;
+	TEST_ASSERT(seq.try_read(v) && v == 10, "SeqLock::try_read() / update()");
+}
+
+// HIGH: rewrites the table every tick (preempts the reader mid-copy)
+static void seq_writer_func_(void*)
+{
+	uint32_t n = 0;
+	Table t;
+	while (!stop_) {
+		fill_(t, ++n);
+		seq_table_.write(t);
+		vTaskDelay(1);
+	}
+	helper_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+static void test_seqlock_consistency(void)
+{
+	helper_done_ = false;
+	stop_ = false;
+	helper_task_.create(seq_writer_func_, "SEQW", Priority::HIGH);
+
+	uint32_t reads = 0;
+	uint32_t bad = 0;
+	uint32_t last = 0;
+	bool monotonic = true;
+	uint64_t start = ustim::get();
+	while (ustim::elapsed(start) < 50000) {
+		Table t = seq_table_.read();
+		if (!consistent_(t)) {
+			bad++;
+		}
+		if (t.v[0] < last) {
+			monotonic = false;
+		}
+		last = t.v[0];
+		reads++;
+	}
+	stop_ = true;
+	wait_flag_(helper_done_, 50);
+	vTaskDelay(2);
+
+	sio::writef(fmt_buf_, "[RWLOCK] seqlock %lu reads over %lu writes\r\n", reads, seq_table_.version());
+	TEST_ASSERT(seq_table_.version() >= 40, "SeqLock writer preempted reader repeatedly");
+	TEST_ASSERT_EQ(bad, 0, "SeqLock reads never torn");
+	TEST_ASSERT(monotonic, "SeqLock reads never go back in time");
+}
+
+//=============================================================================
+// Benchmark: reader throughput
+//=============================================================================
+
+static void reader_func_(void* param)
+{
+	uint32_t id = reinterpret_cast<uintptr_t>(param);
+	Table t;
+
+	while (true) {
+		start_sem_.take(portMAX_DELAY);
+		if (quit_) {
+			break;
+		}
+		uint32_t n = 0;
+
+		while (!stop_) {
+			switch (mode_) {
+			case Mode::MUTEX: {
+				MutexLock lock(mutex_);
+				t = table_;
+				break;
+			}
+			case Mode::RWLOCK: {
+				ReadLock lock(rwlock_);
+				t = table_;
+				break;
+			}
+			default:
+				t = seq_table_.read();
+				break;
+			}
+			if (!consistent_(t)) {
+				torn_ = torn_ + 1;
+			}
+			n++;
+		}
+
+		reads_[id] = n;
+		done_sem_.give();
+	}
+
+	done_sem_.give();
+	vTaskDelete(nullptr);
+}
+
+static void write_table_(uint32_t value)
+{
+	Table t;
+	fill_(t, value);
+
+	switch (mode_) {
+	case Mode::MUTEX: {
+		MutexLock lock(mutex_);
+		table_ = t;
+		break;
+	}
+	case Mode::RWLOCK: {
+		WriteLock lock(rwlock_);
+		table_ = t;
+		break;
+	}
+	default:
+		seq_table_.write(t);
+		break;
+	}
+}
+
+// Readers (LOW) spin for BENCH_MS while this task writes once per tick
+static uint32_t run_bench_(Mode mode, uint32_t readers)
+{
+	mode_ = mode;
+	stop_ = false;
+	for (uint32_t i = 0; i < readers; i++) {
+		reads_[i] = 0;
+		start_sem_.give();
+	}
+
+	for (uint32_t ms = 0; ms < BENCH_MS; ms++) {
+		vTaskDelay(1);
+		write_table_(ms);
+	}
+	stop_ = true;
+
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < readers; i++) {
+		done_sem_.take(pdMS_TO_TICKS(100));
+	}
+	for (uint32_t i = 0; i < readers; i++) {
+		total += reads_[i];
+	}
+	return total / BENCH_MS;
+}
+
+static void test_rwlock_benchmark(void)
+{
+	for (uint32_t i = 0; i < MAX_READERS; i++) {
+		reader_tasks_[i].create(reader_func_, "RDR", Priority::LOW, reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
+	}
+	torn_ = 0;
+	quit_ = false;
+
+	uint32_t mutex_rate[MAX_READERS];
+	uint32_t rw_rate[MAX_READERS];
+	uint32_t seq_rate[MAX_READERS];
+
+	for (uint32_t n = 1; n <= MAX_READERS; n++) {
+		mutex_rate[n - 1] = run_bench_(Mode::MUTEX, n);
+		rw_rate[n - 1] = run_bench_(Mode::RWLOCK, n);
+		seq_rate[n - 1] = run_bench_(Mode::SEQLOCK, n);
+		sio::writef(fmt_buf_, "[RWLOCK] %lu reader%s: mutex %lu, rwlock %lu, seqlock %lu reads/ms\r\n",
+			    n, n == 1 ? " " : "s", mutex_rate[n - 1], rw_rate[n - 1], seq_rate[n - 1]);
+	}
+
+	// Stop the readers and let IDLE reclaim them
+	quit_ = true;
+	for (uint32_t i = 0; i < MAX_READERS; i++) {
+		start_sem_.give();
+	}
+	for (uint32_t i = 0; i < MAX_READERS; i++) {
+		done_sem_.take(pdMS_TO_TICKS(100));
+	}
+	vTaskDelay(2);
+
+	TEST_ASSERT_EQ(torn_, 0, "No torn reads in any mode");
+	TEST_ASSERT(rw_rate[MAX_READERS - 1] > mutex_rate[MAX_READERS - 1], "StaticRwLock beats MutexLock (4 readers)");
+	TEST_ASSERT(seq_rate[MAX_READERS - 1] > rw_rate[MAX_READERS - 1], "SeqLock beats StaticRwLock (4 readers)");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_rwlock_runtime(void)
+{
+	test_rwlock_create();
+	test_rwlock_shared_readers();
+	test_rwlock_writer_waits();
+	test_rwlock_priority_inheritance();
+	test_rwlock_reader_boost();
+	test_seqlock_basic();
+	test_seqlock_consistency();
+	test_rwlock_benchmark();
+}
@@ -0,0 +1,280 @@
+/**
+ * STM32ZERO Run-Time Statistics Runtime Tests
+ *
+ * Tests for stm32zero-stats.hpp functionality:
+ *   - ustim run-time counter (1 us)
+ *   - snapshot(): task list, state, priority, stack high-water
+ *   - Per-task CPU share under a known load (busy task ~50%)
+ *   - sample() / load_average() sliding window
+ *   - IsrScope time accounting (simulated handler, nesting)
+ *   - Trace ISR hooks feed the same accounting
+ *
+ * Output (top-like table):
+ *   [STATS] window 200012 us, load 51.2%, isr 0.0%
+ *   [STATS] TEST           X  pri 24/24  cpu   0.4%  stack  612
+ *   [STATS] Burner         B  pri 40/40  cpu  49.8%  stack  102
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-stats.hpp"
+#include "stm32zero-trace.hpp"
+#include <cstdio>
+#include <cstring>
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define LOAD_WINDOW_MS	200
+#define BURN_US		500
+
+STM32ZERO_DTCM static StaticTask<128> burner_task_;
+static stats::Snapshot snap_;
+
+static volatile bool burner_stop_ = false;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static const stats::TaskInfo* find_task(const stats::Snapshot& snap, TaskHandle_t handle)
+{
+	for (size_t i = 0; i < snap.count; i++) {
+		if (snap.tasks[i].handle == handle) {
+			return &snap.tasks[i];
+		}
+	}
+	return nullptr;
+}
+
+static char state_char(stats::State s)
+{
+	switch (s) {
+	case stats::State::RUNNING:   return 'X';
+	case stats::State::READY:     return 'R';
+	case stats::State::BLOCKED:   return 'B';
+	case stats::State::SUSPENDED: return 'S';
+	default:                      return 'D';
+	}
+}
+
+static void print_snapshot(const stats::Snapshot& snap)
+{
+	printf("[STATS] window %lu us, load %u.%u%%, isr %u.%u%%\r\n",
+	       snap.window_us,
+	       snap.load_permille / 10, snap.load_permille % 10,
+	       snap.isr_permille / 10, snap.isr_permille % 10);
+	for (size_t i = 0; i < snap.count; i++) {
+		const stats::TaskInfo& t = snap.tasks[i];
+		printf("[STATS] %-14s %c  pri %2u/%2u  cpu %3u.%u%%  stack %4lu\r\n",
+		       t.name, state_char(t.state), t.priority, t.base_priority,
+		       t.cpu_permille / 10, t.cpu_permille % 10, t.stack_free);
+	}
+}
+
+//=============================================================================
+// Run-Time Counter Tests
+//=============================================================================
+
+static void test_stats_counter(void)
+{
+	STM32ZERO_STATS_COUNTER_TYPE c1 = stm32zero_stats_counter();
+	ustim::spin(1000);
+	STM32ZERO_STATS_COUNTER_TYPE c2 = stm32zero_stats_counter();
+	uint32_t delta = static_cast<uint32_t>(c2 - c1);
+
+	TEST_ASSERT(delta >= 1000 && delta <= 1100, "stm32zero_stats_counter() counts microseconds");
+
+	if (sizeof(STM32ZERO_STATS_COUNTER_TYPE) == sizeof(uint64_t)) {
+		uint64_t lag = ustim::get() - static_cast<uint64_t>(stm32zero_stats_counter());
+		TEST_ASSERT(lag <= 10, "stm32zero_stats_counter() is the full 64-bit ustim");
+	}
+}
+
+//=============================================================================
+// snapshot() Tests
+//=============================================================================
+
+static void test_stats_snapshot(void)
+{
+	TEST_ASSERT(stats::snapshot(snap_), "stats::snapshot() succeeds");
+	TEST_ASSERT_EQ(snap_.count, snap_.total_tasks, "stats::snapshot() lists all tasks");
+
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	const stats::TaskInfo* me = find_task(snap_, self);
+	TEST_ASSERT(me != nullptr, "stats::snapshot() contains the calling task");
+	if (me != nullptr) {
+		TEST_ASSERT(me->state == stats::State::RUNNING, "Calling task state is RUNNING");
+		TEST_ASSERT_EQ(me->priority, uxTaskPriorityGet(nullptr), "Calling task priority");
+		TEST_ASSERT(me->stack_free > 0, "Calling task stack high-water > 0");
+		TEST_ASSERT(strcmp(me->name, pcTaskGetName(self)) == 0, "Calling task name");
+	}
+
+	TEST_ASSERT(find_task(snap_, xTaskGetIdleTaskHandle()) != nullptr, "stats::snapshot() contains IDLE");
+}
+
+//=============================================================================
+// CPU Share / Load Tests
+//=============================================================================
+
+// Busy for BURN_US, then sleep until the next tick: ~50% at 1 kHz tick
+static void burner_func_(void*)
+{
+	while (!burner_stop_) {
+		ustim::spin(BURN_US);
+		vTaskDelay(1);
+	}
+	vTaskDelete(nullptr);
+}
+
+static void test_stats_cpu_share(void)
+{
+	burner_stop_ = false;
+	burner_task_.create(burner_func_, "Burner", Priority::HIGH);
+
+	stats::snapshot(snap_);     // window start
+	stats::sample();
+	vTaskDelay(pdMS_TO_TICKS(LOAD_WINDOW_MS / 2));
+	stats::sample();
+	vTaskDelay(pdMS_TO_TICKS(LOAD_WINDOW_MS / 2));
+	stats::sample();
+	stats::snapshot(snap_);
+
+	burner_stop_ = true;
+	vTaskDelay(pdMS_TO_TICKS(5));
+
+	print_snapshot(snap_);
+
+	uint32_t window_ms = snap_.window_us / 1000;
+	TEST_ASSERT(window_ms >= LOAD_WINDOW_MS && window_ms <= LOAD_WINDOW_MS + 10, "stats::snapshot() window length");
+
+	const stats::TaskInfo* burner = find_task(snap_, burner_task_.handle());
+	TEST_ASSERT(burner != nullptr, "Burner task in snapshot");
+	if (burner != nullptr) {
+		TEST_ASSERT(burner->cpu_permille >= 400 && burner->cpu_permille <= 600, "Burner CPU share ~50%");
+	}
+
+	uint32_t sum = 0;
+	for (size_t i = 0; i < snap_.count; i++) {
+		sum += snap_.tasks[i].cpu_permille;
+	}
+	TEST_ASSERT(sum >= 980 && sum <= 1010, "Task CPU shares sum to ~100%");
+	TEST_ASSERT(snap_.load_permille >= 400, "Snapshot load includes burner");
+
+	// Last two samples cover the burner window
+	uint16_t load = stats::load_average(2);
+	printf("[STATS] load average (2 samples) %u.%u%%, samples kept %u\r\n",
+	       load / 10, load % 10, (unsigned)stats::sample_count());
+	TEST_ASSERT(load >= 400 && load <= 700, "stats::load_average() over burner window");
+}
+
+static void test_stats_timer_sampling(void)
+{
+	size_t before = stats::sample_count();
+	TEST_ASSERT(stats::start(10), "stats::start()");
+	vTaskDelay(pdMS_TO_TICKS(55));
+	stats::stop();
+
+	size_t taken = stats::sample_count() - before;
+	TEST_ASSERT(taken >= 4 || stats::sample_count() == STM32ZERO_STATS_HISTORY, "stats::start() samples periodically");
+	TEST_ASSERT(stats::load_average(4) < 300, "Idle load average after burner stopped");
+}
+
+//=============================================================================
+// ISR Accounting Tests
+//=============================================================================
+
+static void simulated_isr_(uint32_t us)
+{
+	stats::IsrScope scope;
+	ustim::spin(us);
+}
+
+static void simulated_nested_isr_(void)
+{
+	stats::IsrScope scope;
+	ustim::spin(100);
+	simulated_isr_(100);    // preempting handler: counted once
+}
+
+static void test_stats_isr_accounting(void)
+{
+	uint64_t before = stats::isr_total_us();
+	for (int i = 0; i < 10; i++) {
+		simulated_isr_(100);
+	}
+	uint64_t spent = stats::isr_total_us() - before;
+	TEST_ASSERT(spent >= 1000 && spent <= 1100, "IsrScope accumulates handler time");
+
+	before = stats::isr_total_us();
+	simulated_nested_isr_();
+	spent = stats::isr_total_us() - before;
+	TEST_ASSERT(spent >= 200 && spent <= 230, "IsrScope nested handlers not double counted");
+
+	before = stats::isr_total_us();
+	stm32zero_trace_isr_enter();
+	ustim::spin(100);
+	stm32zero_trace_isr_exit();
+	spent = stats::isr_total_us() - before;
+	TEST_ASSERT(spent >= 100 && spent <= 115, "Trace ISR hooks feed ISR time");
+
+	stats::snapshot(snap_);
+	for (int i = 0; i < 20; i++) {
+		simulated_isr_(500);
+		vTaskDelay(1);
+	}
+	stats::snapshot(snap_);
+	printf("[STATS] isr %lu us in %lu us window (%u.%u%%)\r\n",
+	       snap_.isr_us, snap_.window_us, snap_.isr_permille / 10, snap_.isr_permille % 10);
+	TEST_ASSERT(snap_.isr_us >= 10000 && snap_.isr_us <= 10500, "Snapshot ISR time");
+	TEST_ASSERT(snap_.isr_permille >= 300, "Snapshot ISR share");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_stats_runtime(void)
+{
+	test_stats_counter();
+	test_stats_snapshot();
+	test_stats_cpu_share();
+	test_stats_timer_sampling();
+	test_stats_isr_accounting();
+}
@@ -0,0 +1,262 @@
+/**
+ * STM32ZERO Stream / Message Buffer Runtime Tests
+ *
+ * Tests for stm32zero-streambuffer.hpp functionality:
+ *   - StaticStreamBuffer create/send/receive/space/reset
+ *   - Trigger level wakes a blocked reader
+ *   - StaticMessageBuffer message boundaries / too-small buffer
+ *   - send_from_isr() (called from task context, valid on Cortex-M ports)
+ *   - Throughput: StaticStreamBuffer vs StaticQueue<1, N> for byte streams
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-sio.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-streambuffer.hpp"
+#include <cstring>
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define STREAM_SIZE	128
+#define BENCH_CHUNK	64
+#define BENCH_BYTES	8192
+
+STM32ZERO_DTCM static StaticStreamBuffer<STREAM_SIZE> test_stream_;
+STM32ZERO_DTCM static StaticStreamBuffer<STREAM_SIZE, 4> test_trigger_stream_;
+STM32ZERO_DTCM static StaticMessageBuffer<64> test_msg_;
+STM32ZERO_DTCM static StaticQueue<1, STREAM_SIZE> test_byte_queue_;
+STM32ZERO_DTCM static StaticTask<256> producer_task_;
+
+static_assert(StaticMessageBuffer<64>::max_message_size() == 64 - sizeof(size_t), "max_message_size");
+
+static uint8_t tx_buf_[BENCH_CHUNK];
+static uint8_t rx_buf_[BENCH_CHUNK];
+static char fmt_buf_[128];
+
+//=============================================================================
+// StaticStreamBuffer Tests
+//=============================================================================
+
+static void test_stream_buffer_create(void)
+{
+	StreamBufferHandle_t handle = test_stream_.create();
+	TEST_ASSERT(handle != nullptr, "StaticStreamBuffer::create() returns valid handle");
+	TEST_ASSERT(test_stream_.is_created(), "StaticStreamBuffer::is_created() returns true");
+	TEST_ASSERT(test_stream_.is_empty(), "StaticStreamBuffer initially empty");
+	TEST_ASSERT_EQ(test_stream_.space(), STREAM_SIZE, "StaticStreamBuffer::space() == Size");
+}
+
+static void test_stream_buffer_send_receive(void)
+{
+	const char msg[] = "hello stream";
+	size_t n = test_stream_.send(msg, sizeof(msg), 0);
+	TEST_ASSERT_EQ(n, sizeof(msg), "StaticStreamBuffer::send() writes all bytes");
+	TEST_ASSERT_EQ(test_stream_.available(), sizeof(msg), "StaticStreamBuffer::available()");
+
+	// Stream has no message boundaries: read in two parts
+	char out[sizeof(msg)] = {};
+	size_t r1 = test_stream_.receive(out, 5, 0);
+	size_t r2 = test_stream_.receive(out + 5, sizeof(out) - 5, 0);
+	TEST_ASSERT_EQ(r1 + r2, sizeof(msg), "StaticStreamBuffer::receive() partial reads");
+	TEST_ASSERT(memcmp(out, msg, sizeof(msg)) == 0, "StaticStreamBuffer data matches");
+
+	TEST_ASSERT_EQ(test_stream_.receive(out, sizeof(out), 0), 0, "StaticStreamBuffer::receive() empty returns 0");
+}
+
+static void test_stream_buffer_full(void)
+{
+	memset(tx_buf_, 0x5A, sizeof(tx_buf_));
+	test_stream_.send(tx_buf_, BENCH_CHUNK, 0);
+	test_stream_.send(tx_buf_, BENCH_CHUNK, 0);
+	TEST_ASSERT(test_stream_.is_full(), "StaticStreamBuffer::is_full() after Size bytes");
+	TEST_ASSERT_EQ(test_stream_.send(tx_buf_, 1, 0), 0, "StaticStreamBuffer::send() full returns 0");
+
+	TEST_ASSERT(test_stream_.reset(), "StaticStreamBuffer::reset()");
+	TEST_ASSERT(test_stream_.is_empty(), "StaticStreamBuffer empty after reset()");
+}
+
+static void test_stream_buffer_from_isr(void)
+{
+	BaseType_t woken = pdFALSE;
+	uint8_t data[3] = { 1, 2, 3 };
+
+	size_t n = test_stream_.send_from_isr(data, sizeof(data), &woken);
+	TEST_ASSERT_EQ(n, 3, "StaticStreamBuffer::send_from_isr()");
+
+	uint8_t out[3] = {};
+	n = test_stream_.receive_from_isr(out, sizeof(out), &woken);
+	TEST_ASSERT(n == 3 && out[2] == 3, "StaticStreamBuffer::receive_from_isr()");
+}
+
+//=============================================================================
+// Trigger Level Test
+//=============================================================================
+
+static void trickle_producer_(void*)
+{
+	// One byte every 5ms: reader with trigger 4 should wake after 4 bytes
+	for (uint8_t i = 0; i < 8; i++) {
+		vTaskDelay(pdMS_TO_TICKS(5));
+		test_trigger_stream_.send(&i, 1, 0);
+	}
+	vTaskDelete(nullptr);
+}
+
+static void test_stream_buffer_trigger(void)
+{
+	test_trigger_stream_.create();
+	TEST_ASSERT_EQ(test_trigger_stream_.trigger(), 4, "StaticStreamBuffer::trigger()");
+
+	producer_task_.create(trickle_producer_, "Trickle", Priority::HIGH);
+
+	uint8_t out[8];
+	size_t n = test_trigger_stream_.receive(out, sizeof(out), pdMS_TO_TICKS(100));
+	TEST_ASSERT_EQ(n, 4, "StaticStreamBuffer reader wakes at trigger level");
+	TEST_ASSERT(out[0] == 0 && out[3] == 3, "StaticStreamBuffer trigger data in order");
+
+	vTaskDelay(pdMS_TO_TICKS(40));
+	n = test_trigger_stream_.receive(out, sizeof(out), 0);
+	TEST_ASSERT_EQ(n, 4, "StaticStreamBuffer remaining bytes");
+}
+
+//=============================================================================
+// StaticMessageBuffer Tests
+//=============================================================================
+
+static void test_message_buffer(void)
+{
+	MessageBufferHandle_t handle = test_msg_.create();
+	TEST_ASSERT(handle != nullptr, "StaticMessageBuffer::create() returns valid handle");
+	TEST_ASSERT(test_msg_.is_empty(), "StaticMessageBuffer initially empty");
+
+	TEST_ASSERT(test_msg_.send("abc", 3, 0), "StaticMessageBuffer::send() 3 bytes");
+	TEST_ASSERT(test_msg_.send("defghij", 7, 0), "StaticMessageBuffer::send() 7 bytes");
+
+	BaseType_t woken = pdFALSE;
+	TEST_ASSERT(test_msg_.send_from_isr("k", 1, &woken), "StaticMessageBuffer::send_from_isr()");
+
+	TEST_ASSERT_EQ(test_msg_.next_length(), 3, "StaticMessageBuffer::next_length()");
+
+	// Buffer too small: message stays
+	char out[16];
+	TEST_ASSERT_EQ(test_msg_.receive(out, 2, 0), 0, "StaticMessageBuffer::receive() small buffer returns 0");
+
+	size_t n = test_msg_.receive(out, sizeof(out), 0);
+	TEST_ASSERT(n == 3 && memcmp(out, "abc", 3) == 0, "StaticMessageBuffer message boundary [0]");
+	n = test_msg_.receive(out, sizeof(out), 0);
+	TEST_ASSERT(n == 7 && memcmp(out, "defghij", 7) == 0, "StaticMessageBuffer message boundary [1]");
+	n = test_msg_.receive(out, sizeof(out), 0);
+	TEST_ASSERT(n == 1 && out[0] == 'k', "StaticMessageBuffer message from ISR");
+
+	uint8_t big[64] = {};
+	TEST_ASSERT(!test_msg_.send(big, sizeof(big), 0), "StaticMessageBuffer::send() > max_message_size fails");
+	TEST_ASSERT(test_msg_.send(big, test_msg_.max_message_size(), 0), "StaticMessageBuffer::send() max_message_size");
+	TEST_ASSERT(test_msg_.is_full(), "StaticMessageBuffer::is_full()");
+	TEST_ASSERT(test_msg_.reset(), "StaticMessageBuffer::reset()");
+}
+
+//=============================================================================
+// Throughput: StreamBuffer vs byte StaticQueue
+//=============================================================================
+
+static void report_throughput(const char* name, uint64_t us)
+{
+	sio::writef(fmt_buf_, "[STREAM] %-20s %lu bytes in %lu us (%lu KB/s)\r\n",
+		    name, (uint32_t)BENCH_BYTES, (uint32_t)us,
+		    (uint32_t)(us ? (uint64_t)BENCH_BYTES * 1000000 / 1024 / us : 0));
+}
+
+static void test_stream_buffer_throughput(void)
+{
+	test_stream_.reset();
+	test_byte_queue_.create();
+	for (size_t i = 0; i < sizeof(tx_buf_); i++) {
+		tx_buf_[i] = static_cast<uint8_t>(i);
+	}
+
+	bool ok = true;
+
+	// StreamBuffer: one kernel call per chunk
+	uint64_t start = ustim::get();
+	for (size_t done = 0; done < BENCH_BYTES; done += BENCH_CHUNK) {
+		test_stream_.send(tx_buf_, BENCH_CHUNK, 0);
+		ok = ok && (test_stream_.receive(rx_buf_, BENCH_CHUNK, 0) == BENCH_CHUNK);
+	}
+	uint64_t stream_us = ustim::elapsed(start);
+	ok = ok && (memcmp(tx_buf_, rx_buf_, BENCH_CHUNK) == 0);
+	report_throughput("StaticStreamBuffer", stream_us);
+
+	// StaticQueue<1, N>: one kernel call per byte
+	start = ustim::get();
+	for (size_t done = 0; done < BENCH_BYTES; done += BENCH_CHUNK) {
+		for (size_t i = 0; i < BENCH_CHUNK; i++) {
+			test_byte_queue_.send(&tx_buf_[i], 0);
+		}
+		for (size_t i = 0; i < BENCH_CHUNK; i++) {
+			test_byte_queue_.receive(&rx_buf_[i], 0);
+		}
+	}
+	uint64_t queue_us = ustim::elapsed(start);
+	ok = ok && (memcmp(tx_buf_, rx_buf_, BENCH_CHUNK) == 0);
+	report_throughput("StaticQueue<1,N>", queue_us);
+
+	TEST_ASSERT(ok, "Stream throughput data integrity");
+	TEST_ASSERT(stream_us < queue_us, "StaticStreamBuffer faster than byte StaticQueue");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_streambuffer_runtime(void)
+{
+	// StaticStreamBuffer tests
+	test_stream_buffer_create();
+	test_stream_buffer_send_receive();
+	test_stream_buffer_full();
+	test_stream_buffer_from_isr();
+	test_stream_buffer_trigger();
+
+	// StaticMessageBuffer tests
+	test_message_buffer();
+
+	// Throughput
+	test_stream_buffer_throughput();
+}
@@ -0,0 +1,311 @@
+/**
+ * STM32ZERO Software Timer Runtime Tests
+ *
+ * Tests for stm32zero-timer.hpp functionality:
+ *   - One-shot / auto-reload tick timers with capturing lambdas
+ *   - change_period(), RAII delete of a running timer
+ *   - Coalescing of batched requests
+ *   - Burst of starts: direct commands overflow the timer queue,
+ *     batched requests do not (queue depth and command latency)
+ *   - Precise timers: sub-tick, coarse + handoff, and auto-reload
+ *     deadlines from the ustim compare interrupt
+ *   - sleep_until() leaves the other task notification bits alone
+ *
+ * Output:
+ *   [TIMER] direct  16 starts: 10 queued, 6 overflowed, max depth 10
+ *   [TIMER] batched 16 starts: 16 applied, 0 overflowed, 3 batches, max depth 9
+ *   [TIMER]   queue  n=16 min 2 avg 40 p99 127 max 81 us | 2:2 32:10 64:4
+ *   [TIMER]   batch  n=16 min 12 avg 130 p99 255 max 210 us | 8:8 128:8
+ *   [TIMER] precise 250 us x 40, 40 fired
+ *   [TIMER]   late   n=40 min 1 avg 1 p99 3 max 2 us | 1:38 2:2
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-ustim.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-histogram.hpp"
+#include "stm32zero-timer.hpp"
+#include <cstdio>
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+extern void test_report_hist(const char* prefix, const char* name, int width, const Histogram& h);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define BURST           16
+#define PRECISE_CYCLES  40
+#define MAX_LATE_US     50
+
+STM32ZERO_DTCM static StaticTimer once_;
+STM32ZERO_DTCM static StaticTimer auto_;
+STM32ZERO_DTCM static StaticTimer burst_[BURST];
+STM32ZERO_DTCM static StaticTimer sub_tick_;
+STM32ZERO_DTCM static StaticTimer coarse_;
+STM32ZERO_DTCM static StaticTimer strobe_;
+
+static volatile uint32_t once_count_ = 0;
+static volatile uint32_t auto_count_ = 0;
+static volatile uint32_t burst_count_ = 0;
+static volatile uint32_t scoped_count_ = 0;
+static volatile uint32_t strobe_count_ = 0;
+static volatile uint64_t fire_us_ = 0;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+//=============================================================================
+// Tick Timer Tests
+//=============================================================================
+
+static void test_timer_oneshot(void)
+{
+	volatile uint32_t* count = &once_count_;
+	TEST_ASSERT(once_.create("ONCE", 5, false, [count] { *count = *count + 1; }),
+		    "StaticTimer::create() one-shot with lambda");
+	TEST_ASSERT(!once_.create("ONCE", 5, false, [] {}), "create() twice fails");
+	TEST_ASSERT(!once_.is_precise(), "is_precise() false for tick timer");
+
+	TEST_ASSERT(once_.start(), "start() (batched)");
+	TEST_ASSERT(once_.is_active(), "is_active() while start pending");
+
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(once_count_, 1, "one-shot fired once");
+	TEST_ASSERT_EQ(once_.fired(), 1, "fired() counts callback");
+	TEST_ASSERT(!once_.is_active(), "one-shot inactive after expiry");
+
+	// Longer period: not yet expired after 10 ticks
+	TEST_ASSERT(once_.change_period(20), "change_period() (batched)");
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(once_count_, 1, "change_period(20) not fired at 10 ticks");
+	vTaskDelay(15);
+	TEST_ASSERT_EQ(once_count_, 2, "change_period(20) fired by 25 ticks");
+}
+
+static void test_timer_auto_reload(void)
+{
+	auto_.create("AUTO", 2, true, [] { auto_count_ = auto_count_ + 1; });
+	auto_.start();
+	vTaskDelay(21);
+	auto_.stop();
+	vTaskDelay(2);
+
+	uint32_t n = auto_count_;
+	TEST_ASSERT(n >= 9 && n <= 11, "auto-reload 2 ticks: ~10 fires in 21 ticks");
+
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(auto_count_, n, "stop() halts auto-reload");
+}
+
+static void test_timer_raii(void)
+{
+	uint32_t received = timer::stats().received;
+	{
+		StaticTimer scoped;
+		scoped.create("SCOP", 1, true, [] { scoped_count_ = scoped_count_ + 1; });
+		scoped.start();
+		vTaskDelay(5);
+	}
+	uint32_t n = scoped_count_;
+	TEST_ASSERT(n >= 3, "scoped timer ran");
+	TEST_ASSERT(timer::stats().received > received, "commands traced as received");
+
+	vTaskDelay(5);
+	TEST_ASSERT_EQ(scoped_count_, n, "destructor deleted running timer");
+}
+
+static void test_timer_coalesce(void)
+{
+	once_.change_period(3);
+	vTaskDelay(5);
+
+	timer::reset_stats();
+	uint32_t before = once_count_;
+	once_.start();
+	once_.stop();
+	once_.start();
+
+	TimerStats st = timer::stats();
+	TEST_ASSERT_EQ(st.requests, 3, "three requests");
+	TEST_ASSERT_EQ(st.coalesced, 2, "two merged into the pending one");
+
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(once_count_, before + 1, "latest request (start) applied once");
+	TEST_ASSERT_EQ(timer::stats().batches, 1, "one batch call");
+}
+
+//=============================================================================
+// Burst Tests (queue overflow)
+//=============================================================================
+
+static void test_timer_burst(void)
+{
+	for (size_t i = 0; i < BURST; i++) {
+		burst_[i].create("BRST", 5, false, [] { burst_count_ = burst_count_ + 1; });
+	}
+
+	// Direct: the daemon (low priority) cannot drain while we send
+	vTaskDelay(2);
+	timer::reset_stats();
+	burst_count_ = 0;
+	uint32_t queued = 0;
+	for (size_t i = 0; i < BURST; i++) {
+		if (burst_[i].start_now(0)) {
+			queued++;
+		}
+	}
+	TimerStats st = timer::stats();
+	printf("[TIMER] direct  %d starts: %lu queued, %lu overflowed, max depth %lu\r\n",
+	       BURST, queued, st.overflows, st.max_depth);
+	TEST_ASSERT(queued < BURST, "direct burst overflows the timer queue");
+	TEST_ASSERT_EQ(st.overflows, BURST - queued, "overflows counted");
+	TEST_ASSERT(st.max_depth <= configTIMER_QUEUE_LENGTH, "depth bounded by queue length");
+
+	vTaskDelay(10);
+	TEST_ASSERT_EQ(burst_count_, queued, "only queued starts fired");
+
+	// Batched: one queue entry from us, the daemon throttles itself
+	timer::reset_stats();
+	burst_count_ = 0;
+	uint32_t accepted = 0;
+	for (size_t i = 0; i < BURST; i++) {
+		if (burst_[i].start()) {
+			accepted++;
+		}
+	}
+	TEST_ASSERT_EQ(accepted, BURST, "batched burst: every start accepted");
+	TEST_ASSERT_EQ(timer::depth(), 1, "one batch call queued");
+
+	vTaskDelay(15);
+	st = timer::stats();
+	printf("[TIMER] batched %d starts: %lu applied, %lu overflowed, %lu batches, max depth %lu\r\n",
+	       BURST, burst_count_, st.overflows, st.batches, st.max_depth);
+	test_report_hist("[TIMER]  ", "queue", 6, st.queue_latency);
+	test_report_hist("[TIMER]  ", "batch", 6, st.batch_latency);
+
+	TEST_ASSERT_EQ(burst_count_, BURST, "batched burst: all timers fired");
+	TEST_ASSERT_EQ(st.overflows, 0, "batched burst: no overflow");
+	TEST_ASSERT(st.deferred > 0 && st.batches > 1, "batch split to leave queue space");
+	TEST_ASSERT(st.max_depth < configTIMER_QUEUE_LENGTH, "batched depth stays below queue length");
+	TEST_ASSERT_EQ(st.queue_latency.count(), st.received, "latency per received command");
+	TEST_ASSERT_EQ(timer::depth(), 0, "queue drained");
+}
+
+//=============================================================================
+// Precise Timer Tests
+//=============================================================================
+
+static void test_timer_precise(void)
+{
+#if STM32ZERO_TIMER_PRECISE
+	TEST_ASSERT(sub_tick_.create_precise("SUB", 300, false, [] { fire_us_ = ustim::get(); }),
+		    "create_precise() 300 us");
+	TEST_ASSERT(sub_tick_.is_precise(), "is_precise()");
+
+	// Sub-tick: armed directly, no daemon involved
+	timer::reset_stats();
+	fire_us_ = 0;
+	uint64_t start = ustim::get();
+	sub_tick_.start();
+	TEST_ASSERT_EQ(timer::stats().requests, 0, "sub-tick start bypasses the daemon");
+	vTaskDelay(3);
+	uint32_t dt = (uint32_t)(fire_us_ - start);
+	printf("[TIMER] precise 300 us one-shot fired after %lu us\r\n", dt);
+	TEST_ASSERT(fire_us_ != 0 && dt >= 300 && dt < 300 + MAX_LATE_US, "300 us one-shot on time");
+	TEST_ASSERT(!sub_tick_.is_active(), "precise one-shot inactive after expiry");
+
+	// Beyond the handoff: daemon sleeps the coarse part
+	coarse_.create_precise("CRS", 5300, false, [] { fire_us_ = ustim::get(); });
+	fire_us_ = 0;
+	start = ustim::get();
+	coarse_.start();
+	vTaskDelay(8);
+	dt = (uint32_t)(fire_us_ - start);
+	printf("[TIMER] precise 5300 us one-shot fired after %lu us\r\n", dt);
+	TEST_ASSERT(fire_us_ != 0 && dt >= 5300 && dt < 5300 + MAX_LATE_US, "5300 us one-shot on time");
+
+	// Auto-reload below the tick, stopped from its own callback (ISR)
+	strobe_.create_precise("STRB", 250, true, [] {
+		strobe_count_ = strobe_count_ + 1;
+		if (strobe_count_ >= PRECISE_CYCLES) {
+			strobe_.stop();
+		}
+	});
+	timer::reset_stats();
+	strobe_.start();
+	vTaskDelay(PRECISE_CYCLES * 250 / 1000 + 5);
+
+	TimerStats st = timer::stats();
+	printf("[TIMER] precise 250 us x %d, %lu fired\r\n", PRECISE_CYCLES, st.precise_fired);
+	test_report_hist("[TIMER]  ", "late", 6, st.precise_late);
+
+	TEST_ASSERT_EQ(strobe_count_, PRECISE_CYCLES, "auto-reload precise cycles");
+	TEST_ASSERT(!strobe_.is_active(), "stop() from callback");
+	TEST_ASSERT(st.precise_late.max() < MAX_LATE_US, "precise lateness bounded");
+#else
+	StaticTimer t;
+	TEST_ASSERT(!t.create_precise("SUB", 300, false, [] {}), "create_precise() without ustim LOW fails");
+#endif
+}
+
+static void test_timer_sleep_notify(void)
+{
+	// A Notify* bit pending across the sleep must survive it untouched
+	xTaskNotify(xTaskGetCurrentTaskHandle(), 1U << 0, eSetBits);
+	uint64_t deadline = ustim::get() + 1500;
+	timer::sleep_until(deadline);
+	TEST_ASSERT(ustim::get() >= deadline, "sleep_until() reaches the deadline");
+
+	uint32_t value = notify::wait_bits(0xFFFFFFFFU, false, false, 0);
+	TEST_ASSERT_EQ(value, 1U << 0, "sleep_until() keeps other bits, leaves no wake bit");
+	notify::clear_bits(value);
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_timer_runtime(void)
+{
+	test_timer_oneshot();
+	test_timer_auto_reload();
+	test_timer_raii();
+	test_timer_coalesce();
+	test_timer_burst();
+	test_timer_precise();
+	test_timer_sleep_notify();
+}
@@ -0,0 +1,324 @@
+/**
+ * STM32ZERO Trace Recorder Runtime Tests
+ *
+ * Tests for stm32zero-trace.hpp functionality:
+ *   - Timestamp, record and ISR hook cost per event in DWT cycles
+ *     (target < 50 beyond the timestamp's timer reads)
+ *   - Context switch and queue records around a blocking receive
+ *   - ISR entry / exit records from the precise timer interrupt
+ *   - Snapshot trigger: ring wraps, freezes after the post count, dump()
+ *   - Streaming over sio: every recorded event is sent or counted dropped
+ *
+ * Output (dump / stream lines are input for tools/trace2perfetto.py):
+ *   [TRACE] timestamp 22 cycles, record 49 cycles/event, off 6 cycles/event
+ *   [TRACE] isr hook 63 cycles/event, recorder off 41 cycles/event
+ *   #trace stm32zero 1 us 512
+ *   #task 1 TEST
+ *   =0001e2400000020a0001e2410000030a...
+ *   #dropped 0
+ *   #end
+ */
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32zero.hpp"
+#include "stm32zero-freertos.hpp"
+#include "stm32zero-timer.hpp"
+#include "stm32zero-trace.hpp"
+#include <cstdio>
+
+using namespace stm32zero;
+using namespace stm32zero::freertos;
+
+//=============================================================================
+// Test Helper Functions (defined in test_runner.cpp)
+//=============================================================================
+
+extern void test_report_pass(const char* desc);
+extern void test_report_fail(const char* desc);
+extern void test_report_pass_eq(const char* desc, long expected, long actual);
+extern void test_report_fail_eq(const char* desc, long expected, long actual);
+
+#define TEST_ASSERT(cond, desc) \
+	do { \
+		if (cond) { \
+			test_report_pass(desc); \
+		} else { \
+			test_report_fail(desc); \
+		} \
+	} while (0)
+
+#define TEST_ASSERT_EQ(actual, expected, desc) \
+	do { \
+		long a_ = (long)(actual); \
+		long e_ = (long)(expected); \
+		if (a_ == e_) { \
+			test_report_pass_eq(desc, e_, a_); \
+		} else { \
+			test_report_fail_eq(desc, e_, a_); \
+		} \
+	} while (0)
+
+//=============================================================================
+// Test Objects (static allocation)
+//=============================================================================
+
+#define OVERHEAD_EVENTS  256
+#define MAX_CYCLES       50      // per event, beyond trace::timestamp()
+#define POST_TRIGGER     8
+
+#if STM32ZERO_TIMER_PRECISE
+#define TRACE_PASTE_(a, b, c)   a##b##c
+#define TRACE_XPASTE_(a, b, c)  TRACE_PASTE_(a, b, c)
+#define TIMER_EXCEPTION         (TRACE_XPASTE_(TIM, STM32ZERO_USTIM_LOW, _IRQn) + 16)
+#endif
+
+STM32ZERO_DTCM static StaticTask<256> helper_task_;
+STM32ZERO_DTCM static StaticQueue<sizeof(uint32_t), 4> queue_;
+STM32ZERO_DTCM static StaticTimer isr_timer_;
+
+static trace::Record records_[trace::SIZE];
+static volatile bool helper_done_ = false;
+
+//=============================================================================
+// Helpers
+//=============================================================================
+
+static inline uint32_t cycles_now_(void)
+{
+	return DWT->CYCCNT;
+}
+
+static void cycle_counter_enable_(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if (__CORTEX_M == 7U)
+	DWT->LAR = 0xC5ACCE55;      // unlock DWT on Cortex-M7
+#endif
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// Index of the first record matching event/arg at or after from, or -1
+static int find_(size_t n, trace::Event ev, uint16_t arg, int from = 0)
+{
+	for (size_t i = from; i < n; i++) {
+		if (records_[i].event() == ev && records_[i].arg() == arg) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+static void helper_func_(void*)
+{
+	uint32_t value;
+	queue_.receive(&value, pdMS_TO_TICKS(100));
+	helper_done_ = true;
+	vTaskDelete(nullptr);
+}
+
+//=============================================================================
+// Overhead Tests
+//=============================================================================
+
+static void test_trace_overhead(void)
+{
+	cycle_counter_enable_();
+
+	// No context switch may add records between start() and stop()
+	taskENTER_CRITICAL();
+	trace::start();
+	bool snapshot = trace::mode() == trace::Mode::SNAPSHOT;
+	uint32_t t0 = cycles_now_();
+	for (uint32_t i = 0; i < OVERHEAD_EVENTS; i++) {
+		trace::mark(static_cast<uint16_t>(i));
+	}
+	uint32_t t1 = cycles_now_();
+	trace::stop();
+	taskEXIT_CRITICAL();
+
+	TEST_ASSERT(snapshot, "trace::start() -> SNAPSHOT");
+
+	taskENTER_CRITICAL();
+	uint32_t t2 = cycles_now_();
+	for (uint32_t i = 0; i < OVERHEAD_EVENTS; i++) {
+		trace::mark(static_cast<uint16_t>(i));
+	}
+	uint32_t t3 = cycles_now_();
+
+	// Timer reads behind every record (three APB reads with a 16-bit LOW)
+	volatile uint32_t sink = 0;
+	uint32_t t4 = cycles_now_();
+	for (uint32_t i = 0; i < OVERHEAD_EVENTS; i++) {
+		sink = trace::timestamp();
+	}
+	uint32_t t5 = cycles_now_();
+	taskEXIT_CRITICAL();
+	(void)sink;
+
+	uint32_t on = (t1 - t0) / OVERHEAD_EVENTS;
+	uint32_t off = (t3 - t2) / OVERHEAD_EVENTS;
+	uint32_t ts = (t5 - t4) / OVERHEAD_EVENTS;
+	printf("[TRACE] timestamp %lu cycles, record %lu cycles/event, off %lu cycles/event\r\n", ts, on, off);
+
+	TEST_ASSERT_EQ(trace::stats().recorded, OVERHEAD_EVENTS, "every mark recorded");
+	TEST_ASSERT(on < ts + MAX_CYCLES, "record overhead beyond the timestamp < 50 cycles/event");
+
+	size_t n = trace::copy(records_, trace::SIZE);
+	TEST_ASSERT_EQ(n, OVERHEAD_EVENTS, "copy() returns recorded events");
+	TEST_ASSERT(records_[0].event() == trace::Event::MARK && records_[0].arg() == 0, "oldest record first");
+	TEST_ASSERT_EQ(records_[n - 1].arg(), OVERHEAD_EVENTS - 1, "newest record last");
+	TEST_ASSERT(records_[n - 1].ts - records_[0].ts < 1000, "ustim timestamps");
+
+	// ISR hooks: one timestamp shared by the record and stats::isr_us
+	taskENTER_CRITICAL();
+	trace::start();
+	uint32_t t6 = cycles_now_();
+	for (uint32_t i = 0; i < OVERHEAD_EVENTS / 2; i++) {
+		stm32zero_trace_isr_enter();
+		stm32zero_trace_isr_exit();
+	}
+	uint32_t t7 = cycles_now_();
+	trace::stop();
+	uint32_t t8 = cycles_now_();
+	for (uint32_t i = 0; i < OVERHEAD_EVENTS / 2; i++) {
+		stm32zero_trace_isr_enter();
+		stm32zero_trace_isr_exit();
+	}
+	uint32_t t9 = cycles_now_();
+	taskEXIT_CRITICAL();
+
+	uint32_t hook = (t7 - t6) / OVERHEAD_EVENTS;
+	uint32_t hook_off = (t9 - t8) / OVERHEAD_EVENTS;
+	printf("[TRACE] isr hook %lu cycles/event, recorder off %lu cycles/event\r\n", hook, hook_off);
+
+	TEST_ASSERT_EQ(trace::stats().recorded, OVERHEAD_EVENTS, "every ISR hook recorded");
+	TEST_ASSERT(hook < ts + MAX_CYCLES, "ISR hook overhead beyond the timestamp < 50 cycles/event");
+}
+
+//=============================================================================
+// Scheduler / Queue Tests
+//=============================================================================
+
+static void test_trace_switch(void)
+{
+	if (!queue_.is_created()) {
+		queue_.create();
+	}
+	uint16_t queue_num = static_cast<uint16_t>(uxQueueGetQueueNumber(queue_.handle()));
+	TEST_ASSERT(queue_num != 0, "queue numbered at creation");
+
+	trace::start();
+	helper_done_ = false;
+	TaskHandle_t helper = helper_task_.create(helper_func_, "THLP", Priority::HIGH);
+	uint16_t task_num = static_cast<uint16_t>(uxTaskGetTaskNumber(helper));
+
+	uint32_t value = 1;
+	queue_.send(&value, 0);
+	trace::stop();
+	vTaskDelay(2);
+
+	TEST_ASSERT(helper_done_, "helper received");
+
+	size_t n = trace::copy(records_, trace::SIZE);
+	int block = find_(n, trace::Event::QUEUE_BLOCK_RECEIVE, queue_num);
+	int send = find_(n, trace::Event::QUEUE_SEND, queue_num);
+	int in = find_(n, trace::Event::TASK_IN, task_num, send < 0 ? 0 : send);
+	int recv = find_(n, trace::Event::QUEUE_RECEIVE, queue_num, in < 0 ? 0 : in);
+
+	TEST_ASSERT(block >= 0, "helper blocks on empty queue");
+	TEST_ASSERT(send > block, "send recorded after block");
+	TEST_ASSERT(in > send, "helper switched in after send");
+	TEST_ASSERT(recv > in, "receive recorded in helper");
+	if (send >= 0) {
+		TEST_ASSERT_EQ(records_[send].aux(), 0, "send records items before");
+	}
+}
+
+static void test_trace_isr(void)
+{
+#if STM32ZERO_TIMER_PRECISE
+	if (!isr_timer_.is_created()) {
+		isr_timer_.create_precise("TISR", 200, false, [] {});
+	}
+
+	uint32_t fired = isr_timer_.fired();
+	trace::start();
+	isr_timer_.start();
+	vTaskDelay(2);
+	trace::stop();
+
+	size_t n = trace::copy(records_, trace::SIZE);
+	int enter = find_(n, trace::Event::ISR_ENTER, TIMER_EXCEPTION);
+	int exit = find_(n, trace::Event::ISR_EXIT, TIMER_EXCEPTION, enter < 0 ? 0 : enter);
+
+	TEST_ASSERT_EQ(isr_timer_.fired() - fired, 1, "precise timer fired once");
+	TEST_ASSERT(enter >= 0, "ISR_ENTER from compare interrupt");
+	TEST_ASSERT(exit > enter, "matching ISR_EXIT");
+	if (enter >= 0 && exit > enter) {
+		printf("[TRACE] compare ISR %lu us\r\n", records_[exit].ts - records_[enter].ts);
+	}
+#endif
+}
+
+//=============================================================================
+// Snapshot / Stream Tests
+//=============================================================================
+
+static void test_trace_trigger(void)
+{
+	trace::start();
+	for (uint32_t i = 0; i < trace::SIZE + 100; i++) {
+		trace::mark(static_cast<uint16_t>(i));
+	}
+	trace::trigger(POST_TRIGGER);
+	TEST_ASSERT(!trace::is_frozen(), "recording continues after trigger");
+
+	for (uint32_t i = 0; i < 20; i++) {
+		trace::mark(0xFFFF);
+	}
+	TEST_ASSERT(trace::is_frozen(), "frozen after post-trigger records");
+
+	size_t n = trace::copy(records_, trace::SIZE);
+	TEST_ASSERT_EQ(n, trace::SIZE, "wrapped ring holds SIZE records");
+
+	int trig = find_(n, trace::Event::TRIGGER, 0);
+	TEST_ASSERT(trig >= 0, "TRIGGER kept in snapshot");
+	TEST_ASSERT_EQ((int)n - 1 - trig, POST_TRIGGER, "post-trigger records");
+
+	size_t dumped = trace::dump();
+	TEST_ASSERT_EQ(dumped, n, "dump() writes the snapshot");
+	trace::stop();
+}
+
+static void test_trace_stream(void)
+{
+	TEST_ASSERT(trace::stream_start(Priority::LOW), "stream_start()");
+	TEST_ASSERT(!trace::stream_start(Priority::LOW), "stream_start() twice fails");
+
+	for (int i = 0; i < 20; i++) {
+		trace::mark(static_cast<uint16_t>(i));
+		vTaskDelay(1);
+	}
+	trace::stream_stop();
+
+	trace::Stats st = trace::stats();
+	printf("[TRACE] stream recorded %lu, streamed %lu, dropped %lu\r\n",
+	       st.recorded, st.streamed, st.dropped);
+	TEST_ASSERT(st.streamed >= 20, "stream sent the marks");
+	TEST_ASSERT_EQ(st.streamed, st.recorded, "every claimed record streamed");
+	TEST_ASSERT(trace::mode() == trace::Mode::OFF, "stream_stop() -> OFF");
+}
+
+//=============================================================================
+// Entry Point
+//=============================================================================
+
+extern "C" void test_trace_runtime(void)
+{
+	test_trace_overhead();
+	test_trace_switch();
+	test_trace_isr();
+	test_trace_trigger();
+	test_trace_stream();
+}
@@ -0,0 +1,143 @@
+/**
+ * FreeRTOS Configuration for the Host Build (FreeRTOS POSIX port)
+ *
+ * Kernel settings follow the NUCLEO-H753ZI project (priorities, timer
+ * task, trace facility) so the runtime tests see the same kernel; the
+ * STM32ZERO hooks below are the same as in the board configurations.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern uint32_t SystemCoreClock;
+void vAssertCalled(const char* file, unsigned long line);
+#ifdef __cplusplus
+}
+#endif
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configKERNEL_PROVIDED_STATIC_MEMORY      1
+#define configUSE_IDLE_HOOK                      0
+#define configUSE_TICK_HOOK                      0
+#define configCPU_CLOCK_HZ                       ( SystemCoreClock )
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     ( 56 )
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
+#define configTOTAL_HEAP_SIZE                    ((size_t)(1024 * 1024))
+#define configMAX_TASK_NAME_LEN                  ( 16 )
+#define configUSE_TRACE_FACILITY                 1
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_COUNTING_SEMAPHORES            1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configMESSAGE_BUFFER_LENGTH_TYPE         size_t
+#define configUSE_TASK_NOTIFICATIONS             1
+#define configCHECK_FOR_STACK_OVERFLOW           0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                ( 2 )
+#define configTIMER_QUEUE_LENGTH                 10
+#define configTIMER_TASK_STACK_DEPTH             256
+
+/* No newlib on the host; the C library is thread safe. */
+#define configUSE_NEWLIB_REENTRANT               0
+
+#define INCLUDE_vTaskPrioritySet             1
+#define INCLUDE_uxTaskPriorityGet            1
+#define INCLUDE_vTaskDelete                  1
+#define INCLUDE_vTaskCleanUpResources        0
+#define INCLUDE_vTaskSuspend                 1
+#define INCLUDE_xTaskDelayUntil              1
+#define INCLUDE_vTaskDelay                   1
+#define INCLUDE_xTaskGetSchedulerState       1
+#define INCLUDE_xTimerPendFunctionCall       1
+#define INCLUDE_xQueueGetMutexHolder         1
+#define INCLUDE_uxTaskGetStackHighWaterMark  1
+#define INCLUDE_xTaskGetCurrentTaskHandle    1
+#define INCLUDE_eTaskGetState                1
+
+/* Interrupt priorities keep the Cortex-M values for code that programs the
+NVIC (the host NVIC only records them). */
+#define configPRIO_BITS                              4
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY      15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configKERNEL_INTERRUPT_PRIORITY 	( configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS) )
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY 	( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS) )
+
+#define configASSERT( x ) if ((x) == 0) { vAssertCalled(__FILE__, __LINE__); }
+
+/* Run-time stats clocked by ustim (1 us), see Main/Inc/stm32zero-stats.hpp.
+   ustim::init() runs in app_init() before the scheduler starts.
+   64-bit counters so the per-task run time never wraps. */
+#define configGENERATE_RUN_TIME_STATS            1
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+#define configRUN_TIME_COUNTER_TYPE              uint64_t
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C"
+  #endif
+  configRUN_TIME_COUNTER_TYPE stm32zero_stats_counter(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         stm32zero_stats_counter()
+/* Timer queue depth and command latency, see Main/Inc/stm32zero-timer.hpp. */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C" {
+  #endif
+  void stm32zero_timer_cmd_sent(long result);
+  void stm32zero_timer_cmd_received(void);
+  #ifdef __cplusplus
+  }
+  #endif
+#endif
+#define traceTIMER_COMMAND_SEND(xTimer, xMessageID, xMessageValueValue, xReturn) \
+	stm32zero_timer_cmd_sent(xReturn)
+#define traceTIMER_COMMAND_RECEIVED(pxTimer, xMessageID, xMessageValue) \
+	stm32zero_timer_cmd_received()
+/* Trace recorder, see Main/Inc/stm32zero-trace.hpp (codes = trace::Event). */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C" {
+  #endif
+  void stm32zero_trace_record(uint32_t info);
+  uint32_t stm32zero_trace_queue_id(void);
+  #ifdef __cplusplus
+  }
+  #endif
+#endif
+#define STM32ZERO_TRACE_INFO(ev, aux, arg) \
+	((uint32_t)(ev) | ((uint32_t)(uint8_t)(aux) << 8) | ((uint32_t)(uint16_t)(arg) << 16))
+#define traceTASK_SWITCHED_IN() \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(1, 0, pxCurrentTCB->uxTCBNumber))
+#define traceQUEUE_CREATE(pxNewQueue) \
+	((pxNewQueue)->uxQueueNumber = stm32zero_trace_queue_id())
+#define traceQUEUE_SEND(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(4, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(5, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_RECEIVE(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(6, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(7, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(8, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(9, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+
+#endif /* FREERTOS_CONFIG_H */
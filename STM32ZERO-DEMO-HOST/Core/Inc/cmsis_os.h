@@ -0,0 +1,44 @@
+/**
+ * STM32ZERO Host CMSIS-RTOS Subset
+ *
+ * The board projects use the CMSIS-RTOS V2 wrapper only to initialize and
+ * start the kernel; the host maps those calls directly onto FreeRTOS.
+ */
+
+#ifndef __CMSIS_OS_H__
+#define __CMSIS_OS_H__
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	osOK = 0,
+	osError = -1,
+} osStatus_t;
+
+static inline osStatus_t osKernelInitialize(void)
+{
+	return osOK;
+}
+
+static inline osStatus_t osKernelStart(void)
+{
+	vTaskStartScheduler();
+	return osError;
+}
+
+static inline osStatus_t osDelay(uint32_t ticks)
+{
+	vTaskDelay(ticks);
+	return osOK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CMSIS_OS_H__
@@ -0,0 +1,27 @@
+/**
+ * STM32ZERO Host Application Header
+ *
+ * Stands in for the CubeMX main.h of the board projects on the FreeRTOS
+ * POSIX port (see stm32host_hal.h).
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32host_hal.h"
+
+void Error_Handler(void);
+
+// Called by the test runner after the summary; returns only when the
+// console is interactive (--pty), otherwise exits with the fail count
+void stm32zero_host_tests_done(uint32_t failed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MAIN_H
@@ -0,0 +1,398 @@
+/**
+ * STM32ZERO Host Device Header
+ *
+ * Stand-in for the CMSIS device header (stm32h7xx.h) on the FreeRTOS
+ * POSIX port. It keeps the names the STM32ZERO library and the demo use
+ * and mirrors the NUCLEO-H753ZI peripheral set:
+ *
+ *   - TIM2/TIM5 (32-bit), TIM3/TIM4/TIM8/TIM12 (16-bit), counting 1 MHz
+ *     from CLOCK_MONOTONIC in the cascades used by ustim
+ *   - USART3 (sio), FDCAN1/FDCAN2 (in-process bus), see stm32host_hal.h
+ *   - DWT cycle counter at SystemCoreClock, scaled from CLOCK_MONOTONIC
+ *   - core intrinsics (LDREX/STREX as compare-and-swap, IPSR from the
+ *     simulated interrupt context)
+ *
+ * Registers with side effects on real hardware (CNT, SR, EGR, CYCCNT) are
+ * host_reg_t objects in C++: reads and writes go to the simulation in
+ * stm32host_hal.cpp. All other registers are plain memory.
+ */
+
+#ifndef __STM32HOST_H__
+#define __STM32HOST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Compiler / Core
+//=============================================================================
+
+#ifdef __cplusplus
+#define __I       volatile           // as CMSIS: const members would block definitions
+#else
+#define __I       volatile const
+#endif
+#define __O       volatile
+#define __IO      volatile
+#define __IM      __I
+#define __OM      volatile
+#define __IOM     volatile
+
+#ifndef __NO_RETURN
+#define __NO_RETURN          __attribute__((__noreturn__))
+#endif
+#define __STATIC_INLINE      static inline
+#define __STATIC_FORCEINLINE __attribute__((always_inline)) static inline
+#define __ALIGNED(x)         __attribute__((aligned(x)))
+#define __PACKED             __attribute__((packed, aligned(1)))
+#define __WEAK               __attribute__((weak))
+#define __USED               __attribute__((used))
+#define __weak               __attribute__((weak))
+#define __packed             __attribute__((__packed__))
+
+#define __CORTEX_M           (0U)       // host: no Cortex-M specific paths
+#define __FPU_PRESENT        0U
+#define __MPU_PRESENT        0U
+#define __DCACHE_PRESENT     0U
+#define __ICACHE_PRESENT     0U
+#define __NVIC_PRIO_BITS     4U
+
+extern uint32_t SystemCoreClock;
+
+//=============================================================================
+// Interrupt Numbers (STM32H753 values)
+//=============================================================================
+
+typedef enum {
+	NonMaskableInt_IRQn = -14,
+	HardFault_IRQn = -13,
+	SVCall_IRQn = -5,
+	PendSV_IRQn = -2,
+	SysTick_IRQn = -1,
+	FDCAN1_IT0_IRQn = 19,
+	FDCAN2_IT0_IRQn = 20,
+	FDCAN1_IT1_IRQn = 21,
+	FDCAN2_IT1_IRQn = 22,
+	TIM2_IRQn = 28,
+	TIM3_IRQn = 29,
+	TIM4_IRQn = 30,
+	USART3_IRQn = 39,
+	TIM8_BRK_TIM12_IRQn = 43,
+	TIM5_IRQn = 50,
+	HOST_IRQn_COUNT = 64,
+} IRQn_Type;
+
+//=============================================================================
+// Simulated Registers
+//=============================================================================
+
+// Register owners and kinds for host_reg_read() / host_reg_write()
+enum {
+	HOST_REG_CNT = 0,
+	HOST_REG_SR = 1,
+	HOST_REG_EGR = 2,
+	HOST_REG_CYCCNT = 3,
+};
+
+#define HOST_REG_OWNER_DWT  0xFFFFU
+
+uint32_t host_reg_read(uint16_t owner, uint16_t kind);
+void host_reg_write(uint16_t owner, uint16_t kind, uint32_t value);
+
+#ifdef __cplusplus
+} // extern "C"
+
+struct host_reg_t {
+	uint16_t owner;             // timer number or HOST_REG_OWNER_DWT
+	uint16_t kind;
+
+	operator uint32_t() const volatile { return host_reg_read(owner, kind); }
+
+	volatile host_reg_t& operator=(uint32_t v) volatile
+	{
+		host_reg_write(owner, kind, v);
+		return *this;
+	}
+	volatile host_reg_t& operator|=(uint32_t v) volatile { return *this = (uint32_t)*this | v; }
+	volatile host_reg_t& operator&=(uint32_t v) volatile { return *this = (uint32_t)*this & v; }
+};
+
+extern "C" {
+#else
+typedef struct {
+	uint16_t owner;
+	uint16_t kind;
+} host_reg_t;                   // C: use host_reg_read() / host_reg_write()
+#endif
+
+//=============================================================================
+// Peripheral Registers
+//=============================================================================
+
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SMCR;
+	__IO uint32_t DIER;
+	host_reg_t SR;              // rc_w0: writing 0 clears a flag
+	host_reg_t EGR;             // CC1G / UG set the matching flags
+	__IO uint32_t CCMR1;
+	__IO uint32_t CCMR2;
+	__IO uint32_t CCER;
+	host_reg_t CNT;             // counts 1 MHz (cascade shifted)
+	__IO uint32_t PSC;
+	__IO uint32_t ARR;
+	__IO uint32_t RCR;
+	__IO uint32_t CCR1;
+	__IO uint32_t CCR2;
+	__IO uint32_t CCR3;
+	__IO uint32_t CCR4;
+	__IO uint32_t BDTR;
+	__IO uint32_t DCR;
+	__IO uint32_t DMAR;
+	uint32_t RESERVED1;
+	__IO uint32_t CCMR3;
+	__IO uint32_t CCR5;
+	__IO uint32_t CCR6;
+	__IO uint32_t AF1;
+	__IO uint32_t AF2;
+	__IO uint32_t TISEL;
+} TIM_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t CR3;
+	__IO uint32_t BRR;
+	__IO uint32_t GTPR;
+	__IO uint32_t RTOR;
+	__IO uint32_t RQR;
+	__IO uint32_t ISR;
+	__IO uint32_t ICR;
+	__IO uint32_t RDR;
+	__IO uint32_t TDR;
+	__IO uint32_t PRESC;
+} USART_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR;
+	__IO uint32_t NDTR;
+	__IO uint32_t PAR;
+	__IO uint32_t M0AR;
+	__IO uint32_t M1AR;
+	__IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+	__I  uint32_t CREL;
+	__I  uint32_t ENDN;
+	uint32_t RESERVED1;
+	__IO uint32_t DBTP;
+	__IO uint32_t TEST;
+	__IO uint32_t RWD;
+	__IO uint32_t CCCR;
+	__IO uint32_t NBTP;
+	__IO uint32_t TSCC;
+	__IO uint32_t TSCV;
+	__IO uint32_t TOCC;
+	__IO uint32_t TOCV;
+	uint32_t RESERVED2[4];
+	__IO uint32_t ECR;
+	__IO uint32_t PSR;
+	__IO uint32_t TDCR;
+	uint32_t RESERVED3;
+	__IO uint32_t IR;
+	__IO uint32_t IE;
+	__IO uint32_t ILS;
+	__IO uint32_t ILE;
+	uint32_t RESERVED4[8];
+	__IO uint32_t GFC;
+	__IO uint32_t SIDFC;
+	__IO uint32_t XIDFC;
+	uint32_t RESERVED5;
+	__IO uint32_t XIDAM;
+	__I  uint32_t HPMS;
+	__IO uint32_t NDAT1;
+	__IO uint32_t NDAT2;
+	__IO uint32_t RXF0C;
+	__IO uint32_t RXF0S;
+	__IO uint32_t RXF0A;
+	__IO uint32_t RXBC;
+	__IO uint32_t RXF1C;
+	__IO uint32_t RXF1S;
+	__IO uint32_t RXF1A;
+	__IO uint32_t RXESC;
+	__IO uint32_t TXBC;
+	__IO uint32_t TXFQS;
+	__IO uint32_t TXESC;
+	__IO uint32_t TXBRP;
+	__IO uint32_t TXBAR;
+	__IO uint32_t TXBCR;
+	__IO uint32_t TXBTO;
+	__IO uint32_t TXBCF;
+	__IO uint32_t TXBTIE;
+	__IO uint32_t TXBCIE;
+	uint32_t RESERVED6[2];
+	__IO uint32_t TXEFC;
+	__IO uint32_t TXEFS;
+	__IO uint32_t TXEFA;
+} FDCAN_GlobalTypeDef;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	host_reg_t CYCCNT;          // SystemCoreClock cycles
+	__IO uint32_t CPICNT;
+	__IO uint32_t EXCCNT;
+	__IO uint32_t SLEEPCNT;
+	__IO uint32_t LSUCNT;
+	__IO uint32_t FOLDCNT;
+	__I  uint32_t PCSR;
+	__O  uint32_t LAR;
+	__IO uint32_t LSR;
+} DWT_Type;
+
+typedef struct {
+	__IO uint32_t DHCSR;
+	__O  uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk       (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk   (1UL << 24)
+
+#define TIM_CR1_CEN        (1UL << 0)
+#define TIM_CR1_URS        (1UL << 2)
+#define TIM_CR1_OPM        (1UL << 3)
+#define TIM_CR1_ARPE       (1UL << 7)
+#define TIM_DIER_UIE       (1UL << 0)
+#define TIM_DIER_CC1IE     (1UL << 1)
+#define TIM_SR_UIF         (1UL << 0)
+#define TIM_SR_CC1IF       (1UL << 1)
+#define TIM_EGR_UG         (1UL << 0)
+#define TIM_EGR_CC1G       (1UL << 1)
+#define TIM_CCMR1_CC1S     (3UL << 0)
+#define TIM_CCMR1_OC1M     ((1UL << 16) | (7UL << 4))
+#define TIM_CCER_CC1E      (1UL << 0)
+#define TIM_SMCR_SMS       ((1UL << 16) | (7UL << 0))
+#define TIM_SMCR_TS        ((3UL << 20) | (7UL << 4))
+
+#define FDCAN_CCCR_INIT    (1UL << 0)
+#define FDCAN_CCCR_CCE     (1UL << 1)
+#define FDCAN_CCCR_FDOE    (1UL << 8)
+#define FDCAN_CCCR_BRSE    (1UL << 9)
+#define FDCAN_TXBC_TFQM    (1UL << 30)
+#define FDCAN_TXFQS_TFFL   (0x3FUL << 0)
+#define FDCAN_TXFQS_TFQF   (1UL << 21)
+#define FDCAN_PSR_LEC      (7UL << 0)
+#define FDCAN_PSR_ACT      (3UL << 3)
+#define FDCAN_PSR_EP       (1UL << 5)
+#define FDCAN_PSR_EW       (1UL << 6)
+#define FDCAN_PSR_BO       (1UL << 7)
+#define FDCAN_PSR_DLEC     (7UL << 8)
+#define FDCAN_ECR_TEC      (0xFFUL << 0)
+#define FDCAN_ECR_REC      (0x7FUL << 8)
+#define FDCAN_ECR_RP       (1UL << 15)
+#define FDCAN_ECR_CEL      (0xFFUL << 16)
+
+//=============================================================================
+// Peripheral Instances
+//=============================================================================
+
+extern TIM_TypeDef host_tim2, host_tim3, host_tim4, host_tim5, host_tim8, host_tim12;
+extern USART_TypeDef host_usart3;
+extern FDCAN_GlobalTypeDef host_fdcan1, host_fdcan2;
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_core_debug;
+
+#define TIM2        (&host_tim2)
+#define TIM3        (&host_tim3)
+#define TIM4        (&host_tim4)
+#define TIM5        (&host_tim5)
+#define TIM8        (&host_tim8)
+#define TIM12       (&host_tim12)
+#define USART3      (&host_usart3)
+#define FDCAN1      (&host_fdcan1)
+#define FDCAN2      (&host_fdcan2)
+#define DWT         (&host_dwt)
+#define CoreDebug   (&host_core_debug)
+
+#define IS_TIM_32B_COUNTER_INSTANCE(INSTANCE) (((INSTANCE) == TIM2) || ((INSTANCE) == TIM5))
+
+//=============================================================================
+// Intrinsics
+//=============================================================================
+
+// Exception number of the interrupt being simulated (0 in thread mode)
+uint32_t __get_IPSR(void);
+uint32_t __get_PRIMASK(void);
+void __disable_irq(void);
+void __enable_irq(void);
+
+__STATIC_FORCEINLINE void __NOP(void) { __asm__ volatile("" ::: "memory"); }
+__STATIC_FORCEINLINE void __WFI(void) {}
+__STATIC_FORCEINLINE void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+__STATIC_FORCEINLINE void __DSB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+__STATIC_FORCEINLINE void __ISB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+// Exclusive monitor: STREX succeeds when the word still holds the value
+// read by the last LDREX of this thread (ABA is harmless for the users)
+extern __thread uint32_t host_exclusive_value;
+
+__STATIC_FORCEINLINE uint32_t __LDREXW(volatile uint32_t* addr)
+{
+	host_exclusive_value = __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+	return host_exclusive_value;
+}
+
+__STATIC_FORCEINLINE uint32_t __STREXW(uint32_t value, volatile uint32_t* addr)
+{
+	uint32_t expected = host_exclusive_value;
+	return __atomic_compare_exchange_n(addr, &expected, value, 0,
+					   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? 0U : 1U;
+}
+
+__STATIC_FORCEINLINE void __CLREX(void) {}
+
+__STATIC_FORCEINLINE uint32_t __CLZ(uint32_t v) { return v == 0U ? 32U : (uint32_t)__builtin_clz(v); }
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t v)
+{
+	uint32_t r = 0;
+	for (int i = 0; i < 32; i++) {
+		r = (r << 1) | ((v >> i) & 1U);
+	}
+	return r;
+}
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t v) { return __builtin_bswap32(v); }
+
+//=============================================================================
+// NVIC / SCB
+//=============================================================================
+
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority);
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+void NVIC_SetPendingIRQ(IRQn_Type irqn);
+void NVIC_ClearPendingIRQ(IRQn_Type irqn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn);
+
+// No data cache on the host
+__STATIC_INLINE void SCB_EnableDCache(void) {}
+__STATIC_INLINE void SCB_CleanDCache(void) {}
+__STATIC_INLINE void SCB_InvalidateDCache(void) {}
+__STATIC_INLINE void SCB_CleanInvalidateDCache(void) {}
+__STATIC_INLINE void SCB_CleanDCache_by_Addr(volatile void* addr, int32_t size) { (void)addr; (void)size; }
+__STATIC_INLINE void SCB_InvalidateDCache_by_Addr(volatile void* addr, int32_t size) { (void)addr; (void)size; }
+__STATIC_INLINE void SCB_CleanInvalidateDCache_by_Addr(volatile void* addr, int32_t size) { (void)addr; (void)size; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __STM32HOST_H__
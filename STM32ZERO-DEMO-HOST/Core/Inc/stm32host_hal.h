@@ -0,0 +1,615 @@
+/**
+ * STM32ZERO Host HAL
+ *
+ * Stand-in for stm32h7xx_hal.h on the FreeRTOS POSIX port: the subset of
+ * the STM32H7 HAL used by the STM32ZERO library (sio, fdcan, ustim) with
+ * the same types, field names and constants, implemented over host
+ * resources in stm32host_hal.cpp:
+ *
+ *   UART    TX writes to the console fd, RX is read by a helper thread;
+ *           the console is stdin/stdout or a pty (--pty)
+ *   FDCAN   all started FDCAN instances share one in-process bus with
+ *           acceptance filters, RX FIFO 0/1, dedicated TX buffers and the
+ *           TX FIFO/queue; frames take their bit time at the configured
+ *           nominal/data timing (no stuff bits) and are timestamped at SOF,
+ *           internal loopback instances are a bus of their own; injected
+ *           errors set LEC/DLEC (kept until read) and raise PEA/PED
+ *           (error callback)
+ *   TIM     see stm32host.h
+ *
+ * Interrupts are simulated by the highest priority task ("HIRQ"), which
+ * runs every tick and right after a transfer is started: completions and
+ * received data are delivered through the HAL callbacks (weak or
+ * registered) with __get_IPSR() returning the exception number of the
+ * simulated interrupt, so FromISR paths run.
+ */
+
+#ifndef __STM32HOST_HAL_H__
+#define __STM32HOST_HAL_H__
+
+#include "stm32host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Common
+//=============================================================================
+
+#define HAL_MODULE_ENABLED
+#define HAL_UART_MODULE_ENABLED
+#define HAL_FDCAN_MODULE_ENABLED
+#define HAL_TIM_MODULE_ENABLED
+#define USE_HAL_FDCAN_REGISTER_CALLBACKS  1
+#define USE_HAL_UART_REGISTER_CALLBACKS   0
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+#define UNUSED(X)          (void)(X)
+
+typedef enum {
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U,
+} HAL_StatusTypeDef;
+
+typedef enum {
+	HAL_UNLOCKED = 0x00U,
+	HAL_LOCKED = 0x01U,
+} HAL_LockTypeDef;
+
+typedef enum {
+	DISABLE = 0U,
+	ENABLE = !DISABLE,
+} FunctionalState;
+
+typedef enum {
+	RESET = 0U,
+	SET = !RESET,
+} FlagStatus, ITStatus;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn);
+void HAL_NVIC_DisableIRQ(IRQn_Type irqn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type irqn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type irqn);
+
+#define RCC_PERIPHCLK_FDCAN  0x00008000U
+uint32_t HAL_RCCEx_GetPeriphCLKFreq(uint32_t periph);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+
+// Peripheral clocks are always on
+#define __HAL_RCC_TIM2_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM3_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM4_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM5_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM8_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM12_CLK_ENABLE()    do { } while (0)
+#define __HAL_RCC_USART3_CLK_ENABLE()   do { } while (0)
+#define __HAL_RCC_FDCAN_CLK_ENABLE()    do { } while (0)
+
+//=============================================================================
+// DMA
+//=============================================================================
+
+#define DMA_NORMAL                 0x00000000U
+#define DMA_CIRCULAR               0x00000100U
+
+#define DMA_IT_TC                  0x00000010U
+#define DMA_IT_HT                  0x00000008U
+
+typedef struct {
+	uint32_t Mode;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+	DMA_Stream_TypeDef* Instance;
+	DMA_InitTypeDef Init;
+	void* Parent;
+	__IO uint32_t State;
+	__IO uint32_t ErrorCode;
+	uint32_t HostDisabledITs;       // host: interrupts turned off by the driver
+} DMA_HandleTypeDef;
+
+// Remaining transfer count of the RX DMA (buffer position)
+#define __HAL_DMA_GET_COUNTER(h)       ((h)->Instance->NDTR)
+#define __HAL_DMA_DISABLE_IT(h, it)    ((h)->HostDisabledITs |= (it))
+#define __HAL_DMA_ENABLE_IT(h, it)     ((h)->HostDisabledITs &= ~(it))
+
+//=============================================================================
+// UART
+//=============================================================================
+
+typedef struct {
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+	uint32_t OneBitSampling;
+	uint32_t ClockPrescaler;
+} UART_InitTypeDef;
+
+typedef uint32_t HAL_UART_StateTypeDef;
+typedef uint32_t HAL_UART_RxTypeTypeDef;
+typedef uint32_t HAL_UART_RxEventTypeTypeDef;
+
+#define HAL_UART_STATE_RESET       0x00000000U
+#define HAL_UART_STATE_READY       0x00000020U
+#define HAL_UART_STATE_BUSY        0x00000024U
+#define HAL_UART_STATE_BUSY_TX     0x00000021U
+#define HAL_UART_STATE_BUSY_RX     0x00000022U
+
+#define HAL_UART_RECEPTION_STANDARD    0x00000000U
+#define HAL_UART_RECEPTION_TOIDLE      0x00000001U
+
+#define HAL_UART_RXEVENT_TC        0x00000000U
+#define HAL_UART_RXEVENT_HT        0x00000001U
+#define HAL_UART_RXEVENT_IDLE      0x00000002U
+
+#define HAL_UART_ERROR_NONE        0x00000000U
+
+typedef struct __UART_HandleTypeDef {
+	USART_TypeDef* Instance;
+	UART_InitTypeDef Init;
+	const uint8_t* pTxBuffPtr;
+	uint16_t TxXferSize;
+	__IO uint16_t TxXferCount;
+	uint8_t* pRxBuffPtr;
+	uint16_t RxXferSize;
+	__IO uint16_t RxXferCount;
+	__IO HAL_UART_RxTypeTypeDef ReceptionType;
+	__IO HAL_UART_RxEventTypeTypeDef RxEventType;
+	DMA_HandleTypeDef* hdmatx;
+	DMA_HandleTypeDef* hdmarx;
+	HAL_LockTypeDef Lock;
+	__IO HAL_UART_StateTypeDef gState;
+	__IO HAL_UART_StateTypeDef RxState;
+	__IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef* huart);
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart);
+HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(const UART_HandleTypeDef* huart);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t size);
+
+//=============================================================================
+// TIM
+//=============================================================================
+
+typedef struct {
+	uint32_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Period;
+	uint32_t ClockDivision;
+	uint32_t RepetitionCounter;
+	uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+	TIM_TypeDef* Instance;
+	TIM_Base_InitTypeDef Init;
+	__IO uint32_t State;
+} TIM_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim);
+
+//=============================================================================
+// FDCAN
+//=============================================================================
+
+typedef struct {
+	uint32_t FrameFormat;
+	uint32_t Mode;
+	FunctionalState AutoRetransmission;
+	FunctionalState TransmitPause;
+	FunctionalState ProtocolException;
+	uint32_t NominalPrescaler;
+	uint32_t NominalSyncJumpWidth;
+	uint32_t NominalTimeSeg1;
+	uint32_t NominalTimeSeg2;
+	uint32_t DataPrescaler;
+	uint32_t DataSyncJumpWidth;
+	uint32_t DataTimeSeg1;
+	uint32_t DataTimeSeg2;
+	uint32_t MessageRAMOffset;
+	uint32_t StdFiltersNbr;
+	uint32_t ExtFiltersNbr;
+	uint32_t RxFifo0ElmtsNbr;
+	uint32_t RxFifo0ElmtSize;
+	uint32_t RxFifo1ElmtsNbr;
+	uint32_t RxFifo1ElmtSize;
+	uint32_t RxBuffersNbr;
+	uint32_t RxBufferSize;
+	uint32_t TxEventsNbr;
+	uint32_t TxBuffersNbr;
+	uint32_t TxFifoQueueElmtsNbr;
+	uint32_t TxFifoQueueMode;
+	uint32_t TxElmtSize;
+} FDCAN_InitTypeDef;
+
+typedef struct {
+	uint32_t IdType;
+	uint32_t FilterIndex;
+	uint32_t FilterType;
+	uint32_t FilterConfig;
+	uint32_t FilterID1;
+	uint32_t FilterID2;
+	uint32_t RxBufferIndex;
+	uint32_t IsCalibrationMsg;
+} FDCAN_FilterTypeDef;
+
+typedef struct {
+	uint32_t Identifier;
+	uint32_t IdType;
+	uint32_t TxFrameType;
+	uint32_t DataLength;
+	uint32_t ErrorStateIndicator;
+	uint32_t BitRateSwitch;
+	uint32_t FDFormat;
+	uint32_t TxEventFifoControl;
+	uint32_t MessageMarker;
+} FDCAN_TxHeaderTypeDef;
+
+typedef struct {
+	uint32_t Identifier;
+	uint32_t IdType;
+	uint32_t RxFrameType;
+	uint32_t DataLength;
+	uint32_t ErrorStateIndicator;
+	uint32_t BitRateSwitch;
+	uint32_t FDFormat;
+	uint32_t RxTimestamp;
+	uint32_t FilterIndex;
+	uint32_t IsFilterMatchingFrame;
+} FDCAN_RxHeaderTypeDef;
+
+typedef struct {
+	uint32_t Identifier;
+	uint32_t IdType;
+	uint32_t TxFrameType;
+	uint32_t DataLength;
+	uint32_t ErrorStateIndicator;
+	uint32_t BitRateSwitch;
+	uint32_t FDFormat;
+	uint32_t TxTimestamp;
+	uint32_t MessageMarker;
+	uint32_t EventType;
+} FDCAN_TxEventFifoTypeDef;
+
+typedef struct {
+	uint32_t LastErrorCode;
+	uint32_t DataLastErrorCode;
+	uint32_t Activity;
+	uint32_t ErrorPassive;
+	uint32_t Warning;
+	uint32_t BusOff;
+	uint32_t RxESIflag;
+	uint32_t RxBRSflag;
+	uint32_t RxFDFflag;
+	uint32_t ProtocolException;
+	uint32_t TDCvalue;
+} FDCAN_ProtocolStatusTypeDef;
+
+typedef struct {
+	uint32_t TxErrorCnt;
+	uint32_t RxErrorCnt;
+	uint32_t RxErrorPassive;
+	uint32_t ErrorLogging;
+} FDCAN_ErrorCountersTypeDef;
+
+typedef enum {
+	HAL_FDCAN_STATE_RESET = 0x00U,
+	HAL_FDCAN_STATE_READY = 0x01U,
+	HAL_FDCAN_STATE_BUSY = 0x02U,
+	HAL_FDCAN_STATE_ERROR = 0x03U,
+} HAL_FDCAN_StateTypeDef;
+
+typedef struct __FDCAN_HandleTypeDef {
+	FDCAN_GlobalTypeDef* Instance;
+	FDCAN_InitTypeDef Init;
+	uint32_t LatestTxFifoQRequest;
+	__IO HAL_FDCAN_StateTypeDef State;
+	HAL_LockTypeDef Lock;
+	__IO uint32_t ErrorCode;
+	void (*TxEventFifoCallback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t TxEventFifoITs);
+	void (*RxFifo0Callback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo0ITs);
+	void (*RxFifo1Callback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo1ITs);
+	void (*TxFifoEmptyCallback)(struct __FDCAN_HandleTypeDef* hfdcan);
+	void (*TxBufferCompleteCallback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+	void (*TxBufferAbortCallback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+	void (*RxBufferNewMessageCallback)(struct __FDCAN_HandleTypeDef* hfdcan);
+	void (*ErrorCallback)(struct __FDCAN_HandleTypeDef* hfdcan);
+	void (*ErrorStatusCallback)(struct __FDCAN_HandleTypeDef* hfdcan, uint32_t ErrorStatusITs);
+} FDCAN_HandleTypeDef;
+
+typedef void (*pFDCAN_TxEventFifoCallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t TxEventFifoITs);
+typedef void (*pFDCAN_RxFifo0CallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo0ITs);
+typedef void (*pFDCAN_RxFifo1CallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo1ITs);
+typedef void (*pFDCAN_TxBufferCompleteCallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+typedef void (*pFDCAN_TxBufferAbortCallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+typedef void (*pFDCAN_ErrorStatusCallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan, uint32_t ErrorStatusITs);
+typedef void (*pFDCAN_CallbackTypeDef)(FDCAN_HandleTypeDef* hfdcan);
+
+typedef enum {
+	HAL_FDCAN_TX_FIFO_EMPTY_CB_ID = 0x00U,
+	HAL_FDCAN_RX_BUFFER_NEW_MSG_CB_ID = 0x01U,
+	HAL_FDCAN_ERROR_CALLBACK_CB_ID = 0x05U,
+} HAL_FDCAN_CallbackIDTypeDef;
+
+#define FDCAN_FRAME_CLASSIC            0x00000000U
+#define FDCAN_FRAME_FD_NO_BRS          FDCAN_CCCR_FDOE
+#define FDCAN_FRAME_FD_BRS             (FDCAN_CCCR_FDOE | FDCAN_CCCR_BRSE)
+
+#define FDCAN_MODE_NORMAL              0x00000000U
+#define FDCAN_MODE_RESTRICTED_OPERATION 0x00000001U
+#define FDCAN_MODE_BUS_MONITORING      0x00000002U
+#define FDCAN_MODE_INTERNAL_LOOPBACK   0x00000003U
+#define FDCAN_MODE_EXTERNAL_LOOPBACK   0x00000004U
+
+#define FDCAN_DATA_BYTES_8             0x00000004U
+#define FDCAN_DATA_BYTES_12            0x00000005U
+#define FDCAN_DATA_BYTES_16            0x00000006U
+#define FDCAN_DATA_BYTES_20            0x00000007U
+#define FDCAN_DATA_BYTES_24            0x00000008U
+#define FDCAN_DATA_BYTES_32            0x0000000AU
+#define FDCAN_DATA_BYTES_48            0x0000000EU
+#define FDCAN_DATA_BYTES_64            0x00000012U
+
+#define FDCAN_TX_FIFO_OPERATION        0x00000000U
+#define FDCAN_TX_QUEUE_OPERATION       FDCAN_TXBC_TFQM
+
+#define FDCAN_STANDARD_ID              0x00000000U
+#define FDCAN_EXTENDED_ID              0x40000000U
+#define FDCAN_DATA_FRAME               0x00000000U
+#define FDCAN_REMOTE_FRAME             0x20000000U
+
+#define FDCAN_DLC_BYTES_0              0x00000000U
+#define FDCAN_DLC_BYTES_1              0x00000001U
+#define FDCAN_DLC_BYTES_2              0x00000002U
+#define FDCAN_DLC_BYTES_3              0x00000003U
+#define FDCAN_DLC_BYTES_4              0x00000004U
+#define FDCAN_DLC_BYTES_5              0x00000005U
+#define FDCAN_DLC_BYTES_6              0x00000006U
+#define FDCAN_DLC_BYTES_7              0x00000007U
+#define FDCAN_DLC_BYTES_8              0x00000008U
+#define FDCAN_DLC_BYTES_12             0x00000009U
+#define FDCAN_DLC_BYTES_16             0x0000000AU
+#define FDCAN_DLC_BYTES_20             0x0000000BU
+#define FDCAN_DLC_BYTES_24             0x0000000CU
+#define FDCAN_DLC_BYTES_32             0x0000000DU
+#define FDCAN_DLC_BYTES_48             0x0000000EU
+#define FDCAN_DLC_BYTES_64             0x0000000FU
+
+#define FDCAN_ESI_ACTIVE               0x00000000U
+#define FDCAN_ESI_PASSIVE              0x80000000U
+#define FDCAN_BRS_OFF                  0x00000000U
+#define FDCAN_BRS_ON                   0x00100000U
+#define FDCAN_CLASSIC_CAN              0x00000000U
+#define FDCAN_FD_CAN                   0x00200000U
+#define FDCAN_NO_TX_EVENTS             0x00000000U
+#define FDCAN_STORE_TX_EVENTS          0x00800000U
+
+#define FDCAN_FILTER_RANGE             0x00000000U
+#define FDCAN_FILTER_DUAL              0x00000001U
+#define FDCAN_FILTER_MASK              0x00000002U
+#define FDCAN_FILTER_RANGE_NO_EIDM     0x00000003U
+
+#define FDCAN_FILTER_DISABLE           0x00000000U
+#define FDCAN_FILTER_TO_RXFIFO0        0x00000001U
+#define FDCAN_FILTER_TO_RXFIFO1        0x00000002U
+#define FDCAN_FILTER_REJECT            0x00000003U
+#define FDCAN_FILTER_HP                0x00000004U
+#define FDCAN_FILTER_TO_RXFIFO0_HP     0x00000005U
+#define FDCAN_FILTER_TO_RXFIFO1_HP     0x00000006U
+#define FDCAN_FILTER_TO_RXBUFFER       0x00000007U
+
+#define FDCAN_RX_FIFO0                 0x00000040U
+#define FDCAN_RX_FIFO1                 0x00000041U
+#define FDCAN_RX_BUFFER0               0x00000000U
+
+#define FDCAN_RX_FIFO_BLOCKING         0x00000000U
+#define FDCAN_RX_FIFO_OVERWRITE        0x00000080U
+
+#define FDCAN_ACCEPT_IN_RX_FIFO0       0x00000000U
+#define FDCAN_ACCEPT_IN_RX_FIFO1       0x00000001U
+#define FDCAN_REJECT                   0x00000002U
+#define FDCAN_FILTER_REMOTE            0x00000000U
+#define FDCAN_REJECT_REMOTE            0x00000001U
+
+#define FDCAN_INTERRUPT_LINE0          0x00000001U
+#define FDCAN_INTERRUPT_LINE1          0x00000002U
+
+#define FDCAN_TIMESTAMP_INTERNAL       0x00000001U
+#define FDCAN_TIMESTAMP_EXTERNAL       0x00000002U
+#define FDCAN_TIMESTAMP_PRESC_1        0x00000000U
+
+#define FDCAN_PROTOCOL_ERROR_NONE      0x00000000U
+#define FDCAN_PROTOCOL_ERROR_STUFF     0x00000001U
+#define FDCAN_PROTOCOL_ERROR_FORM      0x00000002U
+#define FDCAN_PROTOCOL_ERROR_ACK       0x00000003U
+#define FDCAN_PROTOCOL_ERROR_BIT1      0x00000004U
+#define FDCAN_PROTOCOL_ERROR_BIT0      0x00000005U
+#define FDCAN_PROTOCOL_ERROR_CRC       0x00000006U
+#define FDCAN_PROTOCOL_ERROR_NO_CHANGE 0x00000007U
+
+#define FDCAN_COM_STATE_SYNC           0x00000000U
+#define FDCAN_COM_STATE_IDLE           0x00000008U
+#define FDCAN_COM_STATE_RX             0x00000010U
+#define FDCAN_COM_STATE_TX             0x00000018U
+
+#define FDCAN_IT_RX_FIFO0_NEW_MESSAGE  (1UL << 0)
+#define FDCAN_IT_RX_FIFO0_FULL         (1UL << 2)
+#define FDCAN_IT_RX_FIFO0_MESSAGE_LOST (1UL << 3)
+#define FDCAN_IT_RX_FIFO1_NEW_MESSAGE  (1UL << 4)
+#define FDCAN_IT_RX_FIFO1_FULL         (1UL << 6)
+#define FDCAN_IT_RX_FIFO1_MESSAGE_LOST (1UL << 7)
+#define FDCAN_IT_TX_COMPLETE           (1UL << 9)
+#define FDCAN_IT_TX_ABORT_COMPLETE     (1UL << 10)
+#define FDCAN_IT_TX_FIFO_EMPTY         (1UL << 11)
+#define FDCAN_IT_TX_EVT_FIFO_NEW_DATA  (1UL << 12)
+#define FDCAN_IT_TX_EVT_FIFO_ELT_LOST  (1UL << 15)
+#define FDCAN_IT_RX_BUFFER_NEW_MESSAGE (1UL << 19)
+#define FDCAN_IT_ERROR_LOGGING_OVERFLOW (1UL << 22)
+#define FDCAN_IT_ERROR_PASSIVE         (1UL << 23)
+#define FDCAN_IT_ERROR_WARNING         (1UL << 24)
+#define FDCAN_IT_BUS_OFF               (1UL << 25)
+#define FDCAN_IT_ARB_PROTOCOL_ERROR    (1UL << 27)
+#define FDCAN_IT_DATA_PROTOCOL_ERROR   (1UL << 28)
+
+#define FDCAN_FLAG_RX_FIFO0_NEW_MESSAGE FDCAN_IT_RX_FIFO0_NEW_MESSAGE
+#define FDCAN_FLAG_RX_FIFO1_NEW_MESSAGE FDCAN_IT_RX_FIFO1_NEW_MESSAGE
+#define FDCAN_FLAG_TX_COMPLETE          FDCAN_IT_TX_COMPLETE
+#define FDCAN_FLAG_BUS_OFF              FDCAN_IT_BUS_OFF
+
+#define FDCAN_TX_BUFFER0               0x00000001U
+#define FDCAN_TX_BUFFER1               0x00000002U
+#define FDCAN_TX_BUFFER2               0x00000004U
+#define FDCAN_TX_BUFFER3               0x00000008U
+#define FDCAN_TX_BUFFER4               0x00000010U
+#define FDCAN_TX_BUFFER5               0x00000020U
+#define FDCAN_TX_BUFFER6               0x00000040U
+#define FDCAN_TX_BUFFER7               0x00000080U
+#define FDCAN_TX_BUFFER8               0x00000100U
+#define FDCAN_TX_BUFFER9               0x00000200U
+#define FDCAN_TX_BUFFER10              0x00000400U
+#define FDCAN_TX_BUFFER11              0x00000800U
+#define FDCAN_TX_BUFFER12              0x00001000U
+#define FDCAN_TX_BUFFER13              0x00002000U
+#define FDCAN_TX_BUFFER14              0x00004000U
+#define FDCAN_TX_BUFFER15              0x00008000U
+#define FDCAN_TX_BUFFER16              0x00010000U
+#define FDCAN_TX_BUFFER17              0x00020000U
+#define FDCAN_TX_BUFFER18              0x00040000U
+#define FDCAN_TX_BUFFER19              0x00080000U
+#define FDCAN_TX_BUFFER20              0x00100000U
+#define FDCAN_TX_BUFFER21              0x00200000U
+#define FDCAN_TX_BUFFER22              0x00400000U
+#define FDCAN_TX_BUFFER23              0x00800000U
+#define FDCAN_TX_BUFFER24              0x01000000U
+#define FDCAN_TX_BUFFER25              0x02000000U
+#define FDCAN_TX_BUFFER26              0x04000000U
+#define FDCAN_TX_BUFFER27              0x08000000U
+#define FDCAN_TX_BUFFER28              0x10000000U
+#define FDCAN_TX_BUFFER29              0x20000000U
+#define FDCAN_TX_BUFFER30              0x40000000U
+#define FDCAN_TX_BUFFER31              0x80000000U
+
+#define HAL_FDCAN_ERROR_NONE           0x00000000U
+#define HAL_FDCAN_ERROR_NOT_READY      0x00000004U
+#define HAL_FDCAN_ERROR_NOT_STARTED    0x00000008U
+#define HAL_FDCAN_ERROR_NOT_SUPPORTED  0x00000010U
+#define HAL_FDCAN_ERROR_PARAM          0x00000020U
+#define HAL_FDCAN_ERROR_PENDING        0x00000040U
+#define HAL_FDCAN_ERROR_FIFO_EMPTY     0x00000100U
+#define HAL_FDCAN_ERROR_FIFO_FULL      0x00000200U
+#define HAL_FDCAN_ERROR_PROTOCOL_ARBT  FDCAN_IT_ARB_PROTOCOL_ERROR
+#define HAL_FDCAN_ERROR_PROTOCOL_DATA  FDCAN_IT_DATA_PROTOCOL_ERROR
+
+HAL_StatusTypeDef HAL_FDCAN_Init(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_DeInit(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_ConfigFilter(FDCAN_HandleTypeDef* hfdcan, const FDCAN_FilterTypeDef* filter);
+HAL_StatusTypeDef HAL_FDCAN_ConfigGlobalFilter(FDCAN_HandleTypeDef* hfdcan, uint32_t non_matching_std,
+					       uint32_t non_matching_ext, uint32_t reject_remote_std,
+					       uint32_t reject_remote_ext);
+HAL_StatusTypeDef HAL_FDCAN_ConfigExtendedIdMask(FDCAN_HandleTypeDef* hfdcan, uint32_t mask);
+HAL_StatusTypeDef HAL_FDCAN_ConfigRxFifoOverwrite(FDCAN_HandleTypeDef* hfdcan, uint32_t fifo, uint32_t mode);
+HAL_StatusTypeDef HAL_FDCAN_ConfigInterruptLines(FDCAN_HandleTypeDef* hfdcan, uint32_t its, uint32_t line);
+HAL_StatusTypeDef HAL_FDCAN_ConfigTimestampCounter(FDCAN_HandleTypeDef* hfdcan, uint32_t prescaler);
+HAL_StatusTypeDef HAL_FDCAN_EnableTimestampCounter(FDCAN_HandleTypeDef* hfdcan, uint32_t operation);
+uint16_t HAL_FDCAN_GetTimestampCounter(const FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_ConfigTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan, uint32_t offset, uint32_t filter);
+HAL_StatusTypeDef HAL_FDCAN_EnableTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_DisableTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_Start(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_Stop(FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxFifoQ(FDCAN_HandleTypeDef* hfdcan, const FDCAN_TxHeaderTypeDef* header,
+						const uint8_t* data);
+HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxBuffer(FDCAN_HandleTypeDef* hfdcan, const FDCAN_TxHeaderTypeDef* header,
+						 const uint8_t* data, uint32_t buffer_index);
+HAL_StatusTypeDef HAL_FDCAN_EnableTxBufferRequest(FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index);
+uint32_t HAL_FDCAN_GetLatestTxFifoQRequestBuffer(const FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_AbortTxRequest(FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index);
+HAL_StatusTypeDef HAL_FDCAN_GetRxMessage(FDCAN_HandleTypeDef* hfdcan, uint32_t location,
+					 FDCAN_RxHeaderTypeDef* header, uint8_t* data);
+HAL_StatusTypeDef HAL_FDCAN_GetTxEvent(FDCAN_HandleTypeDef* hfdcan, FDCAN_TxEventFifoTypeDef* event);
+HAL_StatusTypeDef HAL_FDCAN_GetProtocolStatus(const FDCAN_HandleTypeDef* hfdcan, FDCAN_ProtocolStatusTypeDef* status);
+HAL_StatusTypeDef HAL_FDCAN_GetErrorCounters(const FDCAN_HandleTypeDef* hfdcan, FDCAN_ErrorCountersTypeDef* counters);
+uint32_t HAL_FDCAN_IsRxBufferMessageAvailable(FDCAN_HandleTypeDef* hfdcan, uint32_t index);
+uint32_t HAL_FDCAN_IsTxBufferMessagePending(const FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index);
+uint32_t HAL_FDCAN_GetRxFifoFillLevel(const FDCAN_HandleTypeDef* hfdcan, uint32_t fifo);
+uint32_t HAL_FDCAN_GetTxFifoFreeLevel(const FDCAN_HandleTypeDef* hfdcan);
+HAL_StatusTypeDef HAL_FDCAN_ActivateNotification(FDCAN_HandleTypeDef* hfdcan, uint32_t its, uint32_t buffer_indexes);
+HAL_StatusTypeDef HAL_FDCAN_DeactivateNotification(FDCAN_HandleTypeDef* hfdcan, uint32_t its);
+void HAL_FDCAN_IRQHandler(FDCAN_HandleTypeDef* hfdcan);
+HAL_FDCAN_StateTypeDef HAL_FDCAN_GetState(const FDCAN_HandleTypeDef* hfdcan);
+uint32_t HAL_FDCAN_GetError(const FDCAN_HandleTypeDef* hfdcan);
+
+HAL_StatusTypeDef HAL_FDCAN_RegisterCallback(FDCAN_HandleTypeDef* hfdcan, HAL_FDCAN_CallbackIDTypeDef id,
+					     pFDCAN_CallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterTxEventFifoCallback(FDCAN_HandleTypeDef* hfdcan,
+							pFDCAN_TxEventFifoCallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterRxFifo0Callback(FDCAN_HandleTypeDef* hfdcan, pFDCAN_RxFifo0CallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterRxFifo1Callback(FDCAN_HandleTypeDef* hfdcan, pFDCAN_RxFifo1CallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterTxBufferCompleteCallback(FDCAN_HandleTypeDef* hfdcan,
+							     pFDCAN_TxBufferCompleteCallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterTxBufferAbortCallback(FDCAN_HandleTypeDef* hfdcan,
+							  pFDCAN_TxBufferAbortCallbackTypeDef callback);
+HAL_StatusTypeDef HAL_FDCAN_RegisterErrorStatusCallback(FDCAN_HandleTypeDef* hfdcan,
+							pFDCAN_ErrorStatusCallbackTypeDef callback);
+
+void HAL_FDCAN_TxEventFifoCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t TxEventFifoITs);
+void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo0ITs);
+void HAL_FDCAN_RxFifo1Callback(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo1ITs);
+void HAL_FDCAN_TxFifoEmptyCallback(FDCAN_HandleTypeDef* hfdcan);
+void HAL_FDCAN_TxBufferCompleteCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+void HAL_FDCAN_TxBufferAbortCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes);
+void HAL_FDCAN_RxBufferNewMessageCallback(FDCAN_HandleTypeDef* hfdcan);
+void HAL_FDCAN_ErrorCallback(FDCAN_HandleTypeDef* hfdcan);
+void HAL_FDCAN_ErrorStatusCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t ErrorStatusITs);
+
+//=============================================================================
+// Host Control (stm32host_hal.cpp)
+//=============================================================================
+
+// Console for USART3: stdin/stdout, or a new pty whose name is printed
+void host_console_open(bool use_pty);
+
+// True when the console is a pty (a terminal may attach at any time)
+bool host_console_interactive(void);
+
+// Create the interrupt task (before the scheduler starts)
+void host_irq_init(void);
+
+// Inject a bus error on an FDCAN instance (error counters, bus-off)
+void host_fdcan_inject_error(FDCAN_HandleTypeDef* hfdcan, uint32_t tec, uint32_t rec, bool bus_off);
+
+// Destroy the next count frames an FDCAN instance transmits with an error
+// frame: LEC lec (FDCAN_PROTOCOL_ERROR_*) on the sender and, except for
+// ACK errors, on the receivers; TEC/REC and retransmission as on the bus
+void host_fdcan_inject_tx_errors(FDCAN_HandleTypeDef* hfdcan, uint32_t count, uint32_t lec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __STM32HOST_HAL_H__
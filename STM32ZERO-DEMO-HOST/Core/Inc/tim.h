@@ -0,0 +1,27 @@
+/**
+ * STM32ZERO Host Timer Handles
+ */
+
+#ifndef __TIM_H__
+#define __TIM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
+extern TIM_HandleTypeDef htim5;
+extern TIM_HandleTypeDef htim8;
+extern TIM_HandleTypeDef htim12;
+
+void MX_TIM_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TIM_H__
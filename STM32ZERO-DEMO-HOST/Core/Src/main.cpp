@@ -0,0 +1,221 @@
+/**
+ * STM32ZERO Host Main
+ *
+ * Peripheral handles and init functions as generated by CubeMX for the
+ * NUCLEO-H753ZI (usart.c, fdcan.c, tim.c), then the same app_init() as
+ * the board projects.
+ *
+ *   stm32zero-demo-host          console on stdin/stdout, exits after the
+ *                                test summary with the fail count
+ *   stm32zero-demo-host --pty    console on a new pty (name on stderr),
+ *                                keeps running for the interactive tests
+ */
+
+#include "main.h"
+#include "usart.h"
+#include "fdcan.h"
+#include "tim.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+extern __NO_RETURN void app_init(void);
+
+UART_HandleTypeDef huart3;
+DMA_HandleTypeDef hdma_usart3_tx;
+DMA_HandleTypeDef hdma_usart3_rx;
+FDCAN_HandleTypeDef hfdcan1;
+FDCAN_HandleTypeDef hfdcan2;
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim4;
+TIM_HandleTypeDef htim5;
+TIM_HandleTypeDef htim8;
+TIM_HandleTypeDef htim12;
+
+static DMA_Stream_TypeDef dma2_stream6_;
+static DMA_Stream_TypeDef dma2_stream7_;
+
+//=============================================================================
+// Peripheral Init (CubeMX values)
+//=============================================================================
+
+static void tim_init_(TIM_HandleTypeDef* htim, TIM_TypeDef* instance, uint32_t period)
+{
+	htim->Instance = instance;
+	htim->Init.Prescaler = 0;
+	htim->Init.CounterMode = 0;
+	htim->Init.Period = period;
+	htim->Init.ClockDivision = 0;
+	htim->Init.AutoReloadPreload = 0;
+	instance->ARR = period;
+}
+
+extern "C" void MX_TIM_Init(void)
+{
+	tim_init_(&htim2, TIM2, 4294967295U);
+	tim_init_(&htim3, TIM3, 65535U);
+	tim_init_(&htim4, TIM4, 65535U);
+	tim_init_(&htim5, TIM5, 4294967295U);
+	tim_init_(&htim8, TIM8, 65535U);
+	tim_init_(&htim12, TIM12, 65535U);
+}
+
+extern "C" void MX_USART3_UART_Init(void)
+{
+	hdma_usart3_tx.Instance = &dma2_stream7_;
+	hdma_usart3_tx.Init.Mode = DMA_NORMAL;
+	hdma_usart3_tx.Parent = &huart3;
+	hdma_usart3_rx.Instance = &dma2_stream6_;
+	hdma_usart3_rx.Init.Mode = DMA_NORMAL;
+	hdma_usart3_rx.Parent = &huart3;
+
+	huart3.Instance = USART3;
+	huart3.Init.BaudRate = 115200;
+	huart3.hdmatx = &hdma_usart3_tx;
+	huart3.hdmarx = &hdma_usart3_rx;
+	if (HAL_UART_Init(&huart3) != HAL_OK) {
+		Error_Handler();
+	}
+
+	HAL_NVIC_SetPriority(USART3_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(USART3_IRQn);
+}
+
+extern "C" void MX_FDCAN1_Init(void)
+{
+	hfdcan1.Instance = FDCAN1;
+	hfdcan1.Init.FrameFormat = FDCAN_FRAME_FD_BRS;
+	hfdcan1.Init.Mode = FDCAN_MODE_NORMAL;
+	hfdcan1.Init.AutoRetransmission = ENABLE;
+	hfdcan1.Init.TransmitPause = DISABLE;
+	hfdcan1.Init.ProtocolException = DISABLE;
+	hfdcan1.Init.NominalPrescaler = 2;
+	hfdcan1.Init.NominalSyncJumpWidth = 1;
+	hfdcan1.Init.NominalTimeSeg1 = 14;
+	hfdcan1.Init.NominalTimeSeg2 = 5;
+	hfdcan1.Init.DataPrescaler = 2;
+	hfdcan1.Init.DataSyncJumpWidth = 1;
+	hfdcan1.Init.DataTimeSeg1 = 14;
+	hfdcan1.Init.DataTimeSeg2 = 5;
+	hfdcan1.Init.MessageRAMOffset = 0;
+	hfdcan1.Init.StdFiltersNbr = 8;
+	hfdcan1.Init.ExtFiltersNbr = 4;
+	hfdcan1.Init.RxFifo0ElmtsNbr = 8;
+	hfdcan1.Init.RxFifo0ElmtSize = FDCAN_DATA_BYTES_64;
+	hfdcan1.Init.RxFifo1ElmtsNbr = 8;
+	hfdcan1.Init.RxFifo1ElmtSize = FDCAN_DATA_BYTES_64;
+	hfdcan1.Init.RxBuffersNbr = 4;
+	hfdcan1.Init.RxBufferSize = FDCAN_DATA_BYTES_64;
+	hfdcan1.Init.TxEventsNbr = 16;
+	hfdcan1.Init.TxBuffersNbr = 16;
+	hfdcan1.Init.TxFifoQueueElmtsNbr = 16;
+	hfdcan1.Init.TxFifoQueueMode = FDCAN_TX_FIFO_OPERATION;
+	hfdcan1.Init.TxElmtSize = FDCAN_DATA_BYTES_64;
+	if (HAL_FDCAN_Init(&hfdcan1) != HAL_OK) {
+		Error_Handler();
+	}
+
+	HAL_NVIC_SetPriority(FDCAN1_IT0_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(FDCAN1_IT0_IRQn);
+	HAL_NVIC_SetPriority(FDCAN1_IT1_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(FDCAN1_IT1_IRQn);
+}
+
+extern "C" void MX_FDCAN2_Init(void)
+{
+	hfdcan2.Instance = FDCAN2;
+	hfdcan2.Init.FrameFormat = FDCAN_FRAME_FD_BRS;
+	hfdcan2.Init.Mode = FDCAN_MODE_NORMAL;
+	hfdcan2.Init.AutoRetransmission = ENABLE;
+	hfdcan2.Init.TransmitPause = DISABLE;
+	hfdcan2.Init.ProtocolException = DISABLE;
+	hfdcan2.Init.NominalPrescaler = 2;
+	hfdcan2.Init.NominalSyncJumpWidth = 1;
+	hfdcan2.Init.NominalTimeSeg1 = 14;
+	hfdcan2.Init.NominalTimeSeg2 = 5;
+	hfdcan2.Init.DataPrescaler = 2;
+	hfdcan2.Init.DataSyncJumpWidth = 1;
+	hfdcan2.Init.DataTimeSeg1 = 14;
+	hfdcan2.Init.DataTimeSeg2 = 5;
+	hfdcan2.Init.MessageRAMOffset = 1280;
+	hfdcan2.Init.StdFiltersNbr = 8;
+	hfdcan2.Init.ExtFiltersNbr = 4;
+	hfdcan2.Init.RxFifo0ElmtsNbr = 8;
+	hfdcan2.Init.RxFifo0ElmtSize = FDCAN_DATA_BYTES_64;
+	hfdcan2.Init.RxFifo1ElmtsNbr = 8;
+	hfdcan2.Init.RxFifo1ElmtSize = FDCAN_DATA_BYTES_64;
+	hfdcan2.Init.RxBuffersNbr = 0;
+	hfdcan2.Init.RxBufferSize = FDCAN_DATA_BYTES_64;
+	hfdcan2.Init.TxEventsNbr = 0;
+	hfdcan2.Init.TxBuffersNbr = 0;
+	hfdcan2.Init.TxFifoQueueElmtsNbr = 16;
+	hfdcan2.Init.TxFifoQueueMode = FDCAN_TX_FIFO_OPERATION;
+	hfdcan2.Init.TxElmtSize = FDCAN_DATA_BYTES_64;
+	if (HAL_FDCAN_Init(&hfdcan2) != HAL_OK) {
+		Error_Handler();
+	}
+
+	HAL_NVIC_SetPriority(FDCAN2_IT0_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(FDCAN2_IT0_IRQn);
+	HAL_NVIC_SetPriority(FDCAN2_IT1_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(FDCAN2_IT1_IRQn);
+}
+
+//=============================================================================
+// Errors / Test Completion
+//=============================================================================
+
+extern "C" void Error_Handler(void)
+{
+	fprintf(stderr, "stm32zero-host: Error_Handler()\n");
+	abort();
+}
+
+extern "C" void vAssertCalled(const char* file, unsigned long line)
+{
+	fprintf(stderr, "stm32zero-host: assert %s:%lu\n", file, line);
+	abort();
+}
+
+extern "C" void stm32zero_host_tests_done(uint32_t failed)
+{
+	if (host_console_interactive()) {
+		return;
+	}
+	vTaskDelay(pdMS_TO_TICKS(100));         // let sio drain the summary
+	exit(failed == 0U ? 0 : 1);
+}
+
+//=============================================================================
+// Main
+//=============================================================================
+
+int main(int argc, char* argv[])
+{
+	bool use_pty = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--pty") == 0) {
+			use_pty = true;
+		} else {
+			fprintf(stderr, "usage: %s [--pty]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// printf() bypasses sio on the host; unbuffered keeps the order
+	setvbuf(stdout, nullptr, _IONBF, 0);
+	host_console_open(use_pty);
+
+	MX_TIM_Init();
+	MX_USART3_UART_Init();
+	MX_FDCAN1_Init();
+	MX_FDCAN2_Init();
+
+	host_irq_init();
+	app_init();
+}
@@ -0,0 +1,2261 @@
+/**
+ * STM32ZERO Host HAL
+ *
+ * Simulation behind stm32host.h and stm32host_hal.h. All peripheral state
+ * is touched from FreeRTOS tasks only (the POSIX port runs one task thread
+ * at a time); the console reader thread fills a lock-free ring and never
+ * calls into FreeRTOS. Task-side calls take a critical section so the
+ * interrupt task cannot run in the middle of one.
+ *
+ * The interrupt task (HIRQ, highest priority) wakes every tick, or right
+ * away when a task starts something that completes in an interrupt (UART
+ * TX, TIM event generation, FDCAN TX request, NVIC_SetPendingIRQ). It
+ * samples the timers, the console ring and the FDCAN bus, then calls the
+ * handlers of the pending enabled interrupts in NVIC priority order with
+ * __get_IPSR() returning their exception number.
+ */
+
+#include "main.h"
+#include "usart.h"
+#include "fdcan.h"
+#include "stm32zero-conf.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <termios.h>
+#include <unistd.h>
+
+// termios output delay flags collide with the USART / TIM register names
+#undef CR1
+#undef CR2
+#undef CR3
+
+//=============================================================================
+// Device Globals
+//=============================================================================
+
+uint32_t SystemCoreClock = 480000000UL;
+
+__thread uint32_t host_exclusive_value;
+
+#define HOST_TIM_REGS(n) \
+	{ 0, 0, 0, 0, { n, HOST_REG_SR }, { n, HOST_REG_EGR }, 0, 0, 0, { n, HOST_REG_CNT } }
+
+TIM_TypeDef host_tim2 = HOST_TIM_REGS(2);
+TIM_TypeDef host_tim3 = HOST_TIM_REGS(3);
+TIM_TypeDef host_tim4 = HOST_TIM_REGS(4);
+TIM_TypeDef host_tim5 = HOST_TIM_REGS(5);
+TIM_TypeDef host_tim8 = HOST_TIM_REGS(8);
+TIM_TypeDef host_tim12 = HOST_TIM_REGS(12);
+USART_TypeDef host_usart3;
+FDCAN_GlobalTypeDef host_fdcan1;
+FDCAN_GlobalTypeDef host_fdcan2;
+DWT_Type host_dwt = { 0, { HOST_REG_OWNER_DWT, HOST_REG_CYCCNT } };
+CoreDebug_Type host_core_debug;
+
+// Interrupt handlers (stm32host_it.cpp, or the library for the timers)
+extern "C" {
+__attribute__((weak)) void TIM2_IRQHandler(void);
+__attribute__((weak)) void TIM3_IRQHandler(void);
+__attribute__((weak)) void TIM4_IRQHandler(void);
+__attribute__((weak)) void TIM5_IRQHandler(void);
+__attribute__((weak)) void TIM8_BRK_TIM12_IRQHandler(void);
+__attribute__((weak)) void USART3_IRQHandler(void);
+__attribute__((weak)) void FDCAN1_IT0_IRQHandler(void);
+__attribute__((weak)) void FDCAN2_IT0_IRQHandler(void);
+__attribute__((weak)) void FDCAN1_IT1_IRQHandler(void);
+__attribute__((weak)) void FDCAN2_IT1_IRQHandler(void);
+}
+
+namespace {
+
+//=============================================================================
+// Time Base
+//=============================================================================
+
+uint64_t mono_ns_()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+const uint64_t epoch_ns_ = mono_ns_();
+
+inline uint64_t now_ns_()
+{
+	return mono_ns_() - epoch_ns_;
+}
+
+inline uint64_t now_us_()
+{
+	return now_ns_() / 1000U;
+}
+
+class Lock {
+public:
+	Lock() { portENTER_CRITICAL(); }
+	~Lock() { portEXIT_CRITICAL(); }
+
+	Lock(const Lock&) = delete;
+	Lock& operator=(const Lock&) = delete;
+};
+
+//=============================================================================
+// NVIC / Interrupt Task
+//=============================================================================
+
+struct IrqLine {
+	bool enabled;
+	bool pending;
+	uint8_t priority;
+};
+
+IrqLine irqs_[HOST_IRQn_COUNT];
+
+TaskHandle_t irq_task_ = nullptr;
+StaticTask_t irq_tcb_;
+StackType_t irq_stack_[1024];
+
+thread_local uint32_t ipsr_ = 0;        // set in the interrupt task only
+thread_local bool primask_ = false;
+
+using Handler = void (*)(void);
+
+Handler handler_(int irqn)
+{
+	switch (irqn) {
+	case TIM2_IRQn:           return TIM2_IRQHandler;
+	case TIM3_IRQn:           return TIM3_IRQHandler;
+	case TIM4_IRQn:           return TIM4_IRQHandler;
+	case TIM5_IRQn:           return TIM5_IRQHandler;
+	case TIM8_BRK_TIM12_IRQn: return TIM8_BRK_TIM12_IRQHandler;
+	case USART3_IRQn:         return USART3_IRQHandler;
+	case FDCAN1_IT0_IRQn:     return FDCAN1_IT0_IRQHandler;
+	case FDCAN2_IT0_IRQn:     return FDCAN2_IT0_IRQHandler;
+	case FDCAN1_IT1_IRQn:     return FDCAN1_IT1_IRQHandler;
+	case FDCAN2_IT1_IRQn:     return FDCAN2_IT1_IRQHandler;
+	default:                  return nullptr;
+	}
+}
+
+inline bool valid_irq_(int irqn)
+{
+	return irqn >= 0 && irqn < HOST_IRQn_COUNT;
+}
+
+// Wake the interrupt task without yielding (safe inside critical sections)
+void kick_()
+{
+	if (irq_task_ == nullptr || ipsr_ != 0) {
+		return;                 // not started, or already in the loop
+	}
+	if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+		return;
+	}
+	vTaskNotifyGiveFromISR(irq_task_, nullptr);
+}
+
+void pend_(int irqn)
+{
+	if (valid_irq_(irqn)) {
+		irqs_[irqn].pending = true;
+	}
+}
+
+// Highest priority pending enabled line (lowest number, then lowest IRQn)
+int next_irq_()
+{
+	int best = -1;
+	for (int i = 0; i < HOST_IRQn_COUNT; i++) {
+		if (irqs_[i].pending && irqs_[i].enabled && handler_(i) != nullptr) {
+			if (best < 0 || irqs_[i].priority < irqs_[best].priority) {
+				best = i;
+			}
+		}
+	}
+	return best;
+}
+
+void dispatch_()
+{
+	if (primask_) {
+		return;
+	}
+	while (true) {
+		int irqn = next_irq_();
+		if (irqn < 0) {
+			return;
+		}
+		irqs_[irqn].pending = false;
+		ipsr_ = static_cast<uint32_t>(irqn) + 16U;
+		handler_(irqn)();
+		ipsr_ = 0;
+	}
+}
+
+//=============================================================================
+// Timers
+//=============================================================================
+
+// Cascades as configured by ustim (stm32zero-conf.h): TIM3 <- TIM4 <- TIM12,
+// TIM5 <- TIM8; TIM2 runs alone. Every counter is a bit field of its chain
+// value (microseconds plus the chain offset) and runs while the host runs.
+struct SimTim {
+	TIM_TypeDef* regs;
+	uint16_t num;
+	uint8_t bits;
+	uint8_t shift;
+	uint8_t chain;
+	int irqn;
+	uint32_t sr;
+	uint32_t last_cnt;
+};
+
+SimTim tims_[] = {
+	{ &host_tim2, 2, 32, 0, 0, TIM2_IRQn, 0, 0 },
+	{ &host_tim3, 3, 16, 0, 1, TIM3_IRQn, 0, 0 },
+	{ &host_tim4, 4, 16, 16, 1, TIM4_IRQn, 0, 0 },
+	{ &host_tim12, 12, 16, 32, 1, TIM8_BRK_TIM12_IRQn, 0, 0 },
+	{ &host_tim5, 5, 32, 0, 2, TIM5_IRQn, 0, 0 },
+	{ &host_tim8, 8, 16, 32, 2, -1, 0, 0 },
+};
+
+uint64_t chain_offset_[3];
+uint32_t cyccnt_offset_ = 0;
+
+SimTim* tim_(uint16_t num)
+{
+	for (auto& t : tims_) {
+		if (t.num == num) {
+			return &t;
+		}
+	}
+	return nullptr;
+}
+
+inline uint32_t tim_mask_(const SimTim& t)
+{
+	return t.bits >= 32 ? 0xFFFFFFFFU : ((1U << t.bits) - 1U);
+}
+
+inline uint32_t tim_cnt_(const SimTim& t, uint64_t us)
+{
+	return static_cast<uint32_t>((us + chain_offset_[t.chain]) >> t.shift) & tim_mask_(t);
+}
+
+// Writing CNT moves the whole chain so the cascade stays consistent
+void tim_set_cnt_(SimTim& t, uint32_t value)
+{
+	uint32_t mask = tim_mask_(t);
+	uint32_t field = tim_cnt_(t, now_us_());
+	chain_offset_[t.chain] += static_cast<uint64_t>((value - field) & mask) << t.shift;
+	t.last_cnt = value & mask;
+}
+
+void tim_raise_(SimTim& t)
+{
+	if ((t.regs->DIER & t.sr & (TIM_DIER_UIE | TIM_DIER_CC1IE)) != 0U) {
+		pend_(t.irqn);
+	}
+}
+
+// Compare match when CCR1 was passed since the previous sample
+void tim_poll_(uint64_t us)
+{
+	for (auto& t : tims_) {
+		uint32_t mask = tim_mask_(t);
+		uint32_t cnt = tim_cnt_(t, us);
+		if ((t.regs->DIER & TIM_DIER_CC1IE) != 0U) {
+			uint32_t to_ccr = (t.regs->CCR1 - t.last_cnt - 1U) & mask;
+			uint32_t to_cnt = (cnt - t.last_cnt) & mask;
+			if (to_ccr < to_cnt) {
+				t.sr |= TIM_SR_CC1IF;
+			}
+		}
+		t.last_cnt = cnt;
+		tim_raise_(t);
+	}
+}
+
+//=============================================================================
+// Console (USART3)
+//=============================================================================
+
+constexpr uint32_t RX_RING_SIZE = 4096;
+
+int tx_fd_ = STDOUT_FILENO;
+int rx_fd_ = STDIN_FILENO;
+int pty_slave_fd_ = -1;
+bool interactive_ = false;
+
+uint8_t rx_ring_[RX_RING_SIZE];
+std::atomic<uint32_t> rx_head_{0};      // reader thread
+std::atomic<uint32_t> rx_tail_{0};      // interrupt task
+
+bool tx_done_ = false;
+uint32_t rx_pos_ = 0;                   // DMA position in pRxBuffPtr
+
+void write_all_(int fd, const uint8_t* data, size_t size)
+{
+	while (size > 0) {
+		ssize_t n = write(fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;       // tick signal, or pty full
+			}
+			return;             // console gone: drop output
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+}
+
+// Console reader: blocks in read(), pushes into the ring, waits when full
+void* reader_func_(void*)
+{
+	uint8_t buf[256];
+
+	while (true) {
+		ssize_t n = read(rx_fd_, buf, sizeof buf);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return nullptr;     // EOF (pipe, /dev/null) or error
+		}
+		for (ssize_t i = 0; i < n; i++) {
+			uint32_t head = rx_head_.load(std::memory_order_relaxed);
+			while (head - rx_tail_.load(std::memory_order_acquire) >= RX_RING_SIZE) {
+				usleep(1000);
+			}
+			rx_ring_[head % RX_RING_SIZE] = buf[i];
+			rx_head_.store(head + 1, std::memory_order_release);
+		}
+	}
+}
+
+inline bool rx_available_()
+{
+	return rx_head_.load(std::memory_order_acquire) != rx_tail_.load(std::memory_order_relaxed);
+}
+
+uint8_t rx_pop_()
+{
+	uint32_t tail = rx_tail_.load(std::memory_order_relaxed);
+	uint8_t c = rx_ring_[tail % RX_RING_SIZE];
+	rx_tail_.store(tail + 1, std::memory_order_release);
+	return c;
+}
+
+void uart_poll_()
+{
+	if (tx_done_ || (rx_available_() && huart3.RxState == HAL_UART_STATE_BUSY_RX)) {
+		pend_(USART3_IRQn);
+	}
+}
+
+// Reception event as the HAL reports it for the DMA mode in use
+void uart_rx_event_(UART_HandleTypeDef* huart, uint32_t event, uint16_t size)
+{
+	bool circular = huart->hdmarx != nullptr && huart->hdmarx->Init.Mode == DMA_CIRCULAR;
+
+	if (event == HAL_UART_RXEVENT_TC) {
+		rx_pos_ = 0;
+		if (!circular) {
+			huart->RxState = HAL_UART_STATE_READY;
+		}
+	}
+	if (event == HAL_UART_RXEVENT_IDLE && !circular) {
+		huart->RxState = HAL_UART_STATE_READY;      // HAL aborts normal DMA on idle
+	}
+
+	if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+		huart->RxEventType = event;
+		HAL_UARTEx_RxEventCallback(huart, size);
+	} else if (event == HAL_UART_RXEVENT_HT) {
+		HAL_UART_RxHalfCpltCallback(huart);
+	} else if (event == HAL_UART_RXEVENT_TC) {
+		HAL_UART_RxCpltCallback(huart);
+	}
+}
+
+// Copy the ring into the reception buffer; the end of the ring is a line idle
+void uart_rx_deliver_(UART_HandleTypeDef* huart)
+{
+	bool since_event = false;
+
+	while (rx_available_() && huart->RxState == HAL_UART_STATE_BUSY_RX) {
+		uint32_t size = huart->RxXferSize;
+		uint32_t half = size / 2U;
+
+		huart->pRxBuffPtr[rx_pos_++] = rx_pop_();
+		since_event = true;
+		if (huart->hdmarx != nullptr) {
+			huart->hdmarx->Instance->NDTR = size - rx_pos_;
+		}
+
+		if (rx_pos_ == size) {
+			since_event = false;
+			uart_rx_event_(huart, HAL_UART_RXEVENT_TC, static_cast<uint16_t>(size));
+		} else if (rx_pos_ == half && huart->hdmarx != nullptr &&
+			   (huart->hdmarx->HostDisabledITs & DMA_IT_HT) == 0U) {
+			since_event = false;
+			uart_rx_event_(huart, HAL_UART_RXEVENT_HT, static_cast<uint16_t>(half));
+		}
+	}
+
+	if (since_event && huart->RxState == HAL_UART_STATE_BUSY_RX &&
+	    huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+		uart_rx_event_(huart, HAL_UART_RXEVENT_IDLE, static_cast<uint16_t>(rx_pos_));
+	}
+}
+
+HAL_StatusTypeDef uart_transmit_(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+	if (data == nullptr || size == 0U) {
+		return HAL_ERROR;
+	}
+	{
+		Lock lock;
+		if (huart->gState != HAL_UART_STATE_READY) {
+			return HAL_BUSY;
+		}
+		huart->gState = HAL_UART_STATE_BUSY_TX;
+		huart->pTxBuffPtr = data;
+		huart->TxXferSize = size;
+		huart->TxXferCount = size;
+	}
+
+	write_all_(tx_fd_, data, size);
+
+	Lock lock;
+	huart->TxXferCount = 0;
+	tx_done_ = true;
+	pend_(USART3_IRQn);
+	kick_();
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef uart_receive_(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size, uint32_t type)
+{
+	if (data == nullptr || size == 0U) {
+		return HAL_ERROR;
+	}
+	Lock lock;
+	if (huart->RxState != HAL_UART_STATE_READY) {
+		return HAL_BUSY;
+	}
+	huart->ReceptionType = type;
+	huart->RxEventType = HAL_UART_RXEVENT_TC;
+	huart->pRxBuffPtr = data;
+	huart->RxXferSize = size;
+	huart->RxXferCount = size;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	if (huart->hdmarx != nullptr) {
+		huart->hdmarx->Instance->NDTR = size;
+	}
+	rx_pos_ = 0;
+	if (rx_available_()) {
+		pend_(USART3_IRQn);
+		kick_();
+	}
+	return HAL_OK;
+}
+
+//=============================================================================
+// FDCAN Bus
+//=============================================================================
+
+constexpr uint32_t MAX_STD_FILTERS = 128;
+constexpr uint32_t MAX_EXT_FILTERS = 64;
+constexpr uint32_t MAX_FIFO = 64;
+constexpr uint32_t MAX_RX_BUFFERS = 64;
+constexpr uint32_t MAX_TX = 32;
+constexpr uint32_t MAX_EVENTS = 32;
+
+constexpr uint32_t IT_RX_FIFO0 = FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_RX_FIFO0_FULL |
+				  FDCAN_IT_RX_FIFO0_MESSAGE_LOST;
+constexpr uint32_t IT_RX_FIFO1 = FDCAN_IT_RX_FIFO1_NEW_MESSAGE | FDCAN_IT_RX_FIFO1_FULL |
+				  FDCAN_IT_RX_FIFO1_MESSAGE_LOST;
+constexpr uint32_t IT_ERROR_STATUS = FDCAN_IT_ERROR_PASSIVE | FDCAN_IT_ERROR_WARNING | FDCAN_IT_BUS_OFF;
+constexpr uint32_t IT_PROTOCOL_ERROR = FDCAN_IT_ARB_PROTOCOL_ERROR | FDCAN_IT_DATA_PROTOCOL_ERROR;
+
+struct CanFrame {
+	FDCAN_RxHeaderTypeDef header;
+	uint8_t data[64];
+};
+
+struct CanTxElement {
+	FDCAN_TxHeaderTypeDef header;
+	uint8_t data[64];
+	uint32_t order;             // request order (TX FIFO elements leave in order)
+	uint64_t requested_ns;      // arbitrates from this time on
+};
+
+struct CanFifo {
+	CanFrame frames[MAX_FIFO];
+	uint32_t get;
+	uint32_t count;
+	uint32_t size;
+	bool overwrite;
+};
+
+struct CanNode {
+	FDCAN_HandleTypeDef* h;
+	FDCAN_GlobalTypeDef* regs;
+	int irq0;
+	int irq1;
+
+	FDCAN_FilterTypeDef std_filters[MAX_STD_FILTERS];
+	FDCAN_FilterTypeDef ext_filters[MAX_EXT_FILTERS];
+	uint32_t non_matching_std;
+	uint32_t non_matching_ext;
+	bool reject_remote_std;
+	bool reject_remote_ext;
+	uint32_t xidam;
+
+	CanFifo fifo[2];
+	CanFrame rx_buffers[MAX_RX_BUFFERS];
+	uint64_t rx_buffer_nd;
+
+	CanTxElement tx[MAX_TX];
+	uint32_t tx_pending;        // TXBRP
+	uint32_t tx_done;           // TXBTO
+	uint32_t tx_cancelled;      // TXBCF
+	uint32_t tx_order;
+	uint32_t tx_put;            // next TX FIFO element (FIFO operation)
+
+	FDCAN_TxEventFifoTypeDef events[MAX_EVENTS];
+	uint32_t event_get;
+	uint32_t event_count;
+
+	uint32_t ir;                // IR
+	uint32_t line1_its;         // ILS
+	uint32_t tec;
+	uint32_t rec;
+	bool bus_off;
+	uint32_t lec;               // PSR.LEC / DLEC, NO_CHANGE after a read
+	uint32_t dlec;
+	bool blocked;               // unacknowledged frame this bus cycle
+	bool ts_external;           // timestamps from TIM3 (H7 external source)
+
+	uint32_t corrupt;           // next transmitted frames destroyed (injected)
+	uint32_t corrupt_lec;
+	uint64_t bus_free_ns;       // end of the last frame (internal loopback)
+};
+
+CanNode can_[2] = {
+	{ &hfdcan1, FDCAN1, FDCAN1_IT0_IRQn, FDCAN1_IT1_IRQn },
+	{ &hfdcan2, FDCAN2, FDCAN2_IT0_IRQn, FDCAN2_IT1_IRQn },
+};
+
+// End of the last frame on the bus shared by all but internal loopback nodes
+uint64_t can_bus_free_ns_ = 0;
+
+const uint8_t DLC_BYTES[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+CanNode* can_node_(const FDCAN_HandleTypeDef* hfdcan)
+{
+	for (auto& node : can_) {
+		if (node.regs == hfdcan->Instance) {
+			return &node;
+		}
+	}
+	return nullptr;
+}
+
+inline uint32_t can_bytes_(uint32_t dlc)
+{
+	return DLC_BYTES[dlc & 0xFU];
+}
+
+uint64_t can_bits_ns_(uint32_t bits, uint32_t prescaler, uint32_t seg1, uint32_t seg2)
+{
+	uint64_t tq = static_cast<uint64_t>(prescaler) * (1U + seg1 + seg2);
+	return bits * tq * 1000000000ULL / STM32ZERO_FDCAN_CLOCK_HZ;
+}
+
+// Bus time of a frame at the sender's bit timing, without dynamic stuff
+// bits: SOF to the end of the intermission, the data phase of FD frames
+// at the data bit rate when the bit rate is switched
+uint64_t can_frame_ns_(const CanNode& node, const FDCAN_TxHeaderTypeDef& header)
+{
+	const FDCAN_InitTypeDef& init = node.h->Init;
+	bool ext = header.IdType == FDCAN_EXTENDED_ID;
+	uint32_t len = header.TxFrameType == FDCAN_REMOTE_FRAME ? 0U : can_bytes_(header.DataLength);
+	uint32_t nominal;
+	uint32_t data = 0;
+
+	if (header.FDFormat != FDCAN_FD_CAN) {
+		nominal = (ext ? 67U : 47U) + (len > 8U ? 8U : len) * 8U;
+	} else {
+		uint32_t crc = len <= 16U ? 17U : 21U;
+		nominal = (ext ? 36U : 17U) + 13U;              // SOF..BRS, CRC delimiter..IFS
+		data = 1U + 4U + len * 8U + 4U + crc + (crc + 3U) / 4U;        // ESI..CRC
+		if (header.BitRateSwitch != FDCAN_BRS_ON || (init.FrameFormat & FDCAN_CCCR_BRSE) == 0U) {
+			nominal += data;
+			data = 0;
+		}
+	}
+	return can_bits_ns_(nominal, init.NominalPrescaler, init.NominalTimeSeg1, init.NominalTimeSeg2) +
+	       can_bits_ns_(data, init.DataPrescaler, init.DataTimeSeg1, init.DataTimeSeg2);
+}
+
+uint32_t can_fifo_mask_(const CanNode& node)
+{
+	uint32_t base = node.h->Init.TxBuffersNbr;
+	uint32_t n = node.h->Init.TxFifoQueueElmtsNbr;
+	if (n == 0U || base >= MAX_TX) {
+		return 0;
+	}
+	uint32_t bits = (base + n >= MAX_TX) ? 0xFFFFFFFFU : ((1U << (base + n)) - 1U);
+	return bits & ~((1U << base) - 1U);
+}
+
+uint32_t can_fifo_free_(const CanNode& node)
+{
+	uint32_t mask = can_fifo_mask_(node);
+	return static_cast<uint32_t>(__builtin_popcount(mask) - __builtin_popcount(node.tx_pending & mask));
+}
+
+// TXFQS as the M_CAN reports it: in queue mode (TXBC.TFQM = 1) the fill
+// level reads 0 and only TFQF tells whether an element is free
+uint32_t can_txfqs_(const CanNode& node)
+{
+	uint32_t free = can_fifo_free_(node);
+	bool queue = node.h->Init.TxFifoQueueMode == FDCAN_TX_QUEUE_OPERATION;
+	return (queue ? 0U : (free & FDCAN_TXFQS_TFFL)) | (free == 0U ? FDCAN_TXFQS_TFQF : 0U);
+}
+
+inline bool can_on_bus_(const CanNode& node)
+{
+	return node.h->State == HAL_FDCAN_STATE_BUSY && (node.regs->CCCR & FDCAN_CCCR_INIT) == 0U &&
+	       !node.bus_off;
+}
+
+// Registers read by drivers that bypass the HAL
+void can_sync_regs_(CanNode& node)
+{
+	FDCAN_GlobalTypeDef* r = node.regs;
+	uint32_t rec = node.rec > 127U ? 127U : node.rec;
+	uint32_t tec = node.tec > 255U ? 255U : node.tec;
+
+	r->IR = node.ir;
+	r->TXBRP = node.tx_pending;
+	r->TXBTO = node.tx_done;
+	r->TXBCF = node.tx_cancelled;
+	r->TXFQS = can_txfqs_(node);
+	r->RXF0S = node.fifo[0].count;
+	r->RXF1S = node.fifo[1].count;
+	r->NDAT1 = static_cast<uint32_t>(node.rx_buffer_nd);
+	r->NDAT2 = static_cast<uint32_t>(node.rx_buffer_nd >> 32);
+	r->ECR = tec | (rec << 8) | (node.rec > 127U ? FDCAN_ECR_RP : 0U);
+	r->PSR = (node.lec & FDCAN_PSR_LEC) | ((node.dlec << 8) & FDCAN_PSR_DLEC) | FDCAN_COM_STATE_IDLE |
+		 ((node.tec > 127U || node.rec > 127U) ? FDCAN_PSR_EP : 0U) |
+		 ((node.tec >= 96U || node.rec >= 96U) ? FDCAN_PSR_EW : 0U) |
+		 (node.bus_off ? FDCAN_PSR_BO : 0U);
+}
+
+// Status bits whose change raises EP / EW / BO
+uint32_t can_status_(const CanNode& node)
+{
+	return ((node.tec > 127U || node.rec > 127U) ? FDCAN_IT_ERROR_PASSIVE : 0U) |
+	       ((node.tec >= 96U || node.rec >= 96U) ? FDCAN_IT_ERROR_WARNING : 0U) |
+	       (node.bus_off ? FDCAN_IT_BUS_OFF : 0U);
+}
+
+void can_raise_(CanNode& node)
+{
+	can_sync_regs_(node);
+	uint32_t active = node.ir & node.regs->IE;
+	if ((active & ~node.line1_its) != 0U) {
+		pend_(node.irq0);
+	}
+	if ((active & node.line1_its) != 0U) {
+		pend_(node.irq1);
+	}
+}
+
+void can_reset_(CanNode& node)
+{
+	FDCAN_HandleTypeDef* h = node.h;
+	FDCAN_GlobalTypeDef* regs = node.regs;
+	int irq0 = node.irq0;
+	int irq1 = node.irq1;
+
+	memset(&node, 0, sizeof node);
+	node.h = h;
+	node.regs = regs;
+	node.irq0 = irq0;
+	node.irq1 = irq1;
+	node.xidam = 0x1FFFFFFFU;
+	node.fifo[0].size = h->Init.RxFifo0ElmtsNbr > MAX_FIFO ? MAX_FIFO : h->Init.RxFifo0ElmtsNbr;
+	node.fifo[1].size = h->Init.RxFifo1ElmtsNbr > MAX_FIFO ? MAX_FIFO : h->Init.RxFifo1ElmtsNbr;
+	node.tx_put = h->Init.TxBuffersNbr;
+	node.lec = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+	node.dlec = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+
+	memset(static_cast<void*>(regs), 0, sizeof *regs);
+	regs->CCCR = FDCAN_CCCR_INIT | FDCAN_CCCR_CCE | h->Init.FrameFormat;
+	regs->TXBC = h->Init.TxFifoQueueMode;
+	can_sync_regs_(node);
+}
+
+bool can_filter_match_(const FDCAN_FilterTypeDef& f, uint32_t id)
+{
+	switch (f.FilterType) {
+	case FDCAN_FILTER_RANGE:
+	case FDCAN_FILTER_RANGE_NO_EIDM:
+		return id >= f.FilterID1 && id <= f.FilterID2;
+	case FDCAN_FILTER_DUAL:
+		return id == f.FilterID1 || id == f.FilterID2;
+	case FDCAN_FILTER_MASK:
+		return (id & f.FilterID2) == (f.FilterID1 & f.FilterID2);
+	default:
+		return false;
+	}
+}
+
+enum class Dest { REJECT, FIFO0, FIFO1, BUFFER };
+
+// Acceptance filtering: first enabled matching element wins, then the
+// global filter for non-matching frames
+Dest can_accept_(const CanNode& node, FDCAN_RxHeaderTypeDef& header, uint32_t& buffer)
+{
+	bool ext = header.IdType == FDCAN_EXTENDED_ID;
+	bool remote = header.RxFrameType == FDCAN_REMOTE_FRAME;
+
+	if (remote && (ext ? node.reject_remote_ext : node.reject_remote_std)) {
+		return Dest::REJECT;
+	}
+
+	const FDCAN_FilterTypeDef* filters = ext ? node.ext_filters : node.std_filters;
+	uint32_t count = ext ? node.h->Init.ExtFiltersNbr : node.h->Init.StdFiltersNbr;
+	uint32_t limit = ext ? MAX_EXT_FILTERS : MAX_STD_FILTERS;
+	if (count > limit) {
+		count = limit;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		const FDCAN_FilterTypeDef& f = filters[i];
+		if (f.FilterConfig == FDCAN_FILTER_DISABLE) {
+			continue;
+		}
+		uint32_t id = header.Identifier;
+		if (ext && f.FilterType != FDCAN_FILTER_RANGE_NO_EIDM) {
+			id &= node.xidam;
+		}
+		if (f.FilterConfig == FDCAN_FILTER_TO_RXBUFFER) {
+			if (header.Identifier != f.FilterID1) {
+				continue;
+			}
+			header.FilterIndex = i;
+			header.IsFilterMatchingFrame = 0;
+			buffer = f.RxBufferIndex;
+			return Dest::BUFFER;
+		}
+		if (!can_filter_match_(f, id)) {
+			continue;
+		}
+		header.FilterIndex = i;
+		header.IsFilterMatchingFrame = 0;
+		switch (f.FilterConfig) {
+		case FDCAN_FILTER_TO_RXFIFO0:
+		case FDCAN_FILTER_TO_RXFIFO0_HP:
+			return Dest::FIFO0;
+		case FDCAN_FILTER_TO_RXFIFO1:
+		case FDCAN_FILTER_TO_RXFIFO1_HP:
+			return Dest::FIFO1;
+		default:
+			return Dest::REJECT;        // REJECT, or HP without storage
+		}
+	}
+
+	header.FilterIndex = 0;
+	header.IsFilterMatchingFrame = 1;
+	switch (ext ? node.non_matching_ext : node.non_matching_std) {
+	case FDCAN_ACCEPT_IN_RX_FIFO0:
+		return Dest::FIFO0;
+	case FDCAN_ACCEPT_IN_RX_FIFO1:
+		return Dest::FIFO1;
+	default:
+		return Dest::REJECT;
+	}
+}
+
+// 16-bit timestamp counter: microseconds, or TIM3 CNT when external
+uint32_t can_timestamp_(const CanNode& node, uint64_t us)
+{
+	if (node.ts_external) {
+		return tim_cnt_(*tim_(3), us);
+	}
+	return static_cast<uint32_t>(us & 0xFFFFU);
+}
+
+void can_store_(CanNode& node, const CanFrame& frame, uint64_t us)
+{
+	CanFrame copy = frame;
+	copy.header.RxTimestamp = can_timestamp_(node, us);
+	uint32_t buffer = 0;
+	Dest dest = can_accept_(node, copy.header, buffer);
+
+	if (dest == Dest::REJECT) {
+		return;
+	}
+	if (dest == Dest::BUFFER) {
+		if (buffer < MAX_RX_BUFFERS && buffer < node.h->Init.RxBuffersNbr) {
+			node.rx_buffers[buffer] = copy;
+			node.rx_buffer_nd |= 1ULL << buffer;
+			node.ir |= FDCAN_IT_RX_BUFFER_NEW_MESSAGE;
+		}
+		return;
+	}
+
+	int n = dest == Dest::FIFO0 ? 0 : 1;
+	CanFifo& fifo = node.fifo[n];
+	uint32_t lost = n == 0 ? FDCAN_IT_RX_FIFO0_MESSAGE_LOST : FDCAN_IT_RX_FIFO1_MESSAGE_LOST;
+
+	if (fifo.size == 0U) {
+		node.ir |= lost;
+		return;
+	}
+	if (fifo.count == fifo.size) {
+		node.ir |= lost;
+		if (!fifo.overwrite) {
+			return;
+		}
+		fifo.get = (fifo.get + 1U) % fifo.size;         // overwrite the oldest
+		fifo.count--;
+	}
+	fifo.frames[(fifo.get + fifo.count) % fifo.size] = copy;
+	fifo.count++;
+	node.ir |= n == 0 ? FDCAN_IT_RX_FIFO0_NEW_MESSAGE : FDCAN_IT_RX_FIFO1_NEW_MESSAGE;
+	if (fifo.count == fifo.size) {
+		node.ir |= n == 0 ? FDCAN_IT_RX_FIFO0_FULL : FDCAN_IT_RX_FIFO1_FULL;
+	}
+}
+
+// Arbitration key: base ID first, standard before extended on a tie
+inline uint32_t can_arbitration_(const FDCAN_TxHeaderTypeDef& header)
+{
+	if (header.IdType == FDCAN_EXTENDED_ID) {
+		return ((header.Identifier >> 18) << 19) | (1U << 18) | (header.Identifier & 0x3FFFFU);
+	}
+	return (header.Identifier & 0x7FFU) << 19;
+}
+
+// Element of a node that takes part in arbitration at time at_ns, or -1
+int can_candidate_(const CanNode& node, uint64_t at_ns)
+{
+	uint32_t fifo_mask = can_fifo_mask_(node);
+	bool fifo_op = node.h->Init.TxFifoQueueMode == FDCAN_TX_FIFO_OPERATION;
+	int best = -1;
+
+	// In FIFO operation only the oldest FIFO element competes
+	int fifo_head = -1;
+	if (fifo_op) {
+		for (uint32_t i = 0; i < MAX_TX; i++) {
+			uint32_t bit = 1U << i;
+			if ((node.tx_pending & fifo_mask & bit) != 0U &&
+			    (fifo_head < 0 || node.tx[i].order - node.tx[fifo_head].order >= 0x80000000U)) {
+				fifo_head = static_cast<int>(i);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < MAX_TX; i++) {
+		uint32_t bit = 1U << i;
+		if ((node.tx_pending & bit) == 0U || node.tx[i].requested_ns > at_ns) {
+			continue;
+		}
+		if (fifo_op && (fifo_mask & bit) != 0U && static_cast<int>(i) != fifo_head) {
+			continue;
+		}
+		if (best < 0 || can_arbitration_(node.tx[i].header) < can_arbitration_(node.tx[best].header)) {
+			best = static_cast<int>(i);
+		}
+	}
+	return best;
+}
+
+bool can_receives_fd_(const CanNode& node)
+{
+	return (node.h->Init.FrameFormat & FDCAN_CCCR_FDOE) != 0U;
+}
+
+// A node that receives (and acknowledges or flags) frames sent by sender
+inline bool can_listens_(const CanNode& node, const CanNode& sender)
+{
+	return &node != &sender && can_on_bus_(node) && node.h->Init.Mode != FDCAN_MODE_INTERNAL_LOOPBACK &&
+	       sender.h->Init.Mode != FDCAN_MODE_INTERNAL_LOOPBACK;
+}
+
+// Unsuccessful transmission without automatic retransmission
+void can_tx_cancel_(CanNode& sender, uint32_t bit)
+{
+	sender.tx_pending &= ~bit;
+	sender.tx_cancelled |= bit;
+	sender.ir |= FDCAN_IT_TX_ABORT_COMPLETE;
+}
+
+// Protocol error in the arbitration (nominal bit time) or data phase:
+// LEC / DLEC and the PEA / PED interrupt
+void can_protocol_error_(CanNode& node, uint32_t lec, bool data_phase)
+{
+	if (data_phase) {
+		node.dlec = lec;
+		node.ir |= FDCAN_IT_DATA_PROTOCOL_ERROR;
+	} else {
+		node.lec = lec;
+		node.ir |= FDCAN_IT_ARB_PROTOCOL_ERROR;
+	}
+}
+
+// Injected error: an error frame destroys the frame, the sender counts a
+// transmit error (+8) and every receiver a receive error (+1); the frame
+// is retransmitted right after (it keeps the bus time it took). Stuff,
+// bit and CRC errors of a bit rate switched frame hit the data phase.
+void can_error_frame_(CanNode& sender, uint32_t bit)
+{
+	sender.corrupt--;
+
+	const FDCAN_TxHeaderTypeDef& header = sender.tx[__builtin_ctz(bit)].header;
+	uint32_t lec = sender.corrupt_lec;
+	bool data_phase = header.FDFormat == FDCAN_FD_CAN && header.BitRateSwitch == FDCAN_BRS_ON &&
+			  (sender.h->Init.FrameFormat & FDCAN_CCCR_BRSE) != 0U &&
+			  lec != FDCAN_PROTOCOL_ERROR_ACK && lec != FDCAN_PROTOCOL_ERROR_FORM;
+
+	uint32_t before = can_status_(sender);
+	sender.tec += 8U;
+	can_protocol_error_(sender, lec, data_phase);
+	if (sender.tec > 255U) {
+		sender.bus_off = true;
+		sender.regs->CCCR |= FDCAN_CCCR_INIT;          // M_CAN enters init on bus-off
+	}
+	sender.ir |= before ^ can_status_(sender);
+
+	if (sender.corrupt_lec != FDCAN_PROTOCOL_ERROR_ACK) {
+		for (auto& node : can_) {
+			if (!can_listens_(node, sender)) {
+				continue;
+			}
+			before = can_status_(node);
+			node.rec++;
+			can_protocol_error_(node, lec, data_phase);
+			node.ir |= before ^ can_status_(node);
+		}
+	}
+	if (sender.h->Init.AutoRetransmission == DISABLE) {
+		can_tx_cancel_(sender, bit);
+	}
+}
+
+// One frame on the bus, starting at sof_ns: every other node on the bus
+// receives it (and the sender in loopback); without an acknowledging node
+// it stays pending
+void can_transmit_(CanNode& sender, uint32_t index, uint64_t sof_ns)
+{
+	CanTxElement& el = sender.tx[index];
+	uint32_t mode = sender.h->Init.Mode;
+	bool internal = mode == FDCAN_MODE_INTERNAL_LOOPBACK;
+	bool loopback = internal || mode == FDCAN_MODE_EXTERNAL_LOOPBACK;
+	bool fd = el.header.FDFormat == FDCAN_FD_CAN;
+	uint64_t us = sof_ns / 1000U;           // timestamps are taken at SOF
+	uint32_t bit = 1U << index;
+
+	if (sender.corrupt > 0U) {
+		can_error_frame_(sender, bit);
+		return;
+	}
+
+	CanFrame frame;
+	frame.header.Identifier = el.header.Identifier;
+	frame.header.IdType = el.header.IdType;
+	frame.header.RxFrameType = el.header.TxFrameType;
+	frame.header.DataLength = el.header.DataLength;
+	frame.header.ErrorStateIndicator = el.header.ErrorStateIndicator;
+	frame.header.BitRateSwitch = el.header.BitRateSwitch;
+	frame.header.FDFormat = el.header.FDFormat;
+	frame.header.RxTimestamp = 0;
+	frame.header.FilterIndex = 0;
+	frame.header.IsFilterMatchingFrame = 0;
+	memcpy(frame.data, el.data, sizeof frame.data);
+
+	bool acked = loopback;
+	for (auto& node : can_) {
+		if (!can_listens_(node, sender)) {
+			continue;
+		}
+		if (fd && !can_receives_fd_(node)) {
+			continue;
+		}
+		can_store_(node, frame, us);
+		if (node.rec > 0U) {
+			node.rec--;
+		}
+		if (node.h->Init.Mode != FDCAN_MODE_BUS_MONITORING) {
+			acked = true;
+		}
+	}
+	if (loopback) {
+		can_store_(sender, frame, us);
+	}
+
+	if (!acked) {
+		can_protocol_error_(sender, FDCAN_PROTOCOL_ERROR_ACK, false);
+		if (sender.h->Init.AutoRetransmission == DISABLE) {
+			can_tx_cancel_(sender, bit);
+		} else {
+			sender.blocked = true;      // retransmits until acknowledged
+		}
+		return;
+	}
+
+	// An unread error code stays: on hardware the error interrupt reads it
+	// before the retransmission ends, here both may fall in one poll
+	if (sender.lec == FDCAN_PROTOCOL_ERROR_NO_CHANGE) {
+		sender.lec = FDCAN_PROTOCOL_ERROR_NONE;
+	}
+	if (fd && el.header.BitRateSwitch == FDCAN_BRS_ON && sender.dlec == FDCAN_PROTOCOL_ERROR_NO_CHANGE) {
+		sender.dlec = FDCAN_PROTOCOL_ERROR_NONE;
+	}
+	if (sender.tec > 0U) {
+		sender.tec--;
+	}
+	sender.tx_pending &= ~bit;
+	sender.tx_done |= bit;
+	if ((sender.regs->TXBTIE & bit) != 0U) {
+		sender.ir |= FDCAN_IT_TX_COMPLETE;
+	}
+	if ((can_fifo_mask_(sender) & bit) != 0U && (sender.tx_pending & can_fifo_mask_(sender)) == 0U) {
+		sender.ir |= FDCAN_IT_TX_FIFO_EMPTY;
+	}
+
+	if (el.header.TxEventFifoControl == FDCAN_STORE_TX_EVENTS && sender.h->Init.TxEventsNbr > 0U) {
+		uint32_t size = sender.h->Init.TxEventsNbr > MAX_EVENTS ? MAX_EVENTS : sender.h->Init.TxEventsNbr;
+		if (sender.event_count < size) {
+			FDCAN_TxEventFifoTypeDef& ev = sender.events[(sender.event_get + sender.event_count) % size];
+			ev.Identifier = el.header.Identifier;
+			ev.IdType = el.header.IdType;
+			ev.TxFrameType = el.header.TxFrameType;
+			ev.DataLength = el.header.DataLength;
+			ev.ErrorStateIndicator = el.header.ErrorStateIndicator;
+			ev.BitRateSwitch = el.header.BitRateSwitch;
+			ev.FDFormat = el.header.FDFormat;
+			ev.TxTimestamp = can_timestamp_(sender, us);
+			ev.MessageMarker = el.header.MessageMarker;
+			ev.EventType = 0x00400000U;     // FDCAN_TX_EVENT
+			sender.event_count++;
+			sender.ir |= FDCAN_IT_TX_EVT_FIFO_NEW_DATA;
+		} else {
+			sender.ir |= FDCAN_IT_TX_EVT_FIFO_ELT_LOST;
+		}
+	}
+}
+
+inline bool can_transmits_(const CanNode& node)
+{
+	return can_on_bus_(node) && !node.blocked && node.h->Init.Mode != FDCAN_MODE_BUS_MONITORING &&
+	       node.h->Init.Mode != FDCAN_MODE_RESTRICTED_OPERATION;
+}
+
+// Frames of the nodes on one bus (own: the internal loopback node that is
+// a bus of its own, nullptr: all others) back to back from the end of the
+// last one: arbitration starts when the bus is idle and a request is
+// pending, among the requests made until then; the winner is delivered
+// once its last bit has passed ns, else it is still on the bus
+void can_run_bus_(CanNode* own, uint64_t& free_ns, uint64_t ns)
+{
+	while (true) {
+		uint64_t first = UINT64_MAX;
+		for (auto& node : can_) {
+			bool internal = node.h->Init.Mode == FDCAN_MODE_INTERNAL_LOOPBACK;
+			if ((own != nullptr ? &node != own : internal) || !can_transmits_(node)) {
+				continue;
+			}
+			for (uint32_t i = 0; i < MAX_TX; i++) {
+				if ((node.tx_pending & (1U << i)) != 0U && node.tx[i].requested_ns < first) {
+					first = node.tx[i].requested_ns;
+				}
+			}
+		}
+		if (first == UINT64_MAX) {
+			return;
+		}
+		uint64_t sof = first > free_ns ? first : free_ns;
+
+		CanNode* winner = nullptr;
+		int index = -1;
+		for (auto& node : can_) {
+			bool internal = node.h->Init.Mode == FDCAN_MODE_INTERNAL_LOOPBACK;
+			if ((own != nullptr ? &node != own : internal) || !can_transmits_(node)) {
+				continue;
+			}
+			int i = can_candidate_(node, sof);
+			if (i < 0) {
+				continue;
+			}
+			if (winner == nullptr ||
+			    can_arbitration_(node.tx[i].header) < can_arbitration_(winner->tx[index].header)) {
+				winner = &node;
+				index = i;
+			}
+		}
+		if (winner == nullptr) {
+			return;
+		}
+		uint64_t end = sof + can_frame_ns_(*winner, winner->tx[index].header);
+		if (end > ns) {
+			return;
+		}
+		can_transmit_(*winner, static_cast<uint32_t>(index), sof);
+		free_ns = end;
+	}
+}
+
+void can_poll_(uint64_t ns)
+{
+	for (auto& node : can_) {
+		node.blocked = false;
+
+		// Bus-off recovery starts when the driver clears CCCR.INIT
+		if (node.bus_off && node.h->State == HAL_FDCAN_STATE_BUSY &&
+		    (node.regs->CCCR & FDCAN_CCCR_INIT) == 0U) {
+			uint32_t before = can_status_(node);
+			node.bus_off = false;
+			node.tec = 0;
+			node.rec = 0;
+			node.ir |= before ^ can_status_(node);
+		}
+	}
+
+	can_run_bus_(nullptr, can_bus_free_ns_, ns);
+	for (auto& node : can_) {
+		if (node.h->Init.Mode == FDCAN_MODE_INTERNAL_LOOPBACK) {
+			can_run_bus_(&node, node.bus_free_ns, ns);
+		}
+	}
+
+	for (auto& node : can_) {
+		can_raise_(node);
+	}
+}
+
+inline void can_call_(void (*cb)(FDCAN_HandleTypeDef*), FDCAN_HandleTypeDef* h)
+{
+	if (cb != nullptr) {
+		cb(h);
+	}
+}
+
+inline void can_call_(void (*cb)(FDCAN_HandleTypeDef*, uint32_t), FDCAN_HandleTypeDef* h, uint32_t arg)
+{
+	if (cb != nullptr) {
+		cb(h, arg);
+	}
+}
+
+//=============================================================================
+// Interrupt Task
+//=============================================================================
+
+void irq_task_func_(void*)
+{
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, 1);
+
+		uint64_t ns = now_ns_();
+		tim_poll_(ns / 1000U);
+		uart_poll_();
+		can_poll_(ns);
+		dispatch_();
+	}
+}
+
+} // namespace
+
+//=============================================================================
+// Simulated Registers / Intrinsics / NVIC
+//=============================================================================
+
+extern "C" uint32_t host_reg_read(uint16_t owner, uint16_t kind)
+{
+	if (owner == HOST_REG_OWNER_DWT) {
+		return static_cast<uint32_t>(now_ns_() * (SystemCoreClock / 1000000U) / 1000U) + cyccnt_offset_;
+	}
+	SimTim* t = tim_(owner);
+	if (t == nullptr) {
+		return 0;
+	}
+	switch (kind) {
+	case HOST_REG_CNT:
+		return tim_cnt_(*t, now_us_());
+	case HOST_REG_SR:
+		return t->sr;
+	default:
+		return 0;               // EGR reads as zero
+	}
+}
+
+extern "C" void host_reg_write(uint16_t owner, uint16_t kind, uint32_t value)
+{
+	if (owner == HOST_REG_OWNER_DWT) {
+		cyccnt_offset_ = 0;
+		cyccnt_offset_ = value - host_reg_read(owner, kind);
+		return;
+	}
+	SimTim* t = tim_(owner);
+	if (t == nullptr) {
+		return;
+	}
+
+	Lock lock;
+	switch (kind) {
+	case HOST_REG_CNT:
+		tim_set_cnt_(*t, value);
+		break;
+	case HOST_REG_SR:
+		t->sr &= value;         // rc_w0
+		break;
+	case HOST_REG_EGR:
+		if ((value & TIM_EGR_UG) != 0U) {
+			t->sr |= TIM_SR_UIF;
+		}
+		if ((value & TIM_EGR_CC1G) != 0U) {
+			t->sr |= TIM_SR_CC1IF;
+		}
+		tim_raise_(*t);
+		kick_();
+		break;
+	default:
+		break;
+	}
+}
+
+extern "C" uint32_t __get_IPSR(void)
+{
+	return ipsr_;
+}
+
+extern "C" uint32_t __get_PRIMASK(void)
+{
+	return primask_ ? 1U : 0U;
+}
+
+extern "C" void __disable_irq(void)
+{
+	portDISABLE_INTERRUPTS();
+	primask_ = true;
+}
+
+extern "C" void __enable_irq(void)
+{
+	primask_ = false;
+	portENABLE_INTERRUPTS();
+}
+
+extern "C" void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority)
+{
+	if (valid_irq_(irqn)) {
+		irqs_[irqn].priority = static_cast<uint8_t>(priority);
+	}
+}
+
+extern "C" void NVIC_EnableIRQ(IRQn_Type irqn)
+{
+	if (valid_irq_(irqn)) {
+		irqs_[irqn].enabled = true;
+		if (irqs_[irqn].pending) {
+			kick_();
+		}
+	}
+}
+
+extern "C" void NVIC_DisableIRQ(IRQn_Type irqn)
+{
+	if (valid_irq_(irqn)) {
+		irqs_[irqn].enabled = false;
+	}
+}
+
+extern "C" void NVIC_SetPendingIRQ(IRQn_Type irqn)
+{
+	pend_(irqn);
+	kick_();
+}
+
+extern "C" void NVIC_ClearPendingIRQ(IRQn_Type irqn)
+{
+	if (valid_irq_(irqn)) {
+		irqs_[irqn].pending = false;
+	}
+}
+
+extern "C" uint32_t NVIC_GetPendingIRQ(IRQn_Type irqn)
+{
+	return valid_irq_(irqn) && irqs_[irqn].pending ? 1U : 0U;
+}
+
+extern "C" uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn)
+{
+	return valid_irq_(irqn) && irqs_[irqn].enabled ? 1U : 0U;
+}
+
+//=============================================================================
+// HAL Common / RCC / TIM
+//=============================================================================
+
+extern "C" uint32_t HAL_GetTick(void)
+{
+	return static_cast<uint32_t>(now_ns_() / 1000000U);
+}
+
+extern "C" void HAL_Delay(uint32_t delay)
+{
+	if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+		vTaskDelay(pdMS_TO_TICKS(delay));
+	} else {
+		usleep(delay * 1000U);
+	}
+}
+
+extern "C" void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub)
+{
+	(void)sub;
+	NVIC_SetPriority(irqn, preempt);
+}
+
+extern "C" void HAL_NVIC_EnableIRQ(IRQn_Type irqn)
+{
+	NVIC_EnableIRQ(irqn);
+}
+
+extern "C" void HAL_NVIC_DisableIRQ(IRQn_Type irqn)
+{
+	NVIC_DisableIRQ(irqn);
+}
+
+extern "C" void HAL_NVIC_SetPendingIRQ(IRQn_Type irqn)
+{
+	NVIC_SetPendingIRQ(irqn);
+}
+
+extern "C" void HAL_NVIC_ClearPendingIRQ(IRQn_Type irqn)
+{
+	NVIC_ClearPendingIRQ(irqn);
+}
+
+extern "C" uint32_t HAL_RCCEx_GetPeriphCLKFreq(uint32_t periph)
+{
+	return periph == RCC_PERIPHCLK_FDCAN ? STM32ZERO_FDCAN_CLOCK_HZ : 0U;
+}
+
+extern "C" uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return SystemCoreClock / 4U;
+}
+
+extern "C" uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+	return SystemCoreClock / 2U;
+}
+
+extern "C" HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim)
+{
+	htim->Instance->CR1 |= TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim)
+{
+	htim->Instance->CR1 &= ~TIM_CR1_CEN;        // host counters keep running
+	return HAL_OK;
+}
+
+//=============================================================================
+// HAL UART
+//=============================================================================
+
+extern "C" HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart)
+{
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->Lock = HAL_UNLOCKED;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size,
+					      uint32_t timeout)
+{
+	(void)timeout;
+	if (data == nullptr || size == 0U) {
+		return HAL_ERROR;
+	}
+	if (huart->gState != HAL_UART_STATE_READY) {
+		return HAL_BUSY;
+	}
+	write_all_(tx_fd_, data, size);
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+	return uart_transmit_(huart, data, size);
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+	return uart_transmit_(huart, data, size);
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size)
+{
+	return uart_receive_(huart, data, size, HAL_UART_RECEPTION_STANDARD);
+}
+
+extern "C" HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size)
+{
+	return uart_receive_(huart, data, size, HAL_UART_RECEPTION_TOIDLE);
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart)
+{
+	Lock lock;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef* huart)
+{
+	Lock lock;
+	huart->RxState = HAL_UART_STATE_READY;
+	if (huart->gState == HAL_UART_STATE_BUSY_TX) {
+		tx_done_ = false;
+		huart->gState = HAL_UART_STATE_READY;
+	}
+	return HAL_OK;
+}
+
+extern "C" void HAL_UART_IRQHandler(UART_HandleTypeDef* huart)
+{
+	if (tx_done_ && huart->gState == HAL_UART_STATE_BUSY_TX) {
+		tx_done_ = false;
+		huart->gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(huart);
+	}
+	uart_rx_deliver_(huart);
+}
+
+extern "C" HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(const UART_HandleTypeDef* huart)
+{
+	return huart->RxEventType;
+}
+
+extern "C" __weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
+{
+	UNUSED(huart);
+}
+
+extern "C" __weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart)
+{
+	UNUSED(huart);
+}
+
+extern "C" __weak void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef* huart)
+{
+	UNUSED(huart);
+}
+
+extern "C" __weak void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+	UNUSED(huart);
+}
+
+extern "C" __weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t size)
+{
+	UNUSED(huart);
+	UNUSED(size);
+}
+
+//=============================================================================
+// HAL FDCAN: Configuration
+//=============================================================================
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_Init(FDCAN_HandleTypeDef* hfdcan)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return HAL_ERROR;
+	}
+	if (hfdcan->State == HAL_FDCAN_STATE_BUSY) {
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	hfdcan->TxEventFifoCallback = HAL_FDCAN_TxEventFifoCallback;
+	hfdcan->RxFifo0Callback = HAL_FDCAN_RxFifo0Callback;
+	hfdcan->RxFifo1Callback = HAL_FDCAN_RxFifo1Callback;
+	hfdcan->TxFifoEmptyCallback = HAL_FDCAN_TxFifoEmptyCallback;
+	hfdcan->TxBufferCompleteCallback = HAL_FDCAN_TxBufferCompleteCallback;
+	hfdcan->TxBufferAbortCallback = HAL_FDCAN_TxBufferAbortCallback;
+	hfdcan->RxBufferNewMessageCallback = HAL_FDCAN_RxBufferNewMessageCallback;
+	hfdcan->ErrorCallback = HAL_FDCAN_ErrorCallback;
+	hfdcan->ErrorStatusCallback = HAL_FDCAN_ErrorStatusCallback;
+
+	can_reset_(*node);
+	hfdcan->LatestTxFifoQRequest = 0;
+	hfdcan->ErrorCode = HAL_FDCAN_ERROR_NONE;
+	hfdcan->Lock = HAL_UNLOCKED;
+	hfdcan->State = HAL_FDCAN_STATE_READY;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_DeInit(FDCAN_HandleTypeDef* hfdcan)
+{
+	HAL_FDCAN_Stop(hfdcan);
+	hfdcan->State = HAL_FDCAN_STATE_RESET;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigFilter(FDCAN_HandleTypeDef* hfdcan, const FDCAN_FilterTypeDef* filter)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+	bool ext = filter->IdType == FDCAN_EXTENDED_ID;
+	if (filter->FilterIndex >= (ext ? MAX_EXT_FILTERS : MAX_STD_FILTERS)) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PARAM;
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	(ext ? node->ext_filters : node->std_filters)[filter->FilterIndex] = *filter;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigGlobalFilter(FDCAN_HandleTypeDef* hfdcan, uint32_t non_matching_std,
+							 uint32_t non_matching_ext, uint32_t reject_remote_std,
+							 uint32_t reject_remote_ext)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		if (node != nullptr) {
+			hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+		}
+		return HAL_ERROR;
+	}
+	node->non_matching_std = non_matching_std;
+	node->non_matching_ext = non_matching_ext;
+	node->reject_remote_std = reject_remote_std == FDCAN_REJECT_REMOTE;
+	node->reject_remote_ext = reject_remote_ext == FDCAN_REJECT_REMOTE;
+	hfdcan->Instance->GFC = (non_matching_std << 4) | (non_matching_ext << 2) |
+				(reject_remote_std << 1) | reject_remote_ext;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigExtendedIdMask(FDCAN_HandleTypeDef* hfdcan, uint32_t mask)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		return HAL_ERROR;
+	}
+	node->xidam = mask & 0x1FFFFFFFU;
+	hfdcan->Instance->XIDAM = node->xidam;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigRxFifoOverwrite(FDCAN_HandleTypeDef* hfdcan, uint32_t fifo, uint32_t mode)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		return HAL_ERROR;
+	}
+	node->fifo[fifo == FDCAN_RX_FIFO0 ? 0 : 1].overwrite = mode == FDCAN_RX_FIFO_OVERWRITE;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigInterruptLines(FDCAN_HandleTypeDef* hfdcan, uint32_t its, uint32_t line)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+	Lock lock;
+	if (line == FDCAN_INTERRUPT_LINE1) {
+		node->line1_its |= its;
+	} else {
+		node->line1_its &= ~its;
+	}
+	hfdcan->Instance->ILS = node->line1_its;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigTimestampCounter(FDCAN_HandleTypeDef* hfdcan, uint32_t prescaler)
+{
+	(void)prescaler;
+	return hfdcan->State == HAL_FDCAN_STATE_READY ? HAL_OK : HAL_ERROR;
+}
+
+// FDCAN_TIMESTAMP_EXTERNAL samples TIM3 CNT as on the H7; the internal
+// counter counts microseconds instead of bit times
+extern "C" HAL_StatusTypeDef HAL_FDCAN_EnableTimestampCounter(FDCAN_HandleTypeDef* hfdcan, uint32_t operation)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		return HAL_ERROR;
+	}
+	node->ts_external = operation == FDCAN_TIMESTAMP_EXTERNAL;
+	return HAL_OK;
+}
+
+extern "C" uint16_t HAL_FDCAN_GetTimestampCounter(const FDCAN_HandleTypeDef* hfdcan)
+{
+	const CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return 0;
+	}
+	return static_cast<uint16_t>(can_timestamp_(*node, now_us_()));
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ConfigTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan, uint32_t offset,
+								uint32_t filter)
+{
+	(void)offset;
+	(void)filter;
+	return hfdcan->State == HAL_FDCAN_STATE_READY ? HAL_OK : HAL_ERROR;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_EnableTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan)
+{
+	return hfdcan->State == HAL_FDCAN_STATE_READY ? HAL_OK : HAL_ERROR;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_DisableTxDelayCompensation(FDCAN_HandleTypeDef* hfdcan)
+{
+	return hfdcan->State == HAL_FDCAN_STATE_READY ? HAL_OK : HAL_ERROR;
+}
+
+//=============================================================================
+// HAL FDCAN: Control / Transfer
+//=============================================================================
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_Start(FDCAN_HandleTypeDef* hfdcan)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+		return HAL_ERROR;
+	}
+	Lock lock;
+	hfdcan->State = HAL_FDCAN_STATE_BUSY;
+	hfdcan->Instance->CCCR &= ~(FDCAN_CCCR_INIT | FDCAN_CCCR_CCE);
+	hfdcan->ErrorCode = HAL_FDCAN_ERROR_NONE;
+	kick_();
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_Stop(FDCAN_HandleTypeDef* hfdcan)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+		return HAL_ERROR;
+	}
+	Lock lock;
+	hfdcan->Instance->CCCR |= FDCAN_CCCR_INIT | FDCAN_CCCR_CCE;
+	node->tx_pending = 0;
+	node->tx_put = hfdcan->Init.TxBuffersNbr;
+	hfdcan->LatestTxFifoQRequest = 0;
+	hfdcan->State = HAL_FDCAN_STATE_READY;
+	can_sync_regs_(*node);
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxFifoQ(FDCAN_HandleTypeDef* hfdcan,
+							  const FDCAN_TxHeaderTypeDef* header, const uint8_t* data)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	uint32_t mask = can_fifo_mask_(*node);
+	if (can_fifo_free_(*node) == 0U) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_FULL;
+		return HAL_ERROR;
+	}
+
+	uint32_t index;
+	if (hfdcan->Init.TxFifoQueueMode == FDCAN_TX_FIFO_OPERATION) {
+		index = node->tx_put;
+		uint32_t next = index + 1U;
+		node->tx_put = ((1U << (next & 31U)) & mask) != 0U && next < MAX_TX ? next : hfdcan->Init.TxBuffersNbr;
+	} else {
+		index = static_cast<uint32_t>(__builtin_ctz(mask & ~node->tx_pending));
+	}
+
+	uint32_t bit = 1U << index;
+	CanTxElement& el = node->tx[index];
+	el.header = *header;
+	memcpy(el.data, data, can_bytes_(header->DataLength));
+	el.order = node->tx_order++;
+	el.requested_ns = now_ns_();
+	node->tx_pending |= bit;
+	node->tx_done &= ~bit;
+	node->tx_cancelled &= ~bit;
+	hfdcan->LatestTxFifoQRequest = bit;
+	can_sync_regs_(*node);
+	kick_();
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxBuffer(FDCAN_HandleTypeDef* hfdcan,
+							   const FDCAN_TxHeaderTypeDef* header, const uint8_t* data,
+							   uint32_t buffer_index)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET || buffer_index == 0U) {
+		return HAL_ERROR;
+	}
+	uint32_t index = static_cast<uint32_t>(__builtin_ctz(buffer_index));
+	if (index >= hfdcan->Init.TxBuffersNbr) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PARAM;
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	if ((node->tx_pending & buffer_index) != 0U) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PENDING;
+		return HAL_ERROR;
+	}
+	CanTxElement& el = node->tx[index];
+	el.header = *header;
+	memcpy(el.data, data, can_bytes_(header->DataLength));
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_EnableTxBufferRequest(FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	uint64_t ns = now_ns_();
+	for (uint32_t i = 0; i < MAX_TX; i++) {
+		if ((buffer_index & (1U << i)) != 0U) {
+			node->tx[i].order = node->tx_order++;
+			node->tx[i].requested_ns = ns;
+		}
+	}
+	node->tx_pending |= buffer_index;
+	node->tx_done &= ~buffer_index;
+	node->tx_cancelled &= ~buffer_index;
+	can_sync_regs_(*node);
+	kick_();
+	return HAL_OK;
+}
+
+extern "C" uint32_t HAL_FDCAN_GetLatestTxFifoQRequestBuffer(const FDCAN_HandleTypeDef* hfdcan)
+{
+	return hfdcan->LatestTxFifoQRequest;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_AbortTxRequest(FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	uint32_t cancelled = node->tx_pending & buffer_index;
+	if (cancelled != 0U) {
+		node->tx_pending &= ~cancelled;
+		node->tx_cancelled |= cancelled;
+		node->ir |= FDCAN_IT_TX_ABORT_COMPLETE;
+		can_raise_(*node);
+		kick_();
+	}
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_GetRxMessage(FDCAN_HandleTypeDef* hfdcan, uint32_t location,
+						   FDCAN_RxHeaderTypeDef* header, uint8_t* data)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	const CanFrame* frame;
+	if (location == FDCAN_RX_FIFO0 || location == FDCAN_RX_FIFO1) {
+		CanFifo& fifo = node->fifo[location == FDCAN_RX_FIFO0 ? 0 : 1];
+		if (fifo.count == 0U) {
+			hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_EMPTY;
+			return HAL_ERROR;
+		}
+		frame = &fifo.frames[fifo.get];
+		fifo.get = (fifo.get + 1U) % fifo.size;
+		fifo.count--;
+	} else {
+		if (location >= MAX_RX_BUFFERS) {
+			hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PARAM;
+			return HAL_ERROR;
+		}
+		frame = &node->rx_buffers[location];
+		node->rx_buffer_nd &= ~(1ULL << location);
+	}
+
+	*header = frame->header;
+	memcpy(data, frame->data, can_bytes_(frame->header.DataLength));
+	can_sync_regs_(*node);
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_GetTxEvent(FDCAN_HandleTypeDef* hfdcan, FDCAN_TxEventFifoTypeDef* event)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	if (node->event_count == 0U) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_EMPTY;
+		return HAL_ERROR;
+	}
+	uint32_t size = hfdcan->Init.TxEventsNbr > MAX_EVENTS ? MAX_EVENTS : hfdcan->Init.TxEventsNbr;
+	*event = node->events[node->event_get];
+	node->event_get = (node->event_get + 1U) % size;
+	node->event_count--;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_GetProtocolStatus(const FDCAN_HandleTypeDef* hfdcan,
+							FDCAN_ProtocolStatusTypeDef* status)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return HAL_ERROR;
+	}
+	memset(status, 0, sizeof *status);
+	status->LastErrorCode = node->lec;
+	status->DataLastErrorCode = node->dlec;
+	node->lec = FDCAN_PROTOCOL_ERROR_NO_CHANGE;         // PSR read resets LEC / DLEC
+	node->dlec = FDCAN_PROTOCOL_ERROR_NO_CHANGE;
+	status->Activity = FDCAN_COM_STATE_IDLE;
+	status->ErrorPassive = (node->tec > 127U || node->rec > 127U) ? 1U : 0U;
+	status->Warning = (node->tec >= 96U || node->rec >= 96U) ? 1U : 0U;
+	status->BusOff = node->bus_off ? 1U : 0U;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_GetErrorCounters(const FDCAN_HandleTypeDef* hfdcan,
+						       FDCAN_ErrorCountersTypeDef* counters)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return HAL_ERROR;
+	}
+	counters->TxErrorCnt = node->tec > 255U ? 255U : node->tec;
+	counters->RxErrorCnt = node->rec > 127U ? 127U : node->rec;
+	counters->RxErrorPassive = node->rec > 127U ? 1U : 0U;
+	counters->ErrorLogging = 0;
+	return HAL_OK;
+}
+
+extern "C" uint32_t HAL_FDCAN_IsRxBufferMessageAvailable(FDCAN_HandleTypeDef* hfdcan, uint32_t index)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || index >= MAX_RX_BUFFERS) {
+		return 0;
+	}
+	return (node->rx_buffer_nd >> index) & 1U ? 1U : 0U;
+}
+
+extern "C" uint32_t HAL_FDCAN_IsTxBufferMessagePending(const FDCAN_HandleTypeDef* hfdcan, uint32_t buffer_index)
+{
+	CanNode* node = can_node_(hfdcan);
+	return node != nullptr && (node->tx_pending & buffer_index) != 0U ? 1U : 0U;
+}
+
+extern "C" uint32_t HAL_FDCAN_GetRxFifoFillLevel(const FDCAN_HandleTypeDef* hfdcan, uint32_t fifo)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return 0;
+	}
+	return node->fifo[fifo == FDCAN_RX_FIFO0 ? 0 : 1].count;
+}
+
+extern "C" uint32_t HAL_FDCAN_GetTxFifoFreeLevel(const FDCAN_HandleTypeDef* hfdcan)
+{
+	CanNode* node = can_node_(hfdcan);
+	return node != nullptr ? (can_txfqs_(*node) & FDCAN_TXFQS_TFFL) : 0U;
+}
+
+//=============================================================================
+// HAL FDCAN: Interrupts / Callbacks
+//=============================================================================
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_ActivateNotification(FDCAN_HandleTypeDef* hfdcan, uint32_t its,
+							   uint32_t buffer_indexes)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	if ((its & FDCAN_IT_TX_COMPLETE) != 0U) {
+		hfdcan->Instance->TXBTIE |= buffer_indexes;
+	}
+	if ((its & FDCAN_IT_TX_ABORT_COMPLETE) != 0U) {
+		hfdcan->Instance->TXBCIE |= buffer_indexes;
+	}
+	hfdcan->Instance->IE |= its;
+	hfdcan->Instance->ILE = FDCAN_INTERRUPT_LINE0 | FDCAN_INTERRUPT_LINE1;
+	can_raise_(*node);
+	kick_();
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_DeactivateNotification(FDCAN_HandleTypeDef* hfdcan, uint32_t its)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr || hfdcan->State == HAL_FDCAN_STATE_RESET) {
+		return HAL_ERROR;
+	}
+
+	Lock lock;
+	if ((its & FDCAN_IT_TX_COMPLETE) != 0U) {
+		hfdcan->Instance->TXBTIE = 0;
+	}
+	if ((its & FDCAN_IT_TX_ABORT_COMPLETE) != 0U) {
+		hfdcan->Instance->TXBCIE = 0;
+	}
+	hfdcan->Instance->IE &= ~its;
+	return HAL_OK;
+}
+
+// Same order as the STM32H7 HAL handler; flags are cleared before the callback
+extern "C" void HAL_FDCAN_IRQHandler(FDCAN_HandleTypeDef* hfdcan)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return;
+	}
+	uint32_t flags = node->ir & hfdcan->Instance->IE;
+
+	uint32_t its = flags & (FDCAN_IT_TX_EVT_FIFO_NEW_DATA | FDCAN_IT_TX_EVT_FIFO_ELT_LOST);
+	if (its != 0U) {
+		node->ir &= ~its;
+		can_call_(hfdcan->TxEventFifoCallback, hfdcan, its);
+	}
+
+	its = flags & IT_RX_FIFO0;
+	if (its != 0U) {
+		node->ir &= ~its;
+		can_call_(hfdcan->RxFifo0Callback, hfdcan, its);
+	}
+
+	its = flags & IT_RX_FIFO1;
+	if (its != 0U) {
+		node->ir &= ~its;
+		can_call_(hfdcan->RxFifo1Callback, hfdcan, its);
+	}
+
+	if ((flags & FDCAN_IT_TX_FIFO_EMPTY) != 0U) {
+		node->ir &= ~FDCAN_IT_TX_FIFO_EMPTY;
+		can_call_(hfdcan->TxFifoEmptyCallback, hfdcan);
+	}
+
+	if ((flags & FDCAN_IT_TX_COMPLETE) != 0U) {
+		node->ir &= ~FDCAN_IT_TX_COMPLETE;
+		can_call_(hfdcan->TxBufferCompleteCallback, hfdcan, node->tx_done & hfdcan->Instance->TXBTIE);
+	}
+
+	if ((flags & FDCAN_IT_TX_ABORT_COMPLETE) != 0U) {
+		node->ir &= ~FDCAN_IT_TX_ABORT_COMPLETE;
+		can_call_(hfdcan->TxBufferAbortCallback, hfdcan, node->tx_cancelled & hfdcan->Instance->TXBCIE);
+	}
+
+	if ((flags & FDCAN_IT_RX_BUFFER_NEW_MESSAGE) != 0U) {
+		node->ir &= ~FDCAN_IT_RX_BUFFER_NEW_MESSAGE;
+		can_call_(hfdcan->RxBufferNewMessageCallback, hfdcan);
+	}
+
+	its = flags & IT_ERROR_STATUS;
+	if (its != 0U) {
+		node->ir &= ~its;
+		can_call_(hfdcan->ErrorStatusCallback, hfdcan, its);
+	}
+
+	// The HAL reports PEA / PED in ErrorCode (cumulative until cleared)
+	its = flags & IT_PROTOCOL_ERROR;
+	if (its != 0U) {
+		node->ir &= ~its;
+		hfdcan->ErrorCode |= its;
+		can_call_(hfdcan->ErrorCallback, hfdcan);
+	}
+
+	can_sync_regs_(*node);
+}
+
+extern "C" HAL_FDCAN_StateTypeDef HAL_FDCAN_GetState(const FDCAN_HandleTypeDef* hfdcan)
+{
+	return hfdcan->State;
+}
+
+extern "C" uint32_t HAL_FDCAN_GetError(const FDCAN_HandleTypeDef* hfdcan)
+{
+	return hfdcan->ErrorCode;
+}
+
+// Registration is allowed before HAL_FDCAN_Start(), as in the HAL
+static HAL_StatusTypeDef can_register_check_(FDCAN_HandleTypeDef* hfdcan, const void* callback)
+{
+	if (callback == nullptr || hfdcan->State != HAL_FDCAN_STATE_READY) {
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+		return HAL_ERROR;
+	}
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterCallback(FDCAN_HandleTypeDef* hfdcan, HAL_FDCAN_CallbackIDTypeDef id,
+						       pFDCAN_CallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	switch (id) {
+	case HAL_FDCAN_TX_FIFO_EMPTY_CB_ID:
+		hfdcan->TxFifoEmptyCallback = callback;
+		return HAL_OK;
+	case HAL_FDCAN_RX_BUFFER_NEW_MSG_CB_ID:
+		hfdcan->RxBufferNewMessageCallback = callback;
+		return HAL_OK;
+	case HAL_FDCAN_ERROR_CALLBACK_CB_ID:
+		hfdcan->ErrorCallback = callback;
+		return HAL_OK;
+	default:
+		hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PARAM;
+		return HAL_ERROR;
+	}
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterTxEventFifoCallback(FDCAN_HandleTypeDef* hfdcan,
+								  pFDCAN_TxEventFifoCallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->TxEventFifoCallback = callback;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterRxFifo0Callback(FDCAN_HandleTypeDef* hfdcan,
+							      pFDCAN_RxFifo0CallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->RxFifo0Callback = callback;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterRxFifo1Callback(FDCAN_HandleTypeDef* hfdcan,
+							      pFDCAN_RxFifo1CallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->RxFifo1Callback = callback;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterTxBufferCompleteCallback(FDCAN_HandleTypeDef* hfdcan,
+								       pFDCAN_TxBufferCompleteCallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->TxBufferCompleteCallback = callback;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterTxBufferAbortCallback(FDCAN_HandleTypeDef* hfdcan,
+								    pFDCAN_TxBufferAbortCallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->TxBufferAbortCallback = callback;
+	return HAL_OK;
+}
+
+extern "C" HAL_StatusTypeDef HAL_FDCAN_RegisterErrorStatusCallback(FDCAN_HandleTypeDef* hfdcan,
+								  pFDCAN_ErrorStatusCallbackTypeDef callback)
+{
+	if (can_register_check_(hfdcan, reinterpret_cast<const void*>(callback)) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	hfdcan->ErrorStatusCallback = callback;
+	return HAL_OK;
+}
+
+extern "C" __weak void HAL_FDCAN_TxEventFifoCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t TxEventFifoITs)
+{
+	UNUSED(hfdcan);
+	UNUSED(TxEventFifoITs);
+}
+
+extern "C" __weak void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo0ITs)
+{
+	UNUSED(hfdcan);
+	UNUSED(RxFifo0ITs);
+}
+
+extern "C" __weak void HAL_FDCAN_RxFifo1Callback(FDCAN_HandleTypeDef* hfdcan, uint32_t RxFifo1ITs)
+{
+	UNUSED(hfdcan);
+	UNUSED(RxFifo1ITs);
+}
+
+extern "C" __weak void HAL_FDCAN_TxFifoEmptyCallback(FDCAN_HandleTypeDef* hfdcan)
+{
+	UNUSED(hfdcan);
+}
+
+extern "C" __weak void HAL_FDCAN_TxBufferCompleteCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes)
+{
+	UNUSED(hfdcan);
+	UNUSED(BufferIndexes);
+}
+
+extern "C" __weak void HAL_FDCAN_TxBufferAbortCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t BufferIndexes)
+{
+	UNUSED(hfdcan);
+	UNUSED(BufferIndexes);
+}
+
+extern "C" __weak void HAL_FDCAN_RxBufferNewMessageCallback(FDCAN_HandleTypeDef* hfdcan)
+{
+	UNUSED(hfdcan);
+}
+
+extern "C" __weak void HAL_FDCAN_ErrorCallback(FDCAN_HandleTypeDef* hfdcan)
+{
+	UNUSED(hfdcan);
+}
+
+extern "C" __weak void HAL_FDCAN_ErrorStatusCallback(FDCAN_HandleTypeDef* hfdcan, uint32_t ErrorStatusITs)
+{
+	UNUSED(hfdcan);
+	UNUSED(ErrorStatusITs);
+}
+
+//=============================================================================
+// Host Control
+//=============================================================================
+
+extern "C" void host_console_open(bool use_pty)
+{
+	if (use_pty) {
+		int master = posix_openpt(O_RDWR | O_NOCTTY);
+		if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+			perror("stm32zero-host: pty");
+			exit(2);
+		}
+		const char* name = ptsname(master);
+
+		// Keep the slave open so the master never reads EIO between sessions
+		pty_slave_fd_ = open(name, O_RDWR | O_NOCTTY);
+		if (pty_slave_fd_ >= 0) {
+			termios tio;
+			tcgetattr(pty_slave_fd_, &tio);
+			cfmakeraw(&tio);
+			tcsetattr(pty_slave_fd_, TCSANOW, &tio);
+		}
+
+		tx_fd_ = master;
+		rx_fd_ = master;
+		interactive_ = true;
+		fprintf(stderr, "stm32zero-host: console on %s\n", name);
+	}
+
+	// The reader must never take FreeRTOS signals
+	sigset_t all;
+	sigset_t old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	pthread_t reader;
+	if (pthread_create(&reader, nullptr, reader_func_, nullptr) == 0) {
+		pthread_detach(reader);
+	}
+	pthread_sigmask(SIG_SETMASK, &old, nullptr);
+}
+
+extern "C" bool host_console_interactive(void)
+{
+	return interactive_;
+}
+
+extern "C" void host_irq_init(void)
+{
+	irq_task_ = xTaskCreateStatic(irq_task_func_, "HIRQ", sizeof irq_stack_ / sizeof irq_stack_[0], nullptr,
+				      configMAX_PRIORITIES - 1, irq_stack_, &irq_tcb_);
+}
+
+extern "C" void host_fdcan_inject_error(FDCAN_HandleTypeDef* hfdcan, uint32_t tec, uint32_t rec, bool bus_off)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return;
+	}
+
+	Lock lock;
+	uint32_t before = can_status_(*node);
+	node->tec = tec;
+	node->rec = rec;
+	if (bus_off && !node->bus_off) {
+		node->bus_off = true;
+		hfdcan->Instance->CCCR |= FDCAN_CCCR_INIT;      // M_CAN enters init on bus-off
+	}
+	node->ir |= before ^ can_status_(*node);
+	can_raise_(*node);
+	kick_();
+}
+
+extern "C" void host_fdcan_inject_tx_errors(FDCAN_HandleTypeDef* hfdcan, uint32_t count, uint32_t lec)
+{
+	CanNode* node = can_node_(hfdcan);
+	if (node == nullptr) {
+		return;
+	}
+
+	Lock lock;
+	node->corrupt = count;
+	node->corrupt_lec = lec;
+}
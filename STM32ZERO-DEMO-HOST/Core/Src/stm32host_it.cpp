@@ -0,0 +1,53 @@
+/**
+ * STM32ZERO Host Interrupt Handlers
+ *
+ * Counterpart of stm32h7xx_it.c: the peripheral vectors the interrupt
+ * task calls (stm32host_hal.cpp), with the same trace hooks. The LOW
+ * ustim timer vector is defined by stm32zero-timer.cpp.
+ */
+
+#include "main.h"
+#include "usart.h"
+#include "fdcan.h"
+
+extern "C" {
+
+void stm32zero_trace_isr_enter(void);
+void stm32zero_trace_isr_exit(void);
+
+void FDCAN1_IT0_IRQHandler(void)
+{
+	stm32zero_trace_isr_enter();
+	HAL_FDCAN_IRQHandler(&hfdcan1);
+	stm32zero_trace_isr_exit();
+}
+
+void FDCAN1_IT1_IRQHandler(void)
+{
+	stm32zero_trace_isr_enter();
+	HAL_FDCAN_IRQHandler(&hfdcan1);
+	stm32zero_trace_isr_exit();
+}
+
+void FDCAN2_IT0_IRQHandler(void)
+{
+	stm32zero_trace_isr_enter();
+	HAL_FDCAN_IRQHandler(&hfdcan2);
+	stm32zero_trace_isr_exit();
+}
+
+void FDCAN2_IT1_IRQHandler(void)
+{
+	stm32zero_trace_isr_enter();
+	HAL_FDCAN_IRQHandler(&hfdcan2);
+	stm32zero_trace_isr_exit();
+}
+
+void USART3_IRQHandler(void)
+{
+	stm32zero_trace_isr_enter();
+	HAL_UART_IRQHandler(&huart3);
+	stm32zero_trace_isr_exit();
+}
+
+} // extern "C"
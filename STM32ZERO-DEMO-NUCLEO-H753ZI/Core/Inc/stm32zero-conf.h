@@ -30,6 +30,11 @@
 #define STM32ZERO_USTIM_MID   4
 #define STM32ZERO_USTIM_HIGH  12
 
+// Asynchronous MDMA memcpy (copies below threshold use memcpy)
+#define STM32ZERO_DMACPY_THRESHOLD     256
+#define STM32ZERO_DMACPY_QUEUE_LEN     8
+#define STM32ZERO_DMACPY_IRQ_PRIORITY  5
+
 // Namespace alias
 #define STM32ZERO_NAMESPACE_ALIAS zero
 
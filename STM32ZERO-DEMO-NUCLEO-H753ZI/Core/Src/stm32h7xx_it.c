@@ -46,6 +46,8 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
+void stm32zero_trace_isr_enter(void);
+void stm32zero_trace_isr_exit(void);
 
 /* USER CODE END PFP */
 
@@ -170,11 +172,11 @@ void DebugMon_Handler(void)
 void FDCAN1_IT0_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN1_IT0_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END FDCAN1_IT0_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
   /* USER CODE BEGIN FDCAN1_IT0_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END FDCAN1_IT0_IRQn 1 */
 }
 
@@ -184,25 +186,53 @@ void FDCAN1_IT0_IRQHandler(void)
 void FDCAN1_IT1_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN1_IT1_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END FDCAN1_IT1_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
   /* USER CODE BEGIN FDCAN1_IT1_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END FDCAN1_IT1_IRQn 1 */
 }
 
+/**
+  * @brief This function handles FDCAN2 interrupt 0.
+  */
+void FDCAN2_IT0_IRQHandler(void)
+{
+  /* USER CODE BEGIN FDCAN2_IT0_IRQn 0 */
+  stm32zero_trace_isr_enter();
+  /* USER CODE END FDCAN2_IT0_IRQn 0 */
+  HAL_FDCAN_IRQHandler(&hfdcan2);
+  /* USER CODE BEGIN FDCAN2_IT0_IRQn 1 */
+  stm32zero_trace_isr_exit();
+  /* USER CODE END FDCAN2_IT0_IRQn 1 */
+}
+
+/**
+  * @brief This function handles FDCAN2 interrupt 1.
+  */
+void FDCAN2_IT1_IRQHandler(void)
+{
+  /* USER CODE BEGIN FDCAN2_IT1_IRQn 0 */
+  stm32zero_trace_isr_enter();
+  /* USER CODE END FDCAN2_IT1_IRQn 0 */
+  HAL_FDCAN_IRQHandler(&hfdcan2);
+  /* USER CODE BEGIN FDCAN2_IT1_IRQn 1 */
+  stm32zero_trace_isr_exit();
+  /* USER CODE END FDCAN2_IT1_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART3 global interrupt.
   */
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END USART3_IRQn 1 */
 }
 
@@ -212,11 +242,11 @@ void USART3_IRQHandler(void)
 void EXTI15_10_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI15_10_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END EXTI15_10_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(BTN_Pin);
   /* USER CODE BEGIN EXTI15_10_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END EXTI15_10_IRQn 1 */
 }
 
@@ -226,12 +256,12 @@ void EXTI15_10_IRQHandler(void)
 void FDCAN_CAL_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN_CAL_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END FDCAN_CAL_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
   HAL_FDCAN_IRQHandler(&hfdcan2);
   /* USER CODE BEGIN FDCAN_CAL_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END FDCAN_CAL_IRQn 1 */
 }
 
@@ -241,11 +271,11 @@ void FDCAN_CAL_IRQHandler(void)
 void DMA2_Stream6_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA2_Stream6_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END DMA2_Stream6_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart3_rx);
   /* USER CODE BEGIN DMA2_Stream6_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END DMA2_Stream6_IRQn 1 */
 }
 
@@ -255,11 +285,11 @@ void DMA2_Stream6_IRQHandler(void)
 void DMA2_Stream7_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA2_Stream7_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END DMA2_Stream7_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart3_tx);
   /* USER CODE BEGIN DMA2_Stream7_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END DMA2_Stream7_IRQn 1 */
 }
 
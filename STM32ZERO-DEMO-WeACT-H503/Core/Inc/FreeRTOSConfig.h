@@ -175,6 +175,65 @@ header file. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Run-time stats clocked by ustim (1 us), see Main/Inc/stm32zero-stats.hpp.
+   ustim::init() runs in app_init() before the scheduler starts.
+   64-bit counters so the per-task run time never wraps. */
+#define configGENERATE_RUN_TIME_STATS            1
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+#undef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE              uint64_t
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C"
+  #endif
+  configRUN_TIME_COUNTER_TYPE stm32zero_stats_counter(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         stm32zero_stats_counter()
+/* Timer queue depth and command latency, see Main/Inc/stm32zero-timer.hpp. */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C" {
+  #endif
+  void stm32zero_timer_cmd_sent(long result);
+  void stm32zero_timer_cmd_received(void);
+  #ifdef __cplusplus
+  }
+  #endif
+#endif
+#define traceTIMER_COMMAND_SEND(xTimer, xMessageID, xMessageValueValue, xReturn) \
+	stm32zero_timer_cmd_sent(xReturn)
+#define traceTIMER_COMMAND_RECEIVED(pxTimer, xMessageID, xMessageValue) \
+	stm32zero_timer_cmd_received()
+/* Trace recorder, see Main/Inc/stm32zero-trace.hpp (codes = trace::Event). */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #ifdef __cplusplus
+  extern "C" {
+  #endif
+  void stm32zero_trace_record(uint32_t info);
+  uint32_t stm32zero_trace_queue_id(void);
+  #ifdef __cplusplus
+  }
+  #endif
+#endif
+#define STM32ZERO_TRACE_INFO(ev, aux, arg) \
+	((uint32_t)(ev) | ((uint32_t)(uint8_t)(aux) << 8) | ((uint32_t)(uint16_t)(arg) << 16))
+#define traceTASK_SWITCHED_IN() \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(1, 0, pxCurrentTCB->uxTCBNumber))
+#define traceQUEUE_CREATE(pxNewQueue) \
+	((pxNewQueue)->uxQueueNumber = stm32zero_trace_queue_id())
+#define traceQUEUE_SEND(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(4, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(5, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_RECEIVE(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(6, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(7, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(8, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) \
+	stm32zero_trace_record(STM32ZERO_TRACE_INFO(9, (pxQueue)->uxMessagesWaiting, (pxQueue)->uxQueueNumber))
 /* USER CODE END Defines */
 
 #endif /* __FREERTOS_CONFIG_H */
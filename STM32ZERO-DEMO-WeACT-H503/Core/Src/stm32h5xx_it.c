@@ -46,6 +46,8 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
+void stm32zero_trace_isr_enter(void);
+void stm32zero_trace_isr_exit(void);
 
 /* USER CODE END PFP */
 
@@ -169,11 +171,11 @@ void DebugMon_Handler(void)
 void FDCAN1_IT0_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN1_IT0_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END FDCAN1_IT0_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
   /* USER CODE BEGIN FDCAN1_IT0_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END FDCAN1_IT0_IRQn 1 */
 }
 
@@ -183,11 +185,11 @@ void FDCAN1_IT0_IRQHandler(void)
 void FDCAN1_IT1_IRQHandler(void)
 {
   /* USER CODE BEGIN FDCAN1_IT1_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END FDCAN1_IT1_IRQn 0 */
   HAL_FDCAN_IRQHandler(&hfdcan1);
   /* USER CODE BEGIN FDCAN1_IT1_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END FDCAN1_IT1_IRQn 1 */
 }
 
@@ -211,11 +213,11 @@ void TIM7_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END USART1_IRQn 1 */
 }
 
@@ -225,11 +227,11 @@ void USART1_IRQHandler(void)
 void GPDMA2_Channel0_IRQHandler(void)
 {
   /* USER CODE BEGIN GPDMA2_Channel0_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END GPDMA2_Channel0_IRQn 0 */
   HAL_DMA_IRQHandler(&handle_GPDMA2_Channel0);
   /* USER CODE BEGIN GPDMA2_Channel0_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END GPDMA2_Channel0_IRQn 1 */
 }
 
@@ -239,11 +241,11 @@ void GPDMA2_Channel0_IRQHandler(void)
 void GPDMA2_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN GPDMA2_Channel1_IRQn 0 */
-
+  stm32zero_trace_isr_enter();
   /* USER CODE END GPDMA2_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&handle_GPDMA2_Channel1);
   /* USER CODE BEGIN GPDMA2_Channel1_IRQn 1 */
-
+  stm32zero_trace_isr_exit();
   /* USER CODE END GPDMA2_Channel1_IRQn 1 */
 }
 
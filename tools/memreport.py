@@ -0,0 +1,480 @@
+#!/usr/bin/env python3
+"""
+STM32ZERO Memory Budget Report
+
+Parses the GNU ld map file (and optionally the ELF symbol table via nm
+and section flags via objdump) produced by the firmware build and reports
+memory usage per region, per output section, per module (object file) and
+per symbol.
+
+Budgets are read from a JSON file; exceeding any budget makes the tool
+exit with status 1 so the build fails. A JSON report with stable key
+ordering is written for diffing against a previous build. With
+--update-baseline the report replaces the baseline only when all budgets
+are met, so a failing build keeps diffing against the last good one.
+
+Usage:
+    memreport.py --map firmware.map [--elf firmware.elf --nm arm-none-eabi-nm
+                 --objdump arm-none-eabi-objdump]
+                 [--budget memory-budget.json] [--json report.json]
+                 [--baseline previous.json [--update-baseline]] [--top 10]
+
+Budget file format (sizes are bytes, "K"/"M" suffixed strings, or a
+percentage of the region length for region budgets):
+
+    {
+        "regions":  { "DTCMRAM": "112K", "AXISRAM": "90%" },
+        "sections": { ".dtcmram_bss": "96K", ".lwip_heap_sec": "128K" },
+        "symbols":  { "ucHeap": "64K" }
+    }
+"""
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import subprocess
+import sys
+
+#=============================================================================
+# Map File Parsing
+#=============================================================================
+
+# Output sections that never occupy target memory
+NON_ALLOC_PREFIXES = (
+	".debug", ".comment", ".ARM.attributes", ".stab", ".gnu.attributes",
+	"/DISCARD/",
+)
+
+RE_REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S+))?\s*$")
+RE_OUT_FULL = re.compile(
+	r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+RE_OUT_NAME = re.compile(r"^(\.\S+)\s*$")
+RE_OUT_CONT = re.compile(
+	r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+RE_IN_FULL = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+RE_IN_NAME = re.compile(r"^ (\S+)\s*$")
+RE_IN_CONT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+
+# Input sections that occupy memory but have no file contents
+NOBITS_INPUT_PREFIXES = (".bss", ".tbss", ".dtcmram_bss", "COMMON")
+
+# Input section prefixes stripped to recover the symbol name
+# (-ffunction-sections / -fdata-sections emit one section per symbol)
+SYMBOL_SECTION_PREFIXES = (
+	".text.", ".rodata.", ".data.", ".bss.", ".tbss.", ".tdata.",
+	".dtcmram_data.", ".dtcmram_bss.",
+)
+
+
+class Region:
+	def __init__(self, name, origin, length):
+		self.name = name
+		self.origin = origin
+		self.length = length
+		self.used = 0
+
+	def contains(self, addr):
+		return self.origin <= addr < self.origin + self.length
+
+
+class Section:
+	def __init__(self, name, vma, size, lma):
+		self.name = name
+		self.vma = vma
+		self.size = size
+		self.lma = lma
+		self.region = None
+		self.load_region = None
+		self.contents = None    # None until known (ELF flags or inputs)
+		self.inputs = []    # (name, addr, size, module)
+
+	def has_contents(self):
+		"""True if the section is loaded from the image (not NOBITS/NOLOAD)."""
+		if self.contents is not None:
+			return self.contents
+		# Without ELF flags: a section with only .bss/COMMON inputs or only
+		# location counter moves (heap/stack reservations) has no contents.
+		return any(size and name != "*fill*" and not name.startswith(NOBITS_INPUT_PREFIXES)
+			   for name, _addr, size, _module in self.inputs)
+
+
+def module_name(path):
+	"""Reduce an object/archive path to a short, build-independent module name."""
+	path = path.strip()
+	if not path:
+		return "*linker*"
+	m = re.match(r"^(.*?)\((.*)\)$", path)
+	if m:
+		# libfoo.a(bar.o) -> libfoo.a(bar.o) without directories
+		return "%s(%s)" % (os.path.basename(m.group(1)), m.group(2))
+	name = os.path.basename(path)
+	for suffix in (".obj", ".o"):
+		if name.endswith(suffix):
+			name = name[:-len(suffix)]
+			break
+	return name
+
+
+def parse_map(path):
+	with open(path, "r", errors="replace") as f:
+		lines = f.read().splitlines()
+
+	regions = []
+	sections = []
+
+	# Memory Configuration block
+	i = 0
+	while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+		i += 1
+	i += 1
+	while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+		m = RE_REGION.match(lines[i])
+		if m and m.group(1) not in ("Name", "*default*"):
+			regions.append(Region(m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+		i += 1
+
+	# Linker script and memory map block
+	current = None
+	pending_out = None
+	pending_in = None
+	for line in lines[i:]:
+		if pending_out is not None:
+			m = RE_OUT_CONT.match(line)
+			if m:
+				lma = int(m.group(3), 16) if m.group(3) else None
+				current = Section(pending_out, int(m.group(1), 16), int(m.group(2), 16), lma)
+				sections.append(current)
+			pending_out = None
+			continue
+
+		if pending_in is not None:
+			m = RE_IN_CONT.match(line)
+			if m and current is not None:
+				current.inputs.append((pending_in, int(m.group(1), 16),
+						       int(m.group(2), 16), module_name(m.group(3))))
+			pending_in = None
+			continue
+
+		if line and not line[0].isspace():
+			m = RE_OUT_FULL.match(line)
+			if m:
+				lma = int(m.group(4), 16) if m.group(4) else None
+				current = Section(m.group(1), int(m.group(2), 16), int(m.group(3), 16), lma)
+				sections.append(current)
+				continue
+			m = RE_OUT_NAME.match(line)
+			if m:
+				pending_out = m.group(1)
+				continue
+			# LOAD/OUTPUT/etc. directives end the current section
+			current = None
+			continue
+
+		if current is None:
+			continue
+
+		m = RE_IN_FULL.match(line)
+		if m:
+			name = m.group(1)
+			if name.startswith("*") and name != "*fill*":
+				continue
+			current.inputs.append((name, int(m.group(2), 16), int(m.group(3), 16),
+					       "*fill*" if name == "*fill*" else module_name(m.group(4))))
+			continue
+		m = RE_IN_NAME.match(line)
+		if m and not m.group(1).startswith("*"):
+			pending_in = m.group(1)
+
+	sections = [s for s in sections
+		    if s.size > 0 and not s.name.startswith(NON_ALLOC_PREFIXES)]
+
+	return regions, sections
+
+
+def assign_regions(regions, sections):
+	"""Charge each section to its run region and, if loaded, its load region."""
+	for s in sections:
+		s.region = find_region(regions, s.vma)
+		# ld also prints a "load address" for NOLOAD sections placed after
+		# an AT> section; those take no space in the load region.
+		if s.lma is not None and s.lma != s.vma and s.has_contents():
+			s.load_region = find_region(regions, s.lma)
+		if s.region is not None:
+			s.region.used += s.size
+		if s.load_region is not None and s.load_region is not s.region:
+			s.load_region.used += s.size
+
+
+def find_region(regions, addr):
+	for r in regions:
+		if r.contains(addr):
+			return r
+	return None
+
+
+def section_contents_from_elf(elf, objdump):
+	"""Map output section name -> has CONTENTS flag, via objdump -h."""
+	out = subprocess.run([objdump, "-h", elf],
+			     check=True, stdout=subprocess.PIPE,
+			     universal_newlines=True).stdout
+	contents = {}
+	name = None
+	for line in out.splitlines():
+		parts = line.split()
+		if len(parts) == 7 and parts[0].isdigit():
+			# Idx Name Size VMA LMA File-off Algn; flags on the next line
+			name = parts[1]
+		elif name is not None:
+			contents[name] = "CONTENTS" in line
+			name = None
+	return contents
+
+
+#=============================================================================
+# Symbols
+#=============================================================================
+
+def symbols_from_map(sections):
+	"""Derive per-symbol sizes from per-symbol input sections."""
+	symbols = {}
+	for s in sections:
+		for name, addr, size, module in s.inputs:
+			if size == 0 or name == "*fill*":
+				continue
+			sym = name
+			for prefix in SYMBOL_SECTION_PREFIXES:
+				if name.startswith(prefix):
+					sym = name[len(prefix):]
+					break
+			else:
+				# Whole-section input (e.g. .dtcmram_bss): attribute to module
+				sym = "%s:%s" % (module, name)
+			key = (s.region.name if s.region else "?", sym)
+			symbols[key] = symbols.get(key, 0) + size
+	return symbols
+
+
+def symbols_from_elf(elf, nm, regions):
+	"""Read sized symbols (including file-local statics) from the ELF via nm."""
+	out = subprocess.run([nm, "-S", "-C", "--defined-only", elf],
+			     check=True, stdout=subprocess.PIPE,
+			     universal_newlines=True).stdout
+	symbols = {}
+	for line in out.splitlines():
+		parts = line.split(None, 3)
+		if len(parts) != 4:
+			continue
+		addr, size, kind, name = parts
+		if kind.lower() not in "bdtr":
+			continue
+		size = int(size, 16)
+		if size == 0:
+			continue
+		region = find_region(regions, int(addr, 16))
+		key = (region.name if region else "?", name)
+		symbols[key] = symbols.get(key, 0) + size
+	return symbols
+
+
+#=============================================================================
+# Budgets
+#=============================================================================
+
+def parse_size(value, base=None):
+	if isinstance(value, int):
+		return value
+	text = str(value).strip().upper()
+	if text.endswith("%"):
+		if base is None:
+			raise ValueError("percentage budget needs a region: %s" % value)
+		return int(base * float(text[:-1]) / 100.0)
+	scale = 1
+	if text.endswith("K"):
+		scale, text = 1024, text[:-1]
+	elif text.endswith("M"):
+		scale, text = 1024 * 1024, text[:-1]
+	return int(float(text) * scale)
+
+
+def check_budgets(budget, regions, sections, symbols):
+	violations = []
+
+	for name, limit in budget.get("regions", {}).items():
+		region = next((r for r in regions if r.name == name), None)
+		if region is None:
+			violations.append("region %s: not found in map" % name)
+			continue
+		limit = parse_size(limit, region.length)
+		if region.used > limit:
+			violations.append("region %s: %d bytes used, budget %d (+%d)"
+					  % (name, region.used, limit, region.used - limit))
+
+	for name, limit in budget.get("sections", {}).items():
+		limit = parse_size(limit)
+		used = sum(s.size for s in sections if s.name == name)
+		if used > limit:
+			violations.append("section %s: %d bytes used, budget %d (+%d)"
+					  % (name, used, limit, used - limit))
+
+	for pattern, limit in budget.get("symbols", {}).items():
+		limit = parse_size(limit)
+		for (region, sym), size in sorted(symbols.items()):
+			if fnmatch.fnmatchcase(sym, pattern) and size > limit:
+				violations.append("symbol %s (%s): %d bytes, budget %d (+%d)"
+						  % (sym, region, size, limit, size - limit))
+
+	return violations
+
+
+#=============================================================================
+# Report
+#=============================================================================
+
+def build_report(regions, sections, symbols):
+	report = {"regions": {}, "sections": {}, "modules": {}, "symbols": {}}
+
+	for r in regions:
+		report["regions"][r.name] = {
+			"origin": "0x%08X" % r.origin,
+			"length": r.length,
+			"used": r.used,
+		}
+
+	for s in sections:
+		report["sections"][s.name] = {
+			"region": s.region.name if s.region else None,
+			"load_region": s.load_region.name if s.load_region else None,
+			"address": "0x%08X" % s.vma,
+			"size": s.size,
+		}
+
+	for s in sections:
+		region = s.region.name if s.region else "?"
+		per_region = report["modules"].setdefault(region, {})
+		for _name, _addr, size, module in s.inputs:
+			if size:
+				per_region[module] = per_region.get(module, 0) + size
+
+	for (region, sym), size in symbols.items():
+		report["symbols"].setdefault(region, {})[sym] = size
+
+	return report
+
+
+def print_report(report, top):
+	print("%-12s %10s %10s %10s %7s" % ("Region", "Origin", "Used", "Length", "Use%"))
+	for name, r in report["regions"].items():
+		pct = 100.0 * r["used"] / r["length"] if r["length"] else 0.0
+		print("%-12s %10s %10d %10d %6.1f%%" % (name, r["origin"], r["used"], r["length"], pct))
+	print()
+
+	print("%-20s %-10s %10s %10s" % ("Section", "Region", "Address", "Size"))
+	for name, s in sorted(report["sections"].items(), key=lambda kv: kv[1]["address"]):
+		print("%-20s %-10s %10s %10d" % (name, s["region"] or "?", s["address"], s["size"]))
+
+	for region, modules in sorted(report["modules"].items()):
+		if not modules:
+			continue
+		print()
+		print("Top modules in %s:" % region)
+		for module, size in sorted(modules.items(), key=lambda kv: -kv[1])[:top]:
+			print("  %10d  %s" % (size, module))
+
+	for region, syms in sorted(report["symbols"].items()):
+		print()
+		print("Top symbols in %s:" % region)
+		for sym, size in sorted(syms.items(), key=lambda kv: -kv[1])[:top]:
+			print("  %10d  %s" % (size, sym))
+
+
+def print_delta(report, baseline):
+	print()
+	print("Delta vs baseline:")
+	changed = False
+	for kind, key in (("regions", "used"), ("sections", "size")):
+		old = baseline.get(kind, {})
+		for name, entry in report[kind].items():
+			before = old.get(name, {}).get(key, 0)
+			if entry[key] != before:
+				print("  %-8s %-20s %10d -> %10d (%+d)"
+				      % (kind[:-1], name, before, entry[key], entry[key] - before))
+				changed = True
+	if not changed:
+		print("  (no change)")
+
+
+def write_report(report, path):
+	with open(path, "w") as f:
+		json.dump(report, f, indent=2, sort_keys=True)
+		f.write("\n")
+
+
+#=============================================================================
+# Entry Point
+#=============================================================================
+
+def main():
+	parser = argparse.ArgumentParser(description="Per-region memory budget report")
+	parser.add_argument("--map", required=True, help="GNU ld map file")
+	parser.add_argument("--elf", help="ELF image (per-symbol sizes via nm)")
+	parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm executable")
+	parser.add_argument("--objdump", default="arm-none-eabi-objdump",
+			    help="objdump executable (section flags)")
+	parser.add_argument("--budget", help="JSON budget file")
+	parser.add_argument("--json", help="write JSON report to this path")
+	parser.add_argument("--baseline", help="previous JSON report to diff against")
+	parser.add_argument("--update-baseline", action="store_true",
+			    help="write the report to --baseline when all budgets are met")
+	parser.add_argument("--top", type=int, default=10, help="entries per top-N table")
+	args = parser.parse_args()
+
+	regions, sections = parse_map(args.map)
+
+	if args.elf:
+		try:
+			contents = section_contents_from_elf(args.elf, args.objdump)
+			for s in sections:
+				s.contents = contents.get(s.name)
+		except (OSError, subprocess.CalledProcessError) as e:
+			print("warning: %s failed (%s), using map inputs" % (args.objdump, e))
+	assign_regions(regions, sections)
+
+	symbols = None
+	if args.elf:
+		try:
+			symbols = symbols_from_elf(args.elf, args.nm, regions)
+		except (OSError, subprocess.CalledProcessError) as e:
+			print("warning: %s failed (%s), using map symbols" % (args.nm, e))
+	if symbols is None:
+		symbols = symbols_from_map(sections)
+
+	report = build_report(regions, sections, symbols)
+	print_report(report, args.top)
+
+	if args.baseline and os.path.exists(args.baseline):
+		with open(args.baseline) as f:
+			print_delta(report, json.load(f))
+
+	violations = []
+	if args.budget:
+		with open(args.budget) as f:
+			budget = json.load(f)
+		violations = check_budgets(budget, regions, sections, symbols)
+		print()
+		for v in violations:
+			print("BUDGET EXCEEDED: %s" % v)
+		if not violations:
+			print("All memory budgets met.")
+
+	if args.json:
+		write_report(report, args.json)
+	if args.update_baseline and args.baseline and not violations:
+		write_report(report, args.baseline)
+
+	return 1 if violations else 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
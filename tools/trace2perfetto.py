@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+"""
+STM32ZERO Trace Converter
+
+Converts the text output of trace::dump() or the trace stream (captured
+from the serial console, other console output may be interleaved) into
+Chrome trace JSON, which Perfetto (ui.perfetto.dev) and chrome://tracing
+open directly.
+
+    #trace stm32zero 1 us <size>     start of a capture
+    #task <number> <name>            task table (repeated while streaming)
+    =<ts><info>[<ts><info>...]       records, 8 + 8 hex digits each
+    #dropped <count>
+    #end
+
+Tasks become threads with a slice per time slice, interrupts become
+threads with a slice per entry/exit pair, queue operations become
+instants on the running task plus one depth counter per queue, and user
+marks and triggers become instants.
+
+Usage:
+    trace2perfetto.py console.log [-o trace.json] [--segment -1] [--list]
+"""
+
+import argparse
+import json
+import sys
+
+#=============================================================================
+# Record Format (keep in sync with stm32zero-trace.hpp)
+#=============================================================================
+
+EV_TASK_IN = 1
+EV_ISR_ENTER = 2
+EV_ISR_EXIT = 3
+EV_QUEUE_SEND = 4
+EV_QUEUE_SEND_ISR = 5
+EV_QUEUE_RECEIVE = 6
+EV_QUEUE_RECEIVE_ISR = 7
+EV_QUEUE_BLOCK_SEND = 8
+EV_QUEUE_BLOCK_RECEIVE = 9
+EV_MARK = 10
+EV_TRIGGER = 11
+
+# Queue events: (name, depth change, or None when the depth is unchanged)
+QUEUE_EVENTS = {
+	EV_QUEUE_SEND: ("send", 1),
+	EV_QUEUE_SEND_ISR: ("send_isr", 1),
+	EV_QUEUE_RECEIVE: ("receive", -1),
+	EV_QUEUE_RECEIVE_ISR: ("receive_isr", -1),
+	EV_QUEUE_BLOCK_SEND: ("block_send", None),
+	EV_QUEUE_BLOCK_RECEIVE: ("block_receive", None),
+}
+
+RECORD_CHARS = 16
+PID = 1
+ISR_TID_BASE = 10000        # interrupt threads sort after the tasks
+
+#=============================================================================
+# Log Parsing
+#=============================================================================
+
+class Capture:
+	def __init__(self, line_no):
+		self.line_no = line_no
+		self.tasks = {}
+		self.records = []       # (ts, info), claim order
+		self.dropped = 0
+		self.bad_lines = 0
+		self.complete = False
+
+
+def parse_log(lines):
+	captures = []
+	cur = None
+
+	for line_no, raw in enumerate(lines, 1):
+		line = raw.strip()
+		if line.startswith("#trace "):
+			cur = Capture(line_no)
+			captures.append(cur)
+			continue
+		if cur is None or cur.complete:
+			continue
+
+		if line.startswith("#task "):
+			parts = line.split(None, 2)
+			if len(parts) == 3 and parts[1].isdigit():
+				cur.tasks[int(parts[1])] = parts[2]
+		elif line.startswith("#dropped "):
+			try:
+				cur.dropped = int(line.split()[1])
+			except (IndexError, ValueError):
+				cur.bad_lines += 1
+		elif line == "#end":
+			cur.complete = True
+		elif line.startswith("="):
+			body = line[1:]
+			if len(body) == 0 or len(body) % RECORD_CHARS != 0:
+				cur.bad_lines += 1
+				continue
+			try:
+				for i in range(0, len(body), RECORD_CHARS):
+					cur.records.append((int(body[i:i + 8], 16), int(body[i + 8:i + 16], 16)))
+			except ValueError:
+				cur.bad_lines += 1
+
+	return captures
+
+
+def unwrap(records):
+	"""Extend 32-bit timestamps; a record may precede its predecessor by a
+	few us (timestamp taken before the slot was claimed)."""
+	out = []
+	prev = None
+	base = 0
+	for ts32, info in records:
+		if prev is None:
+			ts = ts32
+		else:
+			delta = (ts32 - (prev & 0xFFFFFFFF)) & 0xFFFFFFFF
+			if delta >= 0x80000000:
+				delta -= 0x100000000
+			ts = prev + delta
+		prev = ts
+		out.append((ts, info))
+	if out:
+		base = min(ts for ts, _ in out)
+	return [(ts - base, info) for ts, info in sorted(out, key=lambda r: r[0])]
+
+#=============================================================================
+# Chrome Trace Events
+#=============================================================================
+
+def task_name(tasks, number):
+	return tasks.get(number, "task %d" % number)
+
+
+def convert(cap):
+	events = []
+	records = unwrap(cap.records)
+	end_ts = records[-1][0] if records else 0
+
+	running = None          # (task number, since)
+	isr_open = {}           # exception -> [entry ts, ...]
+	depth = {}              # queue number -> depth after the last operation
+	seen_tasks = set()
+	seen_isrs = set()
+
+	def close_slice(until):
+		if running is not None:
+			number, since = running
+			events.append({
+				"name": task_name(cap.tasks, number), "ph": "X", "pid": PID,
+				"tid": number, "ts": since, "dur": max(until - since, 0),
+			})
+
+	for ts, info in records:
+		ev = info & 0xFF
+		aux = (info >> 8) & 0xFF
+		arg = info >> 16
+		tid = running[0] if running is not None else 0
+
+		if ev == EV_TASK_IN:
+			if running is not None and running[0] == arg:
+				continue
+			close_slice(ts)
+			running = (arg, ts)
+			seen_tasks.add(arg)
+		elif ev == EV_ISR_ENTER:
+			isr_open.setdefault(arg, []).append(ts)
+			seen_isrs.add(arg)
+		elif ev == EV_ISR_EXIT:
+			stack = isr_open.get(arg)
+			if stack:
+				since = stack.pop()
+				events.append({
+					"name": "IRQ %d" % (arg - 16), "ph": "X", "pid": PID,
+					"tid": ISR_TID_BASE + arg, "ts": since, "dur": ts - since,
+				})
+		elif ev in QUEUE_EVENTS:
+			name, change = QUEUE_EVENTS[ev]
+			events.append({
+				"name": "%s Q%d" % (name, arg), "ph": "i", "s": "t", "pid": PID,
+				"tid": tid, "ts": ts, "args": {"queue": arg, "items_before": aux},
+			})
+			if change is not None:
+				depth[arg] = max(aux + change, 0)
+				events.append({
+					"name": "Q%d depth" % arg, "ph": "C", "pid": PID, "ts": ts,
+					"args": {"items": depth[arg]},
+				})
+		elif ev == EV_MARK:
+			events.append({
+				"name": "mark %d" % arg, "ph": "i", "s": "t", "pid": PID,
+				"tid": tid, "ts": ts, "args": {"id": arg, "value": aux},
+			})
+		elif ev == EV_TRIGGER:
+			events.append({
+				"name": "TRIGGER", "ph": "i", "s": "g", "pid": PID, "ts": ts,
+			})
+
+	close_slice(end_ts)
+
+	meta = [{"name": "process_name", "ph": "M", "pid": PID, "args": {"name": "stm32zero"}}]
+	for number in sorted(seen_tasks | set(cap.tasks)):
+		meta.append({
+			"name": "thread_name", "ph": "M", "pid": PID, "tid": number,
+			"args": {"name": task_name(cap.tasks, number)},
+		})
+	for exc in sorted(seen_isrs):
+		meta.append({
+			"name": "thread_name", "ph": "M", "pid": PID, "tid": ISR_TID_BASE + exc,
+			"args": {"name": "IRQ %d" % (exc - 16)},
+		})
+
+	return {
+		"traceEvents": meta + events,
+		"displayTimeUnit": "ns",
+		"otherData": {
+			"records": len(records),
+			"dropped": cap.dropped,
+			"complete": cap.complete,
+		},
+	}
+
+#=============================================================================
+# Main
+#=============================================================================
+
+def main():
+	parser = argparse.ArgumentParser(description="STM32ZERO trace to Chrome/Perfetto JSON")
+	parser.add_argument("log", help="captured console output ('-' for stdin)")
+	parser.add_argument("-o", "--output", help="JSON output (default: stdout)")
+	parser.add_argument("--segment", type=int, default=-1,
+			    help="capture index when the log holds several (default: last)")
+	parser.add_argument("--list", action="store_true", help="list captures and exit")
+	args = parser.parse_args()
+
+	if args.log == "-":
+		captures = parse_log(sys.stdin)
+	else:
+		with open(args.log, errors="replace") as f:
+			captures = parse_log(f)
+
+	if not captures:
+		print("no '#trace' capture found in %s" % args.log, file=sys.stderr)
+		return 1
+
+	if args.list:
+		for i, cap in enumerate(captures):
+			print("%d: line %d, %d records, %d tasks, dropped %d%s" % (
+				i, cap.line_no, len(cap.records), len(cap.tasks), cap.dropped,
+				"" if cap.complete else ", incomplete"))
+		return 0
+
+	try:
+		cap = captures[args.segment]
+	except IndexError:
+		print("capture %d out of range (%d found)" % (args.segment, len(captures)), file=sys.stderr)
+		return 1
+
+	if cap.bad_lines:
+		print("warning: %d malformed record lines skipped" % cap.bad_lines, file=sys.stderr)
+	if cap.dropped:
+		print("warning: %d records dropped by the target" % cap.dropped, file=sys.stderr)
+
+	trace = convert(cap)
+	if args.output:
+		with open(args.output, "w") as f:
+			json.dump(trace, f)
+			f.write("\n")
+	else:
+		json.dump(trace, sys.stdout)
+		sys.stdout.write("\n")
+
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())